@@ -0,0 +1,276 @@
+﻿#include "Core/Player/CraftingComponent.h"
+
+#include "Core/Player/InventoryComponent.h"
+#include "Crafting/CraftingJobs.h"
+#include "Crafting/CraftingPlanner.h"
+#include "Crafting/RecipeCatalog.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemInstanceStore.h"
+
+UCraftingComponent::UCraftingComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+void UCraftingComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	Inventory = GetOwner() ? GetOwner()->FindComponentByClass<UInventoryComponent>() : nullptr;
+}
+
+void UCraftingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Cancelled jobs give back what they took from the inventory, so that leaving the world loses no ingredient.
+	if (UCraftingJobSubsystem* Jobs = GetJobs())
+	{
+		for (const uint32 JobId : ActiveJobs)
+		{
+			FCraftingJob Job;
+			if (Jobs->CancelJob(JobId, &Job))
+			{
+				RefundItems(Job.TakenItems);
+			}
+		}
+	}
+	ActiveJobs.Reset();
+	UE_CLOG(!PendingRefunds.IsEmpty(), LogTemp, Warning, TEXT("CraftingComponent: %d refunded items found no room in the inventory of %s and are lost."), PendingRefunds.Num(), *GetNameSafe(GetOwner()));
+	PendingRefunds.Reset();
+	Inventory = nullptr;
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UCraftingComponent::PlanCraft(const FName ItemID, const int32 Quantity, FCraftingPlan& OutPlan) const
+{
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	const URecipeCatalogSubsystem* Recipes = URecipeCatalogSubsystem::Get();
+	if (!Inventory || !Items || !Recipes)
+	{
+		OutPlan.Reset();
+		return false;
+	}
+	return Recipes->GetPlanner().Plan(Items->FindId(ItemID), Quantity, Inventory->GetItemCounts(), *Items, OutPlan);
+}
+
+void UCraftingComponent::ServerCraft_Implementation(const FName ItemID, const int32 Quantity)
+{
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	const FRecipeCatalog* Recipes = URecipeCatalogSubsystem::GetCatalog();
+	UCraftingJobSubsystem* Jobs = GetJobs();
+	FlushRefunds();
+
+	FCraftingPlan Plan;
+	TMap<int32, int32> Taken;
+	if (!Items || !Recipes || !Jobs || Quantity <= 0 || Quantity > MaxCraftQuantity || !PlanCraft(ItemID, Quantity, Plan) || !ConsumePlan(Plan, Taken))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("CraftingComponent: %s cannot craft %d %s."), *GetNameSafe(GetOwner()), Quantity, *ItemID.ToString());
+		ClientCraftFinished(ItemID, Quantity, false);
+		return;
+	}
+
+	const uint32 JobId = Jobs->StartCraft(this, Items->FindId(ItemID), Quantity, Plan, Taken);
+	if (JobId == 0)
+	{
+		RefundItems(Taken);
+		ClientCraftFinished(ItemID, Quantity, false);
+		return;
+	}
+	ActiveJobs.Add(JobId);
+	ClientCraftStarted(ItemID, Quantity, static_cast<float>(UCraftingJobSubsystem::GetPlanDuration(Plan, *Recipes)));
+}
+
+void UCraftingComponent::ServerRepair_Implementation(const int32 SlotId)
+{
+	FlushRefunds();
+	const uint32 JobId = StartRepair(SlotId);
+	if (JobId == 0)
+	{
+		ClientRepairFinished(SlotId, false);
+		return;
+	}
+	ActiveJobs.Add(JobId);
+}
+
+void UCraftingComponent::HandleJobCompleted(const FCraftingJob& Job, TConstArrayView<FItemHandle> Instances, const bool bSuccess)
+{
+	ActiveJobs.RemoveSingleSwap(Job.JobId, EAllowShrinking::No);
+	FlushRefunds();
+	if (Job.Kind == ECraftingJobKind::Repair)
+	{
+		const FInventorySlot* Slot = Inventory ? Inventory->FindSlotByInstance(Job.Instance) : nullptr;
+		const int32 SlotId = Slot ? Slot->ReplicationID : INDEX_NONE;
+		if (Slot)
+		{
+			Inventory->RefreshSlot(SlotId);
+		}
+		ClientRepairFinished(SlotId, bSuccess);
+		return;
+	}
+
+	if (bSuccess)
+	{
+		OnItemsCrafted.Broadcast(Instances);
+	}
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	ClientCraftFinished(Items ? Items->GetRowName(Job.ItemId) : NAME_None, Job.Quantity, bSuccess);
+}
+
+void UCraftingComponent::ClientCraftStarted_Implementation(const FName ItemID, const int32 Quantity, const float Duration)
+{
+	OnCraftStarted.Broadcast(ItemID, Quantity, Duration);
+}
+
+void UCraftingComponent::ClientCraftFinished_Implementation(const FName ItemID, const int32 Quantity, const bool bSuccess)
+{
+	OnCraftFinished.Broadcast(ItemID, Quantity, bSuccess);
+}
+
+void UCraftingComponent::ClientRepairFinished_Implementation(const int32 SlotId, const bool bSuccess)
+{
+	OnRepairFinished.Broadcast(SlotId, bSuccess);
+}
+
+UCraftingJobSubsystem* UCraftingComponent::GetJobs() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetSubsystem<UCraftingJobSubsystem>() : nullptr;
+}
+
+bool UCraftingComponent::ConsumePlan(const FCraftingPlan& Plan, TMap<int32, int32>& OutTaken)
+{
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	const FRecipeCatalog* Recipes = URecipeCatalogSubsystem::GetCatalog();
+	if (!Inventory || !Items || !Recipes || !Plan.IsComplete()) return false;
+
+	// The planner counts the tags on the whole holdings: an item may not serve both by name and by tag.
+	TMap<int32, int32> Left = Inventory->GetItemCounts();
+	for (const TPair<int32, int32>& Consumed : Plan.ConsumedItems)
+	{
+		int32* Held = Left.Find(Consumed.Key);
+		if (!Held || *Held < Consumed.Value) return false;
+
+		*Held -= Consumed.Value;
+	}
+	TArray<int32> TagCounts;
+	Recipes->CountTags(Left, *Items, TagCounts);
+	for (const TPair<int32, int32>& Consumed : Plan.ConsumedTags)
+	{
+		if (!TagCounts.IsValidIndex(Consumed.Key) || TagCounts[Consumed.Key] < Consumed.Value) return false;
+	}
+
+	// Named items first, so that tags only draw from what is left.
+	for (const TPair<int32, int32>& Consumed : Plan.ConsumedItems)
+	{
+		Inventory->ConsumeItems(Consumed.Key, Consumed.Value, &OutTaken);
+	}
+	for (const TPair<int32, int32>& Consumed : Plan.ConsumedTags)
+	{
+		Inventory->ConsumeTagged(Recipes->GetIngredientTags()[Consumed.Key], Consumed.Value, &OutTaken);
+	}
+	return true;
+}
+
+bool UCraftingComponent::PlaceCrafted(TConstArrayView<FItemHandle> Crafted, const TMap<int32, int32>& TakenItems)
+{
+	TArray<FItemHandle> Unplaced;
+	if (Inventory && Inventory->PlaceInstances(Crafted, Unplaced) == Crafted.Num()) return true;
+
+	// A result fitting nowhere undoes the whole craft, rather than leaving instances nobody holds.
+	UItemInstanceSubsystem* Instances = GetWorld() ? GetWorld()->GetSubsystem<UItemInstanceSubsystem>() : nullptr;
+	for (const FItemHandle Instance : Crafted)
+	{
+		if (const FInventorySlot* Slot = Inventory ? Inventory->FindSlotByInstance(Instance) : nullptr)
+		{
+			Inventory->RemoveSlot(Slot->ReplicationID);
+		}
+		if (Instances)
+		{
+			Instances->DestroyInstance(Instance);
+		}
+	}
+	UE_LOG(LogTemp, Verbose, TEXT("CraftingComponent: %d crafted stacks fit nowhere in %s, the craft is refunded."), Unplaced.Num(), *GetNameSafe(GetOwner()));
+	RefundItems(TakenItems);
+	return false;
+}
+
+bool UCraftingComponent::CommitRepair(const FItemHandle Instance, const TMap<int32, int32>& TakenItems)
+{
+	// The instance may have been dropped, traded or destroyed while the job waited: only a stack still held is repaired.
+	UItemInstanceSubsystem* Instances = GetWorld() ? GetWorld()->GetSubsystem<UItemInstanceSubsystem>() : nullptr;
+	if (Inventory && Instances && Inventory->FindSlotByInstance(Instance) && Instances->Repair(Instance)) return true;
+
+	UE_LOG(LogTemp, Verbose, TEXT("CraftingComponent: the repaired instance left %s or cannot be repaired, the repair is refunded."), *GetNameSafe(GetOwner()));
+	RefundItems(TakenItems);
+	return false;
+}
+
+void UCraftingComponent::RefundItems(const TMap<int32, int32>& Items)
+{
+	for (const TPair<int32, int32>& Item : Items)
+	{
+		PendingRefunds.FindOrAdd(Item.Key) += Item.Value;
+	}
+	FlushRefunds();
+}
+
+void UCraftingComponent::FlushRefunds()
+{
+	UItemInstanceSubsystem* Instances = GetWorld() ? GetWorld()->GetSubsystem<UItemInstanceSubsystem>() : nullptr;
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	if (PendingRefunds.IsEmpty() || !Inventory || !Instances || !Items) return;
+
+	TArray<FItemHandle> Refunds;
+	for (const TPair<int32, int32>& Refund : PendingRefunds)
+	{
+		const int32 MaxStack = FMath::Max(Items->GetStats().GetMaxStackSize(Refund.Key), 1);
+		for (int32 Remaining = Refund.Value; Remaining > 0; Remaining -= MaxStack)
+		{
+			const FItemHandle Instance = Instances->CreateInstance(Items->GetRowName(Refund.Key), FMath::Min(Remaining, MaxStack));
+			if (Instances->IsValidInstance(Instance))
+			{
+				Refunds.Add(Instance);
+			}
+		}
+	}
+	PendingRefunds.Reset();
+
+	TArray<FItemHandle> Unplaced;
+	Inventory->PlaceInstances(Refunds, Unplaced);
+	for (const FItemHandle Instance : Unplaced)
+	{
+		PendingRefunds.FindOrAdd(Instances->GetStore().GetItemId(Instance)) += Instances->GetStore().GetStack(Instance);
+		Instances->DestroyInstance(Instance);
+	}
+	UE_CLOG(!PendingRefunds.IsEmpty(), LogTemp, Log, TEXT("CraftingComponent: %d refunded items wait for room in the inventory of %s."), PendingRefunds.Num(), *GetNameSafe(GetOwner()));
+}
+
+uint32 UCraftingComponent::StartRepair(const int32 SlotId)
+{
+	const FInventorySlot* Slot = Inventory ? Inventory->FindSlot(SlotId) : nullptr;
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	UCraftingJobSubsystem* Jobs = GetJobs();
+	if (!Slot || !Items || !Jobs) return 0;
+
+	// Every material is checked before any is consumed.
+	const TConstArrayView<FRepairMaterial> Materials = Items->GetDetails().GetRepairMaterials(Slot->GetItemId());
+	for (const FRepairMaterial& Material : Materials)
+	{
+		if (Material.ItemId == INDEX_NONE || Inventory->GetItemCount(Material.ItemId) < Material.Quantity) return 0;
+	}
+
+	TMap<int32, int32> Taken;
+	for (const FRepairMaterial& Material : Materials)
+	{
+		Taken.Add(Material.ItemId, Material.Quantity);
+	}
+	const uint32 JobId = Jobs->StartRepair(this, Slot->Instance, MoveTemp(Taken));
+	if (JobId == 0) return 0;
+
+	for (const FRepairMaterial& Material : Materials)
+	{
+		Inventory->ConsumeItems(Material.ItemId, Material.Quantity);
+	}
+	return JobId;
+}
@@ -0,0 +1,646 @@
+﻿#include "Core/Player/InventoryComponent.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/GameStateBase.h"
+#include "Inventory/GridOccupancy.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemInstanceStore.h"
+#include "Inventory/ItemSnapshot.h"
+#include "Net/UnrealNetwork.h"
+
+namespace InventoryComponent
+{
+	uint8 Quantize(const float Value, const float Max)
+	{
+		if (Max <= 0.0f) return 0;
+		return static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(Value / Max, 0.0f, 1.0f) * FInventorySlot::QuantizationSteps));
+	}
+
+	UItemInstanceSubsystem* GetInstances(const UActorComponent* Component)
+	{
+		const UWorld* World = Component->GetWorld();
+		return World ? World->GetSubsystem<UItemInstanceSubsystem>() : nullptr;
+	}
+
+	/** @return The server world time clients see minus the world time the perish clock of the instances runs on. */
+	double GetServerTimeOffset(const UActorComponent* Component)
+	{
+		const UWorld* World = Component->GetWorld();
+		const AGameStateBase* GameState = World ? World->GetGameState() : nullptr;
+		return GameState ? GameState->GetServerWorldTimeSeconds() - World->GetTimeSeconds() : 0.0;
+	}
+
+	/** @return The cells an item covers, one cell for items without footprint as the pack solver does. */
+	FIntPoint GetFootprint(const FItemCatalog& Catalog, const int32 ItemId)
+	{
+		const FIntPoint Footprint = Catalog.GetDetails().Get(ItemId).GetFootprint();
+		return Footprint.X > 0 && Footprint.Y > 0 ? Footprint : FIntPoint(1, 1);
+	}
+}
+
+// ===============================[ Inventory Slot ]============================
+
+double FInventorySlot::GetPerishRemaining(const UWorld* World) const
+{
+	if (PerishDeadline == 0) return -1.0;
+
+	const AGameStateBase* GameState = World ? World->GetGameState() : nullptr;
+	const double ServerNow = GameState ? GameState->GetServerWorldTimeSeconds() : (World ? World->GetTimeSeconds() : 0.0);
+	return FMath::Max(PerishDeadline - ServerNow, 0.0);
+}
+
+bool FInventorySlot::SyncFromInstance(const FItemInstanceStore& Store, const FItemCatalog& Catalog, const double ServerTimeOffset)
+{
+	using namespace InventoryComponent;
+
+	const int32 Id = Store.GetItemId(Instance);
+	const bool bKnown = Catalog.IsValidId(Id);
+	// Overdue deadlines stay above 0, which means never perishing.
+	const double Deadline = Store.GetPerishDeadline(Instance) > 0.0 ? FMath::Max(Store.GetPerishDeadline(Instance) + ServerTimeOffset, 1.0) : 0.0;
+
+	const uint16 NewItemId = Id >= 0 && Id < NoItem ? static_cast<uint16>(Id) : NoItem;
+	const uint16 NewStack = static_cast<uint16>(FMath::Clamp(Store.GetStack(Instance), 0, static_cast<int32>(MAX_uint16)));
+	const uint8 NewDurability = bKnown ? Quantize(Store.GetDurability(Instance), Catalog.GetStats().Get(EItemStat::MaxDurability, Id)) : 0;
+	const uint8 NewWear = bKnown ? Quantize(Store.GetWear(Instance), Catalog.GetStats().Get(EItemStat::MaxWear, Id)) : 0;
+	const uint32 NewDeadline = Deadline > 0.0 ? static_cast<uint32>(FMath::Min(FMath::CeilToDouble(Deadline), static_cast<double>(MAX_uint32))) : 0;
+
+	const bool bChanged = NewItemId != ItemId || NewStack != Stack || NewDurability != Durability || NewWear != Wear || NewDeadline != PerishDeadline;
+	ItemId = NewItemId;
+	Stack = NewStack;
+	Durability = NewDurability;
+	Wear = NewWear;
+	PerishDeadline = NewDeadline;
+	return bChanged;
+}
+
+bool FInventorySlot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << ItemId;
+	uint32 PackedStack = Stack;
+	Ar.SerializeIntPacked(PackedStack);
+	Ar << Pocket << CellX << CellY;
+
+	uint8 Flags = (bRotated ? 1 : 0) | (Durability != 0 || Wear != 0 ? 2 : 0) | (PerishDeadline != 0 ? 4 : 0);
+	Ar.SerializeBits(&Flags, 3);
+
+	// Items without durability or deadline, most of them, skip the corresponding fields.
+	if (Flags & 2)
+	{
+		Ar << Durability << Wear;
+	}
+	if (Flags & 4)
+	{
+		Ar.SerializeIntPacked(PerishDeadline);
+	}
+
+	if (Ar.IsLoading())
+	{
+		Stack = static_cast<uint16>(FMath::Min(PackedStack, static_cast<uint32>(MAX_uint16)));
+		bRotated = (Flags & 1) != 0;
+		if (!(Flags & 2))
+		{
+			Durability = 0;
+			Wear = 0;
+		}
+		if (!(Flags & 4))
+		{
+			PerishDeadline = 0;
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+void FInventorySlot::PreReplicatedRemove(const FInventorySlotArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->HandleSlotReplicated(*this, EInventorySlotChange::E_Removed);
+	}
+}
+
+void FInventorySlot::PostReplicatedAdd(const FInventorySlotArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->HandleSlotReplicated(*this, EInventorySlotChange::E_Added);
+	}
+}
+
+void FInventorySlot::PostReplicatedChange(const FInventorySlotArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->HandleSlotReplicated(*this, EInventorySlotChange::E_Changed);
+	}
+}
+
+// ===============================[ Inventory Component ]============================
+
+UInventoryComponent::UInventoryComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+	Inventory.Owner = this;
+}
+
+void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(UInventoryComponent, Inventory);
+}
+
+void UInventoryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	if (!GetOwner() || !GetOwner()->HasAuthority()) return;
+
+	if (UItemInstanceSubsystem* Instances = InventoryComponent::GetInstances(this))
+	{
+		PerishedHandle = Instances->OnInstancesPerished.AddUObject(this, &UInventoryComponent::HandleInstancesPerished);
+		MassOwner = Instances->GetContainerTree().AddOwner();
+	}
+	if (UItemCatalogSubsystem* Catalog = UItemCatalogSubsystem::Get())
+	{
+		CatalogRebuiltHandle = Catalog->OnCatalogRebuilt.AddUObject(this, &UInventoryComponent::HandleCatalogRebuilt);
+		RowsPatchedHandle = Catalog->OnRowsPatched.AddUObject(this, &UInventoryComponent::HandleRowsPatched);
+	}
+}
+
+void UInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UItemInstanceSubsystem* Instances = InventoryComponent::GetInstances(this))
+	{
+		Instances->OnInstancesPerished.Remove(PerishedHandle);
+		if (MassOwner != INDEX_NONE)
+		{
+			for (const FInventorySlot& Slot : Inventory.Slots)
+			{
+				Instances->GetContainerTree().SetOwner(Slot.Instance, INDEX_NONE);
+			}
+			Instances->GetContainerTree().RemoveOwner(MassOwner);
+		}
+	}
+	MassOwner = INDEX_NONE;
+	if (UItemCatalogSubsystem* Catalog = UItemCatalogSubsystem::Get())
+	{
+		Catalog->OnCatalogRebuilt.Remove(CatalogRebuiltHandle);
+		Catalog->OnRowsPatched.Remove(RowsPatchedHandle);
+	}
+	CatalogRebuiltHandle.Reset();
+	RowsPatchedHandle.Reset();
+	PerishedHandle.Reset();
+	Super::EndPlay(EndPlayReason);
+}
+
+int32 UInventoryComponent::AddInstance(const FItemHandle Instance, const uint8 Pocket, const FIntPoint Cell, const bool bRotated)
+{
+	UItemInstanceSubsystem* Instances = InventoryComponent::GetInstances(this);
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!GetOwner() || !GetOwner()->HasAuthority() || !Instances || !Catalog) return INDEX_NONE;
+
+	if (!Instances->GetStore().IsValid(Instance) || SlotIds.Contains(Instance))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("InventoryComponent: %s cannot hold instance %u."), *GetNameSafe(GetOwner()), Instance.GetValue());
+		return INDEX_NONE;
+	}
+
+	FInventorySlot& Slot = Inventory.Slots.AddDefaulted_GetRef();
+	Slot.Instance = Instance;
+	Slot.Pocket = Pocket;
+	Slot.CellX = static_cast<uint8>(FMath::Clamp(Cell.X, 0, static_cast<int32>(MAX_uint8)));
+	Slot.CellY = static_cast<uint8>(FMath::Clamp(Cell.Y, 0, static_cast<int32>(MAX_uint8)));
+	Slot.bRotated = bRotated;
+	Slot.SyncFromInstance(Instances->GetStore(), *Catalog, InventoryComponent::GetServerTimeOffset(this));
+	Inventory.MarkItemDirty(Slot);
+
+	SlotIds.Add(Instance, Slot.ReplicationID);
+	SlotIndices.Add(Slot.ReplicationID, Inventory.Slots.Num() - 1);
+	Instances->GetContainerTree().SetOwner(Instance, MassOwner);
+	const int32 SlotId = Slot.ReplicationID;
+	CountSlot(SlotId, Slot.GetItemId(), Slot.Stack);
+	return SlotId;
+}
+
+int32 UInventoryComponent::PlaceInstances(TConstArrayView<FItemHandle> Instances, TArray<FItemHandle>& OutUnplaced)
+{
+	const UItemInstanceSubsystem* InstanceSubsystem = InventoryComponent::GetInstances(this);
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!InstanceSubsystem || !Catalog)
+	{
+		OutUnplaced.Append(Instances.GetData(), Instances.Num());
+		return 0;
+	}
+
+	TArray<int32> ItemIds;
+	ItemIds.Reserve(Instances.Num());
+	for (const FItemHandle Instance : Instances)
+	{
+		ItemIds.Add(InstanceSubsystem->GetStore().GetItemId(Instance));
+	}
+	TArray<int32> Pockets;
+	RoutePockets(ItemIds, Pockets);
+
+	// The occupancy of a pocket is built once from its stacks, then kept up to date with every instance added.
+	TMap<int32, FGridOccupancy> Grids;
+	int32 NumPlaced = 0;
+	for (int32 Index = 0; Index < Instances.Num(); ++Index)
+	{
+		const int32 Pocket = Pockets[Index];
+		if (Pocket == INDEX_NONE || !Catalog->IsValidId(ItemIds[Index]))
+		{
+			OutUnplaced.Add(Instances[Index]);
+			continue;
+		}
+
+		FGridOccupancy* Grid = Grids.Find(Pocket);
+		if (!Grid)
+		{
+			Grid = &Grids.Add(Pocket);
+			BuildOccupancy(static_cast<uint8>(Pocket), *Catalog, *Grid);
+		}
+
+		const FIntPoint Footprint = InventoryComponent::GetFootprint(*Catalog, ItemIds[Index]);
+		FIntPoint Cell;
+		bool bRotated = false;
+		if (!Grid->FindFirstFreeRotated(Footprint, Cell, bRotated) || AddInstance(Instances[Index], static_cast<uint8>(Pocket), Cell, bRotated) == INDEX_NONE)
+		{
+			OutUnplaced.Add(Instances[Index]);
+			continue;
+		}
+		Grid->Place(bRotated ? FGridOccupancy::Rotate(Footprint) : Footprint, Cell);
+		++NumPlaced;
+	}
+	return NumPlaced;
+}
+
+bool UInventoryComponent::RemoveSlot(const int32 SlotId)
+{
+	const int32 Index = FindSlotIndex(SlotId);
+	if (Index == INDEX_NONE) return false;
+
+	const FItemHandle Instance = Inventory.Slots[Index].Instance;
+	if (UItemInstanceSubsystem* Instances = InventoryComponent::GetInstances(this))
+	{
+		Instances->GetContainerTree().SetOwner(Instance, INDEX_NONE);
+	}
+	SlotIds.Remove(Instance);
+	SlotIndices.Remove(SlotId);
+	Inventory.Slots.RemoveAtSwap(Index);
+	if (Inventory.Slots.IsValidIndex(Index))
+	{
+		// The last slot took the place of the removed one.
+		SlotIndices.Add(Inventory.Slots[Index].ReplicationID, Index);
+	}
+	Inventory.MarkArrayDirty();
+	CountSlot(SlotId, INDEX_NONE, 0);
+	return true;
+}
+
+bool UInventoryComponent::MoveSlot(const int32 SlotId, const uint8 Pocket, const FIntPoint Cell, const bool bRotated)
+{
+	FInventorySlot* Slot = FindSlotMutable(SlotId);
+	if (!Slot) return false;
+
+	const uint8 CellX = static_cast<uint8>(FMath::Clamp(Cell.X, 0, static_cast<int32>(MAX_uint8)));
+	const uint8 CellY = static_cast<uint8>(FMath::Clamp(Cell.Y, 0, static_cast<int32>(MAX_uint8)));
+	if (Slot->Pocket == Pocket && Slot->CellX == CellX && Slot->CellY == CellY && Slot->bRotated == bRotated) return true;
+
+	Slot->Pocket = Pocket;
+	Slot->CellX = CellX;
+	Slot->CellY = CellY;
+	Slot->bRotated = bRotated;
+	Inventory.MarkItemDirty(*Slot);
+	return true;
+}
+
+bool UInventoryComponent::RefreshSlot(const int32 SlotId)
+{
+	FInventorySlot* Slot = FindSlotMutable(SlotId);
+	UItemInstanceSubsystem* Instances = InventoryComponent::GetInstances(this);
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Slot || !Instances || !Catalog) return false;
+
+	if (!Instances->Refresh(Slot->Instance))
+	{
+		return RemoveSlot(SlotId);
+	}
+	if (!Slot->SyncFromInstance(Instances->GetStore(), *Catalog, InventoryComponent::GetServerTimeOffset(this))) return false;
+
+	Inventory.MarkItemDirty(*Slot);
+	CountSlot(SlotId, Slot->GetItemId(), Slot->Stack);
+	return true;
+}
+
+int32 UInventoryComponent::ConsumeItems(const int32 ItemId, const int32 Quantity, TMap<int32, int32>* OutTaken)
+{
+	return ConsumeMatching([ItemId](const int32 Id) { return Id == ItemId; }, Quantity, OutTaken);
+}
+
+int32 UInventoryComponent::ConsumeTagged(const FGameplayTag& Tag, const int32 Quantity, TMap<int32, int32>* OutTaken)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog) return 0;
+
+	return ConsumeMatching([Catalog, &Tag](const int32 Id) { return Catalog->GetTagIndex().HasTag(Tag, Id); }, Quantity, OutTaken);
+}
+
+float UInventoryComponent::GetCarriedMass() const
+{
+	const UItemInstanceSubsystem* Instances = InventoryComponent::GetInstances(this);
+	return Instances ? static_cast<float>(Instances->GetContainerTree().GetOwnerMass(MassOwner)) : 0.0f;
+}
+
+void UInventoryComponent::SetPocketSpec(const uint8 Pocket, const FPocketSpec& Spec)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog) return;
+
+	if (!PocketFilters.IsValidIndex(Pocket))
+	{
+		PocketFilters.SetNum(Pocket + 1);
+		PocketDimensions.SetNum(Pocket + 1);
+	}
+	PocketFilters[Pocket].Compile(Catalog->GetTagIndex(), Spec);
+	PocketDimensions[Pocket] = Spec.Dimensions;
+}
+
+bool UInventoryComponent::CanAdmit(const uint8 Pocket, const int32 ItemId) const
+{
+	return PocketFilters.IsValidIndex(Pocket) && PocketFilters[Pocket].Admits(ItemId);
+}
+
+void UInventoryComponent::RoutePockets(TConstArrayView<int32> ItemIds, TArray<int32>& OutPockets) const
+{
+	OutPockets.Init(INDEX_NONE, ItemIds.Num());
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog || PocketFilters.IsEmpty()) return;
+
+	FDenseBitSet Loot(Catalog->GetTagIndex().NumItems());
+	for (const int32 ItemId : ItemIds)
+	{
+		if (Loot.IsValidIndex(ItemId))
+		{
+			Loot.Set(ItemId);
+		}
+	}
+
+	TArray<const FPocketFilter*, TInlineAllocator<16>> Pockets;
+	for (const FPocketFilter& Filter : PocketFilters)
+	{
+		Pockets.Add(&Filter);
+	}
+	TArray<FDenseBitSet> Routed;
+	FPocketFilter::Route(Pockets, Loot, Routed);
+
+	for (int32 Index = 0; Index < ItemIds.Num(); ++Index)
+	{
+		const int32 ItemId = ItemIds[Index];
+		for (int32 Pocket = 0; Pocket < Routed.Num(); ++Pocket)
+		{
+			if (Routed[Pocket].IsValidIndex(ItemId) && Routed[Pocket].Test(ItemId))
+			{
+				OutPockets[Index] = Pocket;
+				break;
+			}
+		}
+	}
+}
+
+void UInventoryComponent::ServerEditPocketFilter_Implementation(const uint8 Pocket, const FGameplayTag Tag, const bool bBlacklist, const bool bAdd)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog || !PocketFilters.IsValidIndex(Pocket)) return;
+
+	FPocketFilter& Filter = PocketFilters[Pocket];
+	if (!Filter.IsPlayerEditable())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("InventoryComponent: pocket %d of %s has fixed filters."), Pocket, *GetNameSafe(GetOwner()));
+		return;
+	}
+
+	if (bAdd)
+	{
+		Filter.AddTag(Catalog->GetTagIndex(), Tag, bBlacklist);
+	}
+	else
+	{
+		Filter.RemoveTag(Catalog->GetTagIndex(), Tag, bBlacklist);
+	}
+}
+
+void UInventoryComponent::QueueSnapshot(FItemSnapshotWriter& Writer) const
+{
+	for (const FInventorySlot& Slot : Inventory.Slots)
+	{
+		FItemSnapshotPlacement Placement;
+		Placement.Pocket = Slot.Pocket;
+		Placement.CellX = Slot.CellX;
+		Placement.CellY = Slot.CellY;
+		Placement.bRotated = Slot.bRotated;
+		Writer.AddRoot(Slot.Instance, &Placement);
+	}
+}
+
+int32 UInventoryComponent::RestoreSnapshot(TConstArrayView<FItemSnapshotEntry> Entries, TConstArrayView<FItemHandle> Handles)
+{
+	int32 NumAdded = 0;
+	for (int32 Index = 0; Index < FMath::Min(Entries.Num(), Handles.Num()); ++Index)
+	{
+		const FItemSnapshotEntry& Entry = Entries[Index];
+		if (!Entry.bHasPlacement || Entry.Parent != INDEX_NONE || !Handles[Index].IsValid()) continue;
+
+		const FItemSnapshotPlacement& Placement = Entry.Placement;
+		NumAdded += AddInstance(Handles[Index], Placement.Pocket, FIntPoint(Placement.CellX, Placement.CellY), Placement.bRotated) != INDEX_NONE;
+	}
+	return NumAdded;
+}
+
+const FInventorySlot* UInventoryComponent::FindSlot(const int32 SlotId) const
+{
+	const int32 Index = FindSlotIndex(SlotId);
+	return Index != INDEX_NONE ? &Inventory.Slots[Index] : nullptr;
+}
+
+const FInventorySlot* UInventoryComponent::FindSlotByInstance(const FItemHandle Instance) const
+{
+	const int32* SlotId = SlotIds.Find(Instance);
+	return SlotId ? FindSlot(*SlotId) : nullptr;
+}
+
+void UInventoryComponent::HandleSlotReplicated(const FInventorySlot& Slot, const EInventorySlotChange Change)
+{
+	const bool bRemoved = Change == EInventorySlotChange::E_Removed;
+	CountSlot(Slot.ReplicationID, bRemoved ? INDEX_NONE : Slot.GetItemId(), bRemoved ? 0 : Slot.Stack);
+	OnSlotReplicated.Broadcast(Slot, Change);
+}
+
+FInventorySlot* UInventoryComponent::FindSlotMutable(const int32 SlotId)
+{
+	const int32 Index = FindSlotIndex(SlotId);
+	return Index != INDEX_NONE ? &Inventory.Slots[Index] : nullptr;
+}
+
+int32 UInventoryComponent::FindSlotIndex(const int32 SlotId) const
+{
+	if (GetOwner() && GetOwner()->HasAuthority())
+	{
+		const int32* Index = SlotIndices.Find(SlotId);
+		return Index ? *Index : INDEX_NONE;
+	}
+	return Inventory.Slots.IndexOfByPredicate([SlotId](const FInventorySlot& Slot) { return Slot.ReplicationID == SlotId; });
+}
+
+void UInventoryComponent::HandleInstancesPerished(TConstArrayView<FPerishTransform> Transforms)
+{
+	if (SlotIds.IsEmpty()) return;
+
+	for (const FPerishTransform& Transform : Transforms)
+	{
+		const int32* SlotId = SlotIds.Find(Transform.Handle);
+		if (!SlotId) continue;
+
+		if (Transform.ToItem == INDEX_NONE)
+		{
+			RemoveSlot(*SlotId);
+		}
+		else
+		{
+			RefreshSlot(*SlotId);
+		}
+	}
+}
+
+void UInventoryComponent::HandleCatalogRebuilt()
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog) return;
+
+	for (FPocketFilter& Filter : PocketFilters)
+	{
+		Filter.Recompile(Catalog->GetTagIndex());
+	}
+}
+
+void UInventoryComponent::HandleRowsPatched(TConstArrayView<int32> Ids)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog) return;
+
+	for (FPocketFilter& Filter : PocketFilters)
+	{
+		Filter.RefreshItems(Catalog->GetTagIndex(), Ids);
+	}
+}
+
+void UInventoryComponent::CountSlot(const int32 SlotId, const int32 ItemId, const int32 Stack)
+{
+	const bool bHolds = ItemId != INDEX_NONE && Stack > 0;
+	TPair<int32, int32>* Counted = CountedSlots.Find(SlotId);
+	if (Counted && bHolds && Counted->Key == ItemId && Counted->Value == Stack) return;
+
+	if (Counted)
+	{
+		const TPair<int32, int32> Previous = *Counted;
+		if (bHolds)
+		{
+			*Counted = TPair<int32, int32>(ItemId, Stack);
+		}
+		else
+		{
+			CountedSlots.Remove(SlotId);
+		}
+
+		// A stack turning into another item, when perishing, changes both counts.
+		if (bHolds && Previous.Key == ItemId)
+		{
+			AddItemCount(ItemId, Stack - Previous.Value);
+			return;
+		}
+		AddItemCount(Previous.Key, -Previous.Value);
+	}
+	else if (bHolds)
+	{
+		CountedSlots.Add(SlotId, TPair<int32, int32>(ItemId, Stack));
+	}
+
+	if (bHolds)
+	{
+		AddItemCount(ItemId, Stack);
+	}
+}
+
+int32 UInventoryComponent::ConsumeMatching(TFunctionRef<bool(int32 ItemId)> Matches, const int32 Quantity, TMap<int32, int32>* OutTaken)
+{
+	UItemInstanceSubsystem* Instances = InventoryComponent::GetInstances(this);
+	if (!GetOwner() || !GetOwner()->HasAuthority() || !Instances || Quantity <= 0) return 0;
+
+	// Gathered first: emptied slots are removed from the array.
+	TArray<TPair<int32, FItemHandle>, TInlineAllocator<8>> Matching;
+	for (const FInventorySlot& Slot : Inventory.Slots)
+	{
+		if (Slot.Stack > 0 && Matches(Slot.GetItemId()))
+		{
+			Matching.Emplace(Slot.ReplicationID, Slot.Instance);
+		}
+	}
+
+	int32 Consumed = 0;
+	for (const TPair<int32, FItemHandle>& Match : Matching)
+	{
+		if (Consumed >= Quantity) break;
+
+		// The stack may have perished into another item since the slot was last synced.
+		const FItemHandle Instance = Match.Value;
+		if (!Instances->Refresh(Instance) || !Matches(Instances->GetStore().GetItemId(Instance)))
+		{
+			RefreshSlot(Match.Key);
+			continue;
+		}
+
+		const int32 Stack = Instances->GetStore().GetStack(Instance);
+		const int32 Taken = FMath::Min(Stack, Quantity - Consumed);
+		Consumed += Taken;
+		if (OutTaken)
+		{
+			OutTaken->FindOrAdd(Instances->GetStore().GetItemId(Instance)) += Taken;
+		}
+		if (Instances->SetStack(Instance, Stack - Taken))
+		{
+			RefreshSlot(Match.Key);
+		}
+		else
+		{
+			RemoveSlot(Match.Key);
+		}
+	}
+	return Consumed;
+}
+
+void UInventoryComponent::BuildOccupancy(const uint8 Pocket, const FItemCatalog& Catalog, FGridOccupancy& OutGrid) const
+{
+	OutGrid.Init(PocketDimensions.IsValidIndex(Pocket) ? PocketDimensions[Pocket] : FIntPoint::ZeroValue);
+	for (const FInventorySlot& Slot : Inventory.Slots)
+	{
+		if (Slot.Pocket != Pocket || !Catalog.IsValidId(Slot.GetItemId())) continue;
+
+		const FIntPoint Footprint = InventoryComponent::GetFootprint(Catalog, Slot.GetItemId());
+		OutGrid.Place(Slot.bRotated ? FGridOccupancy::Rotate(Footprint) : Footprint, Slot.GetCell());
+	}
+}
+
+void UInventoryComponent::AddItemCount(const int32 ItemId, const int32 Delta)
+{
+	if (Delta == 0) return;
+
+	int32& Count = ItemCounts.FindOrAdd(ItemId);
+	Count += Delta;
+	const int32 NewCount = Count;
+	if (NewCount <= 0)
+	{
+		ItemCounts.Remove(ItemId);
+	}
+	OnItemCountChanged.Broadcast(ItemId, FMath::Max(NewCount, 0));
+}
@@ -1,5 +1,42 @@
 ﻿#include "Core/Player/ProgressionComponent.h"
 
+#include "Core/Player/InventoryComponent.h"
+#include "Crafting/RecipeCatalog.h"
+#include "GameFramework/Actor.h"
+#include "Inventory/ItemCatalog.h"
+
+void UProgressionComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Inventory = GetOwner() ? GetOwner()->FindComponentByClass<UInventoryComponent>() : nullptr;
+	if (Inventory)
+	{
+		ItemCountHandle = Inventory->OnItemCountChanged.AddUObject(this, &UProgressionComponent::HandleItemCountChanged);
+	}
+	if (URecipeCatalogSubsystem* Recipes = URecipeCatalogSubsystem::Get())
+	{
+		RecipesRebuiltHandle = Recipes->OnRecipesRebuilt.AddUObject(this, &UProgressionComponent::ResetTracker);
+	}
+	ResetTracker();
+}
+
+void UProgressionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Inventory)
+	{
+		Inventory->OnItemCountChanged.Remove(ItemCountHandle);
+	}
+	if (URecipeCatalogSubsystem* Recipes = URecipeCatalogSubsystem::Get())
+	{
+		Recipes->OnRecipesRebuilt.Remove(RecipesRebuiltHandle);
+	}
+	ItemCountHandle.Reset();
+	RecipesRebuiltHandle.Reset();
+	Inventory = nullptr;
+	Super::EndPlay(EndPlayReason);
+}
+
 void UProgressionComponent::AddNewDiscovery(const FDataTableRowHandle& NewDiscovery)
 {
 	if (HasDiscovery(NewDiscovery)) return;
@@ -30,14 +67,28 @@ bool UProgressionComponent::HasDiscovery(const FDataTableRowHandle& DiscoveryToC
 void UProgressionComponent::LearnRecipe(const FDataTableRowHandle& Recipe)
 {
 	if (HasRecipe(Recipe)) return;
+
+	KnownRecipes.Add(Recipe);
 	OnLearnNewRecipe.Broadcast(Recipe);
+	if (Tracker.Track(FindRecipeId(Recipe)))
+	{
+		OnRecipeCraftableChanged.Broadcast(Recipe, true);
+	}
 }
 
 void UProgressionComponent::ForgetRecipe(const FDataTableRowHandle& Recipe)
 {
 	if (!HasRecipe(Recipe)) return;
-	ForgetRecipe(Recipe);
+
+	const int32 RecipeId = FindRecipeId(Recipe);
+	const bool bWasCraftable = Tracker.IsCraftable(RecipeId);
+	KnownRecipes.Remove(Recipe);
+	Tracker.Untrack(RecipeId);
 	OnForgetRecipe.Broadcast(Recipe);
+	if (bWasCraftable)
+	{
+		OnRecipeCraftableChanged.Broadcast(Recipe, false);
+	}
 }
 
 bool UProgressionComponent::HasRecipe(const FDataTableRowHandle& Recipe) const
@@ -45,8 +96,68 @@ bool UProgressionComponent::HasRecipe(const FDataTableRowHandle& Recipe) const
 	return KnownRecipes.Contains(Recipe);
 }
 
+bool UProgressionComponent::IsRecipeCraftable(const FDataTableRowHandle& Recipe) const
+{
+	return HasRecipe(Recipe) && Tracker.IsCraftable(FindRecipeId(Recipe));
+}
+
+TArray<FDataTableRowHandle> UProgressionComponent::GetCraftableRecipes() const
+{
+	TArray<FDataTableRowHandle> Craftable;
+	Tracker.GetCraftable().ForEachSetBit([&](const int32 RecipeId)
+	{
+		Craftable.Add(MakeRecipeHandle(RecipeId));
+	});
+	return Craftable;
+}
+
 void UProgressionComponent::ClearRecipes()
 {
+	TArray<FDataTableRowHandle> Craftable = GetCraftableRecipes();
 	KnownRecipes.Empty();
+	Tracker.Clear();
+	for (const FDataTableRowHandle& Recipe : Craftable)
+	{
+		OnRecipeCraftableChanged.Broadcast(Recipe, false);
+	}
+}
+
+void UProgressionComponent::ResetTracker()
+{
+	const FRecipeCatalog* Recipes = URecipeCatalogSubsystem::GetCatalog();
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	if (!Recipes || !Items)
+	{
+		Tracker = FCraftabilityTracker();
+		return;
+	}
+
+	Tracker.Reset(*Recipes, *Items, Inventory ? Inventory->GetItemCounts() : TMap<int32, int32>());
+	for (const FDataTableRowHandle& Recipe : KnownRecipes)
+	{
+		Tracker.Track(FindRecipeId(Recipe));
+	}
+}
+
+void UProgressionComponent::HandleItemCountChanged(const int32 ItemId, const int32 Count)
+{
+	CraftabilityChanges.Reset();
+	Tracker.SetHeld(ItemId, Count, CraftabilityChanges);
+	for (const FCraftabilityChange& Change : CraftabilityChanges)
+	{
+		OnRecipeCraftableChanged.Broadcast(MakeRecipeHandle(Change.RecipeId), Change.bCraftable);
+	}
+}
+
+int32 UProgressionComponent::FindRecipeId(const FDataTableRowHandle& Recipe) const
+{
+	const FRecipeCatalog* Recipes = URecipeCatalogSubsystem::GetCatalog();
+	return Recipes ? Recipes->FindId(Recipe) : INDEX_NONE;
+}
+
+FDataTableRowHandle UProgressionComponent::MakeRecipeHandle(const int32 RecipeId) const
+{
+	const FRecipeCatalog* Recipes = URecipeCatalogSubsystem::GetCatalog();
+	return Recipes ? Recipes->MakeHandle(RecipeId) : FDataTableRowHandle();
 }
 
@@ -0,0 +1,154 @@
+﻿#include "Crafting/CraftabilityTracker.h"
+
+#include "Crafting/RecipeCatalog.h"
+#include "Inventory/ItemCatalog.h"
+
+// ===============================[ Craftability Tracker ]============================
+
+void FCraftabilityTracker::Reset(const FRecipeCatalog& InRecipes, const FItemCatalog& InItems, const TMap<int32, int32>& Holdings)
+{
+	Recipes = &InRecipes;
+	Items = &InItems;
+	Missing.Init(INDEX_NONE, Recipes->Num());
+	Craftable.Init(Recipes->Num(), false);
+	ItemTagSlots.Reset();
+	Held.Reset();
+	TagCounts.Init(0, Recipes->GetIngredientTags().Num());
+
+	for (const TPair<int32, int32>& Holding : Holdings)
+	{
+		if (Holding.Value <= 0) continue;
+
+		Held.Add(Holding.Key, Holding.Value);
+		for (const int32 Slot : GetTagSlots(Holding.Key))
+		{
+			TagCounts[Slot] += Holding.Value;
+		}
+	}
+}
+
+void FCraftabilityTracker::Clear()
+{
+	for (int32& Count : Missing)
+	{
+		Count = INDEX_NONE;
+	}
+	Craftable.ClearAll();
+}
+
+bool FCraftabilityTracker::Track(const int32 RecipeId)
+{
+	if (!Recipes || !Missing.IsValidIndex(RecipeId) || Missing[RecipeId] != INDEX_NONE) return false;
+
+	// Recipes without ingredient are never craftable, as in FRecipeCatalog::FindCraftable.
+	const TConstArrayView<FRecipeIngredient> Ingredients = Recipes->GetIngredients(RecipeId);
+	int32 Count = Ingredients.IsEmpty() ? 1 : 0;
+	for (const FRecipeIngredient& Ingredient : Ingredients)
+	{
+		Count += !IsCovered(Ingredient);
+	}
+	Missing[RecipeId] = Count;
+	Craftable.SetTo(RecipeId, Count == 0);
+	return Count == 0;
+}
+
+void FCraftabilityTracker::Untrack(const int32 RecipeId)
+{
+	if (!IsTracked(RecipeId)) return;
+
+	Missing[RecipeId] = INDEX_NONE;
+	Craftable.Clear(RecipeId);
+}
+
+void FCraftabilityTracker::SetHeld(const int32 ItemId, const int32 Count, TArray<FCraftabilityChange>& OutChanges)
+{
+	if (!Recipes) return;
+
+	const int32* Current = Held.Find(ItemId);
+	const int32 OldCount = Current ? *Current : 0;
+	const int32 NewCount = FMath::Max(Count, 0);
+	if (OldCount == NewCount) return;
+
+	if (NewCount > 0)
+	{
+		Held.Add(ItemId, NewCount);
+	}
+	else
+	{
+		Held.Remove(ItemId);
+	}
+
+	for (const int32 RecipeId : Recipes->GetRecipesUsingItem(ItemId))
+	{
+		if (!IsTracked(RecipeId)) continue;
+
+		for (const FRecipeIngredient& Ingredient : Recipes->GetIngredients(RecipeId))
+		{
+			if (Ingredient.ItemId == ItemId)
+			{
+				AdjustMissing(RecipeId, OldCount >= Ingredient.Quantity, NewCount >= Ingredient.Quantity, OutChanges);
+			}
+		}
+	}
+
+	for (const int32 Slot : GetTagSlots(ItemId))
+	{
+		const int32 OldTagCount = TagCounts[Slot];
+		const int32 NewTagCount = TagCounts[Slot] += NewCount - OldCount;
+		for (const int32 RecipeId : Recipes->GetRecipesUsingTagSlot(Slot))
+		{
+			if (!IsTracked(RecipeId)) continue;
+
+			for (const FRecipeIngredient& Ingredient : Recipes->GetIngredients(RecipeId))
+			{
+				if (Ingredient.TagSlot == Slot)
+				{
+					AdjustMissing(RecipeId, OldTagCount >= Ingredient.Quantity, NewTagCount >= Ingredient.Quantity, OutChanges);
+				}
+			}
+		}
+	}
+}
+
+bool FCraftabilityTracker::IsCovered(const FRecipeIngredient& Ingredient) const
+{
+	if (Ingredient.ItemId != INDEX_NONE)
+	{
+		const int32* Count = Held.Find(Ingredient.ItemId);
+		return Count && *Count >= Ingredient.Quantity;
+	}
+	return TagCounts.IsValidIndex(Ingredient.TagSlot) && TagCounts[Ingredient.TagSlot] >= Ingredient.Quantity;
+}
+
+void FCraftabilityTracker::AdjustMissing(const int32 RecipeId, const bool bWasCovered, const bool bIsCovered, TArray<FCraftabilityChange>& OutChanges)
+{
+	if (bWasCovered == bIsCovered) return;
+
+	int32& Count = Missing[RecipeId];
+	const bool bWasCraftable = Count == 0;
+	Count += bIsCovered ? -1 : 1;
+	if (bWasCraftable == (Count == 0)) return;
+
+	Craftable.SetTo(RecipeId, Count == 0);
+	OutChanges.Add({ RecipeId, Count == 0 });
+}
+
+TConstArrayView<int32> FCraftabilityTracker::GetTagSlots(const int32 ItemId)
+{
+	if (const TArray<int32>* Slots = ItemTagSlots.Find(ItemId)) return *Slots;
+
+	// Ingredient tags are few: each is tested once per item, then the slots are kept.
+	TArray<int32>& Slots = ItemTagSlots.Add(ItemId);
+	if (Items && Items->IsValidId(ItemId))
+	{
+		const TConstArrayView<FGameplayTag> Tags = Recipes->GetIngredientTags();
+		for (int32 Slot = 0; Slot < Tags.Num(); ++Slot)
+		{
+			if (Items->GetTagIndex().HasTag(Tags[Slot], ItemId))
+			{
+				Slots.Add(Slot);
+			}
+		}
+	}
+	return Slots;
+}
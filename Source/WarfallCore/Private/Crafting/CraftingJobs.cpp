@@ -0,0 +1,294 @@
+﻿#include "Crafting/CraftingJobs.h"
+
+#include "Async/ParallelFor.h"
+#include "Core/Player/CraftingComponent.h"
+#include "Crafting/CraftingTypes.h"
+#include "Crafting/RecipeCatalog.h"
+#include "Engine/World.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemInstanceStore.h"
+
+namespace CraftingJobs
+{
+	/** Below this number of jobs in a batch, outputs are resolved on the game thread. */
+	constexpr int32 MinParallelJobs = 16;
+	/** Stale heap entries tolerated beyond the live jobs before the heap is compacted. */
+	constexpr int32 MaxStaleEntries = 64;
+}
+
+// ===============================[ Crafting Job Queue ]============================
+
+uint32 FCraftingJobQueue::Push(FCraftingJob&& Job)
+{
+	const uint32 JobId = NextJobId++;
+	if (NextJobId == 0)
+	{
+		NextJobId = 1;
+	}
+
+	Job.JobId = JobId;
+	Heap.HeapPush({ Job.CompletionTime, JobId }, FEarlier());
+	Jobs.Add(JobId, MoveTemp(Job));
+	return JobId;
+}
+
+bool FCraftingJobQueue::Cancel(const uint32 JobId, FCraftingJob* OutJob)
+{
+	FCraftingJob Job;
+	if (!Jobs.RemoveAndCopyValue(JobId, Job)) return false;
+
+	if (OutJob)
+	{
+		*OutJob = MoveTemp(Job);
+	}
+
+	if (Heap.Num() > 2 * Jobs.Num() + CraftingJobs::MaxStaleEntries)
+	{
+		Heap.RemoveAllSwap([this](const FEntry& Entry) { return !Jobs.Contains(Entry.JobId); }, EAllowShrinking::No);
+		Heap.Heapify(FEarlier());
+	}
+	return true;
+}
+
+void FCraftingJobQueue::Reset()
+{
+	Heap.Reset();
+	Jobs.Reset();
+}
+
+int32 FCraftingJobQueue::PopDue(const double Now, const int32 MaxJobs, TArray<FCraftingJob>& OutJobs)
+{
+	int32 NumPopped = 0;
+	while (NumPopped < MaxJobs && !Heap.IsEmpty() && Heap.HeapTop().CompletionTime <= Now)
+	{
+		FEntry Entry;
+		Heap.HeapPop(Entry, FEarlier(), EAllowShrinking::No);
+
+		FCraftingJob Job;
+		if (!Jobs.RemoveAndCopyValue(Entry.JobId, Job)) continue;
+
+		OutJobs.Add(MoveTemp(Job));
+		++NumPopped;
+	}
+	return NumPopped;
+}
+
+bool FCraftingJobQueue::HasDue(const double Now)
+{
+	PruneTop();
+	return !Heap.IsEmpty() && Heap.HeapTop().CompletionTime <= Now;
+}
+
+void FCraftingJobQueue::ResolveOutput(const FCraftingJob& Job, const FRecipeCatalog& Recipes, const FItemCatalog& Items, FCraftingJobOutput& OutOutput)
+{
+	// Consumed holdings plus everything produced, minus every ingredient used: what the steps leave over.
+	TMap<int32, int32, TInlineSetAllocator<16>> Produced;
+	for (const TPair<int32, int32>& Consumed : Job.ConsumedItems)
+	{
+		Produced.Add(Consumed.Key, Consumed.Value);
+	}
+	for (const FCraftingStep& Step : Job.Steps)
+	{
+		for (const FRecipeResult& Result : Recipes.GetResults(Step.RecipeId))
+		{
+			Produced.FindOrAdd(Result.ItemId) += Result.Quantity * Step.Batches;
+		}
+		for (const FRecipeIngredient& Ingredient : Recipes.GetIngredients(Step.RecipeId))
+		{
+			if (Ingredient.ItemId != INDEX_NONE)
+			{
+				Produced.FindOrAdd(Ingredient.ItemId) -= Ingredient.Quantity * Step.Batches;
+			}
+		}
+	}
+
+	for (const TPair<int32, int32>& Output : Produced)
+	{
+		if (!Items.IsValidId(Output.Key)) continue;
+
+		const int32 MaxStack = FMath::Max(Items.GetStats().GetMaxStackSize(Output.Key), 1);
+		for (int32 Remaining = Output.Value; Remaining > 0; Remaining -= MaxStack)
+		{
+			OutOutput.Stacks.Emplace(Output.Key, FMath::Min(Remaining, MaxStack));
+		}
+	}
+}
+
+void FCraftingJobQueue::PruneTop()
+{
+	while (!Heap.IsEmpty() && !Jobs.Contains(Heap.HeapTop().JobId))
+	{
+		FEntry Entry;
+		Heap.HeapPop(Entry, FEarlier(), EAllowShrinking::No);
+	}
+}
+
+// ===============================[ Crafting Job Subsystem ]============================
+
+void UCraftingJobSubsystem::Deinitialize()
+{
+	Queue.Reset();
+	Super::Deinitialize();
+}
+
+void UCraftingJobSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	Stats.CompletedLastFrame = 0;
+	Stats.MeanLatency = 0.0;
+	Stats.MaxLatency = 0.0;
+	Stats.LastFrameMilliseconds = 0.0;
+	Stats.bBudgetExceeded = false;
+	Stats.QueueDepth = Queue.Num();
+
+	const FRecipeCatalog* Recipes = URecipeCatalogSubsystem::GetCatalog();
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	if (Queue.Num() == 0 || !Recipes || !Items) return;
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double Now = GetNow();
+	const int32 BatchSize = FMath::Max(Budget.BatchSize, 1);
+	double TotalLatency = 0.0;
+	while (Stats.CompletedLastFrame < Budget.MaxCompletionsPerFrame && (FPlatformTime::Seconds() - StartTime) * 1000.0 < Budget.MaxMillisecondsPerFrame)
+	{
+		DueJobs.Reset();
+		const int32 NumDue = Queue.PopDue(Now, FMath::Min(BatchSize, Budget.MaxCompletionsPerFrame - Stats.CompletedLastFrame), DueJobs);
+		if (NumDue == 0) break;
+
+		Outputs.SetNum(NumDue, EAllowShrinking::No);
+		ParallelFor(NumDue, [this, Recipes, Items](const int32 Index)
+		{
+			Outputs[Index].Stacks.Reset();
+			if (DueJobs[Index].Kind == ECraftingJobKind::Craft)
+			{
+				FCraftingJobQueue::ResolveOutput(DueJobs[Index], *Recipes, *Items, Outputs[Index]);
+			}
+		}, NumDue < CraftingJobs::MinParallelJobs ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+		for (int32 Index = 0; Index < NumDue; ++Index)
+		{
+			const double Latency = Now - DueJobs[Index].CompletionTime;
+			TotalLatency += Latency;
+			Stats.MaxLatency = FMath::Max(Stats.MaxLatency, Latency);
+			CommitJob(DueJobs[Index], Outputs[Index], *Items);
+		}
+		Stats.CompletedLastFrame += NumDue;
+	}
+
+	Stats.bBudgetExceeded = Queue.HasDue(Now);
+	Stats.QueueDepth = Queue.Num();
+	Stats.MeanLatency = Stats.CompletedLastFrame > 0 ? TotalLatency / Stats.CompletedLastFrame : 0.0;
+	Stats.LastFrameMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	UE_CLOG(Stats.bBudgetExceeded, LogTemp, Verbose, TEXT("CraftingJobs: budget reached with %d jobs pending, %.2f s late at most."), Stats.QueueDepth, Stats.MaxLatency);
+}
+
+TStatId UCraftingJobSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCraftingJobSubsystem, STATGROUP_Tickables);
+}
+
+uint32 UCraftingJobSubsystem::StartCraft(UCraftingComponent* Owner, const int32 ItemId, const int32 Quantity, const FCraftingPlan& Plan, TMap<int32, int32> TakenItems)
+{
+	const FRecipeCatalog* Recipes = URecipeCatalogSubsystem::GetCatalog();
+	if (!Owner || !Recipes || !Plan.IsComplete()) return 0;
+
+	FCraftingJob Job;
+	Job.Kind = ECraftingJobKind::Craft;
+	Job.Owner = Owner;
+	Job.ItemId = ItemId;
+	Job.Quantity = Quantity;
+	Job.Steps = Plan.Steps;
+	Job.ConsumedItems = Plan.ConsumedItems;
+	Job.TakenItems = MoveTemp(TakenItems);
+	Job.StartTime = GetNow();
+	Job.CompletionTime = Job.StartTime + GetPlanDuration(Plan, *Recipes);
+	return Queue.Push(MoveTemp(Job));
+}
+
+uint32 UCraftingJobSubsystem::StartRepair(UCraftingComponent* Owner, const FItemHandle Instance, TMap<int32, int32> TakenItems)
+{
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	const UItemInstanceSubsystem* Instances = GetWorld()->GetSubsystem<UItemInstanceSubsystem>();
+	if (!Owner || !Items || !Instances || !Instances->IsValidInstance(Instance)) return 0;
+
+	const int32 ItemId = Instances->GetStore().GetItemId(Instance);
+	if (!Items->HasCapabilities(ItemId, EItemCapability::CanBeRepaired)) return 0;
+
+	FCraftingJob Job;
+	Job.Kind = ECraftingJobKind::Repair;
+	Job.Owner = Owner;
+	Job.ItemId = ItemId;
+	Job.Quantity = 1;
+	Job.Instance = Instance;
+	Job.TakenItems = MoveTemp(TakenItems);
+	Job.StartTime = GetNow();
+	Job.CompletionTime = Job.StartTime + Items->GetDetails().Get(ItemId).RepairTime;
+	return Queue.Push(MoveTemp(Job));
+}
+
+double UCraftingJobSubsystem::GetPlanDuration(const FCraftingPlan& Plan, const FRecipeCatalog& Recipes)
+{
+	double Duration = 0.0;
+	for (const FCraftingStep& Step : Plan.Steps)
+	{
+		Duration += static_cast<double>(Recipes.GetCraftDuration(Step.RecipeId)) * Step.Batches;
+	}
+	return Duration;
+}
+
+double UCraftingJobSubsystem::GetNow() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetTimeSeconds() : 0.0;
+}
+
+void UCraftingJobSubsystem::CommitJob(const FCraftingJob& Job, const FCraftingJobOutput& Output, const FItemCatalog& Items)
+{
+	UCraftingComponent* Owner = Job.Owner.Get();
+	UItemInstanceSubsystem* Instances = GetWorld()->GetSubsystem<UItemInstanceSubsystem>();
+	if (!Owner || !Instances)
+	{
+		++Stats.TotalDropped;
+		return;
+	}
+
+	Created.Reset();
+	bool bSuccess = true;
+	if (Job.Kind == ECraftingJobKind::Repair)
+	{
+		bSuccess = Owner->CommitRepair(Job.Instance, Job.TakenItems);
+		if (bSuccess)
+		{
+			Created.Add(Job.Instance);
+		}
+	}
+	else
+	{
+		for (const TPair<int32, int32>& Stack : Output.Stacks)
+		{
+			const FItemHandle Instance = Instances->CreateInstance(Items.GetRowName(Stack.Key), Stack.Value);
+			if (Instances->IsValidInstance(Instance))
+			{
+				Created.Add(Instance);
+			}
+		}
+
+		// The results go into the owner inventory in this same pass; a craft whose results fit nowhere is refunded.
+		bSuccess = Owner->PlaceCrafted(Created, Job.TakenItems);
+		if (!bSuccess)
+		{
+			Created.Reset();
+		}
+	}
+
+	if (bSuccess)
+	{
+		++Stats.TotalCompleted;
+	}
+	else
+	{
+		++Stats.TotalDropped;
+	}
+	Owner->HandleJobCompleted(Job, Created, bSuccess);
+}
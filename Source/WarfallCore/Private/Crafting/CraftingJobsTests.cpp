@@ -0,0 +1,81 @@
+﻿#include "Crafting/CraftingJobs.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// ===============================[ Crafting Job Tests ]============================
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCraftingJobQueueTest, "Warfall.Crafting.JobQueue.OrderAndCancel", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCraftingJobQueueTest::RunTest(const FString& Parameters)
+{
+	FCraftingJobQueue Queue;
+	auto Push = [&Queue](const double CompletionTime, const int32 ItemId)
+	{
+		FCraftingJob Job;
+		Job.ItemId = ItemId;
+		Job.CompletionTime = CompletionTime;
+		return Queue.Push(MoveTemp(Job));
+	};
+
+	// Item ids record the expected completion order: by time, then by start order.
+	const uint32 Late = Push(5.0, 5);
+	const uint32 First = Push(1.0, 0);
+	const uint32 TieA = Push(3.0, 2);
+	const uint32 TieB = Push(3.0, 3);
+	const uint32 Second = Push(2.0, 1);
+	const uint32 Cancelled = Push(4.0, 4);
+	TestNotEqual(TEXT("Job ids are never 0"), First, 0u);
+	TestEqual(TEXT("Every job is pending"), Queue.Num(), 6);
+
+	FCraftingJob CancelledJob;
+	TestTrue(TEXT("A pending job can be cancelled"), Queue.Cancel(Cancelled, &CancelledJob));
+	TestEqual(TEXT("The cancelled job is returned"), CancelledJob.ItemId, 4);
+	TestFalse(TEXT("A job is cancelled once"), Queue.Cancel(Cancelled));
+	TestNull(TEXT("A cancelled job is no longer found"), Queue.Find(Cancelled));
+	TestEqual(TEXT("The cancelled job left the queue"), Queue.Num(), 5);
+
+	TArray<FCraftingJob> Due;
+	TestFalse(TEXT("Nothing is due before the first completion"), Queue.HasDue(0.5));
+	TestEqual(TEXT("Nothing pops before the first completion"), Queue.PopDue(0.5, 10, Due), 0);
+	TestEqual(TEXT("The jobs due at 2.5"), Queue.PopDue(2.5, 10, Due), 2);
+	TestEqual(TEXT("MaxJobs limits a pop"), Queue.PopDue(10.0, 1, Due), 1);
+	TestEqual(TEXT("The remaining jobs, the cancelled one skipped"), Queue.PopDue(10.0, 10, Due), 2);
+	if (TestEqual(TEXT("Every live job completed"), Due.Num(), 5))
+	{
+		const int32 Expected[] = { 0, 1, 2, 3, 5 };
+		for (int32 Index = 0; Index < Due.Num(); ++Index)
+		{
+			TestEqual(FString::Printf(TEXT("Completion %d"), Index), Due[Index].ItemId, Expected[Index]);
+		}
+		TestEqual(TEXT("Equal times complete in start order"), Due[2].JobId, TieA);
+		TestEqual(TEXT("Equal times complete in start order"), Due[3].JobId, TieB);
+	}
+	TestFalse(TEXT("A completed job cannot be cancelled"), Queue.Cancel(First));
+	TestFalse(TEXT("A completed job cannot be cancelled"), Queue.Cancel(Second));
+	TestFalse(TEXT("A completed job cannot be cancelled"), Queue.Cancel(Late));
+	TestEqual(TEXT("The queue is empty"), Queue.Num(), 0);
+
+	// Mass cancellation compacts the heap without losing the live jobs.
+	TArray<uint32> JobIds;
+	for (int32 Index = 0; Index < 300; ++Index)
+	{
+		JobIds.Add(Push(100.0 + Index, Index));
+	}
+	for (int32 Index = 0; Index < JobIds.Num(); ++Index)
+	{
+		if (Index % 10 != 0)
+		{
+			Queue.Cancel(JobIds[Index]);
+		}
+	}
+	Due.Reset();
+	TestEqual(TEXT("Only the kept jobs pop"), Queue.PopDue(1000.0, 1000, Due), 30);
+	for (int32 Index = 0; Index < Due.Num(); ++Index)
+	{
+		if (!TestEqual(TEXT("Kept jobs complete in order"), Due[Index].ItemId, Index * 10)) break;
+	}
+	return true;
+}
+
+#endif
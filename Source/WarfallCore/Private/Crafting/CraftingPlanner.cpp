@@ -0,0 +1,410 @@
+﻿#include "Crafting/CraftingPlanner.h"
+
+#include "Algo/Reverse.h"
+#include "Crafting/RecipeCatalog.h"
+#include "Inventory/ItemCatalog.h"
+
+namespace CraftingPlanner
+{
+	/** @return The quantity of items and ingredient tags a plan misses. */
+	int64 CountMissing(const FCraftingPlan& Plan)
+	{
+		int64 Missing = 0;
+		for (const TPair<int32, int32>& Item : Plan.MissingItems)
+		{
+			Missing += Item.Value;
+		}
+		for (const TPair<int32, int32>& Tag : Plan.MissingTags)
+		{
+			Missing += Tag.Value;
+		}
+		return Missing;
+	}
+}
+
+// ===============================[ Crafting Plan ]============================
+
+void FCraftingPlan::Reset()
+{
+	Steps.Reset();
+	ConsumedItems.Reset();
+	ConsumedTags.Reset();
+	MissingItems.Reset();
+	MissingTags.Reset();
+	NumCrafts = 0;
+	bBudgetExceeded = false;
+}
+
+// ===============================[ Crafting Planner ]============================
+
+int32 FCraftingPlanner::Build(const FRecipeCatalog& InRecipes)
+{
+	Reset();
+	Recipes = &InRecipes;
+
+	TArray<int32> Order;
+	FindCycles(Order);
+
+	// Producers come first in Order, so the levels of the ingredients are final when a recipe is reached.
+	Levels.Init(0, Recipes->GetNumItems());
+	for (const int32 RecipeId : Order)
+	{
+		int32 Level = 1;
+		for (const FRecipeIngredient& Ingredient : Recipes->GetIngredients(RecipeId))
+		{
+			if (Levels.IsValidIndex(Ingredient.ItemId))
+			{
+				Level = FMath::Max(Level, Levels[Ingredient.ItemId] + 1);
+			}
+		}
+		for (const FRecipeResult& Result : Recipes->GetResults(RecipeId))
+		{
+			Levels[Result.ItemId] = FMath::Max(Levels[Result.ItemId], Level);
+		}
+	}
+
+	UnitCosts.Init(-1.0, Levels.Num());
+	BestRecipes.Init(INDEX_NONE, Levels.Num());
+	return NumCyclicRecipes;
+}
+
+void FCraftingPlanner::Reset()
+{
+	Recipes = nullptr;
+	CyclicRecipes = FDenseBitSet();
+	NumCyclicRecipes = 0;
+	Levels.Reset();
+	UnitCosts.Reset();
+	BestRecipes.Reset();
+}
+
+bool FCraftingPlanner::Plan(const int32 ItemId, const int32 Quantity, const TMap<int32, int32>& Holdings, const FItemCatalog& Items, FCraftingPlan& OutPlan, const int32 NodeBudget) const
+{
+	OutPlan.Reset();
+	if (!Recipes || !Levels.IsValidIndex(ItemId) || Quantity <= 0) return false;
+
+	if (GetBestRecipe(ItemId) == INDEX_NONE)
+	{
+		OutPlan.MissingItems.Add(ItemId, Quantity);
+		return false;
+	}
+
+	TArray<int32> TagCounts;
+	Recipes->CountTags(Holdings, Items, TagCounts);
+	TMap<int32, int32> Choices;
+	int32 Budget = NodeBudget;
+	Expand(ItemId, Quantity, Holdings, TagCounts, Choices, Budget, OutPlan);
+	if (OutPlan.IsComplete() || OutPlan.bBudgetExceeded) return OutPlan.IsComplete();
+
+	// The cheapest producer may need something neither held nor craftable while another one would not. The other
+	// producers of the crafted items are tried from the target down, each item once, the first one leaving less
+	// missing being kept before the steps of the new plan are scanned again.
+	FCraftingPlan Candidate;
+	int64 Missing = CraftingPlanner::CountMissing(OutPlan);
+	TSet<int32> Tried;
+	bool bImproved = true;
+	while (bImproved && Missing > 0 && Budget > 0)
+	{
+		bImproved = false;
+		for (int32 StepIndex = OutPlan.Steps.Num() - 1; StepIndex >= 0 && !bImproved && Budget > 0; --StepIndex)
+		{
+			const FCraftingStep Step = OutPlan.Steps[StepIndex];
+			bool bAlreadyTried = false;
+			Tried.Add(Step.ItemId, &bAlreadyTried);
+			if (bAlreadyTried) continue;
+
+			for (const int32 RecipeId : Recipes->GetRecipesProducing(Step.ItemId))
+			{
+				if (RecipeId == Step.RecipeId || IsCyclic(RecipeId)) continue;
+
+				Choices.Add(Step.ItemId, RecipeId);
+				Expand(ItemId, Quantity, Holdings, TagCounts, Choices, Budget, Candidate);
+				if (Candidate.bBudgetExceeded) break;
+
+				if (const int64 CandidateMissing = CraftingPlanner::CountMissing(Candidate); CandidateMissing < Missing)
+				{
+					Missing = CandidateMissing;
+					Swap(OutPlan, Candidate);
+					bImproved = true;
+					break;
+				}
+			}
+			if (!bImproved)
+			{
+				Choices.Add(Step.ItemId, Step.RecipeId);
+			}
+		}
+	}
+	return OutPlan.IsComplete();
+}
+
+void FCraftingPlanner::Expand(const int32 ItemId, const int32 Quantity, const TMap<int32, int32>& Holdings, TConstArrayView<int32> TagCounts, const TMap<int32, int32>& Choices, int32& Budget, FCraftingPlan& OutPlan) const
+{
+	OutPlan.Reset();
+	TMap<int32, int32> Available = Holdings;
+	TArray<int32> TagsAvailable(TagCounts);
+
+	// Highest level first: every item needing an item has a higher level, so its whole demand is known when it is popped.
+	const auto ByLevel = [this](const int32 A, const int32 B) { return Levels[A] > Levels[B]; };
+	TMap<int32, int32> Needs;
+	TArray<int32> Pending;
+	Needs.Add(ItemId, Quantity);
+	Pending.HeapPush(ItemId, ByLevel);
+
+	while (!Pending.IsEmpty())
+	{
+		int32 Item = INDEX_NONE;
+		Pending.HeapPop(Item, ByLevel, EAllowShrinking::No);
+		if (--Budget < 0)
+		{
+			OutPlan.bBudgetExceeded = true;
+			break;
+		}
+
+		int32 Need = Needs.FindAndRemoveChecked(Item);
+		if (Item != ItemId)
+		{
+			if (int32* Held = Available.Find(Item); Held && *Held > 0)
+			{
+				const int32 Taken = FMath::Min(*Held, Need);
+				*Held -= Taken;
+				Need -= Taken;
+				OutPlan.ConsumedItems.FindOrAdd(Item) += Taken;
+			}
+		}
+		if (Need <= 0) continue;
+
+		const int32* Chosen = Choices.Find(Item);
+		const int32 RecipeId = Chosen ? *Chosen : GetBestRecipe(Item);
+		if (RecipeId == INDEX_NONE)
+		{
+			OutPlan.MissingItems.FindOrAdd(Item) += Need;
+			continue;
+		}
+
+		const int32 Batches = FMath::DivideAndRoundUp(Need, GetYield(RecipeId, Item));
+		OutPlan.Steps.Add({ RecipeId, Batches, Item });
+		OutPlan.NumCrafts += Batches;
+		for (const FRecipeIngredient& Ingredient : Recipes->GetIngredients(RecipeId))
+		{
+			const int32 Required = Ingredient.Quantity * Batches;
+			if (Ingredient.ItemId != INDEX_NONE)
+			{
+				if (int32* Pended = Needs.Find(Ingredient.ItemId))
+				{
+					*Pended += Required;
+				}
+				else
+				{
+					Needs.Add(Ingredient.ItemId, Required);
+					Pending.HeapPush(Ingredient.ItemId, ByLevel);
+				}
+			}
+			else if (TagsAvailable.IsValidIndex(Ingredient.TagSlot))
+			{
+				const int32 Taken = FMath::Min(TagsAvailable[Ingredient.TagSlot], Required);
+				TagsAvailable[Ingredient.TagSlot] -= Taken;
+				if (Taken > 0)
+				{
+					OutPlan.ConsumedTags.FindOrAdd(Ingredient.TagSlot) += Taken;
+				}
+				if (Required > Taken)
+				{
+					OutPlan.MissingTags.FindOrAdd(Ingredient.TagSlot) += Required - Taken;
+				}
+			}
+			else
+			{
+				// Ingredient naming an item missing from the catalog.
+				OutPlan.MissingItems.FindOrAdd(INDEX_NONE) += Required;
+			}
+		}
+	}
+
+	// Steps were found from the target down, by decreasing level.
+	Algo::Reverse(OutPlan.Steps);
+}
+
+int32 FCraftingPlanner::GetBestRecipe(const int32 ItemId) const
+{
+	if (!BestRecipes.IsValidIndex(ItemId)) return INDEX_NONE;
+
+	if (UnitCosts[ItemId] < 0.0)
+	{
+		ComputeUnitCost(ItemId);
+	}
+	return BestRecipes[ItemId];
+}
+
+void FCraftingPlanner::FindCycles(TArray<int32>& OutOrder)
+{
+	// Iterative Tarjan over recipes, a recipe depending on every producer of its item ingredients. Components are
+	// completed dependencies first, which gives the build order of the acyclic recipes for free.
+	struct FFrame
+	{
+		int32 RecipeId = INDEX_NONE;
+		int32 Ingredient = 0;
+		int32 Producer = 0;
+	};
+
+	const int32 NumRecipes = Recipes->Num();
+	CyclicRecipes.Init(NumRecipes, false);
+	TArray<int32> Indices;
+	TArray<int32> LowLinks;
+	TArray<bool> OnStack;
+	Indices.Init(INDEX_NONE, NumRecipes);
+	LowLinks.Init(INDEX_NONE, NumRecipes);
+	OnStack.Init(false, NumRecipes);
+	TArray<int32> Stack;
+	TArray<FFrame> Frames;
+	int32 NextIndex = 0;
+	OutOrder.Reserve(NumRecipes);
+
+	auto Visit = [&](const int32 RecipeId)
+	{
+		Indices[RecipeId] = LowLinks[RecipeId] = NextIndex++;
+		Stack.Add(RecipeId);
+		OnStack[RecipeId] = true;
+		Frames.Add({ RecipeId, 0, 0 });
+	};
+
+	for (int32 Root = 0; Root < NumRecipes; ++Root)
+	{
+		if (Indices[Root] != INDEX_NONE) continue;
+
+		Visit(Root);
+		while (!Frames.IsEmpty())
+		{
+			FFrame& Frame = Frames.Last();
+			const int32 RecipeId = Frame.RecipeId;
+			const TConstArrayView<FRecipeIngredient> Ingredients = Recipes->GetIngredients(RecipeId);
+			int32 Next = INDEX_NONE;
+			while (Next == INDEX_NONE && Frame.Ingredient < Ingredients.Num())
+			{
+				const TConstArrayView<int32> Producers = Recipes->GetRecipesProducing(Ingredients[Frame.Ingredient].ItemId);
+				if (Frame.Producer >= Producers.Num())
+				{
+					++Frame.Ingredient;
+					Frame.Producer = 0;
+					continue;
+				}
+
+				const int32 Producer = Producers[Frame.Producer++];
+				if (Producer == RecipeId)
+				{
+					CyclicRecipes.Set(RecipeId);
+				}
+				else if (Indices[Producer] == INDEX_NONE)
+				{
+					Next = Producer;
+				}
+				else if (OnStack[Producer])
+				{
+					LowLinks[RecipeId] = FMath::Min(LowLinks[RecipeId], Indices[Producer]);
+				}
+			}
+			if (Next != INDEX_NONE)
+			{
+				Visit(Next);
+				continue;
+			}
+
+			Frames.Pop(EAllowShrinking::No);
+			if (!Frames.IsEmpty())
+			{
+				const int32 Parent = Frames.Last().RecipeId;
+				LowLinks[Parent] = FMath::Min(LowLinks[Parent], LowLinks[RecipeId]);
+			}
+			if (LowLinks[RecipeId] != Indices[RecipeId]) continue;
+
+			// RecipeId roots a component: the recipes above it on the stack.
+			int32 First = Stack.Num() - 1;
+			while (Stack[First] != RecipeId)
+			{
+				--First;
+			}
+			const bool bCycle = Stack.Num() - First > 1 || CyclicRecipes.Test(RecipeId);
+			for (int32 Index = First; Index < Stack.Num(); ++Index)
+			{
+				OnStack[Stack[Index]] = false;
+				if (bCycle)
+				{
+					CyclicRecipes.Set(Stack[Index]);
+					UE_LOG(LogTemp, Warning, TEXT("CraftingPlanner: recipe %s is part of a cycle and will not be planned."), *Recipes->GetRowName(Stack[Index]).ToString());
+				}
+			}
+			Stack.SetNum(First, EAllowShrinking::No);
+			if (!bCycle)
+			{
+				OutOrder.Add(RecipeId);
+			}
+		}
+	}
+	NumCyclicRecipes = CyclicRecipes.CountSetBits();
+}
+
+int32 FCraftingPlanner::GetYield(const int32 RecipeId, const int32 ItemId) const
+{
+	for (const FRecipeResult& Result : Recipes->GetResults(RecipeId))
+	{
+		if (Result.ItemId == ItemId) return Result.Quantity;
+	}
+	return 1;
+}
+
+void FCraftingPlanner::ComputeUnitCost(const int32 ItemId) const
+{
+	// Ingredients of acyclic producers have lower levels, so the walk always ends.
+	TArray<int32, TInlineAllocator<32>> Pending;
+	Pending.Add(ItemId);
+	while (!Pending.IsEmpty())
+	{
+		const int32 Item = Pending.Last();
+		if (UnitCosts[Item] >= 0.0)
+		{
+			Pending.Pop(EAllowShrinking::No);
+			continue;
+		}
+
+		bool bReady = true;
+		for (const int32 RecipeId : Recipes->GetRecipesProducing(Item))
+		{
+			if (IsCyclic(RecipeId)) continue;
+
+			for (const FRecipeIngredient& Ingredient : Recipes->GetIngredients(RecipeId))
+			{
+				if (UnitCosts.IsValidIndex(Ingredient.ItemId) && UnitCosts[Ingredient.ItemId] < 0.0)
+				{
+					Pending.Add(Ingredient.ItemId);
+					bReady = false;
+				}
+			}
+		}
+		if (!bReady) continue;
+
+		Pending.Pop(EAllowShrinking::No);
+		double BestCost = 0.0;
+		int32 BestRecipe = INDEX_NONE;
+		for (const int32 RecipeId : Recipes->GetRecipesProducing(Item))
+		{
+			if (IsCyclic(RecipeId)) continue;
+
+			double Cost = 1.0;
+			for (const FRecipeIngredient& Ingredient : Recipes->GetIngredients(RecipeId))
+			{
+				if (UnitCosts.IsValidIndex(Ingredient.ItemId))
+				{
+					Cost += Ingredient.Quantity * UnitCosts[Ingredient.ItemId];
+				}
+			}
+			Cost /= GetYield(RecipeId, Item);
+			if (BestRecipe == INDEX_NONE || Cost < BestCost)
+			{
+				BestCost = Cost;
+				BestRecipe = RecipeId;
+			}
+		}
+		UnitCosts[Item] = BestCost;
+		BestRecipes[Item] = BestRecipe;
+	}
+}
@@ -0,0 +1,98 @@
+﻿#include "Crafting/CraftingPlanner.h"
+#include "Crafting/RecipeCatalog.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemTestTables.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// ===============================[ Crafting Planner Tests ]============================
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCraftingPlannerGraphTest, "Warfall.Crafting.Planner.CyclesAndLevels", ItemTests::Flags)
+
+bool FCraftingPlannerGraphTest::RunTest(const FString& Parameters)
+{
+	ItemTests::FTestTables Tables;
+	for (const TCHAR* RowName : { TEXT("Test_Ore"), TEXT("Test_Scrap"), TEXT("Test_Bar"), TEXT("Test_Blade"), TEXT("Test_Egg"), TEXT("Test_Hen") })
+	{
+		Tables.AddItem(RowName, EItemType::E_Ingredient, 50);
+	}
+	// Ore -> Bar -> Blade, Scrap -> Bar as a second producer, and Egg <-> Hen producing each other.
+	Tables.AddRecipe(TEXT("Test_Smelt"), { FName(TEXT("Test_Ore")) }, TEXT("Test_Bar"));
+	Tables.AddRecipe(TEXT("Test_Forge"), { FName(TEXT("Test_Bar")) }, TEXT("Test_Blade"));
+	Tables.AddRecipe(TEXT("Test_Hatch"), { FName(TEXT("Test_Egg")) }, TEXT("Test_Hen"));
+	Tables.AddRecipe(TEXT("Test_Lay"), { FName(TEXT("Test_Hen")) }, TEXT("Test_Egg"));
+	Tables.AddRecipe(TEXT("Test_Salvage"), { FName(TEXT("Test_Scrap")) }, TEXT("Test_Bar"));
+
+	FItemCatalog Items;
+	Items.Build(Tables.Items);
+	FRecipeCatalog Recipes;
+	Recipes.Build(Tables.Recipes, Items);
+	if (!TestEqual(TEXT("Every recipe is compiled"), Recipes.Num(), 5)) return false;
+
+	const int32 Ore = Items.FindId(TEXT("Test_Ore"));
+	const int32 Scrap = Items.FindId(TEXT("Test_Scrap"));
+	const int32 Bar = Items.FindId(TEXT("Test_Bar"));
+	const int32 Blade = Items.FindId(TEXT("Test_Blade"));
+	const int32 Egg = Items.FindId(TEXT("Test_Egg"));
+	const int32 Hen = Items.FindId(TEXT("Test_Hen"));
+	const int32 Smelt = Recipes.FindId(TEXT("Test_Smelt"));
+	const int32 Forge = Recipes.FindId(TEXT("Test_Forge"));
+	const int32 Salvage = Recipes.FindId(TEXT("Test_Salvage"));
+
+	FCraftingPlanner Planner;
+	TestEqual(TEXT("Both recipes of the loop are set aside"), Planner.Build(Recipes), 2);
+	TestEqual(TEXT("Cyclic recipes are counted"), Planner.NumCyclic(), 2);
+	TestFalse(TEXT("Smelt is not cyclic"), Planner.IsCyclic(Smelt));
+	TestFalse(TEXT("Forge is not cyclic"), Planner.IsCyclic(Forge));
+	TestTrue(TEXT("Hatch is cyclic"), Planner.IsCyclic(Recipes.FindId(TEXT("Test_Hatch"))));
+	TestTrue(TEXT("Lay is cyclic"), Planner.IsCyclic(Recipes.FindId(TEXT("Test_Lay"))));
+
+	TestEqual(TEXT("Raw items are level 0"), Planner.GetLevel(Ore), 0);
+	TestEqual(TEXT("Bar is one level above its ingredient"), Planner.GetLevel(Bar), 1);
+	TestEqual(TEXT("Blade is one level above its ingredient"), Planner.GetLevel(Blade), 2);
+	TestEqual(TEXT("Items only made by cyclic recipes count as raw"), Planner.GetLevel(Hen), 0);
+	TestEqual(TEXT("Best recipe of Blade"), Planner.GetBestRecipe(Blade), Forge);
+	TestEqual(TEXT("Cyclic producers are never chosen"), Planner.GetBestRecipe(Egg), static_cast<int32>(INDEX_NONE));
+
+	// Three blades from ore: every level crafted in order, the ore consumed.
+	FCraftingPlan Plan;
+	TMap<int32, int32> Holdings;
+	Holdings.Add(Ore, 5);
+	TestTrue(TEXT("The blades can be planned"), Planner.Plan(Blade, 3, Holdings, Items, Plan));
+	if (TestEqual(TEXT("Two steps"), Plan.Steps.Num(), 2))
+	{
+		TestEqual(TEXT("Bars are smelted first"), Plan.Steps[0].RecipeId, Smelt);
+		TestEqual(TEXT("Three bars"), Plan.Steps[0].Batches, 3);
+		TestEqual(TEXT("Blades are forged last"), Plan.Steps[1].RecipeId, Forge);
+		TestEqual(TEXT("Three blades"), Plan.Steps[1].Batches, 3);
+	}
+	TestEqual(TEXT("Ore consumed"), Plan.ConsumedItems.FindRef(Ore), 3);
+	TestEqual(TEXT("Batches crafted"), Plan.NumCrafts, 6);
+
+	// Held bars are used before smelting more.
+	Holdings.Add(Bar, 2);
+	TestTrue(TEXT("The blades can be planned with bars held"), Planner.Plan(Blade, 3, Holdings, Items, Plan));
+	TestEqual(TEXT("Bars consumed"), Plan.ConsumedItems.FindRef(Bar), 2);
+	TestEqual(TEXT("Ore consumed for the last bar"), Plan.ConsumedItems.FindRef(Ore), 1);
+
+	// Not enough ore: the shortfall is reported.
+	Holdings.Reset();
+	Holdings.Add(Ore, 1);
+	TestFalse(TEXT("The plan is incomplete"), Planner.Plan(Blade, 3, Holdings, Items, Plan));
+	TestEqual(TEXT("Missing ore"), Plan.MissingItems.FindRef(Ore), 2);
+
+	// Only scrap held: the other producer of the bars is used instead of reporting missing ore.
+	Holdings.Reset();
+	Holdings.Add(Scrap, 3);
+	TestTrue(TEXT("The blades can be planned from scrap"), Planner.Plan(Blade, 3, Holdings, Items, Plan));
+	TestTrue(TEXT("The bars are salvaged"), Plan.Steps.ContainsByPredicate([Salvage](const FCraftingStep& Step) { return Step.RecipeId == Salvage; }));
+	TestEqual(TEXT("Scrap consumed"), Plan.ConsumedItems.FindRef(Scrap), 3);
+
+	// The loop is never entered, even with its ingredient held.
+	Holdings.Reset();
+	Holdings.Add(Egg, 10);
+	TestFalse(TEXT("Items only made by cyclic recipes cannot be planned"), Planner.Plan(Hen, 1, Holdings, Items, Plan));
+	return true;
+}
+
+#endif
@@ -2,3 +2,13 @@
 
 
 #include "Crafting/CraftingTypes.h"
+
+#include "Inventory/ItemCatalog.h"
+
+TConstArrayView<FItemMetaEntry> FRecipeRow::OutMeta(const int32 Index) const
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog || !Results.IsValidIndex(Index)) { return TConstArrayView<FItemMetaEntry>(); }
+
+	return Catalog->GetDetails().GetMetaEntries(Catalog->FindId(Results[Index].Result.ID));
+}
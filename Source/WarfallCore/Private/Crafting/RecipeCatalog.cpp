@@ -0,0 +1,618 @@
+﻿#include "Crafting/RecipeCatalog.h"
+
+#include "Crafting/CraftingTypes.h"
+#include "Engine/DataTable.h"
+#include "Engine/Engine.h"
+#include "Inventory/CookedItemCatalog.h"
+#include "Inventory/ItemCatalog.h"
+#include "Utils/AssetCache.h"
+#include "Utils/Tables.h"
+
+// ===============================[ Recipe Catalog ]============================
+
+namespace RecipeCatalog
+{
+	/** Inverts the item lists of the recipes into recipe lists by item, as one flat array with the start of each item. */
+	template<typename EntryType>
+	void InvertByItem(const int32 NumItems, TConstArrayView<int32> RecipeStarts, TConstArrayView<EntryType> Entries, TArray<int32>& OutStarts, TArray<int32>& OutRecipes)
+	{
+		OutStarts.Init(0, NumItems + 1);
+		for (const EntryType& Entry : Entries)
+		{
+			if (Entry.ItemId != INDEX_NONE)
+			{
+				++OutStarts[Entry.ItemId + 1];
+			}
+		}
+		for (int32 ItemId = 0; ItemId < NumItems; ++ItemId)
+		{
+			OutStarts[ItemId + 1] += OutStarts[ItemId];
+		}
+
+		OutRecipes.SetNumUninitialized(OutStarts.Last());
+		TArray<int32> Cursors(OutStarts.GetData(), NumItems);
+		for (int32 Id = 0; Id + 1 < RecipeStarts.Num(); ++Id)
+		{
+			for (int32 Index = RecipeStarts[Id]; Index < RecipeStarts[Id + 1]; ++Index)
+			{
+				if (Entries[Index].ItemId != INDEX_NONE)
+				{
+					OutRecipes[Cursors[Entries[Index].ItemId]++] = Id;
+				}
+			}
+		}
+	}
+}
+
+void FRecipeCatalog::Build(const UDataTable* InTable, const FItemCatalog& Items)
+{
+	Reset();
+	Revision++;
+
+	if (!InTable) return;
+
+	const UScriptStruct* RowStruct = InTable->GetRowStruct();
+	if (!RowStruct || !RowStruct->IsChildOf(FRecipeRowDetail::StaticStruct()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("RecipeCatalog: '%s' is not a recipes table."), *InTable->GetName());
+		return;
+	}
+
+	Table = InTable;
+	TablePath = FSoftObjectPath(InTable);
+	const TMap<FName, uint8*>& RowMap = InTable->GetRowMap();
+	RowNames.Reserve(RowMap.Num());
+	Rows.Reserve(RowMap.Num());
+	RowIds.Reserve(RowMap.Num());
+	IngredientStarts.Reserve(RowMap.Num() + 1);
+	ResultStarts.Reserve(RowMap.Num() + 1);
+	CraftDurations.Reserve(RowMap.Num());
+
+	// Ingredients are flattened first; the same item or tag listed twice in a recipe counts as one ingredient.
+	for (const TPair<FName, uint8*>& Pair : RowMap)
+	{
+		const FRecipeRowDetail* RowDetail = reinterpret_cast<const FRecipeRowDetail*>(Pair.Value);
+		if (!RowDetail) continue;
+
+		const int32 Id = Rows.Add(&RowDetail->Details);
+		RowNames.Add(Pair.Key);
+		RowIds.Add(Pair.Key, Id);
+		CraftDurations.Add(FMath::Max(RowDetail->Details.CraftDuration, 0.0f));
+		const int32 Start = Ingredients.Num();
+		IngredientStarts.Add(Start);
+
+		for (const FItemIngredient& Source : RowDetail->Details.Ingredients)
+		{
+			FRecipeIngredient Ingredient;
+			Ingredient.Quantity = FMath::Max(Source.Quantity, 1);
+			if (Source.IngredientsType.IsValid())
+			{
+				int32* Slot = TagSlots.Find(Source.IngredientsType);
+				if (!Slot)
+				{
+					Slot = &TagSlots.Add(Source.IngredientsType, IngredientTags.Add(Source.IngredientsType));
+				}
+				Ingredient.TagSlot = *Slot;
+			}
+			else
+			{
+				Ingredient.ItemId = Items.FindId(Source.Ingredient.ID);
+				UE_CLOG(Ingredient.ItemId == INDEX_NONE, LogTemp, Warning, TEXT("RecipeCatalog: recipe %s needs unknown item %s."), *Pair.Key.ToString(), *Source.Ingredient.ID.ToString());
+			}
+
+			FRecipeIngredient* Existing = Ingredients.GetData() + Start;
+			FRecipeIngredient* End = Ingredients.GetData() + Ingredients.Num();
+			while (Existing != End && (Existing->ItemId != Ingredient.ItemId || Existing->TagSlot != Ingredient.TagSlot))
+			{
+				++Existing;
+			}
+			if (Existing != End)
+			{
+				Existing->Quantity += Ingredient.Quantity;
+				continue;
+			}
+
+			Ingredients.Add(Ingredient);
+		}
+
+		const int32 ResultStart = Results.Num();
+		ResultStarts.Add(ResultStart);
+		for (const FItemResult& Source : RowDetail->Details.Results)
+		{
+			const int32 ItemId = Items.FindId(Source.Result.ID);
+			if (ItemId == INDEX_NONE)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("RecipeCatalog: recipe %s produces unknown item %s."), *Pair.Key.ToString(), *Source.Result.ID.ToString());
+				continue;
+			}
+
+			FRecipeResult* Existing = Results.GetData() + ResultStart;
+			FRecipeResult* End = Results.GetData() + Results.Num();
+			while (Existing != End && Existing->ItemId != ItemId)
+			{
+				++Existing;
+			}
+			if (Existing != End)
+			{
+				Existing->Quantity += FMath::Max(Source.Quantity, 1);
+				continue;
+			}
+			Results.Add({ ItemId, FMath::Max(Source.Quantity, 1) });
+		}
+	}
+	IngredientStarts.Add(Ingredients.Num());
+	ResultStarts.Add(Results.Num());
+
+	NumRecipes = Rows.Num();
+	IngredientStartData = IngredientStarts.GetData();
+	IngredientData = Ingredients.GetData();
+	ResultStartData = ResultStarts.GetData();
+	ResultData = Results.GetData();
+	CraftDurationData = CraftDurations.GetData();
+	BuildIndexes(Items);
+}
+
+bool FRecipeCatalog::BuildFromCooked(const FCookedItemCatalog& Cooked, const FItemCatalog& Items, const FSoftObjectPath& InTablePath)
+{
+	Reset();
+	Revision++;
+
+	if (!Cooked.IsOpen() || !Cooked.HasRecipes()) return false;
+
+	TablePath = InTablePath;
+
+	const FCookedRecipesHeader& Header = Cooked.GetRecipesHeader();
+	NumRecipes = Header.NumRecipes;
+	RowNames.Reserve(NumRecipes);
+	RowIds.Reserve(NumRecipes);
+	for (int32 Id = 0; Id < NumRecipes; ++Id)
+	{
+		const FName RowName = Cooked.GetRecipeName(Id);
+		RowNames.Add(RowName);
+		RowIds.Add(RowName, Id);
+	}
+
+	IngredientTags.Reserve(Header.NumIngredientTags);
+	for (int32 Slot = 0; Slot < Header.NumIngredientTags; ++Slot)
+	{
+		const FGameplayTag Tag = FGameplayTag::RequestGameplayTag(Cooked.GetIngredientTagName(Slot), false);
+		IngredientTags.Add(Tag);
+		if (Tag.IsValid())
+		{
+			TagSlots.Add(Tag, Slot);
+		}
+	}
+
+	IngredientStartData = Cooked.GetIngredientStarts();
+	IngredientData = Cooked.GetIngredients();
+	ResultStartData = Cooked.GetResultStarts();
+	ResultData = Cooked.GetResults();
+	CraftDurationData = Cooked.GetCraftDurations();
+	BuildIndexes(Items);
+	return true;
+}
+
+void FRecipeCatalog::BuildIndexes(const FItemCatalog& Items)
+{
+	TagRecipes.SetNum(IngredientTags.Num());
+	const TConstArrayView<FRecipeIngredient> AllIngredients = GetRawIngredients();
+	for (int32 Id = 0; Id < NumRecipes; ++Id)
+	{
+		for (const FRecipeIngredient& Ingredient : GetIngredients(Id))
+		{
+			if (TagRecipes.IsValidIndex(Ingredient.TagSlot))
+			{
+				TagRecipes[Ingredient.TagSlot].Add(Id);
+			}
+		}
+	}
+
+	// Meta entries of every item produced, copied once into one pool that every result of the item points to.
+	// They come from the detail columns, so that neither mode reads the items table.
+	const TConstArrayView<FRecipeResult> AllResults = GetRawResults();
+	const FItemDetailColumns& Details = Items.GetDetails();
+	TMap<int32, TPair<int32, int32>> ItemMetaSpans;
+	ResultMetaSpans.Reserve(AllResults.Num());
+	for (const FRecipeResult& Result : AllResults)
+	{
+		if (const TPair<int32, int32>* Span = ItemMetaSpans.Find(Result.ItemId))
+		{
+			ResultMetaSpans.Add(*Span);
+			continue;
+		}
+
+		const TConstArrayView<FItemMetaEntry> Meta = Details.GetMetaEntries(Result.ItemId);
+		const TPair<int32, int32> Span(ResultMeta.Num(), Meta.Num());
+		ResultMeta.Append(Meta);
+		ItemMetaSpans.Add(Result.ItemId, Span);
+		ResultMetaSpans.Add(Span);
+	}
+
+	RecipeCatalog::InvertByItem<FRecipeIngredient>(Items.Num(), GetRawIngredientStarts(), AllIngredients, ItemRecipeStarts, ItemRecipes);
+	RecipeCatalog::InvertByItem<FRecipeResult>(Items.Num(), GetRawResultStarts(), AllResults, ProducerStarts, ProducerRecipes);
+}
+
+bool FRecipeCatalog::PatchItems(TConstArrayView<int32> ItemIds, const FItemCatalog& Items)
+{
+	check(!IsExternal());
+
+	TSet<int32> RemovedItems;
+	for (const int32 ItemId : ItemIds)
+	{
+		if (Items.FindRow(ItemId))
+		{
+			RefreshResultMeta(ItemId, Items.GetDetails().GetMetaEntries(ItemId));
+			continue;
+		}
+
+		// A removed row: ingredients naming it become unknown, as Build leaves the items it cannot find.
+		for (const int32 RecipeId : GetRecipesUsingItem(ItemId))
+		{
+			for (int32 Index = IngredientStarts[RecipeId]; Index < IngredientStarts[RecipeId + 1]; ++Index)
+			{
+				if (Ingredients[Index].ItemId == ItemId)
+				{
+					Ingredients[Index].ItemId = INDEX_NONE;
+					UE_LOG(LogTemp, Warning, TEXT("RecipeCatalog: recipe %s needs removed item %s."), *GetRowName(RecipeId).ToString(), *Items.GetRowName(ItemId).ToString());
+				}
+			}
+		}
+		if (!GetRecipesUsingItem(ItemId).IsEmpty() || !GetRecipesProducing(ItemId).IsEmpty())
+		{
+			RemovedItems.Add(ItemId);
+		}
+	}
+	if (RemovedItems.IsEmpty()) return false;
+
+	// Results of removed items are left out in one compaction pass, which shifts the starts of the following recipes.
+	int32 Read = 0;
+	int32 Write = 0;
+	for (int32 Id = 0; Id < NumRecipes; ++Id)
+	{
+		const int32 End = ResultStarts[Id + 1];
+		ResultStarts[Id] = Write;
+		for (; Read < End; ++Read)
+		{
+			if (RemovedItems.Contains(Results[Read].ItemId)) continue;
+
+			Results[Write] = Results[Read];
+			ResultMetaSpans[Write] = ResultMetaSpans[Read];
+			++Write;
+		}
+	}
+	ResultStarts[NumRecipes] = Write;
+	Results.SetNum(Write, EAllowShrinking::No);
+	ResultMetaSpans.SetNum(Write, EAllowShrinking::No);
+	ResultData = Results.GetData();
+
+	const int32 NumItems = GetNumItems();
+	RecipeCatalog::InvertByItem<FRecipeIngredient>(NumItems, IngredientStarts, Ingredients, ItemRecipeStarts, ItemRecipes);
+	RecipeCatalog::InvertByItem<FRecipeResult>(NumItems, ResultStarts, Results, ProducerStarts, ProducerRecipes);
+	return true;
+}
+
+void FRecipeCatalog::RefreshResultMeta(const int32 ItemId, TConstArrayView<FItemMetaEntry> Meta)
+{
+	// Every result of an item shares one span: it is rewritten in place when the entries still fit, appended
+	// otherwise, the old entries staying unused until the next build.
+	TPair<int32, int32> NewSpan(INDEX_NONE, Meta.Num());
+	for (const int32 RecipeId : GetRecipesProducing(ItemId))
+	{
+		for (int32 Index = ResultStarts[RecipeId]; Index < ResultStarts[RecipeId + 1]; ++Index)
+		{
+			if (Results[Index].ItemId != ItemId) continue;
+
+			TPair<int32, int32>& Span = ResultMetaSpans[Index];
+			if (NewSpan.Key == INDEX_NONE)
+			{
+				NewSpan.Key = Meta.Num() <= Span.Value ? Span.Key : ResultMeta.Num();
+				if (NewSpan.Key == ResultMeta.Num())
+				{
+					ResultMeta.Append(Meta);
+				}
+				else
+				{
+					for (int32 Entry = 0; Entry < Meta.Num(); ++Entry)
+					{
+						ResultMeta[NewSpan.Key + Entry] = Meta[Entry];
+					}
+				}
+			}
+			Span = NewSpan;
+		}
+	}
+}
+
+void FRecipeCatalog::Reset()
+{
+	Table = nullptr;
+	TablePath.Reset();
+	RowNames.Reset();
+	Rows.Reset();
+	RowIds.Reset();
+	IngredientStarts.Reset();
+	Ingredients.Reset();
+	ItemRecipeStarts.Reset();
+	ItemRecipes.Reset();
+	ResultStarts.Reset();
+	Results.Reset();
+	CraftDurations.Reset();
+	IngredientStartData = nullptr;
+	IngredientData = nullptr;
+	ResultStartData = nullptr;
+	ResultData = nullptr;
+	CraftDurationData = nullptr;
+	NumRecipes = 0;
+	ResultMetaSpans.Reset();
+	ResultMeta.Reset();
+	ProducerStarts.Reset();
+	ProducerRecipes.Reset();
+	IngredientTags.Reset();
+	TagSlots.Reset();
+	TagRecipes.Reset();
+}
+
+int32 FRecipeCatalog::FindId(const FDataTableRowHandle& Recipe) const
+{
+	// Cooked catalogs never load their table: handles on it are matched through its path, or by row name without one.
+	if (Recipe.DataTable && Recipe.DataTable != Table && (Table || (TablePath.IsValid() && FSoftObjectPath(Recipe.DataTable) != TablePath))) return INDEX_NONE;
+
+	return FindId(Recipe.RowName);
+}
+
+FDataTableRowHandle FRecipeCatalog::MakeHandle(const int32 Id) const
+{
+	FDataTableRowHandle Handle;
+	Handle.DataTable = GetTable();
+	Handle.RowName = GetRowName(Id);
+	return Handle;
+}
+
+const UDataTable* FRecipeCatalog::GetTable() const
+{
+	return Table ? Table : Cast<UDataTable>(TablePath.ResolveObject());
+}
+
+TConstArrayView<int32> FRecipeCatalog::GetRecipesUsingItem(const int32 ItemId) const
+{
+	if (ItemId < 0 || ItemId + 1 >= ItemRecipeStarts.Num()) return TConstArrayView<int32>();
+
+	const int32 Start = ItemRecipeStarts[ItemId];
+	return TConstArrayView<int32>(ItemRecipes.GetData() + Start, ItemRecipeStarts[ItemId + 1] - Start);
+}
+
+TConstArrayView<int32> FRecipeCatalog::GetRecipesProducing(const int32 ItemId) const
+{
+	if (ItemId < 0 || ItemId + 1 >= ProducerStarts.Num()) return TConstArrayView<int32>();
+
+	const int32 Start = ProducerStarts[ItemId];
+	return TConstArrayView<int32>(ProducerRecipes.GetData() + Start, ProducerStarts[ItemId + 1] - Start);
+}
+
+TConstArrayView<int32> FRecipeCatalog::GetRecipesUsingTag(const FGameplayTag& Tag) const
+{
+	const int32* Slot = TagSlots.Find(Tag);
+	return Slot ? TConstArrayView<int32>(TagRecipes[*Slot]) : TConstArrayView<int32>();
+}
+
+void FRecipeCatalog::FindCraftable(const TMap<int32, int32>& Holdings, const FItemCatalog& Items, TArray<FCraftableRecipe>& OutCraftable) const
+{
+	OutCraftable.Reset();
+
+	TArray<int32> TagCounts;
+	CountTags(Holdings, Items, TagCounts);
+
+	// Only the recipes using something held can be craftable.
+	TArray<int32> Candidates;
+	for (const TPair<int32, int32>& Held : Holdings)
+	{
+		if (Held.Value > 0)
+		{
+			Candidates.Append(GetRecipesUsingItem(Held.Key));
+		}
+	}
+	for (int32 Slot = 0; Slot < TagCounts.Num(); ++Slot)
+	{
+		if (TagCounts[Slot] > 0)
+		{
+			Candidates.Append(TagRecipes[Slot]);
+		}
+	}
+	Candidates.Sort();
+
+	int32 Previous = INDEX_NONE;
+	for (const int32 RecipeId : Candidates)
+	{
+		if (RecipeId == Previous) continue;
+		Previous = RecipeId;
+
+		if (const int32 Batches = ComputeBatches(RecipeId, Holdings, TagCounts); Batches > 0)
+		{
+			OutCraftable.Add({ RecipeId, Batches });
+		}
+	}
+}
+
+int32 FRecipeCatalog::GetMaxBatches(const int32 RecipeId, const TMap<int32, int32>& Holdings, const FItemCatalog& Items) const
+{
+	if (!IsValidId(RecipeId)) return 0;
+
+	TArray<int32> TagCounts;
+	CountTags(Holdings, Items, TagCounts);
+	return ComputeBatches(RecipeId, Holdings, TagCounts);
+}
+
+void FRecipeCatalog::CountTags(const TMap<int32, int32>& Holdings, const FItemCatalog& Items, TArray<int32>& OutTagCounts) const
+{
+	OutTagCounts.Init(0, IngredientTags.Num());
+	if (IngredientTags.IsEmpty()) return;
+
+	// Ingredient tags are few: each held item is tested against every one of them, a bit test each.
+	const FItemTagIndex& TagIndex = Items.GetTagIndex();
+	for (const TPair<int32, int32>& Held : Holdings)
+	{
+		if (Held.Value <= 0 || !Items.IsValidId(Held.Key)) continue;
+
+		for (int32 Slot = 0; Slot < IngredientTags.Num(); ++Slot)
+		{
+			if (TagIndex.HasTag(IngredientTags[Slot], Held.Key))
+			{
+				OutTagCounts[Slot] += Held.Value;
+			}
+		}
+	}
+}
+
+int32 FRecipeCatalog::ComputeBatches(const int32 RecipeId, const TMap<int32, int32>& Holdings, TConstArrayView<int32> TagCounts) const
+{
+	const TConstArrayView<FRecipeIngredient> RecipeIngredients = GetIngredients(RecipeId);
+	if (RecipeIngredients.IsEmpty()) return 0;
+
+	int32 Batches = MAX_int32;
+	for (const FRecipeIngredient& Ingredient : RecipeIngredients)
+	{
+		int32 Held = 0;
+		if (Ingredient.ItemId != INDEX_NONE)
+		{
+			const int32* Count = Holdings.Find(Ingredient.ItemId);
+			Held = Count ? *Count : 0;
+		}
+		else if (TagCounts.IsValidIndex(Ingredient.TagSlot))
+		{
+			Held = TagCounts[Ingredient.TagSlot];
+		}
+
+		Batches = FMath::Min(Batches, Held / Ingredient.Quantity);
+		if (Batches <= 0) return 0;
+	}
+	return Batches;
+}
+
+// ===============================[ Recipe Catalog Subsystem ]============================
+
+void URecipeCatalogSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency<UAssetCacheSubsystem>();
+	Collection.InitializeDependency<UItemCatalogSubsystem>();
+
+	// Ingredients are item ids: a rebuilt item catalog reassigns them, patched rows may add the missing ones.
+	if (UItemCatalogSubsystem* Items = UItemCatalogSubsystem::Get())
+	{
+		ItemsRebuiltHandle = Items->OnCatalogRebuilt.AddUObject(this, &URecipeCatalogSubsystem::Rebuild);
+		ItemsPatchedHandle = Items->OnRowsPatched.AddUObject(this, &URecipeCatalogSubsystem::HandleItemRowsPatched);
+
+		// A cooked item catalog carries the recipes compiled against it: the table is never loaded then.
+		if (Items->IsCooked() && Items->GetCookedCatalog().HasRecipes())
+		{
+			Rebuild();
+			return;
+		}
+	}
+
+	BindTable(UTables::GetTable(ETablePath::RecipesTable));
+	Rebuild();
+
+	// Recipes are resolved against the item ids, so the cooked file is written once both catalogs are compiled.
+	if (IsRunningCookCommandlet())
+	{
+		if (const UItemCatalogSubsystem* Items = UItemCatalogSubsystem::Get(); Items && !Items->IsCooked())
+		{
+			FCookedItemCatalog::Write(Items->GetItems(), &Catalog, FCookedItemCatalog::GetDefaultPath());
+		}
+	}
+}
+
+void URecipeCatalogSubsystem::Deinitialize()
+{
+	if (UItemCatalogSubsystem* Items = UItemCatalogSubsystem::Get())
+	{
+		Items->OnCatalogRebuilt.Remove(ItemsRebuiltHandle);
+		Items->OnRowsPatched.Remove(ItemsPatchedHandle);
+	}
+	ItemsRebuiltHandle.Reset();
+	ItemsPatchedHandle.Reset();
+
+	BindTable(nullptr);
+	Planner.Reset();
+	Catalog.Reset();
+	Super::Deinitialize();
+}
+
+URecipeCatalogSubsystem* URecipeCatalogSubsystem::Get()
+{
+	return GEngine ? GEngine->GetEngineSubsystem<URecipeCatalogSubsystem>() : nullptr;
+}
+
+const FRecipeCatalog* URecipeCatalogSubsystem::GetCatalog()
+{
+	const URecipeCatalogSubsystem* Subsystem = Get();
+	if (!Subsystem || Subsystem->Catalog.IsEmpty()) return nullptr;
+	return &Subsystem->Catalog;
+}
+
+void URecipeCatalogSubsystem::Rebuild()
+{
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	if (!Items)
+	{
+		Planner.Reset();
+		Catalog.Reset();
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const UItemCatalogSubsystem* ItemSubsystem = UItemCatalogSubsystem::Get();
+	if (!RecipesTable && ItemSubsystem && ItemSubsystem->IsCooked())
+	{
+		const FSoftObjectPath* TablePath = UTables::FindTablePath(ETablePath::RecipesTable);
+		Catalog.BuildFromCooked(ItemSubsystem->GetCookedCatalog(), *Items, TablePath ? *TablePath : FSoftObjectPath());
+	}
+	else
+	{
+		Catalog.Build(RecipesTable, *Items);
+	}
+	const int32 NumCyclic = Planner.Build(Catalog);
+	UE_LOG(LogTemp, Log, TEXT("RecipeCatalog: %d recipes compiled in %.2f ms, %d set aside by cycles."), Catalog.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0, NumCyclic);
+
+	OnRecipesRebuilt.Broadcast();
+}
+
+void URecipeCatalogSubsystem::BindTable(UDataTable* NewTable)
+{
+	if (RecipesTable && TableChangedHandle.IsValid())
+	{
+		RecipesTable->OnDataTableChanged().Remove(TableChangedHandle);
+	}
+	TableChangedHandle.Reset();
+
+	RecipesTable = NewTable;
+	if (RecipesTable)
+	{
+		TableChangedHandle = RecipesTable->OnDataTableChanged().AddUObject(this, &URecipeCatalogSubsystem::Rebuild);
+	}
+}
+
+void URecipeCatalogSubsystem::HandleItemRowsPatched(TConstArrayView<int32> Ids)
+{
+	// Patches keep every id, but added rows extend the id range and may resolve ingredients reported as unknown:
+	// only they need a full build.
+	const FItemCatalog* Items = UItemCatalogSubsystem::GetCatalog();
+	if (!Items || Catalog.IsEmpty() || Catalog.IsExternal() || Items->Num() != Catalog.GetNumItems())
+	{
+		Rebuild();
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	if (!Catalog.PatchItems(Ids, *Items))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("RecipeCatalog: %d item rows patched in %.3f ms."), Ids.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		return;
+	}
+
+	// Removed items changed ingredients or results: the planner costs and the craftable sets are stale.
+	const int32 NumCyclic = Planner.Build(Catalog);
+	UE_LOG(LogTemp, Verbose, TEXT("RecipeCatalog: %d item rows patched in %.3f ms, %d recipes set aside by cycles."), Ids.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0, NumCyclic);
+	OnRecipesRebuilt.Broadcast();
+}
@@ -0,0 +1,78 @@
+﻿#include "Crafting/RecipeCatalog.h"
+#include "HAL/FileManager.h"
+#include "Inventory/CookedItemCatalog.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemTestTables.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// ===============================[ Recipe Catalog Tests ]============================
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRecipeCatalogCookedHandlesTest, "Warfall.Crafting.Recipes.CookedHandles", ItemTests::Flags)
+
+bool FRecipeCatalogCookedHandlesTest::RunTest(const FString& Parameters)
+{
+	ItemTests::FTestTables Tables;
+	for (const TCHAR* RowName : { TEXT("Test_Ore"), TEXT("Test_Bar"), TEXT("Test_Blade") })
+	{
+		Tables.AddItem(RowName, EItemType::E_Ingredient, 50);
+	}
+	Tables.AddRecipe(TEXT("Test_Smelt"), { FName(TEXT("Test_Ore")) }, TEXT("Test_Bar"));
+	Tables.AddRecipe(TEXT("Test_Forge"), { FName(TEXT("Test_Bar")) }, TEXT("Test_Blade"));
+	FItemCatalog Items;
+	Items.Build(Tables.Items);
+	FRecipeCatalog Recipes;
+	Recipes.Build(Tables.Recipes, Items);
+	if (!TestEqual(TEXT("Every recipe is compiled"), Recipes.Num(), 2)) return false;
+
+	auto MakeRowHandle = [](const UDataTable* Table, const FName RowName)
+	{
+		FDataTableRowHandle Handle;
+		Handle.DataTable = Table;
+		Handle.RowName = RowName;
+		return Handle;
+	};
+	const int32 Smelt = Recipes.FindId(TEXT("Test_Smelt"));
+	TestEqual(TEXT("Handles on the compiled table resolve"), Recipes.FindId(MakeRowHandle(Tables.Recipes, TEXT("Test_Smelt"))), Smelt);
+	TestTrue(TEXT("Handles of the compiled catalog point at its table"), Recipes.MakeHandle(Smelt).DataTable == Tables.Recipes);
+
+	// The same recipes, as a packaged build binds them on the cooked file.
+	const FString Path = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("RecipeCatalogTests.wfic"));
+	if (!TestTrue(TEXT("The cooked file is written"), FCookedItemCatalog::Write(Items, &Recipes, Path))) return false;
+	{
+		FCookedItemCatalog Cooked;
+		if (!TestTrue(TEXT("The cooked file opens"), Cooked.Open(Path))) return false;
+		FItemCatalog CookedItems;
+		FRecipeCatalog CookedRecipes;
+		if (!TestTrue(TEXT("The items are bound on the file"), CookedItems.BuildFromCooked(Cooked))) return false;
+		if (!TestTrue(TEXT("The recipes are bound on the file"), CookedRecipes.BuildFromCooked(Cooked, CookedItems, FSoftObjectPath(Tables.Recipes)))) return false;
+		TestNull(TEXT("The cooked catalog holds no row"), CookedRecipes.FindRow(Smelt));
+		TestTrue(TEXT("The table is found through its path"), CookedRecipes.GetTable() == Tables.Recipes);
+
+		for (int32 Id = 0; Id < CookedRecipes.Num(); ++Id)
+		{
+			const FDataTableRowHandle Handle = CookedRecipes.MakeHandle(Id);
+			TestTrue(TEXT("Cooked handles point at the table"), Handle.DataTable == Tables.Recipes);
+			TestEqual(TEXT("Cooked handles name the row"), Handle.RowName, Recipes.GetRowName(Id));
+			TestEqual(TEXT("Cooked handles resolve back"), CookedRecipes.FindId(Handle), Id);
+			TestEqual(TEXT("Handles learned before cooking resolve"), CookedRecipes.FindId(Recipes.MakeHandle(Id)), Id);
+		}
+		TestEqual(TEXT("Handles without table match by row name"), CookedRecipes.FindId(MakeRowHandle(nullptr, TEXT("Test_Forge"))), Recipes.FindId(TEXT("Test_Forge")));
+		TestEqual(TEXT("Unknown rows are rejected"), CookedRecipes.FindId(MakeRowHandle(Tables.Recipes, TEXT("Test_Missing"))), static_cast<int32>(INDEX_NONE));
+
+		ItemTests::FTestTables Other;
+		Other.AddRecipe(TEXT("Test_Smelt"), { FName(TEXT("Test_Ore")) }, TEXT("Test_Bar"));
+		TestEqual(TEXT("Rows of another table are rejected"), CookedRecipes.FindId(MakeRowHandle(Other.Recipes, TEXT("Test_Smelt"))), static_cast<int32>(INDEX_NONE));
+
+		// Without the path of its table, a cooked catalog can only match by row name.
+		FRecipeCatalog Unnamed;
+		Unnamed.BuildFromCooked(Cooked, CookedItems);
+		TestEqual(TEXT("Handles match by row name without a table path"), Unnamed.FindId(MakeRowHandle(Tables.Recipes, TEXT("Test_Smelt"))), Smelt);
+		TestNull(TEXT("Handles have no table without a table path"), Unnamed.MakeHandle(Smelt).DataTable.Get());
+	}
+	IFileManager::Get().Delete(*Path);
+	return true;
+}
+
+#endif
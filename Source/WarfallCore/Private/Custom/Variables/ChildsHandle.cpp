@@ -1,4 +1,5 @@
 ﻿#include "Custom/Variables/ChildsHandle.h"
+#include "Inventory/ItemCatalog.h"
 #include "Inventory/ItemRowTypes.h"
 #include "Utils/Tables.h"
 
@@ -9,6 +10,21 @@
 bool FCustomItemRowHandle::GetFilterConditions(const FName RowName, const FName HandleTag) const
 {
 	const bool bFilterByTag = HandleTag != NAME_None;
+	if (const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog(); Catalog && Catalog->GetTable() == DataTable)
+	{
+		const FItemId Id = Catalog->FindId(RowName);
+		if (Id == INDEX_NONE) return false;
+		if (!bFilterByTag) return true;
+
+		if (CachedTag != HandleTag || CachedRevision != Catalog->GetRevision())
+		{
+			Catalog->GetTagIndex().QueryNameContains(HandleTag.ToString(), CachedMatches);
+			CachedTag = HandleTag;
+			CachedRevision = Catalog->GetRevision();
+		}
+		return CachedMatches.IsValidIndex(Id) && CachedMatches.Test(Id);
+	}
+
 	if (const FItemRowDetail* Row = DataTable->FindRow<FItemRowDetail>(RowName, TEXT("")))
 	{
 		if (!bFilterByTag)
@@ -0,0 +1,304 @@
+﻿#include "Inventory/ContainerSearchIndex.h"
+
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemInstanceStore.h"
+#include "Inventory/ItemTagIndex.h"
+
+// ===============================[ Container Search Index ]============================
+
+bool FContainerSearchIndex::Insert(const FItemHandle Handle, const int32 ItemId, const FItemCatalog& Catalog)
+{
+	if (!Handle.IsValid() || Slots.Contains(Handle) || !Catalog.IsValidId(ItemId)) return false;
+
+	const int32 Slot = FreeSlots.IsEmpty() ? Entries.AddDefaulted() : FreeSlots.Pop(EAllowShrinking::No);
+	Entries[Slot].Handle = Handle;
+	Entries[Slot].ItemId = ItemId;
+	Slots.Add(Handle, Slot);
+
+	FItemKeys& Keys = ItemKeys.FindOrAdd(ItemId);
+	if (Keys.NumInstances++ == 0)
+	{
+		BuildKeys(Catalog, ItemId, Keys);
+	}
+	SetBit(Live, Slot, true);
+	ApplyKeys(Keys, Slot, true);
+	++Revision;
+	return true;
+}
+
+bool FContainerSearchIndex::Remove(const FItemHandle Handle)
+{
+	int32 Slot = INDEX_NONE;
+	if (!Slots.RemoveAndCopyValue(Handle, Slot)) return false;
+
+	FEntry& Entry = Entries[Slot];
+	if (FItemKeys* Keys = ItemKeys.Find(Entry.ItemId))
+	{
+		ApplyKeys(*Keys, Slot, false);
+		if (--Keys->NumInstances == 0)
+		{
+			ItemKeys.Remove(Entry.ItemId);
+		}
+	}
+	SetBit(Live, Slot, false);
+	Entry = FEntry();
+	FreeSlots.Add(Slot);
+	++Revision;
+	return true;
+}
+
+bool FContainerSearchIndex::Update(const FItemHandle Handle, const int32 ItemId, const FItemCatalog& Catalog)
+{
+	const int32* Slot = Slots.Find(Handle);
+	if (Slot && Entries[*Slot].ItemId == ItemId) return true;
+
+	Remove(Handle);
+	return Insert(Handle, ItemId, Catalog);
+}
+
+void FContainerSearchIndex::Reset()
+{
+	Entries.Reset();
+	FreeSlots.Reset();
+	Slots.Reset();
+	ItemKeys.Reset();
+	Live = FDenseBitSet();
+	for (FDenseBitSet& Postings : CapabilityPostings)
+	{
+		Postings = FDenseBitSet();
+	}
+	TagPostings.Reset();
+	QualityPostings.Reset();
+	TokenPostings.Reset();
+	++Revision;
+}
+
+void FContainerSearchIndex::Select(const FContainerSearchQuery& Query, FDenseBitSet& OutSlots) const
+{
+	OutSlots = Live;
+	for (uint32 Bits = static_cast<uint32>(Query.Capabilities); Bits; Bits &= Bits - 1)
+	{
+		OutSlots.And(CapabilityPostings[FMath::CountTrailingZeros(Bits)]);
+	}
+
+	for (const FGameplayTag& Tag : Query.Tags)
+	{
+		const FDenseBitSet* Postings = TagPostings.Find(Tag);
+		if (!Postings)
+		{
+			OutSlots.ClearAll();
+			return;
+		}
+		OutSlots.And(*Postings);
+	}
+
+	if (Query.MinQuality > MIN_int32 || Query.MaxQuality < MAX_int32)
+	{
+		FDenseBitSet InRange(OutSlots.Num());
+		for (const TPair<int32, FDenseBitSet>& Postings : QualityPostings)
+		{
+			if (Postings.Key >= Query.MinQuality && Postings.Key <= Query.MaxQuality)
+			{
+				InRange.Or(Postings.Value);
+			}
+		}
+		OutSlots.And(InRange);
+	}
+
+	if (!Query.Text.IsEmpty())
+	{
+		// Each word matches the names having a word starting with it; the distinct words of a container are few.
+		TArray<FString> Words;
+		Tokenize(Query.Text, Words);
+		FDenseBitSet Matches;
+		for (const FString& Word : Words)
+		{
+			Matches.Init(OutSlots.Num(), false);
+			for (const TPair<FString, FDenseBitSet>& Postings : TokenPostings)
+			{
+				if (Postings.Key.StartsWith(Word, ESearchCase::CaseSensitive))
+				{
+					Matches.Or(Postings.Value);
+				}
+			}
+			OutSlots.And(Matches);
+		}
+	}
+}
+
+void FContainerSearchIndex::Search(const FContainerSearchQuery& Query, const FItemInstanceStore& Store, const EContainerSortKey SortKey, const bool bDescending, TArray<FItemHandle>& OutResults) const
+{
+	FDenseBitSet Matches;
+	Select(Query, Matches);
+
+	struct FResult
+	{
+		const FItemKeys* Keys = nullptr;
+		int32 Slot = INDEX_NONE;
+		int32 Stack = 0;
+	};
+	TArray<FResult> Results;
+	Results.Reserve(Matches.CountSetBits());
+	Matches.ForEachSetBit([&](const int32 Slot)
+	{
+		const FEntry& Entry = Entries[Slot];
+		FResult& Result = Results.AddDefaulted_GetRef();
+		Result.Keys = &ItemKeys.FindChecked(Entry.ItemId);
+		Result.Slot = Slot;
+		Result.Stack = Store.IsValid(Entry.Handle) ? Store.GetStack(Entry.Handle) : 0;
+	});
+
+	// Ties keep the slot order, so that pages stay stable between refreshes.
+	auto Compare = [SortKey](const FResult& A, const FResult& B) -> int32
+	{
+		switch (SortKey)
+		{
+		case EContainerSortKey::Name:
+			if (const int32 Order = A.Keys->SortName.Compare(B.Keys->SortName, ESearchCase::CaseSensitive)) return Order;
+			break;
+		case EContainerSortKey::Quality:
+			if (A.Keys->Quality != B.Keys->Quality) return A.Keys->Quality < B.Keys->Quality ? -1 : 1;
+			break;
+		case EContainerSortKey::Stack:
+			if (A.Stack != B.Stack) return A.Stack < B.Stack ? -1 : 1;
+			break;
+		default:
+			break;
+		}
+		return A.Slot - B.Slot;
+	};
+	if (SortKey != EContainerSortKey::None || bDescending)
+	{
+		Results.Sort([&Compare, bDescending](const FResult& A, const FResult& B)
+		{
+			return bDescending ? Compare(B, A) < 0 : Compare(A, B) < 0;
+		});
+	}
+
+	OutResults.Reset(Results.Num());
+	for (const FResult& Result : Results)
+	{
+		OutResults.Add(Entries[Result.Slot].Handle);
+	}
+}
+
+void FContainerSearchIndex::Tokenize(const FString& Text, TArray<FString>& OutTokens)
+{
+	FString Token;
+	for (const TCHAR Char : Text)
+	{
+		if (FChar::IsAlnum(Char))
+		{
+			Token.AppendChar(FChar::ToLower(Char));
+		}
+		else if (!Token.IsEmpty())
+		{
+			OutTokens.AddUnique(Token);
+			Token.Reset();
+		}
+	}
+	if (!Token.IsEmpty())
+	{
+		OutTokens.AddUnique(Token);
+	}
+}
+
+void FContainerSearchIndex::BuildKeys(const FItemCatalog& Catalog, const int32 ItemId, FItemKeys& OutKeys)
+{
+	OutKeys.Capabilities = static_cast<uint32>(Catalog.GetCapabilities(ItemId));
+
+	// Without the items table, the tags come from the catalog postings.
+	const FItemRow* Row = Catalog.FindRow(ItemId);
+	const FString RowName = Catalog.GetRowName(ItemId).ToString();
+	FString Name = Catalog.GetDisplayName(ItemId);
+	if (Name.IsEmpty())
+	{
+		Name = RowName;
+	}
+	OutKeys.Quality = Catalog.GetDetails().Get(ItemId).Quality;
+	if (Row)
+	{
+		FItemTagIndex::GatherIndexedTags(*Row, OutKeys.Tags);
+	}
+	else
+	{
+		const FItemTagIndex& TagIndex = Catalog.GetTagIndex();
+		for (const FGameplayTag& Tag : TagIndex.GetTags())
+		{
+			if (Tag.IsValid() && TagIndex.HasTag(Tag, ItemId))
+			{
+				OutKeys.Tags.Add(Tag);
+			}
+		}
+	}
+
+	// Both the display name and the row name are searchable.
+	Tokenize(Name, OutKeys.Tokens);
+	Tokenize(RowName, OutKeys.Tokens);
+	OutKeys.SortName = Name.ToLower();
+}
+
+void FContainerSearchIndex::ApplyKeys(const FItemKeys& Keys, const int32 Slot, const bool bValue)
+{
+	for (uint32 Bits = Keys.Capabilities; Bits; Bits &= Bits - 1)
+	{
+		SetBit(CapabilityPostings[FMath::CountTrailingZeros(Bits)], Slot, bValue);
+	}
+	for (const FGameplayTag& Tag : Keys.Tags)
+	{
+		SetBit(TagPostings.FindOrAdd(Tag), Slot, bValue);
+	}
+	SetBit(QualityPostings.FindOrAdd(Keys.Quality), Slot, bValue);
+	for (const FString& Token : Keys.Tokens)
+	{
+		SetBit(TokenPostings.FindOrAdd(Token), Slot, bValue);
+	}
+}
+
+void FContainerSearchIndex::SetBit(FDenseBitSet& Postings, const int32 Slot, const bool bValue)
+{
+	if (!bValue)
+	{
+		if (Postings.IsValidIndex(Slot))
+		{
+			Postings.Clear(Slot);
+		}
+		return;
+	}
+
+	// Postings grow by whole words; bits past their end read as cleared.
+	if (!Postings.IsValidIndex(Slot))
+	{
+		Postings.SetNum(Align(Slot + 1, 64));
+	}
+	Postings.Set(Slot);
+}
+
+// ===============================[ Container Search View ]============================
+
+void FContainerSearchView::SetQuery(const FContainerSearchQuery& InQuery, const EContainerSortKey InSortKey, const bool bInDescending)
+{
+	Query = InQuery;
+	SortKey = InSortKey;
+	bDescending = bInDescending;
+	bDirty = true;
+}
+
+bool FContainerSearchView::Refresh(const FContainerSearchIndex& Index, const FItemInstanceStore& Store)
+{
+	if (!bDirty && Source == &Index && SourceRevision == Index.GetRevision()) return false;
+
+	Index.Search(Query, Store, SortKey, bDescending, Results);
+	Source = &Index;
+	SourceRevision = Index.GetRevision();
+	bDirty = false;
+	return true;
+}
+
+TConstArrayView<FItemHandle> FContainerSearchView::GetPage(const int32 Page, const int32 PageSize) const
+{
+	const int32 First = Page * PageSize;
+	if (Page < 0 || PageSize <= 0 || First >= Results.Num()) return TConstArrayView<FItemHandle>();
+
+	return TConstArrayView<FItemHandle>(Results).Slice(First, FMath::Min(PageSize, Results.Num() - First));
+}
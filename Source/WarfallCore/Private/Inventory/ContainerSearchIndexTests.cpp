@@ -0,0 +1,290 @@
+﻿#include "Inventory/ContainerSearchIndex.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemInstanceStore.h"
+#include "Inventory/ItemTestTables.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ContainerSearchTests
+{
+	/** Items of every kind the index has keys for, with their display name and quality. */
+	void AddItems(ItemTests::FTestTables& Tables)
+	{
+		auto Add = [&Tables](const TCHAR* RowName, const EItemType Type, const TCHAR* Name, const int32 Quality, const int32 MaxStackSize = 1, const float PerishRate = 0.0f)
+		{
+			Tables.AddItem(RowName, Type, MaxStackSize, PerishRate);
+			FItemRow& Row = Tables.GetItem(RowName);
+			Row.Name = FText::FromString(Name);
+			Row.Quality = Quality;
+			return &Row;
+		};
+		Add(TEXT("Test_IronSword"), EItemType::E_Weapon, TEXT("Iron Sword"), 3);
+		Add(TEXT("Test_SteelSword"), EItemType::E_Weapon, TEXT("Steel Long-Sword"), 5);
+		Add(TEXT("Test_Bread"), EItemType::E_Consumable, TEXT("Rye Bread"), 1, 20, 5.0f);
+		Add(TEXT("Test_Log"), EItemType::E_Ingredient, TEXT("Oak Log"), 1, 50)->IngredientsType = INGREDIENTS_RESSOURCES_WoodLog;
+		FItemRow* Bar = Add(TEXT("Test_Bar"), EItemType::E_Ingredient, TEXT("Iron Bar"), 2, 50);
+		Bar->IngredientsType = INGREDIENTS_COMPONENTS_MetalBar;
+		Bar->Tags.AddTag(ITEM_Ingredient);
+	}
+
+	/** @return True if the results hold exactly the expected instances, in any order. */
+	bool SameInstances(TConstArrayView<FItemHandle> Results, TConstArrayView<FItemHandle> Expected)
+	{
+		if (Results.Num() != Expected.Num()) return false;
+		for (const FItemHandle Handle : Expected)
+		{
+			if (!Results.Contains(Handle)) return false;
+		}
+		return true;
+	}
+}
+
+// ===============================[ Container Search Index Tests ]============================
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FContainerSearchPostingsTest, "Warfall.Items.Search.Postings", ItemTests::Flags)
+
+bool FContainerSearchPostingsTest::RunTest(const FString& Parameters)
+{
+	using namespace ContainerSearchTests;
+
+	ItemTests::FTestTables Tables;
+	AddItems(Tables);
+	FItemCatalog Catalog;
+	Catalog.Build(Tables.Items);
+	if (!TestEqual(TEXT("The catalog holds every row"), Catalog.Num(), 5)) return false;
+
+	FItemInstanceStore Store;
+	FContainerSearchIndex Index;
+	auto Add = [&](const TCHAR* RowName, const int32 Stack = 1)
+	{
+		const FItemHandle Handle = Store.Create(Catalog.FindId(RowName), Stack);
+		TestTrue(TEXT("The instance is indexed"), Index.Insert(Handle, Store.GetItemId(Handle), Catalog));
+		return Handle;
+	};
+	const FItemHandle IronSword = Add(TEXT("Test_IronSword"));
+	const FItemHandle SteelSword = Add(TEXT("Test_SteelSword"));
+	const FItemHandle Bread = Add(TEXT("Test_Bread"), 4);
+	const FItemHandle OtherBread = Add(TEXT("Test_Bread"), 9);
+	const FItemHandle Log = Add(TEXT("Test_Log"), 30);
+	const FItemHandle Bar = Add(TEXT("Test_Bar"), 7);
+	TestEqual(TEXT("Every instance is indexed"), Index.Num(), 6);
+	TestFalse(TEXT("An instance is indexed once"), Index.Insert(Bread, Store.GetItemId(Bread), Catalog));
+	TestFalse(TEXT("Unknown items are not indexed"), Index.Insert(Store.Create(INDEX_NONE), INDEX_NONE, Catalog));
+
+	TArray<FItemHandle> Results;
+	auto Search = [&](const FContainerSearchQuery& Query) -> TConstArrayView<FItemHandle>
+	{
+		Index.Search(Query, Store, EContainerSortKey::None, false, Results);
+		return Results;
+	};
+
+	FContainerSearchQuery Query;
+	TestTrue(TEXT("An empty query selects everything"), SameInstances(Search(Query), { IronSword, SteelSword, Bread, OtherBread, Log, Bar }));
+
+	// Capability postings.
+	Query.Capabilities = EItemCapability::Weapon;
+	TestTrue(TEXT("Weapons"), SameInstances(Search(Query), { IronSword, SteelSword }));
+	Query.Capabilities = EItemCapability::CanPerish;
+	TestTrue(TEXT("Perishables"), SameInstances(Search(Query), { Bread, OtherBread }));
+	Query.Capabilities = EItemCapability::Weapon | EItemCapability::CanPerish;
+	TestTrue(TEXT("Every capability must hold"), SameInstances(Search(Query), {}));
+
+	// Tag postings, parents included.
+	Query = FContainerSearchQuery();
+	Query.Tags.AddTag(INGREDIENTS_RESSOURCES_WoodLog);
+	TestTrue(TEXT("Ingredient type"), SameInstances(Search(Query), { Log }));
+	Query.Tags.Reset();
+	Query.Tags.AddTag(FGameplayTag::RequestGameplayTag(TEXT("Ingredients")));
+	TestTrue(TEXT("Parent of the ingredient types"), SameInstances(Search(Query), { Log, Bar }));
+	Query.Tags.AddTag(ITEM_Ingredient);
+	TestTrue(TEXT("Every tag must be carried"), SameInstances(Search(Query), { Bar }));
+	Query.Tags.Reset();
+	Query.Tags.AddTag(ITEM_Ammunition);
+	TestTrue(TEXT("A tag nothing carries selects nothing"), SameInstances(Search(Query), {}));
+
+	// Quality postings.
+	Query = FContainerSearchQuery();
+	Query.MinQuality = 2;
+	Query.MaxQuality = 3;
+	TestTrue(TEXT("Quality range"), SameInstances(Search(Query), { IronSword, Bar }));
+	Query.MaxQuality = MAX_int32;
+	Query.MinQuality = 5;
+	TestTrue(TEXT("Minimum quality"), SameInstances(Search(Query), { SteelSword }));
+
+	// Token postings: each word starts a word of the display or row name.
+	Query = FContainerSearchQuery();
+	Query.Text = TEXT("IRON");
+	TestTrue(TEXT("Case insensitive prefix"), SameInstances(Search(Query), { IronSword, Bar }));
+	Query.Text = TEXT("sw ir");
+	TestTrue(TEXT("Every word must match"), SameInstances(Search(Query), { IronSword }));
+	Query.Text = TEXT("long");
+	TestTrue(TEXT("Names split on punctuation"), SameInstances(Search(Query), { SteelSword }));
+	Query.Text = TEXT("steelsw");
+	TestTrue(TEXT("Row names are searchable"), SameInstances(Search(Query), { SteelSword }));
+	Query.Text = TEXT("ron");
+	TestTrue(TEXT("Words match from their start only"), SameInstances(Search(Query), {}));
+
+	// Criteria combine.
+	Query = FContainerSearchQuery();
+	Query.Capabilities = EItemCapability::Ingredient;
+	Query.Text = TEXT("iron");
+	Query.MinQuality = 2;
+	TestTrue(TEXT("Every criterion must hold"), SameInstances(Search(Query), { Bar }));
+
+	// Sorting.
+	Query = FContainerSearchQuery();
+	Index.Search(Query, Store, EContainerSortKey::Name, false, Results);
+	TestTrue(TEXT("Sorted by name"), Results.Num() == 6 && Results[0] == Bar && Results[1] == IronSword && Results[2] == Log && Results[5] == SteelSword);
+	TestTrue(TEXT("Ties keep the slot order"), Results.Num() == 6 && Results[3] == Bread && Results[4] == OtherBread);
+	Index.Search(Query, Store, EContainerSortKey::Quality, true, Results);
+	TestTrue(TEXT("Sorted by descending quality"), Results.Num() == 6 && Results[0] == SteelSword && Results[1] == IronSword && Results[2] == Bar);
+	Index.Search(Query, Store, EContainerSortKey::Stack, false, Results);
+	TestTrue(TEXT("Sorted by stack"), Results.Num() == 6 && Results[3] == Bar && Results[4] == OtherBread && Results[5] == Log);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FContainerSearchChangesTest, "Warfall.Items.Search.Changes", ItemTests::Flags)
+
+bool FContainerSearchChangesTest::RunTest(const FString& Parameters)
+{
+	using namespace ContainerSearchTests;
+
+	ItemTests::FTestTables Tables;
+	AddItems(Tables);
+	FItemCatalog Catalog;
+	Catalog.Build(Tables.Items);
+	const int32 Bread = Catalog.FindId(TEXT("Test_Bread"));
+	const int32 Log = Catalog.FindId(TEXT("Test_Log"));
+
+	FItemInstanceStore Store;
+	FContainerSearchIndex Index;
+	TArray<FItemHandle> Breads;
+	for (int32 Count = 0; Count < 3; ++Count)
+	{
+		Breads.Add(Store.Create(Bread));
+		Index.Insert(Breads.Last(), Bread, Catalog);
+	}
+
+	TArray<FItemHandle> Results;
+	FContainerSearchQuery ByText;
+	ByText.Text = TEXT("bread");
+	FContainerSearchQuery ByTag;
+	ByTag.Tags.AddTag(INGREDIENTS_RESSOURCES_WoodLog);
+	FContainerSearchQuery Perishables;
+	Perishables.Capabilities = EItemCapability::CanPerish;
+
+	// Removal clears the bits of the instance under every key.
+	uint32 Revision = Index.GetRevision();
+	TestTrue(TEXT("Removing an indexed instance succeeds"), Index.Remove(Breads[1]));
+	TestFalse(TEXT("An instance is removed once"), Index.Remove(Breads[1]));
+	TestNotEqual(TEXT("Removing changes the revision"), Index.GetRevision(), Revision);
+	TestFalse(TEXT("The removed instance is gone"), Index.Contains(Breads[1]));
+	Index.Search(ByText, Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("Text no longer finds the removed instance"), SameInstances(Results, { Breads[0], Breads[2] }));
+	Index.Search(Perishables, Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("Capabilities no longer find the removed instance"), SameInstances(Results, { Breads[0], Breads[2] }));
+
+	// The freed slot is reused without leaking the keys of its previous instance.
+	const FItemHandle NewLog = Store.Create(Log);
+	Index.Insert(NewLog, Log, Catalog);
+	Index.Search(ByText, Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("The reused slot does not match the previous item"), SameInstances(Results, { Breads[0], Breads[2] }));
+	Index.Search(ByTag, Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("The reused slot matches its new item"), SameInstances(Results, { NewLog }));
+
+	// An instance turning into another item moves to the keys of the new one.
+	Revision = Index.GetRevision();
+	TestTrue(TEXT("Updating to the same item succeeds"), Index.Update(Breads[0], Bread, Catalog));
+	TestEqual(TEXT("Updating to the same item changes nothing"), Index.GetRevision(), Revision);
+	TestTrue(TEXT("Updating to another item succeeds"), Index.Update(Breads[0], Log, Catalog));
+	Index.Search(ByText, Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("The turned instance leaves the old keys"), SameInstances(Results, { Breads[2] }));
+	Index.Search(ByTag, Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("The turned instance gets the new keys"), SameInstances(Results, { NewLog, Breads[0] }));
+
+	// A move between containers is a removal from one index and an insertion in the other, as the store does it.
+	FContainerSearchIndex Other;
+	Index.Remove(Breads[2]);
+	Other.Insert(Breads[2], Bread, Catalog);
+	Index.Search(ByText, Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("The last bread left the first container"), Results.IsEmpty());
+	Index.Search(Perishables, Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("No perishable is left in the first container"), Results.IsEmpty());
+	Other.Search(ByText, Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("The bread is found in the second container"), SameInstances(Results, { Breads[2] }));
+
+	Index.Reset();
+	TestEqual(TEXT("Reset empties the index"), Index.Num(), 0);
+	Index.Search(FContainerSearchQuery(), Store, EContainerSortKey::None, false, Results);
+	TestTrue(TEXT("Nothing is found after a reset"), Results.IsEmpty());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FContainerSearchViewTest, "Warfall.Items.Search.Paging", ItemTests::Flags)
+
+bool FContainerSearchViewTest::RunTest(const FString& Parameters)
+{
+	ItemTests::FTestTables Tables;
+	ContainerSearchTests::AddItems(Tables);
+	FItemCatalog Catalog;
+	Catalog.Build(Tables.Items);
+	const int32 Log = Catalog.FindId(TEXT("Test_Log"));
+
+	// Logs of stacks 1 to 23, inserted in a shuffled order.
+	FItemInstanceStore Store;
+	FContainerSearchIndex Index;
+	TArray<FItemHandle> Logs;
+	for (int32 Stack = 1; Stack <= 23; ++Stack)
+	{
+		Logs.Add(Store.Create(Log, Stack * 7 % 23 + 1));
+		Index.Insert(Logs.Last(), Log, Catalog);
+	}
+
+	FContainerSearchView View;
+	View.SetQuery(FContainerSearchQuery(), EContainerSortKey::Stack, true);
+	TestTrue(TEXT("The first refresh runs the query"), View.Refresh(Index, Store));
+	TestFalse(TEXT("An unchanged index is not searched again"), View.Refresh(Index, Store));
+	TestEqual(TEXT("Every log is a result"), View.Num(), 23);
+	TestEqual(TEXT("Pages"), View.GetNumPages(10), 3);
+	TestEqual(TEXT("No pages without a page size"), View.GetNumPages(0), 0);
+
+	int32 Previous = MAX_int32;
+	int32 NumPaged = 0;
+	for (int32 Page = 0; Page < View.GetNumPages(10); ++Page)
+	{
+		for (const FItemHandle Handle : View.GetPage(Page, 10))
+		{
+			TestTrue(TEXT("Pages follow the order"), Store.GetStack(Handle) < Previous);
+			Previous = Store.GetStack(Handle);
+			++NumPaged;
+		}
+	}
+	TestEqual(TEXT("Pages cover every result once"), NumPaged, 23);
+	TestEqual(TEXT("The last page is partial"), View.GetPage(2, 10).Num(), 3);
+	TestTrue(TEXT("Past the last page is empty"), View.GetPage(3, 10).IsEmpty());
+	TestTrue(TEXT("A negative page is empty"), View.GetPage(-1, 10).IsEmpty());
+
+	// A stack change alone does not sort again; a change of the content does.
+	Store.SetStack(View.GetPage(0, 10)[0], 0);
+	TestFalse(TEXT("A stack change alone keeps the view"), View.Refresh(Index, Store));
+	const FItemHandle Largest = Store.Create(Log, 100);
+	Index.Insert(Largest, Log, Catalog);
+	TestTrue(TEXT("An insertion runs the query again"), View.Refresh(Index, Store));
+	TestEqual(TEXT("The view grew"), View.Num(), 24);
+	TestTrue(TEXT("The new instance sorts first"), View.GetPage(0, 10)[0] == Largest);
+	TestEqual(TEXT("The changed stack sorts last"), Store.GetStack(View.GetPage(2, 10).Last()), 0);
+
+	Index.Remove(Largest);
+	TestTrue(TEXT("A removal runs the query again"), View.Refresh(Index, Store));
+	TestFalse(TEXT("The removed instance left the pages"), View.GetPage(0, 10).Contains(Largest));
+
+	FContainerSearchQuery Query;
+	Query.Text = TEXT("bread");
+	View.SetQuery(Query, EContainerSortKey::None, false);
+	TestTrue(TEXT("A new query runs at the next refresh"), View.Refresh(Index, Store));
+	TestEqual(TEXT("No bread among the logs"), View.Num(), 0);
+	TestTrue(TEXT("An empty view has no first page"), View.GetPage(0, 10).IsEmpty());
+	return true;
+}
+
+#endif
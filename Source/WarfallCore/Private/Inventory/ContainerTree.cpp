@@ -0,0 +1,261 @@
+﻿#include "Inventory/ContainerTree.h"
+
+namespace ContainerTree
+{
+	/** Nodes grow by this many instance slots, the slab size of FItemInstanceStore. */
+	constexpr int32 NodeGrowth = 4096;
+}
+
+// ===============================[ Container Tree ]============================
+
+void FItemContainerTree::Reset()
+{
+	Nodes.Reset();
+	OwnerMasses.Reset();
+	NumNodes = 0;
+}
+
+bool FItemContainerTree::Insert(const FItemHandle Handle, const FItemHandle Parent, const FContainedItem& Item)
+{
+	if (!Handle.IsValid() || Contains(Handle) || (Parent.IsValid() && !Contains(Parent))) return false;
+
+	const int32 Index = static_cast<int32>(Handle.GetIndex());
+	if (!Nodes.IsValidIndex(Index))
+	{
+		Nodes.SetNum(Align(Index + 1, ContainerTree::NodeGrowth));
+	}
+
+	FNode& Node = Nodes[Index];
+	Node = FNode();
+	Node.Handle = Handle.GetValue();
+	Node.Mass = Item.Mass;
+	Node.SelfMass = Item.Mass;
+	Node.Cells = Item.Cells;
+	Node.Capacity = Item.Capacity;
+	Link(Index, Parent.IsValid() ? static_cast<int32>(Parent.GetIndex()) : INDEX_NONE);
+	++NumNodes;
+	return true;
+}
+
+bool FItemContainerTree::Remove(const FItemHandle Handle, TArray<FItemHandle>* OutContent)
+{
+	if (!Contains(Handle)) return false;
+
+	const int32 Index = static_cast<int32>(Handle.GetIndex());
+	const int32 Parent = Nodes[Index].Parent;
+	const int32 Owner = Nodes[Index].Owner;
+	Unlink(Index);
+
+	// The content left with the subtree mass; it is put back under the parent, or the owner of a root, on its own.
+	int32 Child = Nodes[Index].FirstChild;
+	while (Child != INDEX_NONE)
+	{
+		const int32 Next = Nodes[Child].NextSibling;
+		Nodes[Child].Parent = INDEX_NONE;
+		Nodes[Child].PrevSibling = INDEX_NONE;
+		Nodes[Child].NextSibling = INDEX_NONE;
+		if (Parent != INDEX_NONE)
+		{
+			Link(Child, Parent);
+		}
+		else if (OwnerMasses.IsValidIndex(Owner))
+		{
+			Nodes[Child].Owner = Owner;
+			OwnerMasses[Owner] += Nodes[Child].Mass;
+		}
+		if (OutContent)
+		{
+			OutContent->Add(FItemHandle::FromValue(Nodes[Child].Handle));
+		}
+		Child = Next;
+	}
+
+	Nodes[Index] = FNode();
+	--NumNodes;
+	return true;
+}
+
+bool FItemContainerTree::Move(const FItemHandle Handle, const FItemHandle NewParent)
+{
+	if (!Contains(Handle) || (NewParent.IsValid() && !Contains(NewParent))) return false;
+
+	const int32 Index = static_cast<int32>(Handle.GetIndex());
+	const int32 Parent = NewParent.IsValid() ? static_cast<int32>(NewParent.GetIndex()) : INDEX_NONE;
+	if (Nodes[Index].Parent == Parent) return true;
+
+	for (int32 Ancestor = Parent; Ancestor != INDEX_NONE; Ancestor = Nodes[Ancestor].Parent)
+	{
+		if (Ancestor == Index) return false;
+	}
+
+	Unlink(Index);
+	Link(Index, Parent);
+	return true;
+}
+
+bool FItemContainerTree::Update(const FItemHandle Handle, const FContainedItem& Item)
+{
+	if (!Contains(Handle)) return false;
+
+	const int32 Index = static_cast<int32>(Handle.GetIndex());
+	FNode& Node = Nodes[Index];
+	if (Node.Parent != INDEX_NONE)
+	{
+		Nodes[Node.Parent].UsedCells += Item.Cells - Node.Cells;
+	}
+	Node.Cells = Item.Cells;
+	Node.Capacity = Item.Capacity;
+
+	const double Delta = Item.Mass - Node.SelfMass;
+	Node.SelfMass = Item.Mass;
+	if (Delta != 0.0)
+	{
+		AddMass(Index, Delta);
+	}
+	return true;
+}
+
+int32 FItemContainerTree::AddOwner()
+{
+	return OwnerMasses.Add(0.0);
+}
+
+void FItemContainerTree::RemoveOwner(const int32 Owner)
+{
+	if (!OwnerMasses.IsValidIndex(Owner)) return;
+
+	// A left root would otherwise count toward the next owner reusing the index.
+	if (!FMath::IsNearlyZero(OwnerMasses[Owner]))
+	{
+		for (FNode& Node : Nodes)
+		{
+			if (Node.Handle != 0 && Node.Parent == INDEX_NONE && Node.Owner == Owner)
+			{
+				Node.Owner = INDEX_NONE;
+			}
+		}
+	}
+	OwnerMasses.RemoveAt(Owner);
+}
+
+bool FItemContainerTree::SetOwner(const FItemHandle Handle, const int32 Owner)
+{
+	if (!Contains(Handle) || (Owner != INDEX_NONE && !OwnerMasses.IsValidIndex(Owner))) return false;
+
+	FNode& Node = Nodes[Handle.GetIndex()];
+	if (Node.Parent != INDEX_NONE) return false;
+
+	if (OwnerMasses.IsValidIndex(Node.Owner))
+	{
+		OwnerMasses[Node.Owner] -= Node.Mass;
+	}
+	Node.Owner = Owner;
+	if (Owner != INDEX_NONE)
+	{
+		OwnerMasses[Owner] += Node.Mass;
+	}
+	return true;
+}
+
+FItemHandle FItemContainerTree::GetParent(const FItemHandle Handle) const
+{
+	if (!Contains(Handle)) return FItemHandle();
+
+	const int32 Parent = Nodes[Handle.GetIndex()].Parent;
+	return Parent != INDEX_NONE ? FItemHandle::FromValue(Nodes[Parent].Handle) : FItemHandle();
+}
+
+FItemHandle FItemContainerTree::GetRoot(const FItemHandle Handle) const
+{
+	if (!Contains(Handle)) return FItemHandle();
+
+	int32 Index = static_cast<int32>(Handle.GetIndex());
+	while (Nodes[Index].Parent != INDEX_NONE)
+	{
+		Index = Nodes[Index].Parent;
+	}
+	return FItemHandle::FromValue(Nodes[Index].Handle);
+}
+
+int32 FItemContainerTree::GetDepth(const FItemHandle Handle) const
+{
+	if (!Contains(Handle)) return 0;
+
+	int32 Depth = 0;
+	for (int32 Index = Nodes[Handle.GetIndex()].Parent; Index != INDEX_NONE; Index = Nodes[Index].Parent)
+	{
+		++Depth;
+	}
+	return Depth;
+}
+
+void FItemContainerTree::AddMass(int32 Index, const double Delta)
+{
+	while (true)
+	{
+		FNode& Node = Nodes[Index];
+		Node.Mass += Delta;
+		if (Node.Parent == INDEX_NONE)
+		{
+			if (OwnerMasses.IsValidIndex(Node.Owner))
+			{
+				OwnerMasses[Node.Owner] += Delta;
+			}
+			return;
+		}
+		Index = Node.Parent;
+	}
+}
+
+void FItemContainerTree::Link(const int32 Index, const int32 Parent)
+{
+	if (Parent == INDEX_NONE) return;
+
+	FNode& Node = Nodes[Index];
+	FNode& ParentNode = Nodes[Parent];
+	Node.Parent = Parent;
+	Node.PrevSibling = INDEX_NONE;
+	Node.NextSibling = ParentNode.FirstChild;
+	if (Node.NextSibling != INDEX_NONE)
+	{
+		Nodes[Node.NextSibling].PrevSibling = Index;
+	}
+	ParentNode.FirstChild = Index;
+	ParentNode.UsedCells += Node.Cells;
+	AddMass(Parent, Node.Mass);
+}
+
+void FItemContainerTree::Unlink(const int32 Index)
+{
+	FNode& Node = Nodes[Index];
+	if (Node.Parent == INDEX_NONE)
+	{
+		if (OwnerMasses.IsValidIndex(Node.Owner))
+		{
+			OwnerMasses[Node.Owner] -= Node.Mass;
+		}
+		Node.Owner = INDEX_NONE;
+		return;
+	}
+
+	FNode& ParentNode = Nodes[Node.Parent];
+	if (Node.PrevSibling != INDEX_NONE)
+	{
+		Nodes[Node.PrevSibling].NextSibling = Node.NextSibling;
+	}
+	else
+	{
+		ParentNode.FirstChild = Node.NextSibling;
+	}
+	if (Node.NextSibling != INDEX_NONE)
+	{
+		Nodes[Node.NextSibling].PrevSibling = Node.PrevSibling;
+	}
+	ParentNode.UsedCells -= Node.Cells;
+
+	const int32 Parent = Node.Parent;
+	Node.Parent = INDEX_NONE;
+	Node.PrevSibling = INDEX_NONE;
+	Node.NextSibling = INDEX_NONE;
+	AddMass(Parent, -Node.Mass);
+}
@@ -0,0 +1,421 @@
+﻿#include "Inventory/CookedItemCatalog.h"
+
+#include "Async/MappedFileHandle.h"
+#include "Crafting/RecipeCatalog.h"
+#include "HAL/PlatformFileManager.h"
+#include "Inventory/ItemCatalog.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace CookedItemCatalog
+{
+	constexpr uint64 SectionAlignment = 64;
+
+	uint64 AlignSection(TArray<uint8>& Buffer)
+	{
+		Buffer.SetNumZeroed(Align(Buffer.Num(), SectionAlignment));
+		return Buffer.Num();
+	}
+
+	template <typename T>
+	uint64 AppendSection(TArray<uint8>& Buffer, TConstArrayView<T> Values)
+	{
+		const uint64 Offset = AlignSection(Buffer);
+		Buffer.Append(reinterpret_cast<const uint8*>(Values.GetData()), Values.Num() * sizeof(T));
+		return Offset;
+	}
+
+	/** Writes an offset table followed by the UTF-8 characters of every string. */
+	template <typename FStringAt>
+	uint64 AppendStrings(TArray<uint8>& Buffer, const int32 Count, FStringAt&& StringAt)
+	{
+		TArray<uint32> Offsets;
+		TArray<UTF8CHAR> Chars;
+		Offsets.Reserve(Count + 1);
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			Offsets.Add(Chars.Num());
+			const FTCHARToUTF8 Converted(*StringAt(Index));
+			Chars.Append(reinterpret_cast<const UTF8CHAR*>(Converted.Get()), Converted.Length());
+		}
+		Offsets.Add(Chars.Num());
+
+		const uint64 Offset = AppendSection<uint32>(Buffer, Offsets);
+		Buffer.Append(reinterpret_cast<const uint8*>(Chars.GetData()), Chars.Num());
+		return Offset;
+	}
+
+	/** Writes an offset table followed by the UTF-8 characters of every name. */
+	template <typename FNameAt>
+	uint64 AppendNames(TArray<uint8>& Buffer, const int32 Count, FNameAt&& NameAt)
+	{
+		return AppendStrings(Buffer, Count, [&NameAt](const int32 Index) { return NameAt(Index).ToString(); });
+	}
+
+	/** Writes the recipes section: its header, then its sections. */
+	void AppendRecipes(TArray<uint8>& Buffer, const FRecipeCatalog& Recipes)
+	{
+		FCookedRecipesHeader Header;
+		Header.NumRecipes = Recipes.Num();
+		Header.NumIngredients = Recipes.GetRawIngredients().Num();
+		Header.NumResults = Recipes.GetRawResults().Num();
+		Header.NumIngredientTags = Recipes.GetIngredientTags().Num();
+
+		const uint64 HeaderOffset = AlignSection(Buffer);
+		Buffer.AddZeroed(sizeof(FCookedRecipesHeader));
+		Header.RecipeNamesOffset = AppendNames(Buffer, Header.NumRecipes, [&Recipes](const int32 Id) { return Recipes.GetRowName(Id); });
+		Header.IngredientStartsOffset = AppendSection(Buffer, Recipes.GetRawIngredientStarts());
+		Header.IngredientsOffset = AppendSection(Buffer, Recipes.GetRawIngredients());
+		Header.ResultStartsOffset = AppendSection(Buffer, Recipes.GetRawResultStarts());
+		Header.ResultsOffset = AppendSection(Buffer, Recipes.GetRawResults());
+		Header.CraftDurationsOffset = AppendSection(Buffer, Recipes.GetCraftDurations());
+		Header.IngredientTagNamesOffset = AppendNames(Buffer, Header.NumIngredientTags, [&Recipes](const int32 Slot) { return Recipes.GetIngredientTags()[Slot].GetTagName(); });
+		FMemory::Memcpy(Buffer.GetData() + HeaderOffset, &Header, sizeof(Header));
+	}
+
+	bool IsSectionValid(const uint64 Offset, const uint64 Bytes, const uint64 FileSize)
+	{
+		return Offset % SectionAlignment == 0 && Offset <= FileSize && Bytes <= FileSize - Offset;
+	}
+}
+
+// ===============================[ Cooked Item Catalog ]============================
+
+FCookedItemCatalog::FCookedItemCatalog() = default;
+
+FCookedItemCatalog::~FCookedItemCatalog()
+{
+	Close();
+}
+
+FString FCookedItemCatalog::GetDefaultPath()
+{
+	return FPaths::ProjectContentDir() / TEXT("WarfallCore/ItemCatalog.wfc");
+}
+
+bool FCookedItemCatalog::Write(const FItemCatalog& Catalog, const FRecipeCatalog* Recipes, const FString& Path)
+{
+	using namespace CookedItemCatalog;
+
+	if (Catalog.IsEmpty() || Catalog.GetStats().IsExternal())
+	{
+		UE_LOG(LogTemp, Error, TEXT("CookedItemCatalog: nothing to write to '%s', the catalog must be built from ItemsTable."), *Path);
+		return false;
+	}
+
+	const FItemStatColumns& Stats = Catalog.GetStats();
+	const FItemTagIndex& TagIndex = Catalog.GetTagIndex();
+	const FItemModifierTable& Modifiers = Catalog.GetModifiers();
+	const FItemDetailColumns& Details = Catalog.GetDetails();
+	// Patched catalogs may hold slack between the entries of their items: the ranged sections are copied compact.
+	TArray<uint32> ModifierRanges;
+	TArray<FCompiledModifier> ModifierOps;
+	Modifiers.CopyRawOps(ModifierRanges, ModifierOps);
+	TArray<uint32> RepairRanges;
+	TArray<FRepairMaterial> RepairMaterials;
+	Details.CopyRawRepairMaterials(RepairRanges, RepairMaterials);
+	TArray<FName> MetaKeys;
+	TArray<uint32> MetaRanges;
+	TArray<FCompiledMetaEntry> MetaEntries;
+	Details.CompileMeta(MetaKeys, MetaRanges, MetaEntries);
+
+	FCookedItemCatalogHeader Header;
+	Header.Magic = FileMagic;
+	Header.Version = FileVersion;
+	Header.NumItems = Catalog.Num();
+	Header.StatStride = Stats.GetStride();
+	Header.NumStats = static_cast<int32>(EItemStat::Num);
+	Header.NumTags = TagIndex.NumTags();
+	Header.WordsPerTag = TagIndex.GetWordsPerTag();
+	Header.NumNamePostings = TagIndex.GetRawNameWords().Num() / FMath::Max(Header.WordsPerTag, 1);
+	Header.NumModifierKeys = Modifiers.NumSlots();
+	Header.NumModifierOps = ModifierOps.Num();
+	Header.NumRepairMaterials = RepairMaterials.Num();
+	Header.NumMetaKeys = MetaKeys.Num();
+	Header.NumMetaEntries = MetaEntries.Num();
+
+	TArray<uint8> Buffer;
+	Buffer.SetNumZeroed(sizeof(FCookedItemCatalogHeader));
+	Header.ItemNamesOffset = AppendNames(Buffer, Header.NumItems, [&Catalog](const int32 Id) { return Catalog.GetRowName(Id); });
+	Header.StatsOffset = AppendSection(Buffer, Stats.GetRawFloats());
+	Header.StackSizesOffset = AppendSection(Buffer, Stats.GetRawStackSizes());
+	Header.CapabilitiesOffset = AppendSection(Buffer, Catalog.GetCapabilityColumn());
+	Header.PerishTargetsOffset = AppendSection(Buffer, Catalog.GetPerishTargetColumn());
+	Header.TagNamesOffset = AppendNames(Buffer, Header.NumTags, [&TagIndex](const int32 Slot) { return TagIndex.GetTags()[Slot].GetTagName(); });
+	Header.PostingsOffset = AppendSection(Buffer, TagIndex.GetRawWords());
+	Header.NameSlotsOffset = AppendSection(Buffer, TagIndex.GetNameSlots());
+	Header.NamePostingsOffset = AppendSection(Buffer, TagIndex.GetRawNameWords());
+	Header.ModifierKeysOffset = AppendNames(Buffer, Header.NumModifierKeys, [&Modifiers](const int32 Slot) { return Modifiers.GetStatKey(Slot); });
+	Header.ModifierRangesOffset = AppendSection<uint32>(Buffer, ModifierRanges);
+	Header.ModifierOpsOffset = AppendSection<FCompiledModifier>(Buffer, ModifierOps);
+	Header.DisplayNamesOffset = AppendStrings(Buffer, Header.NumItems, [&Catalog](const int32 Id) { return Catalog.GetDisplayName(Id); });
+	Header.DetailsOffset = AppendSection(Buffer, Details.GetRawDetails());
+	Header.RepairRangesOffset = AppendSection<uint32>(Buffer, RepairRanges);
+	Header.RepairMaterialsOffset = AppendSection<FRepairMaterial>(Buffer, RepairMaterials);
+	Header.MetaKeysOffset = AppendNames(Buffer, Header.NumMetaKeys, [&MetaKeys](const int32 Slot) { return MetaKeys[Slot]; });
+	Header.MetaRangesOffset = AppendSection<uint32>(Buffer, MetaRanges);
+	Header.MetaEntriesOffset = AppendSection<FCompiledMetaEntry>(Buffer, MetaEntries);
+	Header.RecipesOffset = AlignSection(Buffer);
+	if (Recipes && !Recipes->IsEmpty())
+	{
+		AppendRecipes(Buffer, *Recipes);
+	}
+	Header.RecipesSize = Buffer.Num() - Header.RecipesOffset;
+	Header.FileSize = Buffer.Num();
+	FMemory::Memcpy(Buffer.GetData(), &Header, sizeof(Header));
+
+	if (!FFileHelper::SaveArrayToFile(Buffer, *Path))
+	{
+		UE_LOG(LogTemp, Error, TEXT("CookedItemCatalog: failed to write '%s'."), *Path);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("CookedItemCatalog: %d items, %d tags, %d recipes written to '%s' (%llu bytes)."), Header.NumItems, Header.NumTags, Recipes ? Recipes->Num() : 0, *Path, Header.FileSize);
+	return true;
+}
+
+bool FCookedItemCatalog::Open(const FString& Path)
+{
+	Close();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	if (!MappedFile) return false;
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize(), true));
+	if (!MappedRegion)
+	{
+		Close();
+		return false;
+	}
+
+	Data = MappedRegion->GetMappedPtr();
+	Size = MappedRegion->GetMappedSize();
+	if (!Validate())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CookedItemCatalog: '%s' is corrupted or was cooked by another version."), *Path);
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void FCookedItemCatalog::Close()
+{
+	Data = nullptr;
+	Size = 0;
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+FName FCookedItemCatalog::ReadName(const uint64 TableOffset, const int32 Count, const int32 Index) const
+{
+	if (Index < 0 || Index >= Count) return NAME_None;
+
+	const uint32* Offsets = Section<uint32>(TableOffset);
+	const UTF8CHAR* Chars = reinterpret_cast<const UTF8CHAR*>(Offsets + Count + 1);
+	const FUTF8ToTCHAR Converted(Chars + Offsets[Index], Offsets[Index + 1] - Offsets[Index]);
+	return FName(Converted.Length(), Converted.Get());
+}
+
+FString FCookedItemCatalog::ReadString(const uint64 TableOffset, const int32 Count, const int32 Index) const
+{
+	if (Index < 0 || Index >= Count) return FString();
+
+	const uint32* Offsets = Section<uint32>(TableOffset);
+	const UTF8CHAR* Chars = reinterpret_cast<const UTF8CHAR*>(Offsets + Count + 1);
+	const FUTF8ToTCHAR Converted(Chars + Offsets[Index], Offsets[Index + 1] - Offsets[Index]);
+	return FString(Converted.Length(), Converted.Get());
+}
+
+bool FCookedItemCatalog::ValidateNames(const uint64 TableOffset, const int32 Count, const uint64 End) const
+{
+	using namespace CookedItemCatalog;
+
+	const uint64 TableBytes = (Count + 1ull) * sizeof(uint32);
+	if (!IsSectionValid(TableOffset, TableBytes, End)) return false;
+
+	const uint32* Offsets = Section<uint32>(TableOffset);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		if (Offsets[Index] > Offsets[Index + 1]) return false;
+	}
+	return TableOffset + TableBytes + Offsets[Count] <= End;
+}
+
+bool FCookedItemCatalog::ValidateModifiers() const
+{
+	using namespace CookedItemCatalog;
+
+	const FCookedItemCatalogHeader& Header = GetHeader();
+	if (!IsSectionValid(Header.ModifierRangesOffset, (Header.NumItems + 1ull) * sizeof(uint32), Header.FileSize)) return false;
+	if (!IsSectionValid(Header.ModifierOpsOffset, static_cast<uint64>(Header.NumModifierOps) * sizeof(FCompiledModifier), Header.FileSize)) return false;
+
+	const uint32* Ranges = GetModifierRanges();
+	for (int32 Id = 0; Id < Header.NumItems; ++Id)
+	{
+		if (Ranges[Id] > Ranges[Id + 1]) return false;
+	}
+	if (Ranges[Header.NumItems] != static_cast<uint32>(Header.NumModifierOps)) return false;
+
+	const FCompiledModifier* Ops = GetModifierOps();
+	for (int32 Op = 0; Op < Header.NumModifierOps; ++Op)
+	{
+		if (Ops[Op].Slot >= Header.NumModifierKeys) return false;
+	}
+	return true;
+}
+
+bool FCookedItemCatalog::ValidatePerishTargets() const
+{
+	using namespace CookedItemCatalog;
+
+	const FCookedItemCatalogHeader& Header = GetHeader();
+	if (!IsSectionValid(Header.PerishTargetsOffset, static_cast<uint64>(Header.NumItems) * sizeof(int32), Header.FileSize)) return false;
+
+	const int32* Targets = GetPerishTargets();
+	for (int32 Id = 0; Id < Header.NumItems; ++Id)
+	{
+		if (Targets[Id] < INDEX_NONE || Targets[Id] >= Header.NumItems) return false;
+	}
+	return true;
+}
+
+bool FCookedItemCatalog::ValidateNameSlots() const
+{
+	using namespace CookedItemCatalog;
+
+	const FCookedItemCatalogHeader& Header = GetHeader();
+	if (!IsSectionValid(Header.NameSlotsOffset, static_cast<uint64>(Header.NumTags) * sizeof(int32), Header.FileSize)) return false;
+	if (!IsSectionValid(Header.NamePostingsOffset, static_cast<uint64>(Header.NumNamePostings) * Header.WordsPerTag * sizeof(uint64), Header.FileSize)) return false;
+
+	const int32* NameSlots = GetNameSlots();
+	for (int32 Slot = 0; Slot < Header.NumTags; ++Slot)
+	{
+		if (NameSlots[Slot] < INDEX_NONE || NameSlots[Slot] >= Header.NumNamePostings) return false;
+	}
+	return true;
+}
+
+template <typename T>
+bool FCookedItemCatalog::ValidateStarts(const T* Starts, const int32 Count, const int32 Total)
+{
+	if (Starts[0] != 0 || Starts[Count] != static_cast<T>(Total)) return false;
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		if (Starts[Index] > Starts[Index + 1]) return false;
+	}
+	return true;
+}
+
+bool FCookedItemCatalog::ValidateDetails() const
+{
+	using namespace CookedItemCatalog;
+
+	const FCookedItemCatalogHeader& Header = GetHeader();
+	if (Header.NumRepairMaterials < 0) return false;
+	if (!IsSectionValid(Header.DetailsOffset, static_cast<uint64>(Header.NumItems) * sizeof(FItemDetail), Header.FileSize)) return false;
+	if (!IsSectionValid(Header.RepairRangesOffset, (Header.NumItems + 1ull) * sizeof(uint32), Header.FileSize)) return false;
+	if (!IsSectionValid(Header.RepairMaterialsOffset, static_cast<uint64>(Header.NumRepairMaterials) * sizeof(FRepairMaterial), Header.FileSize)) return false;
+	if (!ValidateStarts(GetRepairRanges(), Header.NumItems, Header.NumRepairMaterials)) return false;
+
+	const FItemDetail* Details = GetDetails();
+	for (int32 Id = 0; Id < Header.NumItems; ++Id)
+	{
+		if (Details[Id].FirstTagSlot < INDEX_NONE || Details[Id].FirstTagSlot >= Header.NumTags) return false;
+	}
+	const FRepairMaterial* Materials = GetRepairMaterials();
+	for (int32 Index = 0; Index < Header.NumRepairMaterials; ++Index)
+	{
+		if (Materials[Index].ItemId < INDEX_NONE || Materials[Index].ItemId >= Header.NumItems) return false;
+	}
+	return true;
+}
+
+bool FCookedItemCatalog::ValidateMeta() const
+{
+	using namespace CookedItemCatalog;
+
+	const FCookedItemCatalogHeader& Header = GetHeader();
+	if (Header.NumMetaKeys < 0 || Header.NumMetaEntries < 0) return false;
+	if (!ValidateNames(Header.MetaKeysOffset, Header.NumMetaKeys, Header.FileSize)) return false;
+	if (!IsSectionValid(Header.MetaRangesOffset, (Header.NumItems + 1ull) * sizeof(uint32), Header.FileSize)) return false;
+	if (!IsSectionValid(Header.MetaEntriesOffset, static_cast<uint64>(Header.NumMetaEntries) * sizeof(FCompiledMetaEntry), Header.FileSize)) return false;
+	if (!ValidateStarts(GetMetaRanges(), Header.NumItems, Header.NumMetaEntries)) return false;
+
+	const FCompiledMetaEntry* Entries = GetMetaEntries();
+	for (int32 Index = 0; Index < Header.NumMetaEntries; ++Index)
+	{
+		if (Entries[Index].Slot >= Header.NumMetaKeys) return false;
+	}
+	return true;
+}
+
+bool FCookedItemCatalog::ValidateRecipes() const
+{
+	using namespace CookedItemCatalog;
+
+	const FCookedItemCatalogHeader& Header = GetHeader();
+	if (!IsSectionValid(Header.RecipesOffset, Header.RecipesSize, Header.FileSize)) return false;
+	if (Header.RecipesSize == 0) return true;
+	if (Header.RecipesSize < sizeof(FCookedRecipesHeader)) return false;
+
+	// Every section of the recipes lies within the recipes section.
+	const FCookedRecipesHeader& Recipes = GetRecipesHeader();
+	const uint64 End = Header.RecipesOffset + Header.RecipesSize;
+	if (Recipes.NumRecipes < 0 || Recipes.NumIngredients < 0 || Recipes.NumResults < 0 || Recipes.NumIngredientTags < 0) return false;
+	if (!ValidateNames(Recipes.RecipeNamesOffset, Recipes.NumRecipes, End)) return false;
+	if (!ValidateNames(Recipes.IngredientTagNamesOffset, Recipes.NumIngredientTags, End)) return false;
+	if (!IsSectionValid(Recipes.IngredientStartsOffset, (Recipes.NumRecipes + 1ull) * sizeof(int32), End)) return false;
+	if (!IsSectionValid(Recipes.IngredientsOffset, static_cast<uint64>(Recipes.NumIngredients) * sizeof(FRecipeIngredient), End)) return false;
+	if (!IsSectionValid(Recipes.ResultStartsOffset, (Recipes.NumRecipes + 1ull) * sizeof(int32), End)) return false;
+	if (!IsSectionValid(Recipes.ResultsOffset, static_cast<uint64>(Recipes.NumResults) * sizeof(FRecipeResult), End)) return false;
+	if (!IsSectionValid(Recipes.CraftDurationsOffset, static_cast<uint64>(Recipes.NumRecipes) * sizeof(float), End)) return false;
+	if (!ValidateStarts(GetIngredientStarts(), Recipes.NumRecipes, Recipes.NumIngredients)) return false;
+	if (!ValidateStarts(GetResultStarts(), Recipes.NumRecipes, Recipes.NumResults)) return false;
+
+	const FRecipeIngredient* Ingredients = GetIngredients();
+	for (int32 Index = 0; Index < Recipes.NumIngredients; ++Index)
+	{
+		const FRecipeIngredient& Ingredient = Ingredients[Index];
+		if (Ingredient.ItemId < INDEX_NONE || Ingredient.ItemId >= Header.NumItems) return false;
+		if (Ingredient.TagSlot < INDEX_NONE || Ingredient.TagSlot >= Recipes.NumIngredientTags) return false;
+		if (Ingredient.Quantity < 1) return false;
+	}
+	const FRecipeResult* Results = GetResults();
+	for (int32 Index = 0; Index < Recipes.NumResults; ++Index)
+	{
+		if (Results[Index].ItemId < 0 || Results[Index].ItemId >= Header.NumItems || Results[Index].Quantity < 1) return false;
+	}
+	return true;
+}
+
+bool FCookedItemCatalog::Validate() const
+{
+	using namespace CookedItemCatalog;
+
+	if (!Data || Size < static_cast<int64>(sizeof(FCookedItemCatalogHeader))) return false;
+
+	const FCookedItemCatalogHeader& Header = GetHeader();
+	if (Header.Magic != FileMagic || Header.Version != FileVersion) return false;
+	if (Header.FileSize != static_cast<uint64>(Size)) return false;
+	if (Header.NumItems < 0 || Header.NumTags < 0 || Header.StatStride < Header.NumItems) return false;
+	if (Header.NumModifierKeys < 0 || Header.NumModifierOps < 0 || Header.NumNamePostings < 0) return false;
+	if (Header.NumStats != static_cast<int32>(EItemStat::Num)) return false;
+	if (Header.WordsPerTag != FDenseBitSet::NumWordsFor(Header.NumItems)) return false;
+
+	const uint64 FileSize = Header.FileSize;
+	return ValidateNames(Header.ItemNamesOffset, Header.NumItems, FileSize)
+		&& IsSectionValid(Header.StatsOffset, static_cast<uint64>(Header.StatStride) * Header.NumStats * sizeof(float), FileSize)
+		&& IsSectionValid(Header.StackSizesOffset, static_cast<uint64>(Header.StatStride) * sizeof(int32), FileSize)
+		&& IsSectionValid(Header.CapabilitiesOffset, static_cast<uint64>(Header.NumItems) * sizeof(uint32), FileSize)
+		&& ValidatePerishTargets()
+		&& ValidateNames(Header.TagNamesOffset, Header.NumTags, FileSize)
+		&& IsSectionValid(Header.PostingsOffset, static_cast<uint64>(Header.NumTags) * Header.WordsPerTag * sizeof(uint64), FileSize)
+		&& ValidateNameSlots()
+		&& ValidateNames(Header.ModifierKeysOffset, Header.NumModifierKeys, FileSize)
+		&& ValidateModifiers()
+		&& ValidateNames(Header.DisplayNamesOffset, Header.NumItems, FileSize)
+		&& ValidateDetails()
+		&& ValidateMeta()
+		&& ValidateRecipes();
+}
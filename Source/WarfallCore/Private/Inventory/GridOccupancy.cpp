@@ -0,0 +1,108 @@
+﻿#include "Inventory/GridOccupancy.h"
+
+// ===============================[ Grid Occupancy ]============================
+
+void FGridOccupancy::Init(const FIntPoint InDimensions)
+{
+	if (InDimensions.X > MaxWidth)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("GridOccupancy: grids are at most %d cells wide, %d requested."), MaxWidth, InDimensions.X);
+	}
+
+	Width = FMath::Clamp(InDimensions.X, 0, MaxWidth);
+	Rows.Reset();
+	Rows.SetNumZeroed(FMath::Max(InDimensions.Y, 0));
+}
+
+bool FGridOccupancy::Place(const FIntPoint Footprint, const FIntPoint Position)
+{
+	if (!CanPlace(Footprint, Position)) return false;
+
+	const uint64 Mask = RowMask(Footprint.X) << Position.X;
+	for (int32 Y = Position.Y; Y < Position.Y + Footprint.Y; ++Y)
+	{
+		Rows[Y] |= Mask;
+	}
+	return true;
+}
+
+void FGridOccupancy::Remove(const FIntPoint Footprint, const FIntPoint Position)
+{
+	if (Footprint.X <= 0 || Footprint.Y <= 0 || Position.X >= Width) return;
+
+	const int32 FirstX = FMath::Max(Position.X, 0);
+	const int32 LastX = FMath::Min(Position.X + Footprint.X, Width);
+	if (LastX <= FirstX) return;
+
+	const uint64 Mask = RowMask(LastX - FirstX) << FirstX;
+	for (int32 Y = FMath::Max(Position.Y, 0); Y < FMath::Min(Position.Y + Footprint.Y, Rows.Num()); ++Y)
+	{
+		Rows[Y] &= ~Mask;
+	}
+}
+
+bool FGridOccupancy::FindFirstFree(const FIntPoint Footprint, FIntPoint& OutPosition) const
+{
+	if (!IsInside(Footprint, FIntPoint::ZeroValue)) return false;
+
+	for (int32 Y = 0; Y + Footprint.Y <= Rows.Num(); ++Y)
+	{
+		if (const uint64 Starts = FreeStarts(Footprint, Y))
+		{
+			OutPosition = FIntPoint(static_cast<int32>(FMath::CountTrailingZeros64(Starts)), Y);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FGridOccupancy::FindFirstFreeRotated(const FIntPoint Footprint, FIntPoint& OutPosition, bool& bOutRotated) const
+{
+	bOutRotated = false;
+	if (FindFirstFree(Footprint, OutPosition)) return true;
+	if (Footprint.X == Footprint.Y) return false;
+
+	bOutRotated = FindFirstFree(Rotate(Footprint), OutPosition);
+	return bOutRotated;
+}
+
+int32 FGridOccupancy::CountFreeSpots(const FIntPoint Footprint) const
+{
+	if (!IsInside(Footprint, FIntPoint::ZeroValue)) return 0;
+
+	int32 Count = 0;
+	for (int32 Y = 0; Y + Footprint.Y <= Rows.Num(); ++Y)
+	{
+		Count += FMath::CountBits(FreeStarts(Footprint, Y));
+	}
+	return Count;
+}
+
+int32 FGridOccupancy::CountFreeCells() const
+{
+	int32 Count = 0;
+	for (const uint64 Row : Rows)
+	{
+		Count += Width - FMath::CountBits(Row);
+	}
+	return Count;
+}
+
+uint64 FGridOccupancy::FreeStarts(const FIntPoint Footprint, const int32 Y) const
+{
+	uint64 Occupied = 0;
+	for (int32 Row = Y; Row < Y + Footprint.Y; ++Row)
+	{
+		Occupied |= Rows[Row];
+	}
+
+	// Bit X of Runs tells that Covered cells are free from column X; doubling Covered each step.
+	uint64 Runs = ~Occupied & RowMask(Width);
+	for (int32 Covered = 1; Covered < Footprint.X;)
+	{
+		const int32 Shift = FMath::Min(Covered, Footprint.X - Covered);
+		Runs &= Runs >> Shift;
+		Covered += Shift;
+	}
+	return Runs;
+}
@@ -0,0 +1,251 @@
+﻿#include "Inventory/GridPackSolver.h"
+
+#include "Algo/StableSort.h"
+#include "Async/Async.h"
+#include "Inventory/ItemCatalog.h"
+
+namespace GridPackSolver
+{
+	/** Placements of one attempt. */
+	struct FAttempt
+	{
+		TArray<int32> Order;
+		TArray<FPackEntry> Layout;
+		TArray<FPackEntry> Unplaced;
+		int32 UsedRows = 0;
+	};
+
+	/** Groups the contents by item and splits every group into full stacks. Largest sources keep their handle. */
+	void MergeStacks(const FPackRequest& Request, TArray<FPackEntry>& OutStacks, TArray<int32>& OutRemovedHandles)
+	{
+		TArray<int32> ItemOrder;
+		TMap<int32, TArray<const FPackEntry*>> Sources;
+		for (const FPackEntry& Entry : Request.Contents)
+		{
+			if (Entry.Quantity <= 0) continue;
+
+			TArray<const FPackEntry*>* ItemSources = Sources.Find(Entry.ItemId);
+			if (!ItemSources)
+			{
+				ItemOrder.Add(Entry.ItemId);
+				ItemSources = &Sources.Add(Entry.ItemId);
+			}
+			ItemSources->Add(&Entry);
+		}
+
+		for (const int32 ItemId : ItemOrder)
+		{
+			const FPackItemInfo* Info = Request.Items.Find(ItemId);
+			const FIntPoint Footprint = Info ? Info->Footprint : FIntPoint(1, 1);
+			TArray<const FPackEntry*>& ItemSources = Sources[ItemId];
+
+			if (!Request.bMergeStacks)
+			{
+				for (const FPackEntry* Source : ItemSources)
+				{
+					FPackEntry& Stack = OutStacks.Add_GetRef(*Source);
+					Stack.Footprint = Footprint;
+				}
+				continue;
+			}
+
+			int32 Remaining = 0;
+			for (const FPackEntry* Source : ItemSources)
+			{
+				Remaining += Source->Quantity;
+			}
+			Algo::StableSort(ItemSources, [](const FPackEntry* A, const FPackEntry* B) { return A->Quantity > B->Quantity; });
+
+			const int32 MaxStackSize = FMath::Max(Info ? Info->MaxStackSize : 1, 1);
+			int32 Source = 0;
+			while (Remaining > 0)
+			{
+				FPackEntry& Stack = OutStacks.AddDefaulted_GetRef();
+				Stack.Handle = Source < ItemSources.Num() ? ItemSources[Source++]->Handle : INDEX_NONE;
+				Stack.ItemId = ItemId;
+				Stack.Quantity = FMath::Min(Remaining, MaxStackSize);
+				Stack.Footprint = Footprint;
+				Remaining -= Stack.Quantity;
+			}
+			for (; Source < ItemSources.Num(); ++Source)
+			{
+				OutRemovedHandles.Add(ItemSources[Source]->Handle);
+			}
+		}
+	}
+
+	/** Places the stacks first-fit in the given order, rotating them when they do not fit as is. */
+	void Pack(TConstArrayView<FPackEntry> Stacks, const FIntPoint Dimensions, FAttempt& Attempt)
+	{
+		FGridOccupancy Grid(Dimensions);
+		Attempt.Layout.Reset();
+		Attempt.Unplaced.Reset();
+		Attempt.UsedRows = 0;
+
+		for (const int32 Index : Attempt.Order)
+		{
+			FPackEntry Entry = Stacks[Index];
+			if (Grid.FindFirstFreeRotated(Entry.Footprint, Entry.Position, Entry.bRotated))
+			{
+				const FIntPoint Placed = Entry.bRotated ? FGridOccupancy::Rotate(Entry.Footprint) : Entry.Footprint;
+				Grid.Place(Placed, Entry.Position);
+				Attempt.UsedRows = FMath::Max(Attempt.UsedRows, Entry.Position.Y + Placed.Y);
+				Attempt.Layout.Add(Entry);
+			}
+			else
+			{
+				Attempt.Unplaced.Add(Entry);
+			}
+		}
+	}
+
+	bool IsBetter(const FAttempt& Candidate, const FAttempt& Best)
+	{
+		if (Candidate.Unplaced.Num() != Best.Unplaced.Num()) return Candidate.Unplaced.Num() < Best.Unplaced.Num();
+		return Candidate.UsedRows < Best.UsedRows;
+	}
+}
+
+// ===============================[ Pack Request ]============================
+
+void FPackRequest::ResolveItems(const FItemCatalog& Catalog)
+{
+	check(IsInGameThread());
+
+	for (const FPackEntry& Entry : Contents)
+	{
+		if (Items.Contains(Entry.ItemId)) continue;
+
+		FPackItemInfo& Info = Items.Add(Entry.ItemId);
+		if (!Catalog.IsValidId(Entry.ItemId)) continue;
+
+		Info.MaxStackSize = Catalog.GetStats().GetMaxStackSize(Entry.ItemId);
+		const FItemDetail& Detail = Catalog.GetDetails().Get(Entry.ItemId);
+		const FIntPoint Footprint = Detail.GetFootprint();
+		Info.Footprint = Footprint.X > 0 && Footprint.Y > 0 ? Footprint : FIntPoint(1, 1);
+
+		// The type bits of the capability mask are the EItemType value.
+		const uint32 Type = (static_cast<uint32>(Catalog.GetCapabilities(Entry.ItemId)) >> 8) & 0xFF;
+		Info.TypeOrder = Type == 0 ? MAX_int32 : FMath::FloorLog2(Type);
+		const TConstArrayView<FGameplayTag> Tags = Catalog.GetTagIndex().GetTags();
+		Info.TagKey = Tags.IsValidIndex(Detail.FirstTagSlot) ? Tags[Detail.FirstTagSlot].ToString() : FString();
+	}
+}
+
+// ===============================[ Grid Pack Solver ]============================
+
+FPackResult FGridPackSolver::Solve(const FPackRequest& Request)
+{
+	using namespace GridPackSolver;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	auto ElapsedMicroseconds = [StartCycles]() { return FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000.0; };
+
+	FPackResult Result;
+	Result.ContentVersion = Request.ContentVersion;
+
+	TArray<FPackEntry> Stacks;
+	MergeStacks(Request, Stacks, Result.RemovedHandles);
+
+	// Canonical order: type, first tag, item, then fullest stacks first.
+	FAttempt Best;
+	for (int32 Index = 0; Index < Stacks.Num(); ++Index)
+	{
+		Best.Order.Add(Index);
+	}
+	Algo::StableSort(Best.Order, [&Stacks, &Request](const int32 A, const int32 B)
+	{
+		const FPackItemInfo* InfoA = Request.Items.Find(Stacks[A].ItemId);
+		const FPackItemInfo* InfoB = Request.Items.Find(Stacks[B].ItemId);
+		const int32 TypeA = InfoA ? InfoA->TypeOrder : MAX_int32;
+		const int32 TypeB = InfoB ? InfoB->TypeOrder : MAX_int32;
+		if (TypeA != TypeB) return TypeA < TypeB;
+		if (InfoA && InfoB && InfoA->TagKey != InfoB->TagKey) return InfoA->TagKey < InfoB->TagKey;
+		if (Stacks[A].ItemId != Stacks[B].ItemId) return Stacks[A].ItemId < Stacks[B].ItemId;
+		return Stacks[A].Quantity > Stacks[B].Quantity;
+	});
+	Pack(Stacks, Request.Dimensions, Best);
+	Result.Attempts = 1;
+
+	// No layout can use fewer rows than the total area spread over the full width.
+	int32 TotalArea = 0;
+	for (const FPackEntry& Stack : Stacks)
+	{
+		TotalArea += Stack.Footprint.X * Stack.Footprint.Y;
+	}
+	const int32 MinRows = Request.Dimensions.X > 0 ? FMath::DivideAndRoundUp(TotalArea, Request.Dimensions.X) : 0;
+	auto IsOptimal = [&Best, MinRows]() { return Best.Unplaced.IsEmpty() && Best.UsedRows <= MinRows; };
+
+	FAttempt Candidate;
+	auto TryCandidate = [&]()
+	{
+		Pack(Stacks, Request.Dimensions, Candidate);
+		++Result.Attempts;
+		if (IsBetter(Candidate, Best))
+		{
+			Swap(Best, Candidate);
+		}
+	};
+
+	// Classic first-fit-decreasing orders, each derived from the canonical one so that ties stay sorted.
+	const TArray<int32> CanonicalOrder = Best.Order;
+	const TFunction<int32(const FPackEntry&)> Keys[] =
+	{
+		[](const FPackEntry& Stack) { return Stack.Footprint.X * Stack.Footprint.Y; },
+		[](const FPackEntry& Stack) { return FMath::Max(Stack.Footprint.X, Stack.Footprint.Y); },
+		[](const FPackEntry& Stack) { return Stack.Footprint.X; },
+	};
+	for (const TFunction<int32(const FPackEntry&)>& Key : Keys)
+	{
+		if (IsOptimal() || ElapsedMicroseconds() >= Request.BudgetMicroseconds) break;
+
+		Candidate.Order = CanonicalOrder;
+		Algo::StableSort(Candidate.Order, [&Stacks, &Key](const int32 A, const int32 B) { return Key(Stacks[A]) > Key(Stacks[B]); });
+		TryCandidate();
+	}
+
+	// Local search around the best order until the budget runs out.
+	FRandomStream Random(static_cast<int32>(Request.ContentVersion));
+	while (Stacks.Num() > 1 && !IsOptimal() && ElapsedMicroseconds() < Request.BudgetMicroseconds)
+	{
+		Candidate.Order = Best.Order;
+		const int32 From = Random.RandHelper(Stacks.Num());
+		const int32 To = Random.RandHelper(Stacks.Num());
+		const int32 Moved = Candidate.Order[From];
+		Candidate.Order.RemoveAt(From);
+		Candidate.Order.Insert(Moved, To);
+		TryCandidate();
+	}
+
+	Result.Layout = MoveTemp(Best.Layout);
+	Result.Unplaced = MoveTemp(Best.Unplaced);
+	Result.ElapsedMicroseconds = ElapsedMicroseconds();
+	return Result;
+}
+
+void FGridPackSolver::SolveAsync(FPackRequest Request, TUniqueFunction<void(FPackResult&&)> OnSolved)
+{
+	Async(EAsyncExecution::ThreadPool, [Request = MoveTemp(Request), OnSolved = MoveTemp(OnSolved)]() mutable
+	{
+		FPackResult Result = Solve(Request);
+		AsyncTask(ENamedThreads::GameThread, [Result = MoveTemp(Result), OnSolved = MoveTemp(OnSolved)]() mutable
+		{
+			OnSolved(MoveTemp(Result));
+		});
+	});
+}
+
+bool FGridPackSolver::Apply(const FPackResult& Result, const uint32 CurrentVersion, FGridOccupancy& Grid, TFunctionRef<void(const FPackResult&)> Commit)
+{
+	if (!Result.IsComplete() || Result.ContentVersion != CurrentVersion) return false;
+
+	FGridOccupancy NewGrid(Grid.GetDimensions());
+	for (const FPackEntry& Entry : Result.Layout)
+	{
+		if (!NewGrid.Place(Entry.bRotated ? FGridOccupancy::Rotate(Entry.Footprint) : Entry.Footprint, Entry.Position)) return false;
+	}
+
+	Commit(Result);
+	Grid = MoveTemp(NewGrid);
+	return true;
+}
@@ -0,0 +1,88 @@
+﻿#include "Inventory/ItemAging.h"
+
+#include "Inventory/ItemCatalog.h"
+
+// ===============================[ Item Aging ]============================
+
+double HlpItem::GetPerishLifetime(const FItemCatalog& Catalog, const int32 ItemId)
+{
+	if (!Catalog.HasCapabilities(ItemId, EItemCapability::CanPerish)) return 0.0;
+	return Catalog.GetStats().Get(EItemStat::PerishRate, ItemId) * DefaultPerishTime();
+}
+
+int32 HlpItem::AgeInstance(const FItemCatalog& Catalog, FItemAgingState& State, const double From, const double Now, const float PerishMultiplier, const float WearRate)
+{
+	const FItemStatColumns& Stats = Catalog.GetStats();
+	const double Multiplier = FMath::Max(PerishMultiplier, UE_KINDA_SMALL_NUMBER);
+	double WeatherFrom = From;
+	int32 Steps = 0;
+
+	// Items entered by the chain, with the deadline they had when entered.
+	TArray<TPair<int32, double>, TInlineAllocator<8>> Entered;
+	while (State.PerishDeadline > 0.0 && State.PerishDeadline <= Now)
+	{
+		const int32 Target = Catalog.IsValidId(State.ItemId) ? Catalog.GetPerishTarget(State.ItemId) : INDEX_NONE;
+		WeatherFrom = State.PerishDeadline;
+		++Steps;
+		if (Target == INDEX_NONE)
+		{
+			State.ItemId = INDEX_NONE;
+			State.PerishDeadline = 0.0;
+			return Steps;
+		}
+
+		const double Lifetime = GetPerishLifetime(Catalog, Target) / Multiplier;
+		State.ItemId = Target;
+		State.PerishDeadline = Lifetime > 0.0 ? State.PerishDeadline + Lifetime : 0.0;
+		State.Durability = Stats.Get(EItemStat::MaxDurability, Target);
+		State.Wear = 0.0f;
+
+		const TPair<int32, double>* Loop = Entered.FindByPredicate([Target](const TPair<int32, double>& Item) { return Item.Key == Target; });
+		if (!Loop)
+		{
+			Entered.Emplace(Target, State.PerishDeadline);
+			continue;
+		}
+
+		// Back to an item of the chain: every full loop ends on the same item, only the remainder is walked.
+		const double Period = State.PerishDeadline - Loop->Value;
+		const double Loops = Period > 0.0 ? FMath::FloorToDouble((Now - State.PerishDeadline) / Period) : 0.0;
+		if (Loops > 0.0)
+		{
+			State.PerishDeadline += Loops * Period;
+			WeatherFrom += Loops * Period;
+		}
+		Entered.Reset();
+	}
+
+	if (WearRate > 0.0f && Now > WeatherFrom && Catalog.HasCapabilities(State.ItemId, EItemCapability::HasDurability))
+	{
+		const float MaxDurability = Stats.Get(EItemStat::MaxDurability, State.ItemId);
+		const float MaxWear = Stats.Get(EItemStat::MaxWear, State.ItemId);
+		const float Lost = static_cast<float>(WearRate * (Now - WeatherFrom));
+		State.Wear = FMath::Min(State.Wear + (MaxDurability > 0.0f ? Lost * MaxWear / MaxDurability : 0.0f), MaxWear);
+		State.Durability = FMath::Clamp(State.Durability - Lost, 0.0f, FMath::Max(MaxDurability - State.Wear, 0.0f));
+	}
+	return Steps;
+}
+
+int32 HlpItem::AgeOverdue(const FItemCatalog& Catalog, FItemAgingState& State, const double PerishRemaining, const double SinceEvaluated, const double Now, const float PerishMultiplier, const float WearRate)
+{
+	// Aged in a frame where the saved deadline is at 1, then moved back to the clock of Now.
+	const double Origin = 1.0 - FMath::Min(PerishRemaining, 0.0);
+	State.PerishDeadline = 1.0;
+	const int32 Steps = AgeInstance(Catalog, State, Origin - FMath::Max(SinceEvaluated, 0.0), Origin, PerishMultiplier, WearRate);
+	if (State.PerishDeadline > 0.0)
+	{
+		State.PerishDeadline += Now - Origin;
+	}
+	return Steps;
+}
+
+float HlpItem::GetFreshness(const FItemCatalog& Catalog, const int32 ItemId, const double PerishDeadline, const double Now, const float PerishMultiplier)
+{
+	const double Lifetime = GetPerishLifetime(Catalog, ItemId) / FMath::Max(PerishMultiplier, UE_KINDA_SMALL_NUMBER);
+	if (Lifetime <= 0.0 || PerishDeadline <= 0.0) return 1.0f;
+
+	return static_cast<float>(FMath::Clamp((PerishDeadline - Now) / Lifetime, 0.0, 1.0));
+}
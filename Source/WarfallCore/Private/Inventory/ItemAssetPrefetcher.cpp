@@ -0,0 +1,77 @@
+﻿#include "Inventory/ItemAssetPrefetcher.h"
+
+#include "Engine/Engine.h"
+
+namespace
+{
+	template<typename T>
+	void AddIfNotLoaded(const TSoftObjectPtr<T>& Asset, TSet<FSoftObjectPath>& OutPaths)
+	{
+		if (!Asset.IsNull() && !Asset.IsValid())
+		{
+			OutPaths.Add(Asset.ToSoftObjectPath());
+		}
+	}
+}
+
+void UItemAssetPrefetcher::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency<UItemCatalogSubsystem>();
+}
+
+UItemAssetPrefetcher* UItemAssetPrefetcher::Get()
+{
+	return GEngine ? GEngine->GetEngineSubsystem<UItemAssetPrefetcher>() : nullptr;
+}
+
+TSharedPtr<FStreamableHandle> UItemAssetPrefetcher::Prefetch(TConstArrayView<FItemId> Items, const EItemAssetUsage Usage,
+	FStreamableDelegate OnComplete, const TAsyncLoadPriority Priority)
+{
+	TSet<FSoftObjectPath> Paths;
+	if (const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog(); Catalog && Usage != EItemAssetUsage::None)
+	{
+		for (const FItemId Id : Items)
+		{
+			// Cooked catalogs hold no row: the soft references are read from ItemsTable.
+			if (const FItemRow* Row = Catalog->FindRowOrTable(Id))
+			{
+				CollectPaths(*Row, Usage, Paths);
+			}
+		}
+	}
+
+	if (Paths.IsEmpty())
+	{
+		OnComplete.ExecuteIfBound();
+		return nullptr;
+	}
+	return StreamableManager.RequestAsyncLoad(Paths.Array(), MoveTemp(OnComplete), Priority);
+}
+
+void UItemAssetPrefetcher::Cancel(TSharedPtr<FStreamableHandle>& Handle)
+{
+	if (Handle.IsValid() && Handle->IsActive())
+	{
+		Handle->CancelHandle();
+	}
+	Handle.Reset();
+}
+
+void UItemAssetPrefetcher::CollectPaths(const FItemRow& Row, const EItemAssetUsage Usage, TSet<FSoftObjectPath>& OutPaths)
+{
+	if (EnumHasAnyFlags(Usage, EItemAssetUsage::Icon))
+	{
+		AddIfNotLoaded(Row.Thumbnail.Thumbnail, OutPaths);
+		AddIfNotLoaded(Row.Thumbnail.Layer, OutPaths);
+	}
+	if (EnumHasAnyFlags(Usage, EItemAssetUsage::WorldDrop))
+	{
+		AddIfNotLoaded(Row.DropMesh, OutPaths);
+	}
+	if (EnumHasAnyFlags(Usage, EItemAssetUsage::Equipped))
+	{
+		AddIfNotLoaded(Row.Mesh, OutPaths);
+		AddIfNotLoaded(Row.SkeletalMesh, OutPaths);
+	}
+}
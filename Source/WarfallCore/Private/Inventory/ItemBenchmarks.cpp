@@ -0,0 +1,1109 @@
+﻿#include "Async/ParallelFor.h"
+#include "Core/Player/InventoryComponent.h"
+#include "Crafting/CraftabilityTracker.h"
+#include "Crafting/CraftingJobs.h"
+#include "Crafting/CraftingPlanner.h"
+#include "Crafting/CraftingTypes.h"
+#include "Crafting/RecipeCatalog.h"
+#include "Engine/DataTable.h"
+#include "Inventory/ContainerSearchIndex.h"
+#include "Inventory/ContainerTree.h"
+#include "HAL/IConsoleManager.h"
+#include "Inventory/GridOccupancy.h"
+#include "Inventory/GridPackSolver.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemInstanceStore.h"
+#include "Inventory/ItemSnapshot.h"
+#include "Inventory/PocketFilter.h"
+#include "Inventory/PerishScheduler.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/CoreNet.h"
+#include "Utils/Benchmark.h"
+
+// ===============================[ Item Benchmarks ]============================
+
+namespace ItemBenchmarks
+{
+	constexpr int32 NumSamples = 25;
+	constexpr int32 NumScanSamples = 5;
+	constexpr int32 NumQueries = 1000;
+	/** Data set sizes of the suites when the console command or the automation test does not give any. */
+	constexpr int32 DefaultSizes[] = { 1000, 10000, 100000 };
+	constexpr int32 DefaultNumPlayers = 100;
+	constexpr int32 DefaultNumSeconds = 60;
+	constexpr int32 DefaultNumInstances = 50000;
+
+	/** Written by every benchmark body so that the timed work cannot be optimized away. */
+	int64 Checksum = 0;
+
+	/** Rooted transient items table filled with random rows, plus random recipes over those rows. */
+	struct FSyntheticData
+	{
+		UDataTable* Table = nullptr;
+		TArray<FName> RowNames;
+		TArray<FRecipeRow> Recipes;
+		/** The recipes again, as a recipes table. */
+		UDataTable* RecipesTable = nullptr;
+		/** Quantity held per row name, used by the craftability scan. */
+		TMap<FName, int32> Holdings;
+
+		FSyntheticData(const int32 NumRows, FRandomStream& Random)
+		{
+			const FGameplayTag TagPool[] = { ITEM_Consumable, ITEM_Ammunition, ITEM_Ingredient, INGREDIENTS_RESSOURCES_WoodLog, INGREDIENTS_COMPONENTS_MetalBar };
+			const FGameplayTag MetaPool[] = { ITEM_META_WEAPON_Damage, ITEM_META_WEAPON_AttackSpeed, ITEM_META_ARMOR_ArmorValue, ITEM_META_UTILS_MaxDurability, ITEM_META_UTILS_Weight };
+			const EItemType TypePool[] = { EItemType::E_Weapon, EItemType::E_Armor, EItemType::E_Consumable, EItemType::E_Tool, EItemType::E_Ammunition, EItemType::E_Ingredient };
+			const TCHAR* AdjectivePool[] = { TEXT("Rusty"), TEXT("Fine"), TEXT("Heavy"), TEXT("Sharp"), TEXT("Old"), TEXT("Iron"), TEXT("Steel") };
+			const TCHAR* NounPool[] = { TEXT("Sword"), TEXT("Axe"), TEXT("Bread"), TEXT("Arrow"), TEXT("Plank"), TEXT("Shield"), TEXT("Helmet") };
+
+			Table = NewObject<UDataTable>(GetTransientPackage());
+			Table->RowStruct = FItemRowDetail::StaticStruct();
+			Table->AddToRoot();
+
+			RowNames.Reserve(NumRows);
+			for (int32 Index = 0; Index < NumRows; ++Index)
+			{
+				FItemRowDetail Row;
+				Row.Details.Type = TypePool[Random.RandHelper(UE_ARRAY_COUNT(TypePool))];
+				Row.Details.MaxStackSize = Random.RandRange(1, 100);
+				Row.Details.Quality = Random.RandRange(0, 5);
+				Row.Details.Name = FText::FromString(FString::Printf(TEXT("%s %s"), AdjectivePool[Random.RandHelper(UE_ARRAY_COUNT(AdjectivePool))], NounPool[Random.RandHelper(UE_ARRAY_COUNT(NounPool))]));
+				Row.Details.WeaponDamage = Random.FRandRange(0.0f, 100.0f);
+				Row.Details.Tags.AddTag(TagPool[Random.RandHelper(UE_ARRAY_COUNT(TagPool))]);
+				for (int32 Meta = Random.RandHelper(4); Meta > 0; --Meta)
+				{
+					FItemMetaEntry& Entry = Row.Details.MetaModifiers.AddDefaulted_GetRef();
+					Entry.Key = MetaPool[Random.RandHelper(UE_ARRAY_COUNT(MetaPool))];
+					Entry.Value = Random.FRandRange(-10.0f, 10.0f);
+				}
+
+				const FName RowName(*FString::Printf(TEXT("Bench_Item_%d"), Index));
+				Table->AddRow(RowName, Row);
+				RowNames.Add(RowName);
+				if (Random.FRand() < 0.3f)
+				{
+					Holdings.Add(RowName, Random.RandRange(1, 10));
+				}
+			}
+
+			Recipes.SetNum(NumRows / 4);
+			for (FRecipeRow& Recipe : Recipes)
+			{
+				for (int32 Ingredient = Random.RandRange(2, 4); Ingredient > 0; --Ingredient)
+				{
+					FItemIngredient& Entry = Recipe.Ingredients.AddDefaulted_GetRef();
+					Entry.Ingredient.ID = RowNames[Random.RandHelper(NumRows)];
+					Entry.Quantity = Random.RandRange(1, 3);
+				}
+				Recipe.Results.AddDefaulted_GetRef().Result.ID = RowNames[Random.RandHelper(NumRows)];
+			}
+
+			RecipesTable = NewObject<UDataTable>(GetTransientPackage());
+			RecipesTable->RowStruct = FRecipeRowDetail::StaticStruct();
+			RecipesTable->AddToRoot();
+			for (int32 Index = 0; Index < Recipes.Num(); ++Index)
+			{
+				FRecipeRowDetail Row;
+				Row.Details = Recipes[Index];
+				RecipesTable->AddRow(FName(*FString::Printf(TEXT("Bench_Recipe_%d"), Index)), Row);
+			}
+		}
+
+		~FSyntheticData()
+		{
+			Table->RemoveFromRoot();
+			Table->MarkAsGarbage();
+			RecipesTable->RemoveFromRoot();
+			RecipesTable->MarkAsGarbage();
+		}
+	};
+
+	void RunSuite(FBenchmarkReport& Report, const int32 NumRows)
+	{
+		FRandomStream Random(NumRows);
+		const FSyntheticData Data(NumRows, Random);
+		const UDataTable* Table = Data.Table;
+
+		FItemCatalog Catalog;
+		Report.Run(TEXT("Catalog.Build"), NumRows, NumScanSamples, 1, [&]() { Catalog.Build(Table); });
+
+		// Hot reload: ten edited rows patched in place, to compare against Catalog.Build.
+		TArray<FName> EditedRows;
+		for (int32 Edit = 0; Edit < 10; ++Edit)
+		{
+			EditedRows.Add(Data.RowNames[Random.RandHelper(NumRows)]);
+		}
+		TArray<FItemId> PatchedIds;
+		Report.Run(TEXT("Catalog.PatchRows"), NumRows, NumSamples, EditedRows.Num(), [&]()
+		{
+			Catalog.PatchRows(EditedRows, PatchedIds);
+			Checksum += PatchedIds.Num();
+		});
+
+		TArray<FName> QueryNames;
+		TArray<FItemId> QueryIds;
+		TArray<FName> QueryResults;
+		for (int32 Query = 0; Query < NumQueries; ++Query)
+		{
+			QueryNames.Add(Data.RowNames[Random.RandHelper(NumRows)]);
+			QueryIds.Add(Catalog.FindId(QueryNames.Last()));
+			QueryResults.Add(Data.Recipes.IsEmpty() ? NAME_None : Data.Recipes[Random.RandHelper(Data.Recipes.Num())].Results[0].Result.ID);
+		}
+
+		// Lookups: the former HlpItem::GetItemRow (table search and copy) against the catalog views.
+		Report.Run(TEXT("Lookup.TableFindRowCopy"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			for (const FName RowName : QueryNames)
+			{
+				if (const FItemRowDetail* Row = Table->FindRow<FItemRowDetail>(RowName, TEXT(""), false))
+				{
+					const FItemRow Copy = Row->Details;
+					Checksum += Copy.MaxStackSize;
+				}
+			}
+		});
+		Report.Run(TEXT("Lookup.CatalogFindRow"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			for (const FName RowName : QueryNames)
+			{
+				if (const FItemRow* Row = Catalog.FindRow(RowName))
+				{
+					Checksum += Row->MaxStackSize;
+				}
+			}
+		});
+		Report.Run(TEXT("Lookup.CatalogStatColumn"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			const FItemStatColumns& Stats = Catalog.GetStats();
+			for (const FItemId Id : QueryIds)
+			{
+				Checksum += Stats.GetMaxStackSize(Id);
+			}
+		});
+
+		// Recipe result meta: FRecipeRow::OutMeta searches the table and copies the modifiers.
+		Report.Run(TEXT("Recipe.OutMetaTable"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			for (const FName RowName : QueryResults)
+			{
+				const FItemRowDetail* Row = Table->FindRow<FItemRowDetail>(RowName, TEXT(""), false);
+				const TArray<FItemMetaEntry> Meta = Row ? Row->Details.MetaModifiers : TArray<FItemMetaEntry>();
+				Checksum += Meta.Num();
+			}
+		});
+		Report.Run(TEXT("Recipe.OutMetaCatalog"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			for (const FName RowName : QueryResults)
+			{
+				const FItemRow* Row = Catalog.FindRow(RowName);
+				Checksum += Row ? Row->MetaModifiers.Num() : 0;
+			}
+		});
+
+		// Tag filter of FCustomBaseHandle::RefreshHandle: every row tested against the handle tag.
+		const FString Fragment = ITEM_Ammunition.GetTag().GetTagName().ToString();
+		Report.Run(TEXT("Filter.TableTagScan"), NumRows, NumScanSamples, NumRows, [&]()
+		{
+			for (const FName& RowName : Table->GetRowNames())
+			{
+				const FItemRowDetail* Row = Table->FindRow<FItemRowDetail>(RowName, TEXT(""), false);
+				if (!Row) continue;
+				for (const FGameplayTag& Tag : Row->Details.Tags)
+				{
+					if (Tag.GetTagName().ToString().Contains(Fragment))
+					{
+						++Checksum;
+						break;
+					}
+				}
+			}
+		});
+		FDenseBitSet Matches;
+		Report.Run(TEXT("Filter.TagIndex"), NumRows, NumSamples, NumRows, [&]()
+		{
+			Catalog.GetTagIndex().QueryNameContains(Fragment, Matches);
+			Checksum += Matches.CountSetBits();
+		});
+		Report.Run(TEXT("Filter.Capabilities"), NumRows, NumSamples, NumRows, [&]()
+		{
+			HlpItem::FilterByCapabilities(Catalog.GetCapabilityColumn(), EItemCapability::Weapon, Matches);
+			Checksum += Matches.CountSetBits();
+		});
+
+		// Pocket admission: the row tags tested against the filters, against the compiled bit.
+		const FItemTagIndex& TagIndex = Catalog.GetTagIndex();
+		TArray<FPocketSpec> PocketSpecs;
+		PocketSpecs.SetNum(8);
+		for (FPocketSpec& Spec : PocketSpecs)
+		{
+			Spec.Whitelist.AddTag(TagIndex.GetTags()[Random.RandHelper(TagIndex.NumTags())]);
+			Spec.Whitelist.AddTag(TagIndex.GetTags()[Random.RandHelper(TagIndex.NumTags())]);
+			Spec.Blacklist.AddTag(TagIndex.GetTags()[Random.RandHelper(TagIndex.NumTags())]);
+		}
+		TArray<FPocketFilter> PocketFilters;
+		PocketFilters.SetNum(PocketSpecs.Num());
+		TArray<const FPocketFilter*> Pockets;
+		for (int32 Pocket = 0; Pocket < PocketSpecs.Num(); ++Pocket)
+		{
+			PocketFilters[Pocket].Compile(TagIndex, PocketSpecs[Pocket]);
+			Pockets.Add(&PocketFilters[Pocket]);
+		}
+		Report.Run(TEXT("Pocket.AdmitRowTags"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			for (const FItemId Id : QueryIds)
+			{
+				const FItemRow* Row = Catalog.FindRow(Id);
+				Checksum += Row && Row->Tags.HasAny(PocketSpecs[0].Whitelist) && !Row->Tags.HasAny(PocketSpecs[0].Blacklist);
+			}
+		});
+		Report.Run(TEXT("Pocket.AdmitBit"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			for (const FItemId Id : QueryIds)
+			{
+				Checksum += PocketFilters[0].Admits(Id);
+			}
+		});
+		const FGameplayTag EditedTag = TagIndex.GetTags()[Random.RandHelper(TagIndex.NumTags())];
+		Report.Run(TEXT("Pocket.EditFilter"), NumRows, NumSamples, 2, [&]()
+		{
+			PocketFilters[0].AddTag(TagIndex, EditedTag, false);
+			PocketFilters[0].RemoveTag(TagIndex, EditedTag, false);
+			Checksum += PocketFilters[0].Admits(QueryIds[0]);
+		});
+		FDenseBitSet Loot(TagIndex.NumItems());
+		TArray<FDenseBitSet> Routed;
+		Report.Run(TEXT("Pocket.RouteLoot"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			Loot.ClearAll();
+			for (const FItemId Id : QueryIds)
+			{
+				Loot.Set(Id);
+			}
+			FPocketFilter::Route(Pockets, Loot, Routed);
+			Checksum += Loot.CountSetBits();
+		});
+
+		// Craftability: every recipe tested against the holdings, ingredient by ingredient.
+		Report.Run(TEXT("Craftable.NaiveScan"), NumRows, NumScanSamples, FMath::Max(Data.Recipes.Num(), 1), [&]()
+		{
+			for (const FRecipeRow& Recipe : Data.Recipes)
+			{
+				bool bCraftable = true;
+				for (const FItemIngredient& Ingredient : Recipe.Ingredients)
+				{
+					const int32* Held = Data.Holdings.Find(Ingredient.Ingredient.ID);
+					if (!Held || *Held < Ingredient.Quantity)
+					{
+						bCraftable = false;
+						break;
+					}
+				}
+				Checksum += bCraftable;
+			}
+		});
+
+		// Craftability through the reverse ingredient index: only the recipes using something held are checked.
+		FRecipeCatalog Recipes;
+		Report.Run(TEXT("Craftable.IndexBuild"), NumRows, NumScanSamples, 1, [&]() { Recipes.Build(Data.RecipesTable, Catalog); });
+		TMap<int32, int32> HeldIds;
+		TMap<int32, int32> FewHeldIds;
+		for (const TPair<FName, int32>& Held : Data.Holdings)
+		{
+			HeldIds.Add(Catalog.FindId(Held.Key), Held.Value);
+			if (FewHeldIds.Num() < 40)
+			{
+				FewHeldIds.Add(Catalog.FindId(Held.Key), Held.Value);
+			}
+		}
+		// Recipe result meta baked by the recipe catalog: one span per result, no lookup.
+		TArray<int32> QueryRecipeIds;
+		for (int32 Query = 0; Query < NumQueries && !Recipes.IsEmpty(); ++Query)
+		{
+			QueryRecipeIds.Add(Random.RandHelper(Recipes.Num()));
+		}
+		Report.Run(TEXT("Recipe.OutMetaBaked"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			for (const int32 RecipeId : QueryRecipeIds)
+			{
+				Checksum += Recipes.GetResultMeta(RecipeId, 0).Num();
+			}
+		});
+
+		TArray<FCraftableRecipe> Craftable;
+		Report.Run(TEXT("Craftable.Index"), NumRows, NumScanSamples, FMath::Max(Data.Recipes.Num(), 1), [&]()
+		{
+			Recipes.FindCraftable(HeldIds, Catalog, Craftable);
+			Checksum += Craftable.Num();
+		});
+		// A player inventory holds a few dozen items, whatever the size of the recipes table.
+		Report.Run(TEXT("Craftable.IndexPlayerInventory"), NumRows, NumSamples, FMath::Max(Data.Recipes.Num(), 1), [&]()
+		{
+			Recipes.FindCraftable(FewHeldIds, Catalog, Craftable);
+			Checksum += Craftable.Num();
+		});
+
+		// A player knowing every recipe picks items up and drops them: only the recipes using the item are visited.
+		FCraftabilityTracker Tracker;
+		Tracker.Reset(Recipes, Catalog, FewHeldIds);
+		for (int32 RecipeId = 0; RecipeId < Recipes.Num(); ++RecipeId)
+		{
+			Tracker.Track(RecipeId);
+		}
+		TArray<int32> PickedIds;
+		for (int32 Query = 0; Query < NumQueries; ++Query)
+		{
+			PickedIds.Add(Random.RandHelper(Catalog.Num()));
+		}
+		TArray<FCraftabilityChange> Changes;
+		Report.Run(TEXT("Craftable.TrackerDelta"), NumRows, NumSamples, NumQueries, [&]()
+		{
+			Changes.Reset();
+			for (const int32 ItemId : PickedIds)
+			{
+				const int32* Held = Tracker.GetHoldings().Find(ItemId);
+				Tracker.SetHeld(ItemId, Held ? 0 : 5, Changes);
+			}
+			Checksum += Changes.Num();
+		});
+
+		// Multi-level plans from a player inventory, random recipes making plenty of cycles for the build to set aside.
+		FCraftingPlanner Planner;
+		Report.Run(TEXT("Craft.PlannerBuild"), NumRows, NumScanSamples, FMath::Max(Recipes.Num(), 1), [&]() { Checksum += Planner.Build(Recipes); });
+		TArray<int32> TargetIds;
+		for (int32 Query = 0; Query < NumQueries && !Recipes.IsEmpty(); ++Query)
+		{
+			for (const FRecipeResult& Result : Recipes.GetResults(Random.RandHelper(Recipes.Num())))
+			{
+				TargetIds.Add(Result.ItemId);
+			}
+		}
+		FCraftingPlan Plan;
+		Report.Run(TEXT("Craft.Plan"), NumRows, NumSamples, FMath::Max(TargetIds.Num(), 1), [&]()
+		{
+			for (const int32 ItemId : TargetIds)
+			{
+				Checksum += Planner.Plan(ItemId, 2, FewHeldIds, Catalog, Plan) + Plan.NumCrafts;
+			}
+		});
+
+		// Timed jobs of thousands of players: heap churn, then the per-job work spread over worker tasks.
+		TArray<FCraftingJob> JobTemplates;
+		for (const int32 ItemId : TargetIds)
+		{
+			Planner.Plan(ItemId, 2, HeldIds, Catalog, Plan);
+			FCraftingJob& Job = JobTemplates.AddDefaulted_GetRef();
+			Job.ItemId = ItemId;
+			Job.Steps = Plan.Steps;
+			Job.ConsumedItems = Plan.ConsumedItems;
+			Job.CompletionTime = Random.FRandRange(0.0f, 60.0f);
+		}
+		FCraftingJobQueue JobQueue;
+		TArray<FCraftingJob> DueJobs;
+		Report.Run(TEXT("Craft.JobQueue"), NumRows, NumSamples, FMath::Max(JobTemplates.Num(), 1), [&]()
+		{
+			for (const FCraftingJob& Job : JobTemplates)
+			{
+				JobQueue.Push(CopyTemp(Job));
+			}
+			DueJobs.Reset();
+			Checksum += JobQueue.PopDue(60.0, MAX_int32, DueJobs);
+		});
+		TArray<FCraftingJobOutput> JobOutputs;
+		JobOutputs.SetNum(DueJobs.Num());
+		Report.Run(TEXT("Craft.JobResolveParallel"), NumRows, NumSamples, FMath::Max(DueJobs.Num(), 1), [&]()
+		{
+			ParallelFor(DueJobs.Num(), [&](const int32 Index)
+			{
+				JobOutputs[Index].Stacks.Reset();
+				FCraftingJobQueue::ResolveOutput(DueJobs[Index], Recipes, Catalog, JobOutputs[Index]);
+			});
+			Checksum += JobOutputs.Num();
+		});
+	}
+
+	/** Loot pickups into a half-filled 40-slot bag. */
+	void RunGridSuite(FBenchmarkReport& Report)
+	{
+		FRandomStream Random(40);
+		const FBagSpec Bag = []() { FBagSpec Spec; Spec.Dimensions = FIntPoint(8, 5); return Spec; }();
+		FGridOccupancy Grid(Bag.Dimensions);
+		while (Grid.CountFreeCells() > 20)
+		{
+			Grid.Place(FIntPoint(Random.RandRange(1, 2), Random.RandRange(1, 2)), FIntPoint(Random.RandHelper(8), Random.RandHelper(5)));
+		}
+
+		TArray<FIntPoint> Footprints;
+		for (int32 Query = 0; Query < NumQueries; ++Query)
+		{
+			Footprints.Add(FIntPoint(Random.RandRange(1, 3), Random.RandRange(1, 3)));
+		}
+
+		Report.Run(TEXT("Grid.CanPlace"), 40, NumSamples, NumQueries, [&]()
+		{
+			for (int32 Query = 0; Query < NumQueries; ++Query)
+			{
+				Checksum += Grid.CanPlace(Footprints[Query], FIntPoint(Query & 7, Query % 5));
+			}
+		});
+		Report.Run(TEXT("Grid.FindFirstFreeRotated"), 40, NumSamples, NumQueries, [&]()
+		{
+			FIntPoint Position;
+			bool bRotated;
+			for (const FIntPoint Footprint : Footprints)
+			{
+				Checksum += Grid.FindFirstFreeRotated(Footprint, Position, bRotated) ? Position.X + Position.Y : 0;
+			}
+		});
+	}
+
+	/** Sorting of a 10x20 container holding mixed footprints, at several search budgets. */
+	void RunPackSuite(FBenchmarkReport& Report)
+	{
+		FRandomStream Random(200);
+		FPackRequest Request;
+		Request.Dimensions = FIntPoint(10, 20);
+		for (int32 ItemId = 0; ItemId < 30; ++ItemId)
+		{
+			FPackItemInfo& Info = Request.Items.Add(ItemId);
+			Info.Footprint = FIntPoint(Random.RandRange(1, 3), Random.RandRange(1, 3));
+			Info.MaxStackSize = Random.RandRange(1, 20);
+			Info.TypeOrder = Random.RandHelper(6);
+		}
+		for (int32 Handle = 0; Handle < 60; ++Handle)
+		{
+			FPackEntry& Entry = Request.Contents.AddDefaulted_GetRef();
+			Entry.Handle = Handle;
+			Entry.ItemId = Random.RandHelper(30);
+			Entry.Quantity = Random.RandRange(1, Request.Items[Entry.ItemId].MaxStackSize);
+		}
+
+		for (const int32 Budget : { 0, 200, 1000 })
+		{
+			Request.BudgetMicroseconds = Budget;
+			Report.Run(FString::Printf(TEXT("Pack.Solve.%dus"), Budget), 200, NumScanSamples, 1, [&]()
+			{
+				const FPackResult Result = FGridPackSolver::Solve(Request);
+				Checksum += Result.Unplaced.Num() + Result.Attempts;
+			});
+		}
+	}
+
+	/** Instance churn on a store already holding a server-sized population, in random destroy/create order. */
+	void RunInstanceSuite(FBenchmarkReport& Report)
+	{
+		constexpr int32 NumLive = 200000;
+		FRandomStream Random(NumLive);
+		FItemInstanceStore Store;
+		TArray<FItemHandle> Handles;
+		Handles.Reserve(NumLive);
+		for (int32 Index = 0; Index < NumLive; ++Index)
+		{
+			Handles.Add(Store.Create(Random.RandHelper(1000), 1, 100.0f));
+		}
+
+		TArray<int32> Victims;
+		for (int32 Query = 0; Query < NumQueries; ++Query)
+		{
+			Victims.Add(Random.RandHelper(NumLive));
+		}
+
+		Report.Run(TEXT("Instances.DestroyCreate"), NumLive, NumSamples, NumQueries, [&]()
+		{
+			for (const int32 Victim : Victims)
+			{
+				Store.Destroy(Handles[Victim]);
+				Handles[Victim] = Store.Create(Victim % 1000, 1, 100.0f);
+			}
+			Checksum += Store.GetCapacity();
+		});
+		Report.Run(TEXT("Instances.ReadStack"), NumLive, NumSamples, NumQueries, [&]()
+		{
+			for (const int32 Victim : Victims)
+			{
+				Checksum += Store.IsValid(Handles[Victim]) ? Store.GetStack(Handles[Victim]) : 0;
+			}
+		});
+
+		// Every instance perishes within the hour; each op advances the clock by one second and renews what expired.
+		FPerishScheduler Scheduler;
+		for (const FItemHandle Handle : Handles)
+		{
+			Scheduler.Schedule(Handle, Random.FRandRange(1.0f, 3600.0f));
+		}
+		Report.Run(TEXT("Perish.Reschedule"), NumLive, NumSamples, NumQueries, [&]()
+		{
+			for (const int32 Victim : Victims)
+			{
+				Scheduler.Schedule(Handles[Victim], Random.FRandRange(1.0f, 3600.0f));
+			}
+			Checksum += Scheduler.Num();
+		});
+
+		double Now = 0.0;
+		TArray<FItemHandle> Expired;
+		Report.Run(TEXT("Perish.AdvanceSecond"), NumLive, NumSamples, 1, [&]()
+		{
+			Now += 1.0;
+			Expired.Reset();
+			Scheduler.Advance(Now, Expired);
+			for (const FItemHandle Handle : Expired)
+			{
+				Scheduler.Schedule(Handle, Now + 3600.0);
+			}
+			Checksum += Expired.Num();
+		});
+	}
+
+	/** Mass of a subtree summed node by node, what encumbrance cost without the cached aggregates. */
+	double RecountMass(const FItemContainerTree& Tree, const FItemHandle Handle, const TArray<double>& SelfMasses)
+	{
+		double Mass = SelfMasses[Handle.GetIndex()];
+		Tree.ForEachContent(Handle, [&](const FItemHandle Content) { Mass += RecountMass(Tree, Content, SelfMasses); });
+		return Mass;
+	}
+
+	/** Players carrying bags nested four deep, 20 items per bag; each op consumes one item and reads the encumbrance. */
+	void RunContainerSuite(FBenchmarkReport& Report)
+	{
+		constexpr int32 NumPlayers = 100;
+		constexpr int32 Depth = 4;
+		constexpr int32 ItemsPerBag = 20;
+		FRandomStream Random(NumPlayers);
+		FItemInstanceStore Store;
+		FItemContainerTree Tree;
+		TArray<double> SelfMasses;
+		TArray<FItemHandle> Items;
+		TArray<FItemHandle> Roots;
+		TArray<int32> Owners;
+
+		auto AddItem = [&](const FItemHandle Parent, const int32 Capacity)
+		{
+			FContainedItem Item;
+			Item.Mass = Random.FRandRange(0.1f, 5.0f);
+			Item.Cells = 1;
+			Item.Capacity = Capacity;
+			const FItemHandle Handle = Store.Create(Random.RandHelper(1000), 1, 100.0f);
+			SelfMasses.SetNum(FMath::Max(SelfMasses.Num(), static_cast<int32>(Handle.GetIndex()) + 1));
+			SelfMasses[Handle.GetIndex()] = Item.Mass;
+			Tree.Insert(Handle, Parent, Item);
+			return Handle;
+		};
+
+		for (int32 Player = 0; Player < NumPlayers; ++Player)
+		{
+			const int32 Owner = Tree.AddOwner();
+			FItemHandle Bag = AddItem(FItemHandle(), ItemsPerBag + 1);
+			Roots.Add(Bag);
+			Owners.Add(Owner);
+			Tree.SetOwner(Bag, Owner);
+			for (int32 Level = 0; Level < Depth; ++Level)
+			{
+				for (int32 Index = 0; Index < ItemsPerBag; ++Index)
+				{
+					Items.Add(AddItem(Bag, 0));
+				}
+				Bag = AddItem(Bag, ItemsPerBag + 1);
+			}
+		}
+
+		TArray<int32> Victims;
+		for (int32 Query = 0; Query < NumQueries; ++Query)
+		{
+			Victims.Add(Random.RandHelper(Items.Num()));
+		}
+
+		const int32 NumItems = Tree.Num();
+		Report.Run(TEXT("Containers.ConsumeCached"), NumItems, NumSamples, NumQueries, [&]()
+		{
+			for (const int32 Victim : Victims)
+			{
+				const FItemHandle Handle = Items[Victim];
+				FContainedItem Item;
+				Item.Mass = SelfMasses[Handle.GetIndex()] *= 0.99;
+				Item.Cells = 1;
+				Tree.Update(Handle, Item);
+				Checksum += static_cast<int64>(Tree.GetOwnerMass(Owners[Victim % NumPlayers]));
+			}
+		});
+		Report.Run(TEXT("Containers.ConsumeRecount"), NumItems, NumSamples, NumQueries, [&]()
+		{
+			for (const int32 Victim : Victims)
+			{
+				const FItemHandle Handle = Items[Victim];
+				SelfMasses[Handle.GetIndex()] *= 0.99;
+				Checksum += static_cast<int64>(RecountMass(Tree, Tree.GetRoot(Handle), SelfMasses));
+			}
+		});
+		Report.Run(TEXT("Containers.MoveBetweenPlayers"), NumItems, NumSamples, NumQueries, [&]()
+		{
+			for (const int32 Victim : Victims)
+			{
+				Tree.Move(Items[Victim], Roots[Random.RandHelper(NumPlayers)]);
+			}
+			Checksum += static_cast<int64>(Tree.GetOwnerMass(0));
+		});
+	}
+
+	/**
+	 * Guild vault round trip: instances in bags of 20, written and read back chunk by chunk.
+	 * Every field read back is checked against the store, and the longest chunk, the cost of one frame, is logged.
+	 */
+	void RunSnapshotSuite(FBenchmarkReport& Report, const int32 NumInstances)
+	{
+		constexpr int32 ItemsPerBag = 20;
+		constexpr double Now = 1000.0;
+		FRandomStream Random(NumInstances);
+		const FSyntheticData Data(1000, Random);
+		FItemCatalog Catalog;
+		Catalog.Build(Data.Table);
+
+		FItemInstanceStore Store;
+		FItemContainerTree Tree;
+		TArray<FItemHandle> Roots;
+		FItemHandle Bag;
+		for (int32 Index = 0; Index < NumInstances; ++Index)
+		{
+			const FItemHandle Handle = Store.Create(Random.RandHelper(Catalog.Num()), 1 + Random.RandHelper(20), Random.FRandRange(0.0f, 100.0f));
+			Store.SetWear(Handle, Random.FRandRange(0.0f, 10.0f));
+			Store.SetLastEvaluated(Handle, Now - Random.FRandRange(0.0f, 60.0f));
+			if (Random.RandHelper(4) == 0)
+			{
+				Store.SetPerishDeadline(Handle, Now + Random.FRandRange(1.0f, 3600.0f));
+				Store.SetAgingMode(Handle, Random.RandHelper(2) ? EItemAgingMode::Lazy : EItemAgingMode::Scheduled);
+			}
+
+			const FItemHandle Parent = Index % ItemsPerBag == 0 ? FItemHandle() : Bag;
+			Tree.Insert(Handle, Parent, FContainedItem());
+			Store.SetContainer(Handle, Parent);
+			if (!Parent.IsValid())
+			{
+				Bag = Handle;
+				Roots.Add(Handle);
+			}
+		}
+
+		TArray<uint8> Bytes;
+		TArray<FItemHandle> Order;
+		double LongestChunk = 0.0;
+		auto WriteSnapshot = [&](const bool bCompress)
+		{
+			Bytes.Reset();
+			FMemoryWriter Ar(Bytes);
+			FItemSnapshotWriter Writer(Ar, Store, Tree, Catalog, bCompress);
+			for (int32 Root = 0; Root < Roots.Num(); ++Root)
+			{
+				FItemSnapshotPlacement Placement;
+				Placement.Pocket = static_cast<uint8>(Root % 4);
+				Placement.CellX = static_cast<uint8>(Root % 8);
+				Placement.CellY = static_cast<uint8>(Root / 8 % 8);
+				Placement.bRotated = Root % 3 == 0;
+				Writer.AddRoot(Roots[Root], &Placement);
+			}
+
+			bool bMore = true;
+			while (bMore)
+			{
+				const double Start = FPlatformTime::Seconds();
+				bMore = Writer.WriteChunk(Now);
+				LongestChunk = FMath::Max(LongestChunk, FPlatformTime::Seconds() - Start);
+			}
+
+			Order.Reset();
+			for (int32 Index = 0; Index < Writer.Num(); ++Index)
+			{
+				Order.Add(Writer.GetHandle(Index));
+			}
+		};
+
+		TArray<FItemSnapshotEntry> Entries;
+		auto ReadSnapshot = [&]()
+		{
+			Entries.Reset();
+			FMemoryReader Ar(Bytes);
+			FItemSnapshotReader Reader(Ar);
+			if (!Reader.ReadHeader()) return false;
+
+			int32 NumRead = 0;
+			do
+			{
+				NumRead = Reader.ReadChunk(Entries);
+			}
+			while (NumRead > 0);
+			return NumRead == 0;
+		};
+
+		Report.Run(TEXT("Snapshot.WriteRaw"), NumInstances, NumScanSamples, NumInstances, [&]()
+		{
+			WriteSnapshot(false);
+			Checksum += Bytes.Num();
+		});
+		const int32 RawBytes = Bytes.Num();
+		LongestChunk = 0.0;
+		Report.Run(TEXT("Snapshot.WriteCompressed"), NumInstances, NumScanSamples, NumInstances, [&]()
+		{
+			WriteSnapshot(true);
+			Checksum += Bytes.Num();
+		});
+		Report.Run(TEXT("Snapshot.ReadCompressed"), NumInstances, NumScanSamples, NumInstances, [&]()
+		{
+			Checksum += ReadSnapshot() ? Entries.Num() : 0;
+		});
+
+		// What the generic path costs: every instance as a tagged FItemInstance.
+		TArray<uint8> GenericBytes;
+		FItemInstance Instance;
+		Report.Run(TEXT("Snapshot.GenericStruct"), NumInstances, NumScanSamples, NumInstances, [&]()
+		{
+			GenericBytes.Reset();
+			FMemoryWriter Ar(GenericBytes);
+			Store.ForEach([&](const FItemHandle Handle)
+			{
+				Store.Read(Handle, Catalog, Instance);
+				FItemInstance::StaticStruct()->SerializeItem(Ar, &Instance, nullptr);
+			});
+			Checksum += GenericBytes.Num();
+		});
+
+		// Round trip of the last compressed snapshot, field by field.
+		int32 Mismatches = ReadSnapshot() && Entries.Num() == Order.Num() ? 0 : FMath::Max(Order.Num(), 1);
+		for (int32 Index = 0; Mismatches == 0 && Index < Entries.Num(); ++Index)
+		{
+			const FItemSnapshotEntry& Entry = Entries[Index];
+			const FItemHandle Handle = Order[Index];
+			const FItemHandle Parent = Tree.GetParent(Handle);
+			const bool bPerishes = Store.GetPerishDeadline(Handle) > 0.0;
+			const bool bMatch = Entry.ItemID == Catalog.GetRowName(Store.GetItemId(Handle))
+				&& Entry.Stack == Store.GetStack(Handle)
+				&& Entry.Durability == Store.GetDurability(Handle)
+				&& Entry.Wear == Store.GetWear(Handle)
+				&& Entry.AgingMode == Store.GetAgingMode(Handle)
+				&& Entry.bPerishes == bPerishes
+				&& (!bPerishes || Entry.PerishRemaining == Store.GetPerishDeadline(Handle) - Now)
+				&& Entry.SinceEvaluated == Now - Store.GetLastEvaluated(Handle)
+				&& (Entry.Parent == INDEX_NONE ? !Parent.IsValid() : Order[Entry.Parent] == Parent)
+				&& Entry.bHasPlacement == !Parent.IsValid();
+			Mismatches += !bMatch;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Snapshot: %d instances, %d bytes raw, %d bytes compressed, %d bytes as generic structs, longest chunk %.3f ms."),
+			NumInstances, RawBytes, Bytes.Num(), GenericBytes.Num(), LongestChunk * 1000.0);
+		UE_CLOG(Mismatches > 0, LogTemp, Error, TEXT("Snapshot: round trip failed, %d instances differ."), Mismatches);
+		UE_CLOG(Mismatches == 0, LogTemp, Display, TEXT("Snapshot: round trip identical."));
+	}
+
+	/**
+	 * Replication traffic of player inventories, each sent to its owner at NetHz while the players play.
+	 * Delta is what the fast array sends: one header per updated array, then the id and packed bits of each dirty slot.
+	 * Full is the whole container, row handles as names, every time any slot changed.
+	 */
+	void RunInventoryNetSuite(FBenchmarkReport& Report, const int32 NumPlayers, const int32 NumSeconds)
+	{
+		constexpr int32 SlotsPerPlayer = 40;
+		constexpr int32 NetHz = 30;
+		/** Array replication key, base replication key, deleted and changed counts. */
+		constexpr int32 ArrayHeaderBytes = 16;
+		/** Replication id written before each changed slot. */
+		constexpr int32 SlotHeaderBytes = 4;
+		constexpr float MovesPerSecond = 1.0f;
+		constexpr float StackChangesPerSecond = 0.5f;
+		constexpr float DurabilityStepsPerSecond = 0.2f;
+
+		FRandomStream Random(NumPlayers);
+		TArray<TArray<FInventorySlot>> Inventories;
+		Inventories.SetNum(NumPlayers);
+		for (TArray<FInventorySlot>& Slots : Inventories)
+		{
+			for (int32 Index = 0; Index < SlotsPerPlayer; ++Index)
+			{
+				FInventorySlot& Slot = Slots.AddDefaulted_GetRef();
+				Slot.ReplicationID = Index;
+				Slot.ItemId = static_cast<uint16>(Random.RandHelper(2000));
+				Slot.Stack = static_cast<uint16>(Random.RandRange(1, 20));
+				Slot.Pocket = static_cast<uint8>(Random.RandHelper(4));
+				Slot.CellX = static_cast<uint8>(Random.RandHelper(8));
+				Slot.CellY = static_cast<uint8>(Random.RandHelper(6));
+				Slot.Durability = Random.FRand() < 0.3f ? static_cast<uint8>(Random.RandRange(1, 255)) : 0;
+				Slot.PerishDeadline = Random.FRand() < 0.2f ? static_cast<uint32>(Random.RandRange(60, 100000)) : 0;
+			}
+		}
+
+		auto DeltaSlotBytes = [](FInventorySlot& Slot)
+		{
+			FBitWriter Writer(0, true);
+			bool bSuccess = true;
+			Slot.NetSerialize(Writer, nullptr, bSuccess);
+			return SlotHeaderBytes + Writer.GetNumBytes();
+		};
+		auto FullContainerBytes = [](const TArray<FInventorySlot>& Slots)
+		{
+			FBitWriter Writer(0, true);
+			int32 Count = Slots.Num();
+			Writer << Count;
+			for (const FInventorySlot& Slot : Slots)
+			{
+				FName RowName(*FString::Printf(TEXT("Row%d"), Slot.ItemId));
+				FName Tag(TEXT("Weapon"));
+				UPackageMap::StaticSerializeName(Writer, RowName);
+				UPackageMap::StaticSerializeName(Writer, Tag);
+				int32 Stack = Slot.Stack;
+				float Durability = Slot.Durability;
+				float Wear = Slot.Wear;
+				double Deadline = Slot.PerishDeadline;
+				FIntPoint Cell = Slot.GetCell();
+				uint8 Pocket = Slot.Pocket;
+				Writer << Stack << Durability << Wear << Deadline << Cell << Pocket;
+			}
+			return Writer.GetNumBytes();
+		};
+
+		int64 DeltaBytes = 0;
+		int64 FullBytes = 0;
+		int32 NumTicks = 0;
+		TArray<TArray<int32>> Dirty;
+		Dirty.SetNum(NumPlayers);
+		auto NetTick = [&]()
+		{
+			for (int32 Player = 0; Player < NumPlayers; ++Player)
+			{
+				TArray<FInventorySlot>& Slots = Inventories[Player];
+				if (Random.FRand() < MovesPerSecond / NetHz)
+				{
+					const int32 Index = Random.RandHelper(SlotsPerPlayer);
+					Slots[Index].CellX = static_cast<uint8>(Random.RandHelper(8));
+					Slots[Index].CellY = static_cast<uint8>(Random.RandHelper(6));
+					Dirty[Player].AddUnique(Index);
+				}
+				if (Random.FRand() < StackChangesPerSecond / NetHz)
+				{
+					const int32 Index = Random.RandHelper(SlotsPerPlayer);
+					Slots[Index].Stack = static_cast<uint16>(FMath::Max(Slots[Index].Stack + Random.RandRange(-3, 3), 1));
+					Dirty[Player].AddUnique(Index);
+				}
+				if (Random.FRand() < DurabilityStepsPerSecond / NetHz)
+				{
+					const int32 Index = Random.RandHelper(SlotsPerPlayer);
+					Slots[Index].Durability = static_cast<uint8>(FMath::Max(Slots[Index].Durability - 1, 0));
+					Dirty[Player].AddUnique(Index);
+				}
+				if (Dirty[Player].IsEmpty()) continue;
+
+				DeltaBytes += ArrayHeaderBytes;
+				for (const int32 Index : Dirty[Player])
+				{
+					DeltaBytes += DeltaSlotBytes(Slots[Index]);
+				}
+				FullBytes += FullContainerBytes(Slots);
+				Dirty[Player].Reset();
+			}
+			++NumTicks;
+		};
+
+		for (int32 Tick = 0; Tick < NumSeconds * NetHz; ++Tick)
+		{
+			NetTick();
+		}
+		Report.Run(FString::Printf(TEXT("InventoryNet.Tick.%dPlayers"), NumPlayers), NumPlayers * SlotsPerPlayer, NumSamples, 1, NetTick);
+
+		int64 SingleSlotBytes = 0;
+		for (FInventorySlot& Slot : Inventories[0])
+		{
+			SingleSlotBytes += ArrayHeaderBytes + DeltaSlotBytes(Slot);
+		}
+
+		const double Seconds = static_cast<double>(NumTicks) / NetHz;
+		UE_LOG(LogTemp, Display, TEXT("InventoryNet: %d players, %d slots each, %d Hz over %.0f s."), NumPlayers, SlotsPerPlayer, NetHz, Seconds);
+		UE_LOG(LogTemp, Display, TEXT("InventoryNet: delta %.2f KB/s (%.1f B/s per player), full containers %.2f KB/s, %.1fx less."),
+			DeltaBytes / Seconds / 1024.0, DeltaBytes / Seconds / NumPlayers, FullBytes / Seconds / 1024.0, DeltaBytes > 0 ? static_cast<double>(FullBytes) / DeltaBytes : 0.0);
+		UE_LOG(LogTemp, Display, TEXT("InventoryNet: one moved stack costs %.1f bytes, the full container %lld bytes."),
+			static_cast<double>(SingleSlotBytes) / SlotsPerPlayer, FullContainerBytes(Inventories[0]));
+	}
+
+	/** One guild storage searched by capability, quality and name, sorted by name, against reading the row of every instance. */
+	void RunSearchSuite(FBenchmarkReport& Report)
+	{
+		constexpr int32 NumInstances = 10000;
+		constexpr int32 PageSize = 50;
+		FRandomStream Random(NumInstances);
+		const FSyntheticData Data(1000, Random);
+		FItemCatalog Catalog;
+		Catalog.Build(Data.Table);
+
+		FItemInstanceStore Store;
+		FContainerSearchIndex Index;
+		TArray<FItemHandle> Handles;
+		for (int32 Count = 0; Count < NumInstances; ++Count)
+		{
+			const FItemHandle Handle = Store.Create(Random.RandHelper(Catalog.Num()), 1 + Random.RandHelper(20), 100.0f);
+			Handles.Add(Handle);
+			Index.Insert(Handle, Store.GetItemId(Handle), Catalog);
+		}
+
+		FContainerSearchQuery Query;
+		Query.Capabilities = EItemCapability::Stackable;
+		Query.MinQuality = 2;
+		Query.Text = TEXT("ste");
+
+		TArray<FItemHandle> Results;
+		Report.Run(TEXT("Search.RowScan"), NumInstances, NumSamples, 1, [&]()
+		{
+			TArray<TPair<FString, FItemHandle>> Found;
+			TArray<FString> Words;
+			for (const FItemHandle Handle : Handles)
+			{
+				const int32 ItemId = Store.GetItemId(Handle);
+				const FItemRow* Row = Catalog.FindRow(ItemId);
+				if (!Row || Row->Quality < Query.MinQuality || !EnumHasAllFlags(Catalog.GetCapabilities(ItemId), Query.Capabilities)) continue;
+
+				const FString Name = Row->Name.ToString();
+				Words.Reset();
+				FContainerSearchIndex::Tokenize(Name, Words);
+				if (Words.ContainsByPredicate([&](const FString& Word) { return Word.StartsWith(Query.Text); }))
+				{
+					Found.Emplace(Name.ToLower(), Handle);
+				}
+			}
+			Found.StableSort([](const TPair<FString, FItemHandle>& A, const TPair<FString, FItemHandle>& B) { return A.Key < B.Key; });
+			Checksum += Found.Num();
+		});
+		Report.Run(TEXT("Search.Index"), NumInstances, NumSamples, 1, [&]()
+		{
+			Index.Search(Query, Store, EContainerSortKey::Name, false, Results);
+			Checksum += Results.Num();
+		});
+
+		// Paging through an unchanged storage only copies the page.
+		FContainerSearchView View;
+		View.SetQuery(Query, EContainerSortKey::Name, false);
+		Report.Run(TEXT("Search.PageUnchanged"), NumInstances, NumSamples, NumQueries, [&]()
+		{
+			for (int32 Page = 0; Page < NumQueries; ++Page)
+			{
+				View.Refresh(Index, Store);
+				Checksum += View.GetPage(Page % FMath::Max(View.GetNumPages(PageSize), 1), PageSize).Num();
+			}
+		});
+		Report.Run(TEXT("Search.RemoveInsert"), NumInstances, NumSamples, NumQueries, [&]()
+		{
+			for (int32 Op = 0; Op < NumQueries; ++Op)
+			{
+				const FItemHandle Handle = Handles[Random.RandHelper(Handles.Num())];
+				Index.Remove(Handle);
+				Index.Insert(Handle, Store.GetItemId(Handle), Catalog);
+			}
+			Checksum += Index.Num();
+		});
+	}
+
+	/** Runs every suite of the Items report, the catalog ones once per row count. */
+	void RunItemSuites(FBenchmarkReport& Report, TConstArrayView<int32> Sizes)
+	{
+		for (const int32 Size : Sizes)
+		{
+			RunSuite(Report, Size);
+		}
+		RunGridSuite(Report);
+		RunPackSuite(Report);
+		RunInstanceSuite(Report);
+		RunContainerSuite(Report);
+		RunSearchSuite(Report);
+	}
+}
+
+static FAutoConsoleCommand ItemBenchmarksCommand(
+	TEXT("Warfall.Bench.Items"),
+	TEXT("Times item lookups, filters, craftability and catalog builds against synthetic tables and writes a CSV to Saved/Benchmarks. ")
+	TEXT("Optional arguments: row counts (default 1000 10000 100000)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		TArray<int32> Sizes;
+		for (const FString& Arg : Args)
+		{
+			if (const int32 Size = FCString::Atoi(*Arg); Size > 0)
+			{
+				Sizes.Add(Size);
+			}
+		}
+		if (Sizes.IsEmpty())
+		{
+			Sizes.Append(ItemBenchmarks::DefaultSizes, UE_ARRAY_COUNT(ItemBenchmarks::DefaultSizes));
+		}
+
+		FBenchmarkReport Report(TEXT("Items"));
+		ItemBenchmarks::RunItemSuites(Report, Sizes);
+		Report.Log();
+		Report.WriteCsv();
+		UE_LOG(LogTemp, Verbose, TEXT("Benchmark checksum: %lld"), ItemBenchmarks::Checksum);
+	}));
+
+static FAutoConsoleCommand InventoryNetBenchmarkCommand(
+	TEXT("Warfall.Bench.InventoryNet"),
+	TEXT("Simulates the inventory replication traffic of a full server and logs the bandwidth of slot deltas against full containers. ")
+	TEXT("Optional arguments: player count (default 100), simulated seconds (default 60)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumPlayers = Args.IsValidIndex(0) ? FMath::Max(FCString::Atoi(*Args[0]), 1) : ItemBenchmarks::DefaultNumPlayers;
+		const int32 NumSeconds = Args.IsValidIndex(1) ? FMath::Max(FCString::Atoi(*Args[1]), 1) : ItemBenchmarks::DefaultNumSeconds;
+
+		FBenchmarkReport Report(TEXT("InventoryNet"));
+		ItemBenchmarks::RunInventoryNetSuite(Report, NumPlayers, NumSeconds);
+		Report.Log();
+		Report.WriteCsv();
+	}));
+
+static FAutoConsoleCommand SnapshotBenchmarkCommand(
+	TEXT("Warfall.Bench.Snapshot"),
+	TEXT("Writes and reads back a guild vault snapshot chunk by chunk, checks the round trip field by field and logs its throughput against generic struct serialization. ")
+	TEXT("Optional argument: instance count (default 50000)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumInstances = Args.IsValidIndex(0) ? FMath::Clamp(FCString::Atoi(*Args[0]), 1, FItemInstanceStore::MaxInstances) : ItemBenchmarks::DefaultNumInstances;
+
+		FBenchmarkReport Report(TEXT("Snapshot"));
+		ItemBenchmarks::RunSnapshotSuite(Report, NumInstances);
+		Report.Log();
+		Report.WriteCsv();
+	}));
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// ===============================[ Item Benchmark Tests ]============================
+
+// The suites of the console commands with their default arguments, for perf runs of the automation framework.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemBenchmarkTest, "Warfall.Bench.Items", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FItemBenchmarkTest::RunTest(const FString& Parameters)
+{
+	FBenchmarkReport Report(TEXT("Items"));
+	ItemBenchmarks::RunItemSuites(Report, ItemBenchmarks::DefaultSizes);
+	Report.Log();
+	TestFalse(TEXT("The report is written"), Report.WriteCsv().IsEmpty());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryNetBenchmarkTest, "Warfall.Bench.InventoryNet", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FInventoryNetBenchmarkTest::RunTest(const FString& Parameters)
+{
+	FBenchmarkReport Report(TEXT("InventoryNet"));
+	ItemBenchmarks::RunInventoryNetSuite(Report, ItemBenchmarks::DefaultNumPlayers, ItemBenchmarks::DefaultNumSeconds);
+	Report.Log();
+	TestFalse(TEXT("The report is written"), Report.WriteCsv().IsEmpty());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnapshotBenchmarkTest, "Warfall.Bench.Snapshot", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FSnapshotBenchmarkTest::RunTest(const FString& Parameters)
+{
+	// A round trip that differs logs an error, which fails the test.
+	FBenchmarkReport Report(TEXT("Snapshot"));
+	ItemBenchmarks::RunSnapshotSuite(Report, ItemBenchmarks::DefaultNumInstances);
+	Report.Log();
+	TestFalse(TEXT("The report is written"), Report.WriteCsv().IsEmpty());
+	return true;
+}
+
+#endif
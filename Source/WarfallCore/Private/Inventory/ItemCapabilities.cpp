@@ -0,0 +1,67 @@
+﻿#include "Inventory/ItemCapabilities.h"
+
+EItemFlags HlpItem::GetStateFlags(const FGameplayTagContainer& Flags)
+{
+	EItemFlags Result = EItemFlags::E_None;
+	if (Flags.HasTag(ITEM_STATE_Lootable)) Result |= EItemFlags::E_CanLooted;
+	if (Flags.HasTag(ITEM_STATE_Perishable)) Result |= EItemFlags::E_CanPerished;
+	if (Flags.HasTag(ITEM_STATE_Dismantleable)) Result |= EItemFlags::E_CanDismantled;
+	if (Flags.HasTag(ITEM_STATE_Repairable)) Result |= EItemFlags::E_CanRepair;
+	if (Flags.HasTag(ITEM_STATE_Container)) Result |= EItemFlags::E_HasContainer;
+	return Result;
+}
+
+EItemCapability HlpItem::CompileCapabilities(const FItemRow& Row)
+{
+	uint32 Mask = static_cast<uint32>(GetStateFlags(Row.Flags));
+	Mask |= static_cast<uint32>(Row.Type) << 8;
+
+	EItemCapability Result = static_cast<EItemCapability>(Mask);
+	if (Row.CanPerish()) Result |= EItemCapability::CanPerish;
+	if (Row.CanBeRepair()) Result |= EItemCapability::CanBeRepaired;
+	if (Row.HasDurability()) Result |= EItemCapability::HasDurability;
+	if (Row.IsUsingAmmunition()) Result |= EItemCapability::UsesAmmunition;
+	if (Row.GetEquipeableVisible()) Result |= EItemCapability::Equipable;
+	if (Row.MaxStackSize > 1) Result |= EItemCapability::Stackable;
+	return Result;
+}
+
+void HlpItem::FilterByCapabilities(TConstArrayView<uint32> Column, const EItemCapability Required, FDenseBitSet& OutMatches)
+{
+	const int32 Num = Column.Num();
+	OutMatches.Init(Num, false);
+
+	const uint32 RequiredMask = static_cast<uint32>(Required);
+	const VectorRegister4Int RequiredVector = VectorIntSet1(static_cast<int32>(RequiredMask));
+	TArrayView<uint64> Words = OutMatches.GetWords();
+
+	// Four masks per iteration: (Mask & Required) == Required yields one bit per lane.
+	int32 Index = 0;
+	for (; Index + 4 <= Num; Index += 4)
+	{
+		const VectorRegister4Int Masks = VectorIntLoad(Column.GetData() + Index);
+		const VectorRegister4Int Matches = VectorIntCompareEQ(VectorIntAnd(Masks, RequiredVector), RequiredVector);
+		const uint64 Bits = static_cast<uint64>(VectorMaskBits(VectorCastIntToFloat(Matches)));
+		Words[Index >> 6] |= Bits << (Index & 63);
+	}
+	for (; Index < Num; ++Index)
+	{
+		if ((Column[Index] & RequiredMask) == RequiredMask)
+		{
+			OutMatches.Set(Index);
+		}
+	}
+}
+
+void HlpItem::FilterByCapabilities(TConstArrayView<uint32> Column, TConstArrayView<int32> Items, const EItemCapability Required, TArray<int32>& OutItems)
+{
+	const uint32 RequiredMask = static_cast<uint32>(Required);
+	OutItems.Reset(Items.Num());
+	for (const int32 Id : Items)
+	{
+		if (Column.IsValidIndex(Id) && (Column[Id] & RequiredMask) == RequiredMask)
+		{
+			OutItems.Add(Id);
+		}
+	}
+}
@@ -0,0 +1,429 @@
+﻿#include "Inventory/ItemCatalog.h"
+
+#include "Crafting/RecipeCatalog.h"
+#include "Engine/DataTable.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Utils/AssetCache.h"
+#include "Utils/Tables.h"
+
+// ===============================[ Item Catalog ]============================
+
+namespace ItemCatalog
+{
+	/** Above this share of removed ids, patches give up and the catalog is rebuilt to compact the ids. */
+	constexpr int32 MaxRemovedDivisor = 4;
+}
+
+void FItemCatalog::Build(const UDataTable* InTable)
+{
+	Reset();
+	Generation++;
+	Revision++;
+
+	if (!InTable) return;
+
+	const UScriptStruct* RowStruct = InTable->GetRowStruct();
+	if (!RowStruct || !RowStruct->IsChildOf(FItemRowDetail::StaticStruct()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("ItemCatalog: '%s' is not an items table."), *InTable->GetName());
+		return;
+	}
+
+	Table = InTable;
+	const TMap<FName, uint8*>& RowMap = InTable->GetRowMap();
+	RowNames.Reserve(RowMap.Num());
+	Rows.Reserve(RowMap.Num());
+	Capabilities.Reserve(RowMap.Num());
+	RowIds.Reserve(RowMap.Num());
+
+	for (const TPair<FName, uint8*>& Pair : RowMap)
+	{
+		const FItemRowDetail* RowDetail = reinterpret_cast<const FItemRowDetail*>(Pair.Value);
+		if (!RowDetail) continue;
+
+		const FItemId Id = Rows.Add(&RowDetail->Details);
+		RowNames.Add(Pair.Key);
+		RowIds.Add(Pair.Key, Id);
+		Capabilities.Add(static_cast<uint32>(HlpItem::CompileCapabilities(RowDetail->Details)));
+		AddReferences(Id, RowDetail->Details);
+	}
+	NumItems = Rows.Num();
+	CapabilityData = Capabilities.GetData();
+	ResolvePerishTargets();
+
+	Stats.Build(*this);
+	TagIndex.Build(*this);
+	Modifiers.Build(*this);
+	Details.Build(*this);
+}
+
+bool FItemCatalog::BuildFromCooked(const FCookedItemCatalog& Cooked)
+{
+	Reset();
+	Generation++;
+	Revision++;
+
+	if (!Cooked.IsOpen()) return false;
+
+	const FCookedItemCatalogHeader& Header = Cooked.GetHeader();
+	NumItems = Header.NumItems;
+	RowNames.Reserve(NumItems);
+	RowIds.Reserve(NumItems);
+	for (FItemId Id = 0; Id < NumItems; ++Id)
+	{
+		const FName RowName = Cooked.GetItemName(Id);
+		RowNames.Add(RowName);
+		// Ids removed by a patch before the cook keep their slot under NAME_None, which must not resolve to them.
+		if (!RowName.IsNone())
+		{
+			RowIds.Add(RowName, Id);
+		}
+	}
+
+	Stats.BindExternal(Cooked.GetStats(), Cooked.GetStackSizes(), NumItems, Header.StatStride);
+	CapabilityData = Cooked.GetCapabilities();
+	PerishTargetData = Cooked.GetPerishTargets();
+
+	// Tags removed since the cook keep their slot so that the postings stay aligned, but cannot be queried anymore.
+	TArray<FGameplayTag> Tags;
+	Tags.Reserve(Header.NumTags);
+	for (int32 Slot = 0; Slot < Header.NumTags; ++Slot)
+	{
+		Tags.Add(FGameplayTag::RequestGameplayTag(Cooked.GetTagName(Slot), false));
+	}
+	TagIndex.BindExternal(MoveTemp(Tags), Cooked.GetPostings(), TArray<int32>(Cooked.GetNameSlots(), Header.NumTags), Cooked.GetNamePostings(), NumItems);
+
+	TArray<FName> StatKeys;
+	StatKeys.Reserve(Header.NumModifierKeys);
+	for (int32 Slot = 0; Slot < Header.NumModifierKeys; ++Slot)
+	{
+		StatKeys.Add(Cooked.GetModifierKey(Slot));
+	}
+	Modifiers.BindExternal(MoveTemp(StatKeys), Cooked.GetModifierRanges(), Cooked.GetModifierOps(), NumItems);
+
+	TArray<FName> MetaKeys;
+	MetaKeys.Reserve(Header.NumMetaKeys);
+	for (int32 Slot = 0; Slot < Header.NumMetaKeys; ++Slot)
+	{
+		MetaKeys.Add(Cooked.GetMetaKey(Slot));
+	}
+	Details.BindExternal(Cooked.GetDetails(), Cooked.GetRepairRanges(), Cooked.GetRepairMaterials(), MetaKeys, Cooked.GetMetaRanges(), Cooked.GetMetaEntries(), NumItems);
+	CookedFile = &Cooked;
+	return true;
+}
+
+const FItemRow* FItemCatalog::FindRowOrTable(const FItemId Id) const
+{
+	if (HasRows()) return FindRow(Id);
+
+	// Unknown and removed ids have no name, and no row to look up.
+	const FName RowName = GetRowName(Id);
+	return RowName.IsNone() ? nullptr : HlpItem::FindItemRow(RowName);
+}
+
+FString FItemCatalog::GetDisplayName(const FItemId Id) const
+{
+	if (CookedFile)
+	{
+		return CookedFile->GetDisplayName(Id);
+	}
+	const FItemRow* Row = FindRow(Id);
+	return Row ? Row->Name.ToString() : FString();
+}
+
+void FItemCatalog::Reset()
+{
+	Table = nullptr;
+	RowNames.Reset();
+	Rows.Reset();
+	RowIds.Reset();
+	Stats.Reset();
+	Capabilities.Reset();
+	CapabilityData = nullptr;
+	PerishTargets.Reset();
+	PerishTargetData = nullptr;
+	TagIndex.Reset();
+	Modifiers.Reset();
+	Details.Reset();
+	NameReferrers.Reset();
+	CookedFile = nullptr;
+	NumItems = 0;
+	RemovedCount = 0;
+}
+
+bool FItemCatalog::PatchRows(TConstArrayView<FName> ChangedRows, TArray<FItemId>& OutPatchedIds)
+{
+	OutPatchedIds.Reset();
+	if (!Table || !HasRows()) return false;
+
+	const TMap<FName, uint8*>& RowMap = Table->GetRowMap();
+	TArray<FName> AddedOrRemoved;
+	for (const FName RowName : ChangedRows)
+	{
+		const FItemId Id = FindId(RowName);
+		if (uint8* const* RowData = RowMap.Find(RowName))
+		{
+			const FItemRow& Row = reinterpret_cast<const FItemRowDetail*>(*RowData)->Details;
+			if (Id != INDEX_NONE)
+			{
+				SetRow(Id, &Row);
+				OutPatchedIds.Add(Id);
+			}
+			else
+			{
+				OutPatchedIds.Add(AddRow(RowName, Row));
+				AddedOrRemoved.Add(RowName);
+			}
+		}
+		else if (Id != INDEX_NONE)
+		{
+			RemoveRow(Id);
+			OutPatchedIds.Add(Id);
+			AddedOrRemoved.Add(RowName);
+		}
+	}
+
+	// Removed and renamed rows are not reported by name: reconcile both sides once when the counts disagree.
+	if (NumItems - RemovedCount != RowMap.Num())
+	{
+		for (FItemId Id = 0; Id < NumItems; ++Id)
+		{
+			if (Rows[Id] && !RowMap.Contains(RowNames[Id]))
+			{
+				AddedOrRemoved.Add(RowNames[Id]);
+				RemoveRow(Id);
+				OutPatchedIds.Add(Id);
+			}
+		}
+		for (const TPair<FName, uint8*>& Pair : RowMap)
+		{
+			if (!RowIds.Contains(Pair.Key))
+			{
+				OutPatchedIds.Add(AddRow(Pair.Key, reinterpret_cast<const FItemRowDetail*>(Pair.Value)->Details));
+				AddedOrRemoved.Add(Pair.Key);
+			}
+		}
+	}
+
+	// Perish targets and repair materials are resolved by name, so adding or removing a row may retarget rows that
+	// were not edited.
+	ResolveReferrers(AddedOrRemoved, OutPatchedIds);
+
+	Revision++;
+	return RemovedCount <= NumItems / ItemCatalog::MaxRemovedDivisor;
+}
+
+void FItemCatalog::SetRow(const FItemId Id, const FItemRow* Row)
+{
+	Rows[Id] = Row;
+	Capabilities[Id] = Row ? static_cast<uint32>(HlpItem::CompileCapabilities(*Row)) : 0;
+	PerishTargets[Id] = ResolvePerishTarget(Id, Row);
+	if (Row)
+	{
+		Stats.SetRow(Id, *Row);
+	}
+	else
+	{
+		Stats.ClearRow(Id);
+	}
+	TagIndex.SetRow(Id, Row);
+	Modifiers.SetRow(Id, Row, RowNames[Id]);
+	Details.SetRow(Id, Row, *this);
+	if (Row)
+	{
+		AddReferences(Id, *Row);
+	}
+}
+
+FItemId FItemCatalog::AddRow(const FName RowName, const FItemRow& Row)
+{
+	const FItemId Id = Rows.Add(&Row);
+	RowNames.Add(RowName);
+	RowIds.Add(RowName, Id);
+	Capabilities.Add(static_cast<uint32>(HlpItem::CompileCapabilities(Row)));
+	CapabilityData = Capabilities.GetData();
+	PerishTargets.Add(ResolvePerishTarget(Id, &Row));
+	PerishTargetData = PerishTargets.GetData();
+	NumItems = Rows.Num();
+
+	Stats.AddRow(Row);
+	TagIndex.AddRow(Row);
+	Modifiers.AddRow(Row, RowName);
+	Details.AddRow(Row, *this);
+	AddReferences(Id, Row);
+	return Id;
+}
+
+void FItemCatalog::RemoveRow(const FItemId Id)
+{
+	SetRow(Id, nullptr);
+	RowIds.Remove(RowNames[Id]);
+	RowNames[Id] = NAME_None;
+	RemovedCount++;
+}
+
+void FItemCatalog::ResolvePerishTargets()
+{
+	PerishTargets.SetNumUninitialized(NumItems);
+	PerishTargetData = PerishTargets.GetData();
+	for (FItemId Id = 0; Id < NumItems; ++Id)
+	{
+		PerishTargets[Id] = ResolvePerishTarget(Id, Rows[Id]);
+	}
+}
+
+FItemId FItemCatalog::ResolvePerishTarget(const FItemId Id, const FItemRow* Row) const
+{
+	const FItemId Target = Row ? FindId(Row->PerishTo.ID) : INDEX_NONE;
+	if (Target == Id)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ItemCatalog: %s perishes into itself, PerishTo ignored."), *RowNames[Id].ToString());
+		return INDEX_NONE;
+	}
+	return Target;
+}
+
+void FItemCatalog::AddReferences(const FItemId Id, const FItemRow& Row)
+{
+	if (!Row.PerishTo.ID.IsNone())
+	{
+		NameReferrers.FindOrAdd(Row.PerishTo.ID).AddUnique(Id);
+	}
+	for (const FItemRepairData& Data : Row.RepairData)
+	{
+		if (Data.MaterialToRepair.ID.IsNone()) continue;
+		NameReferrers.FindOrAdd(Data.MaterialToRepair.ID).AddUnique(Id);
+	}
+}
+
+void FItemCatalog::ResolveReferrers(TConstArrayView<FName> PatchedNames, TArray<FItemId>& OutPatchedIds)
+{
+	for (const FName RowName : PatchedNames)
+	{
+		const TArray<FItemId>* Referrers = NameReferrers.Find(RowName);
+		if (!Referrers) continue;
+
+		for (const FItemId Id : *Referrers)
+		{
+			if (!Rows[Id]) continue;
+			PerishTargets[Id] = ResolvePerishTarget(Id, Rows[Id]);
+			Details.SetRow(Id, Rows[Id], *this);
+			OutPatchedIds.AddUnique(Id);
+		}
+	}
+}
+
+// ===============================[ Item Catalog Subsystem ]============================
+
+void UItemCatalogSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency<UAssetCacheSubsystem>();
+
+#if !WITH_EDITOR
+	if (LoadCooked()) return;
+#endif
+
+	// The cook writes the catalog file once the recipes are compiled against it, see URecipeCatalogSubsystem.
+	BindTable(UTables::GetTable(ETablePath::ItemsTable));
+	Rebuild();
+}
+
+void UItemCatalogSubsystem::Deinitialize()
+{
+	BindTable(nullptr);
+	Catalog.Reset();
+	CookedCatalog.Close();
+	Super::Deinitialize();
+}
+
+UItemCatalogSubsystem* UItemCatalogSubsystem::Get()
+{
+	return GEngine ? GEngine->GetEngineSubsystem<UItemCatalogSubsystem>() : nullptr;
+}
+
+const FItemCatalog* UItemCatalogSubsystem::GetCatalog()
+{
+	const UItemCatalogSubsystem* Subsystem = Get();
+	if (!Subsystem || Subsystem->Catalog.IsEmpty()) return nullptr;
+	return &Subsystem->Catalog;
+}
+
+void UItemCatalogSubsystem::Rebuild()
+{
+	const double StartTime = FPlatformTime::Seconds();
+	Catalog.Build(ItemsTable);
+	UE_LOG(LogTemp, Log, TEXT("ItemCatalog: %d items compiled in %.2f ms."), Catalog.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	OnCatalogRebuilt.Broadcast();
+}
+
+bool UItemCatalogSubsystem::LoadCooked()
+{
+	if (FParse::Param(FCommandLine::Get(), TEXT("NoCookedItemCatalog"))) return false;
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FString Path = FCookedItemCatalog::GetDefaultPath();
+	if (!CookedCatalog.Open(Path) || !Catalog.BuildFromCooked(CookedCatalog))
+	{
+		CookedCatalog.Close();
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("ItemCatalog: %d items mapped from '%s' in %.2f ms."), Catalog.Num(), *Path, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	OnCatalogRebuilt.Broadcast();
+	return true;
+}
+
+void UItemCatalogSubsystem::BindTable(UDataTable* NewTable)
+{
+	if (ItemsTable && TableChangedHandle.IsValid())
+	{
+		ItemsTable->OnDataTableChanged().Remove(TableChangedHandle);
+	}
+	TableChangedHandle.Reset();
+
+	ItemsTable = NewTable;
+	if (ItemsTable)
+	{
+		TableChangedHandle = ItemsTable->OnDataTableChanged().AddUObject(this, &UItemCatalogSubsystem::HandleTableChanged);
+	}
+}
+
+void UItemCatalogSubsystem::NotifyRowChanged(const UDataTable* Table, const FName RowName)
+{
+	UItemCatalogSubsystem* Subsystem = Get();
+	if (!Subsystem || !Table || Table != Subsystem->ItemsTable) return;
+
+	Subsystem->PendingRows.Add(RowName);
+}
+
+void UItemCatalogSubsystem::HandleTableChanged()
+{
+	const TArray<FName> ChangedRows = PendingRows.Array();
+	PendingRows.Reset();
+
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<FItemId> PatchedIds;
+	if (ChangedRows.IsEmpty() || !Catalog.PatchRows(ChangedRows, PatchedIds))
+	{
+		Rebuild();
+		return;
+	}
+
+	UE_LOG(LogTemp, Verbose, TEXT("ItemCatalog: %d rows patched in %.3f ms."), PatchedIds.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	OnRowsPatched.Broadcast(PatchedIds);
+}
+
+static FAutoConsoleCommand CookItemCatalogCommand(
+	TEXT("Warfall.Items.CookCatalog"),
+	TEXT("Writes the compiled item and recipe catalogs to the cooked catalog file. Optional argument: destination path."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const UItemCatalogSubsystem* Subsystem = UItemCatalogSubsystem::Get();
+		if (!Subsystem) return;
+
+		FCookedItemCatalog::Write(Subsystem->GetItems(), URecipeCatalogSubsystem::GetCatalog(), Args.IsEmpty() ? FCookedItemCatalog::GetDefaultPath() : Args[0]);
+	}));
@@ -0,0 +1,71 @@
+﻿#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemTestTables.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// ===============================[ Item Catalog Tests ]============================
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemCatalogPatchTest, "Warfall.Items.Catalog.Patch", ItemTests::Flags)
+
+bool FItemCatalogPatchTest::RunTest(const FString& Parameters)
+{
+	ItemTests::FTestTables Tables;
+	Tables.AddItem(TEXT("Test_Meat"), EItemType::E_Ingredient, 10, 5.0f, TEXT("Test_Rot"));
+	Tables.AddItem(TEXT("Test_Sword"), EItemType::E_Weapon);
+	Tables.AddItem(TEXT("Test_Axe"), EItemType::E_Weapon);
+	Tables.GetItem(TEXT("Test_Sword")).RepairData.AddDefaulted_GetRef().MaterialToRepair.ID = TEXT("Test_Bar");
+	Tables.GetItem(TEXT("Test_Sword")).Modifiers.Add(TEXT("Damage"), 5.0f);
+	Tables.GetItem(TEXT("Test_Axe")).Modifiers.Add(TEXT("Damage"), 3.0f);
+
+	FItemCatalog Catalog;
+	Catalog.Build(Tables.Items);
+	const FItemId Meat = Catalog.FindId(TEXT("Test_Meat"));
+	const FItemId Sword = Catalog.FindId(TEXT("Test_Sword"));
+	const FItemId Axe = Catalog.FindId(TEXT("Test_Axe"));
+	TestEqual(TEXT("Meat perishes into nothing while Rot is missing"), Catalog.GetPerishTarget(Meat), static_cast<FItemId>(INDEX_NONE));
+	if (!TestEqual(TEXT("One repair material"), Catalog.GetDetails().GetRepairMaterials(Sword).Num(), 1)) return false;
+	TestEqual(TEXT("The missing material is unresolved"), Catalog.GetDetails().GetRepairMaterials(Sword)[0].ItemId, static_cast<int32>(INDEX_NONE));
+
+	// Adding the referenced rows resolves the rows referring to them, though they were not edited.
+	Tables.AddItem(TEXT("Test_Rot"), EItemType::E_Ingredient, 10);
+	Tables.AddItem(TEXT("Test_Bar"), EItemType::E_Ingredient, 10);
+	TArray<FItemId> Patched;
+	if (!TestTrue(TEXT("Added rows are patched"), Catalog.PatchRows({ FName(TEXT("Test_Rot")), FName(TEXT("Test_Bar")) }, Patched))) return false;
+	const FItemId Rot = Catalog.FindId(TEXT("Test_Rot"));
+	const FItemId Bar = Catalog.FindId(TEXT("Test_Bar"));
+	TestEqual(TEXT("Meat now perishes into Rot"), Catalog.GetPerishTarget(Meat), Rot);
+	TestEqual(TEXT("The material now resolves to Bar"), Catalog.GetDetails().GetRepairMaterials(Sword)[0].ItemId, Bar);
+	TestTrue(TEXT("Meat is reported as patched"), Patched.Contains(Meat));
+	TestTrue(TEXT("Sword is reported as patched"), Patched.Contains(Sword));
+	TestFalse(TEXT("Rows referring to nothing added are left alone"), Patched.Contains(Axe));
+
+	// Growing and shrinking the ops of a row many times never moves the ops of the others.
+	for (int32 Edit = 0; Edit < 200; ++Edit)
+	{
+		TMap<FName, float>& Modifiers = Tables.GetItem(TEXT("Test_Sword")).Modifiers;
+		if (Edit % 2)
+		{
+			Modifiers.Remove(TEXT("Speed"));
+		}
+		else
+		{
+			Modifiers.Add(TEXT("Speed"), 1.5f);
+		}
+		if (!TestTrue(TEXT("The edited row is patched"), Catalog.PatchRows({ FName(TEXT("Test_Sword")) }, Patched))) return false;
+		if (!TestEqual(TEXT("The edited row holds its ops"), Catalog.GetModifiers().GetOps(Sword).Num(), Edit % 2 ? 1 : 2)) return false;
+		if (!TestEqual(TEXT("The other rows keep their ops"), Catalog.GetModifiers().GetOps(Axe).Num(), 1)) return false;
+		if (!TestEqual(TEXT("The other rows keep their values"), Catalog.GetModifiers().GetOps(Axe)[0].Value, 3.0f)) return false;
+	}
+	TestEqual(TEXT("Slack is not counted"), Catalog.GetModifiers().NumOps(), 2);
+
+	// Removing a referenced row resolves its referrers again.
+	Tables.Items->RemoveRow(TEXT("Test_Rot"));
+	TestTrue(TEXT("The removed row is patched"), Catalog.PatchRows({ FName(TEXT("Test_Rot")) }, Patched));
+	TestNull(TEXT("The removed row is gone"), Catalog.FindRow(Rot));
+	TestEqual(TEXT("Meat perishes into nothing again"), Catalog.GetPerishTarget(Meat), static_cast<FItemId>(INDEX_NONE));
+	TestTrue(TEXT("Meat is reported as patched"), Patched.Contains(Meat));
+	TestEqual(TEXT("The material still resolves to Bar"), Catalog.GetDetails().GetRepairMaterials(Sword)[0].ItemId, Bar);
+	return true;
+}
+
+#endif
@@ -0,0 +1,169 @@
+﻿#include "Inventory/ItemDetailColumns.h"
+
+#include "Inventory/ItemCatalog.h"
+
+// ===============================[ Item Detail Columns ]============================
+
+void FItemDetailColumns::Build(const FItemCatalog& Catalog)
+{
+	Reset();
+
+	NumItems = Catalog.Num();
+	Details.Reserve(NumItems);
+	for (int32 Id = 0; Id < NumItems; ++Id)
+	{
+		RowMaterials.Reset();
+		if (const FItemRow* Row = Catalog.FindRow(Id))
+		{
+			Details.Add(CompileDetail(*Row, Catalog));
+			CompileRepairMaterials(*Row, Catalog, RowMaterials);
+			MetaEntries.Add(Row->MetaModifiers);
+		}
+		else
+		{
+			Details.AddDefaulted();
+			MetaEntries.Add(TConstArrayView<FItemMetaEntry>());
+		}
+		RepairMaterials.Add(RowMaterials);
+	}
+	DetailData = Details.GetData();
+}
+
+void FItemDetailColumns::Reset()
+{
+	Details.Reset();
+	DetailData = nullptr;
+	RepairMaterials.Reset();
+	MetaEntries.Reset();
+	NumItems = 0;
+}
+
+void FItemDetailColumns::BindExternal(const FItemDetail* InDetails, const uint32* InRepairRanges, const FRepairMaterial* InRepairMaterials,
+	TConstArrayView<FName> MetaKeys, const uint32* InMetaRanges, const FCompiledMetaEntry* CompiledMeta, const int32 InNumItems)
+{
+	Reset();
+	NumItems = InNumItems;
+	DetailData = InDetails;
+	RepairMaterials.BindExternal(InRepairRanges, InRepairMaterials, NumItems);
+
+	// Keys removed since the cook yield invalid tags, as the tag index slots do.
+	TArray<FGameplayTag> Keys;
+	Keys.Reserve(MetaKeys.Num());
+	for (const FName Key : MetaKeys)
+	{
+		Keys.Add(FGameplayTag::RequestGameplayTag(Key, false));
+	}
+
+	TArray<FItemMetaEntry> RowEntries;
+	for (int32 Id = 0; Id < NumItems; ++Id)
+	{
+		RowEntries.Reset();
+		for (uint32 Index = InMetaRanges[Id]; Index < InMetaRanges[Id + 1]; ++Index)
+		{
+			FItemMetaEntry& Entry = RowEntries.AddDefaulted_GetRef();
+			Entry.Key = Keys[CompiledMeta[Index].Slot];
+			Entry.Operation = CompiledMeta[Index].Operation;
+			Entry.Value = CompiledMeta[Index].Value;
+		}
+		MetaEntries.Add(RowEntries);
+	}
+}
+
+void FItemDetailColumns::SetRow(const int32 Id, const FItemRow* Row, const FItemCatalog& Catalog)
+{
+	check(Id >= 0 && Id < NumItems);
+	check(DetailData == Details.GetData());
+
+	RowMaterials.Reset();
+	if (Row)
+	{
+		Details[Id] = CompileDetail(*Row, Catalog);
+		CompileRepairMaterials(*Row, Catalog, RowMaterials);
+	}
+	else
+	{
+		Details[Id] = FItemDetail();
+	}
+
+	RepairMaterials.Set(Id, RowMaterials);
+	MetaEntries.Set(Id, Row ? TConstArrayView<FItemMetaEntry>(Row->MetaModifiers) : TConstArrayView<FItemMetaEntry>());
+}
+
+void FItemDetailColumns::AddRow(const FItemRow& Row, const FItemCatalog& Catalog)
+{
+	check(DetailData == Details.GetData());
+
+	Details.Add(CompileDetail(Row, Catalog));
+	RowMaterials.Reset();
+	CompileRepairMaterials(Row, Catalog, RowMaterials);
+	RepairMaterials.Add(RowMaterials);
+	MetaEntries.Add(Row.MetaModifiers);
+	NumItems++;
+
+	DetailData = Details.GetData();
+}
+
+void FItemDetailColumns::CompileMeta(TArray<FName>& OutKeys, TArray<uint32>& OutRanges, TArray<FCompiledMetaEntry>& OutEntries) const
+{
+	TArray<FItemMetaEntry> Entries;
+	MetaEntries.CopyCompact(OutRanges, Entries);
+	OutKeys.Reset();
+	OutEntries.Reset(Entries.Num());
+
+	TMap<FName, int32> Slots;
+	for (const FItemMetaEntry& Entry : Entries)
+	{
+		const FName Key = Entry.Key.GetTagName();
+		const int32* Slot = Slots.Find(Key);
+		if (!Slot)
+		{
+			checkf(OutKeys.Num() < MAX_uint16, TEXT("ItemDetailColumns: too many distinct meta keys."));
+			Slot = &Slots.Add(Key, OutKeys.Add(Key));
+		}
+
+		FCompiledMetaEntry& Compiled = OutEntries.AddDefaulted_GetRef();
+		Compiled.Slot = static_cast<uint16>(*Slot);
+		Compiled.Operation = Entry.Operation;
+		Compiled.Value = Entry.Value;
+	}
+}
+
+FItemDetail FItemDetailColumns::CompileDetail(const FItemRow& Row, const FItemCatalog& Catalog)
+{
+	FItemDetail Detail;
+	const FIntPoint Footprint = HlpItem::GetFootprint(Row);
+	Detail.FootprintX = static_cast<int16>(FMath::Clamp(Footprint.X, 0, MAX_int16));
+	Detail.FootprintY = static_cast<int16>(FMath::Clamp(Footprint.Y, 0, MAX_int16));
+	if (Row.HasContainer())
+	{
+		const FIntPoint Dimensions = Row.bIsPocket ? Row.Pocket.Dimensions : Row.Bag.Dimensions;
+		Detail.Capacity = Dimensions.X * Dimensions.Y;
+	}
+	Detail.Quality = Row.Quality;
+	Detail.RepairTime = Row.GetRepairTime();
+	Detail.FirstTagSlot = Row.Tags.IsEmpty() ? INDEX_NONE : Catalog.GetTagIndex().FindSlot(Row.Tags.First());
+	return Detail;
+}
+
+void FItemDetailColumns::CompileRepairMaterials(const FItemRow& Row, const FItemCatalog& Catalog, TArray<FRepairMaterial>& OutMaterials)
+{
+	const int32 First = OutMaterials.Num();
+	for (const FItemRepairData& Data : Row.RepairData)
+	{
+		const int32 ItemId = Catalog.FindId(Data.MaterialToRepair.ID);
+		const int32 Quantity = FMath::Max(Data.Quantity, 1);
+
+		FRepairMaterial* Existing = OutMaterials.GetData() + First;
+		FRepairMaterial* End = OutMaterials.GetData() + OutMaterials.Num();
+		while (Existing != End && Existing->ItemId != ItemId)
+		{
+			++Existing;
+		}
+		if (Existing != End)
+		{
+			Existing->Quantity += Quantity;
+			continue;
+		}
+		OutMaterials.Add({ ItemId, Quantity });
+	}
+}
@@ -0,0 +1,545 @@
+﻿#include "Inventory/ItemInstanceStore.h"
+
+#include "Engine/World.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemSnapshot.h"
+
+namespace ItemInstanceStore
+{
+	/** Floor of the perish multipliers, a zero multiplier would lose the remaining lifetime. */
+	constexpr float MinPerishMultiplier = 1.0e-4f;
+}
+
+// ===============================[ Item Instance Store ]============================
+
+FItemHandle FItemInstanceStore::Create(const int32 ItemId, const int32 Stack, const float Durability)
+{
+	if (FirstFree == INDEX_NONE && !AddSlab()) return FItemHandle();
+
+	const int32 Index = FirstFree;
+	FSlab& Slab = GetSlab(Index);
+	const int32 Slot = Index & SlotMask;
+	FirstFree = Slab.NextFree[Slot];
+
+	Slab.ItemIds[Slot] = ItemId;
+	Slab.Stacks[Slot] = Stack;
+	Slab.Durabilities[Slot] = Durability;
+	Slab.Wears[Slot] = 0.0f;
+	Slab.PerishDeadlines[Slot] = 0.0;
+	Slab.PerishMultipliers[Slot] = 1.0f;
+	Slab.WearRates[Slot] = 0.0f;
+	Slab.LastEvaluated[Slot] = 0.0;
+	Slab.AgingModes[Slot] = EItemAgingMode::Scheduled;
+	Slab.Containers[Slot] = 0;
+	++NumLive;
+	return FItemHandle(Index, Slab.Generations[Slot]);
+}
+
+bool FItemInstanceStore::Destroy(const FItemHandle Handle)
+{
+	if (!IsValid(Handle)) return false;
+
+	const int32 Index = Handle.GetIndex();
+	FSlab& Slab = GetSlab(Index);
+	const int32 Slot = Index & SlotMask;
+	Slab.ItemIds[Slot] = INDEX_NONE;
+	Slab.Generations[Slot] = Slab.Generations[Slot] % FItemHandle::MaxGeneration + 1;
+	Slab.NextFree[Slot] = FirstFree;
+	FirstFree = Index;
+	--NumLive;
+	return true;
+}
+
+void FItemInstanceStore::Reset()
+{
+	// Rebuilds the free list in slot order; generations keep counting so that older handles stay invalid.
+	FirstFree = INDEX_NONE;
+	for (int32 Index = NumSlots - 1; Index >= 0; --Index)
+	{
+		FSlab& Slab = GetSlab(Index);
+		const int32 Slot = Index & SlotMask;
+		if (Slab.ItemIds[Slot] != INDEX_NONE)
+		{
+			Slab.ItemIds[Slot] = INDEX_NONE;
+			Slab.Generations[Slot] = Slab.Generations[Slot] % FItemHandle::MaxGeneration + 1;
+		}
+		Slab.NextFree[Slot] = FirstFree;
+		FirstFree = Index;
+	}
+	NumLive = 0;
+}
+
+void FItemInstanceStore::Reserve(const int32 NumInstances)
+{
+	while (NumSlots < FMath::Min(NumInstances, MaxInstances))
+	{
+		if (!AddSlab()) return;
+	}
+}
+
+bool FItemInstanceStore::Read(const FItemHandle Handle, const FItemCatalog& Catalog, FItemInstance& OutInstance) const
+{
+	if (!IsValid(Handle)) return false;
+
+	OutInstance.Handle = Handle;
+	OutInstance.ItemID = Catalog.GetRowName(GetItemId(Handle));
+	OutInstance.Stack = GetStack(Handle);
+	OutInstance.Durability = GetDurability(Handle);
+	OutInstance.Wear = GetWear(Handle);
+	OutInstance.PerishDeadline = GetPerishDeadline(Handle);
+	OutInstance.Container = GetContainer(Handle);
+	return true;
+}
+
+bool FItemInstanceStore::AddSlab()
+{
+	if (NumSlots >= MaxInstances)
+	{
+		UE_LOG(LogTemp, Error, TEXT("ItemInstanceStore: the store is full (%d instances)."), MaxInstances);
+		return false;
+	}
+
+	FSlab& Slab = *Slabs.Add_GetRef(MakeUnique<FSlab>());
+	const int32 FirstIndex = NumSlots;
+	NumSlots += SlabSize;
+
+	// Pushed in reverse so that the lowest slots are handed out first.
+	for (int32 Slot = SlabSize - 1; Slot >= 0; --Slot)
+	{
+		Slab.ItemIds[Slot] = INDEX_NONE;
+		Slab.Generations[Slot] = 1;
+		Slab.NextFree[Slot] = FirstFree;
+		FirstFree = FirstIndex + Slot;
+	}
+	return true;
+}
+
+// ===============================[ Item Instance Subsystem ]============================
+
+void UItemInstanceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	PerishScheduler.Reset(GetNow());
+}
+
+void UItemInstanceSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ExpiredHandles.Reset();
+	if (PerishScheduler.Advance(GetNow(), ExpiredHandles) > 0)
+	{
+		ApplyPerished();
+	}
+}
+
+TStatId UItemInstanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UItemInstanceSubsystem, STATGROUP_Tickables);
+}
+
+FItemHandle UItemInstanceSubsystem::CreateInstance(const FName ItemID, const int32 Stack)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	const int32 ItemId = Catalog ? Catalog->FindId(ItemID) : INDEX_NONE;
+	if (ItemId == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ItemInstanceSubsystem: unknown item %s."), *ItemID.ToString());
+		return FItemHandle();
+	}
+
+	const FItemStatColumns& Stats = Catalog->GetStats();
+	const FItemHandle Handle = Store.Create(ItemId, FMath::Clamp(Stack, 1, FMath::Max(Stats.GetMaxStackSize(ItemId), 1)), Stats.Get(EItemStat::MaxDurability, ItemId));
+	if (Handle.IsValid())
+	{
+		Store.SetLastEvaluated(Handle, GetNow());
+		StartPerishing(Handle, GetNow());
+		ContainerTree.Insert(Handle, FItemHandle(), DescribeInstance(Handle));
+	}
+	return Handle;
+}
+
+bool UItemInstanceSubsystem::DestroyInstance(const FItemHandle Handle)
+{
+	if (!Store.IsValid(Handle)) return false;
+
+	PerishScheduler.Unschedule(Handle);
+	ReleaseInstance(Handle);
+	return true;
+}
+
+bool UItemInstanceSubsystem::GetInstance(const FItemHandle Handle, FItemInstance& OutInstance)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	return Catalog && Refresh(Handle) && Store.Read(Handle, *Catalog, OutInstance);
+}
+
+bool UItemInstanceSubsystem::Refresh(const FItemHandle Handle)
+{
+	if (!Store.IsValid(Handle)) return false;
+
+	const bool bLazy = Store.GetAgingMode(Handle) == EItemAgingMode::Lazy;
+	const double From = Store.GetLastEvaluated(Handle);
+	const double Now = GetNow();
+	if (Now <= From || (!bLazy && Store.GetWearRate(Handle) <= 0.0f)) return true;
+
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog) return true;
+
+	// Deadlines of scheduled instances belong to the timing wheel, only their weathering is evaluated here.
+	FItemAgingState State;
+	State.ItemId = Store.GetItemId(Handle);
+	State.PerishDeadline = bLazy ? Store.GetPerishDeadline(Handle) : 0.0;
+	State.Durability = Store.GetDurability(Handle);
+	State.Wear = Store.GetWear(Handle);
+	const int32 Steps = HlpItem::AgeInstance(*Catalog, State, From, Now, Store.GetPerishMultiplier(Handle), Store.GetWearRate(Handle));
+
+	// Not batched in PerishTransforms: reads may happen while that batch is being broadcast.
+	FPerishTransform Transform;
+	Transform.Handle = Handle;
+	Transform.FromItem = Store.GetItemId(Handle);
+	Transform.ToItem = State.ItemId;
+
+	// Stored before notifying, so that listeners reading the instance find it up to date instead of evaluating it again.
+	Store.SetLastEvaluated(Handle, Now);
+	if (bLazy)
+	{
+		Store.SetPerishDeadline(Handle, State.PerishDeadline);
+	}
+	if (State.ItemId != INDEX_NONE)
+	{
+		Store.SetItemId(Handle, State.ItemId);
+		Store.SetDurability(Handle, State.Durability);
+		Store.SetWear(Handle, State.Wear);
+		if (Steps > 0)
+		{
+			ContainerTree.Update(Handle, DescribeInstance(Handle));
+			UpdateSearchEntry(Handle);
+		}
+	}
+	if (Steps == 0) return true;
+
+	OnInstancesPerished.Broadcast(TConstArrayView<FPerishTransform>(&Transform, 1));
+	if (Transform.ToItem != INDEX_NONE) return true;
+
+	ReleaseInstance(Handle);
+	return false;
+}
+
+void UItemInstanceSubsystem::SuspendInstances(const TArray<FItemHandle>& Handles)
+{
+	const double Now = GetNow();
+	for (const FItemHandle Handle : Handles)
+	{
+		if (!Refresh(Handle) || Store.GetAgingMode(Handle) == EItemAgingMode::Lazy) continue;
+
+		PerishScheduler.Unschedule(Handle);
+		Store.SetAgingMode(Handle, EItemAgingMode::Lazy);
+		Store.SetLastEvaluated(Handle, Now);
+	}
+}
+
+void UItemInstanceSubsystem::ResumeInstances(const TArray<FItemHandle>& Handles)
+{
+	for (const FItemHandle Handle : Handles)
+	{
+		if (!Refresh(Handle) || Store.GetAgingMode(Handle) == EItemAgingMode::Scheduled) continue;
+
+		Store.SetAgingMode(Handle, EItemAgingMode::Scheduled);
+		if (Store.GetPerishDeadline(Handle) > 0.0)
+		{
+			PerishScheduler.Schedule(Handle, Store.GetPerishDeadline(Handle));
+		}
+	}
+}
+
+float UItemInstanceSubsystem::GetFreshness(const FItemHandle Handle)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog || !Refresh(Handle)) return 1.0f;
+
+	return HlpItem::GetFreshness(*Catalog, Store.GetItemId(Handle), Store.GetPerishDeadline(Handle), GetNow(), Store.GetPerishMultiplier(Handle));
+}
+
+void UItemInstanceSubsystem::SetWearRate(const FItemHandle Handle, const float WearRate)
+{
+	if (!Refresh(Handle)) return;
+
+	Store.SetLastEvaluated(Handle, GetNow());
+	Store.SetWearRate(Handle, FMath::Max(WearRate, 0.0f));
+}
+
+void UItemInstanceSubsystem::SetPerishMultiplier(const FItemHandle Handle, const float Multiplier)
+{
+	if (!Refresh(Handle)) return;
+
+	const float OldMultiplier = Store.GetPerishMultiplier(Handle);
+	const float NewMultiplier = FMath::Max(Multiplier, ItemInstanceStore::MinPerishMultiplier);
+	if (NewMultiplier == OldMultiplier) return;
+
+	Store.SetPerishMultiplier(Handle, NewMultiplier);
+	const double Deadline = Store.GetPerishDeadline(Handle);
+	if (Deadline <= 0.0) return;
+
+	const double Now = GetNow();
+	const double NewDeadline = Now + FMath::Max(Deadline - Now, 0.0) * OldMultiplier / NewMultiplier;
+	Store.SetPerishDeadline(Handle, NewDeadline);
+	if (Store.GetAgingMode(Handle) == EItemAgingMode::Scheduled)
+	{
+		PerishScheduler.Schedule(Handle, NewDeadline);
+	}
+}
+
+bool UItemInstanceSubsystem::MoveToContainer(const FItemHandle Handle, const FItemHandle Container)
+{
+	if (!Store.IsValid(Handle) || (Container.IsValid() && !Store.IsValid(Container))) return false;
+	if (ContainerTree.GetParent(Handle) == Container) return true;
+
+	if (Container.IsValid() && ContainerTree.GetFreeCells(Container) < ContainerTree.GetCells(Handle))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("ItemInstanceSubsystem: no room for instance %u in container %u."), Handle.GetValue(), Container.GetValue());
+		return false;
+	}
+	const FItemHandle From = ContainerTree.GetParent(Handle);
+	if (!ContainerTree.Move(Handle, Container)) return false;
+
+	Store.SetContainer(Handle, Container);
+	MoveSearchEntry(Handle, From, Container);
+	return true;
+}
+
+bool UItemInstanceSubsystem::SetStack(const FItemHandle Handle, const int32 Stack)
+{
+	if (!Store.IsValid(Handle)) return false;
+	if (Stack <= 0)
+	{
+		DestroyInstance(Handle);
+		return false;
+	}
+
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	const int32 ItemId = Store.GetItemId(Handle);
+	const int32 MaxStack = Catalog && Catalog->IsValidId(ItemId) ? FMath::Max(Catalog->GetStats().GetMaxStackSize(ItemId), 1) : Stack;
+	Store.SetStack(Handle, FMath::Min(Stack, MaxStack));
+	ContainerTree.Update(Handle, DescribeInstance(Handle));
+	return true;
+}
+
+bool UItemInstanceSubsystem::Repair(const FItemHandle Handle)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog || !Refresh(Handle)) return false;
+
+	const int32 ItemId = Store.GetItemId(Handle);
+	if (!Catalog->HasCapabilities(ItemId, EItemCapability::CanBeRepaired)) return false;
+
+	const float MaxDurability = Catalog->GetStats().Get(EItemStat::MaxDurability, ItemId);
+	Store.SetDurability(Handle, FMath::Max(MaxDurability - Store.GetWear(Handle), 0.0f));
+	return true;
+}
+
+double UItemInstanceSubsystem::GetNow() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetTimeSeconds() : 0.0;
+}
+
+void UItemInstanceSubsystem::StartPerishing(const FItemHandle Handle, const double From)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	const double Lifetime = Catalog ? HlpItem::GetPerishLifetime(*Catalog, Store.GetItemId(Handle)) : 0.0;
+	if (Lifetime <= 0.0)
+	{
+		Store.SetPerishDeadline(Handle, 0.0);
+		PerishScheduler.Unschedule(Handle);
+		return;
+	}
+
+	const double Deadline = From + Lifetime / Store.GetPerishMultiplier(Handle);
+	Store.SetPerishDeadline(Handle, Deadline);
+	PerishScheduler.Schedule(Handle, Deadline);
+}
+
+void UItemInstanceSubsystem::ApplyPerished()
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog) return;
+
+	const FItemStatColumns& Stats = Catalog->GetStats();
+	PerishTransforms.Reset();
+	for (const FItemHandle Handle : ExpiredHandles)
+	{
+		// Slots recycled without being unscheduled leave stale handles behind.
+		if (!Store.IsValid(Handle)) continue;
+
+		FPerishTransform& Transform = PerishTransforms.AddDefaulted_GetRef();
+		Transform.Handle = Handle;
+		Transform.FromItem = Store.GetItemId(Handle);
+		Transform.ToItem = Catalog->IsValidId(Transform.FromItem) ? Catalog->GetPerishTarget(Transform.FromItem) : INDEX_NONE;
+
+		const double Deadline = Store.GetPerishDeadline(Handle);
+		Store.SetPerishDeadline(Handle, 0.0);
+		if (Transform.ToItem == INDEX_NONE) continue;
+
+		Store.SetItemId(Handle, Transform.ToItem);
+		Store.SetDurability(Handle, Stats.Get(EItemStat::MaxDurability, Transform.ToItem));
+		Store.SetWear(Handle, 0.0f);
+		Store.SetLastEvaluated(Handle, Deadline);
+		StartPerishing(Handle, Deadline);
+		ContainerTree.Update(Handle, DescribeInstance(Handle));
+		UpdateSearchEntry(Handle);
+	}
+
+	OnInstancesPerished.Broadcast(PerishTransforms);
+
+	for (const FPerishTransform& Transform : PerishTransforms)
+	{
+		if (Transform.ToItem == INDEX_NONE)
+		{
+			ReleaseInstance(Transform.Handle);
+		}
+	}
+}
+
+int32 UItemInstanceSubsystem::RestoreInstances(TConstArrayView<FItemSnapshotEntry> Entries, TArray<FItemHandle>& InOutHandles)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	const double Now = GetNow();
+	int32 NumCreated = 0;
+	for (const FItemSnapshotEntry& Entry : Entries)
+	{
+		const int32 ItemId = Catalog && !Entry.ItemID.IsNone() ? Catalog->FindId(Entry.ItemID) : INDEX_NONE;
+		if (ItemId == INDEX_NONE)
+		{
+			UE_CLOG(!Entry.ItemID.IsNone(), LogTemp, Warning, TEXT("ItemInstanceSubsystem: saved item %s is no longer in the catalog."), *Entry.ItemID.ToString());
+			InOutHandles.Add(FItemHandle());
+			continue;
+		}
+
+		const float PerishMultiplier = FMath::Max(Entry.PerishMultiplier, ItemInstanceStore::MinPerishMultiplier);
+		const float WearRate = FMath::Max(Entry.WearRate, 0.0f);
+		FItemAgingState State;
+		State.ItemId = ItemId;
+		State.PerishDeadline = Entry.bPerishes ? Now + Entry.PerishRemaining : 0.0;
+		State.Durability = Entry.Durability;
+		State.Wear = Entry.Wear;
+		double LastEvaluated = Now - Entry.SinceEvaluated;
+
+		// Deadlines that passed while saved are aged to now at once, the overdue time carrying over to the next items.
+		if (Entry.bPerishes && Entry.PerishRemaining <= 0.0)
+		{
+			HlpItem::AgeOverdue(*Catalog, State, Entry.PerishRemaining, Entry.SinceEvaluated, Now, PerishMultiplier, WearRate);
+			LastEvaluated = Now;
+			if (State.ItemId == INDEX_NONE)
+			{
+				InOutHandles.Add(FItemHandle());
+				continue;
+			}
+		}
+
+		const FItemHandle Handle = Store.Create(State.ItemId, Entry.Stack, State.Durability);
+		InOutHandles.Add(Handle);
+		if (!Handle.IsValid()) continue;
+
+		Store.SetWear(Handle, State.Wear);
+		Store.SetPerishMultiplier(Handle, PerishMultiplier);
+		Store.SetWearRate(Handle, WearRate);
+		Store.SetLastEvaluated(Handle, LastEvaluated);
+		Store.SetAgingMode(Handle, Entry.AgingMode);
+
+		const double Deadline = State.PerishDeadline;
+		Store.SetPerishDeadline(Handle, Deadline);
+		if (Deadline > 0.0 && Entry.AgingMode == EItemAgingMode::Scheduled)
+		{
+			PerishScheduler.Schedule(Handle, Deadline);
+		}
+
+		const FItemHandle Parent = InOutHandles.IsValidIndex(Entry.Parent) && ContainerTree.Contains(InOutHandles[Entry.Parent]) ? InOutHandles[Entry.Parent] : FItemHandle();
+		ContainerTree.Insert(Handle, Parent, DescribeInstance(Handle));
+		Store.SetContainer(Handle, Parent);
+		MoveSearchEntry(Handle, FItemHandle(), Parent);
+		++NumCreated;
+	}
+	return NumCreated;
+}
+
+FContainedItem UItemInstanceSubsystem::DescribeInstance(const FItemHandle Handle) const
+{
+	FContainedItem Item;
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	const int32 ItemId = Store.GetItemId(Handle);
+	if (!Catalog || !Catalog->IsValidId(ItemId)) return Item;
+
+	// The mass column was resolved once from WeightConfig, dynamic masses do not walk the meshes here.
+	Item.Mass = static_cast<double>(Catalog->GetStats().Get(EItemStat::Mass, ItemId)) * Store.GetStack(Handle);
+
+	const FItemDetail& Detail = Catalog->GetDetails().Get(ItemId);
+	Item.Cells = Detail.FootprintX * Detail.FootprintY;
+	Item.Capacity = Detail.Capacity;
+	return Item;
+}
+
+void UItemInstanceSubsystem::ReleaseInstance(const FItemHandle Handle)
+{
+	TArray<FItemHandle> Content;
+	const FItemHandle Parent = ContainerTree.GetParent(Handle);
+	ContainerTree.Remove(Handle, &Content);
+	MoveSearchEntry(Handle, Parent, FItemHandle());
+	SearchIndexes.Remove(Handle);
+	for (const FItemHandle Item : Content)
+	{
+		Store.SetContainer(Item, Parent);
+		MoveSearchEntry(Item, FItemHandle(), Parent);
+	}
+	Store.Destroy(Handle);
+}
+
+const FContainerSearchIndex* UItemInstanceSubsystem::EnableSearchIndex(const FItemHandle Container)
+{
+	if (!Store.IsValid(Container)) return nullptr;
+	if (const TUniquePtr<FContainerSearchIndex>* Existing = SearchIndexes.Find(Container)) return Existing->Get();
+
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (!Catalog) return nullptr;
+
+	FContainerSearchIndex& Index = *SearchIndexes.Add(Container, MakeUnique<FContainerSearchIndex>());
+	ContainerTree.ForEachContent(Container, [&](const FItemHandle Item)
+	{
+		Index.Insert(Item, Store.GetItemId(Item), *Catalog);
+	});
+	return &Index;
+}
+
+const FContainerSearchIndex* UItemInstanceSubsystem::FindSearchIndex(const FItemHandle Container) const
+{
+	const TUniquePtr<FContainerSearchIndex>* Index = SearchIndexes.Find(Container);
+	return Index ? Index->Get() : nullptr;
+}
+
+void UItemInstanceSubsystem::MoveSearchEntry(const FItemHandle Handle, const FItemHandle From, const FItemHandle To)
+{
+	if (SearchIndexes.IsEmpty()) return;
+
+	if (const TUniquePtr<FContainerSearchIndex>* Index = From.IsValid() ? SearchIndexes.Find(From) : nullptr)
+	{
+		(*Index)->Remove(Handle);
+	}
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (const TUniquePtr<FContainerSearchIndex>* Index = To.IsValid() && Catalog ? SearchIndexes.Find(To) : nullptr)
+	{
+		(*Index)->Insert(Handle, Store.GetItemId(Handle), *Catalog);
+	}
+}
+
+void UItemInstanceSubsystem::UpdateSearchEntry(const FItemHandle Handle)
+{
+	if (SearchIndexes.IsEmpty()) return;
+
+	const FItemHandle Container = ContainerTree.GetParent(Handle);
+	const TUniquePtr<FContainerSearchIndex>* Index = Container.IsValid() ? SearchIndexes.Find(Container) : nullptr;
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	if (Index && Catalog)
+	{
+		(*Index)->Update(Handle, Store.GetItemId(Handle), *Catalog);
+	}
+}
@@ -0,0 +1,139 @@
+﻿#include "Inventory/ItemInstanceStore.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// ===============================[ Item Instance Store Tests ]============================
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemStoreStaleHandleTest, "Warfall.Items.Store.StaleHandles", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FItemStoreStaleHandleTest::RunTest(const FString& Parameters)
+{
+	FItemInstanceStore Store;
+	TestFalse(TEXT("The null handle is invalid"), Store.IsValid(FItemHandle()));
+	TestFalse(TEXT("A handle beyond the slots is invalid"), Store.IsValid(FItemHandle(12345, 1)));
+
+	const FItemHandle A = Store.Create(1, 5, 10.0f);
+	const FItemHandle B = Store.Create(2, 6, 20.0f);
+	const FItemHandle C = Store.Create(3, 7, 30.0f);
+	TestEqual(TEXT("Three live instances"), Store.Num(), 3);
+	TestEqual(TEXT("Slots are handed out from the lowest"), B.GetIndex(), A.GetIndex() + 1);
+
+	Store.SetWear(B, 4.0f);
+	Store.SetPerishDeadline(B, 99.0);
+	Store.SetContainer(B, A);
+	TestTrue(TEXT("Destroying a live handle succeeds"), Store.Destroy(B));
+	TestFalse(TEXT("The destroyed handle is rejected"), Store.IsValid(B));
+	TestFalse(TEXT("A handle is destroyed once"), Store.Destroy(B));
+	TestTrue(TEXT("Other handles are untouched"), Store.IsValid(A) && Store.IsValid(C));
+	TestEqual(TEXT("Other columns are untouched"), Store.GetStack(C), 7);
+
+	// The freed slot is reused by the next instance, under the next generation.
+	const FItemHandle D = Store.Create(4, 8, 40.0f);
+	TestEqual(TEXT("The freed slot is reused"), D.GetIndex(), B.GetIndex());
+	TestEqual(TEXT("The reused slot moves to the next generation"), D.GetGeneration(), B.GetGeneration() + 1);
+	TestFalse(TEXT("The stale handle stays rejected after reuse"), Store.IsValid(B));
+	TestFalse(TEXT("Destroying through the stale handle fails"), Store.Destroy(B));
+	TestTrue(TEXT("The new instance survives the stale destroy"), Store.IsValid(D));
+	TestEqual(TEXT("The reused slot holds the new item"), Store.GetItemId(D), 4);
+	TestEqual(TEXT("The reused slot holds the new stack"), Store.GetStack(D), 8);
+	TestEqual(TEXT("The reused slot starts without wear"), Store.GetWear(D), 0.0f);
+	TestEqual(TEXT("The reused slot starts without deadline"), Store.GetPerishDeadline(D), 0.0);
+	TestFalse(TEXT("The reused slot starts outside containers"), Store.GetContainer(D).IsValid());
+
+	// Freed slots are reused last freed first.
+	Store.Destroy(A);
+	Store.Destroy(C);
+	TestEqual(TEXT("The last freed slot comes first"), Store.Create(0).GetIndex(), C.GetIndex());
+	TestEqual(TEXT("Then the one freed before"), Store.Create(0).GetIndex(), A.GetIndex());
+
+	int32 NumVisited = 0;
+	Store.ForEach([&](const FItemHandle Handle)
+	{
+		NumVisited += Store.IsValid(Handle);
+	});
+	TestEqual(TEXT("ForEach visits the live instances only"), NumVisited, Store.Num());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemStoreChurnTest, "Warfall.Items.Store.Churn", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FItemStoreChurnTest::RunTest(const FString& Parameters)
+{
+	// Random creates and destroys across several slabs, checked against a plain map after every operation batch.
+	FItemInstanceStore Store;
+	FRandomStream Random(13);
+	TMap<FItemHandle, int32> Live;
+	TArray<FItemHandle> LiveHandles;
+	TArray<FItemHandle> Dead;
+	for (int32 Op = 0; Op < 40000; ++Op)
+	{
+		if (LiveHandles.IsEmpty() || Random.FRand() < 0.55f)
+		{
+			const int32 Stack = Random.RandRange(1, 1000);
+			const FItemHandle Handle = Store.Create(Op, Stack);
+			if (!TestTrue(TEXT("Creating succeeds"), Store.IsValid(Handle))) return false;
+			if (!TestFalse(TEXT("A live handle is never handed out twice"), Live.Contains(Handle))) return false;
+			Live.Add(Handle, Stack);
+			LiveHandles.Add(Handle);
+		}
+		else
+		{
+			const int32 Index = Random.RandHelper(LiveHandles.Num());
+			const FItemHandle Handle = LiveHandles[Index];
+			LiveHandles.RemoveAtSwap(Index);
+			Live.Remove(Handle);
+			Store.Destroy(Handle);
+			Dead.Add(Handle);
+		}
+
+		if (Op % 4000 == 0)
+		{
+			for (const TPair<FItemHandle, int32>& Entry : Live)
+			{
+				if (!TestEqual(TEXT("Live instances keep their columns"), Store.GetStack(Entry.Key), Entry.Value)) return false;
+			}
+			for (const FItemHandle Handle : Dead)
+			{
+				if (!TestFalse(TEXT("Destroyed handles stay rejected"), Store.IsValid(Handle))) return false;
+			}
+		}
+	}
+	TestEqual(TEXT("The live count matches"), Store.Num(), Live.Num());
+	TestTrue(TEXT("Freed slots were reused instead of growing"), Store.GetCapacity() < 40000);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemHandleGenerationWrapTest, "Warfall.Items.Store.HandleGenerationWrap", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FItemHandleGenerationWrapTest::RunTest(const FString& Parameters)
+{
+	FItemInstanceStore Store;
+	const FItemHandle First = Store.Create(0);
+	TestTrue(TEXT("The first handle is valid"), Store.IsValid(First));
+	TestEqual(TEXT("Generations start at 1"), First.GetGeneration(), 1u);
+
+	// The free list hands the destroyed slot out first, so every cycle reuses the slot of First.
+	FItemHandle Previous = First;
+	for (uint32 Cycle = 1; Cycle <= FItemHandle::MaxGeneration; ++Cycle)
+	{
+		Store.Destroy(Previous);
+		const FItemHandle Handle = Store.Create(0);
+		if (!TestEqual(TEXT("The destroyed slot is reused"), Handle.GetIndex(), First.GetIndex())) return false;
+		if (!TestNotEqual(TEXT("A valid handle is never 0"), Handle.GetValue(), 0u)) return false;
+		if (!TestFalse(TEXT("The destroyed handle is no longer valid"), Store.IsValid(Previous))) return false;
+		if (!TestEqual(TEXT("Generations cycle in [1, MaxGeneration]"), Handle.GetGeneration(), Cycle % FItemHandle::MaxGeneration + 1)) return false;
+		Previous = Handle;
+	}
+
+	TestEqual(TEXT("The generation wrapped back to the first one"), Previous.GetGeneration(), First.GetGeneration());
+	TestEqual(TEXT("One instance is live"), Store.Num(), 1);
+
+	// Reset keeps the generations counting.
+	Store.Reset();
+	TestFalse(TEXT("Reset invalidates the live handles"), Store.IsValid(Previous));
+	TestEqual(TEXT("Reset moves to the next generation"), Store.Create(0).GetGeneration(), Previous.GetGeneration() % FItemHandle::MaxGeneration + 1);
+	return true;
+}
+
+#endif
@@ -0,0 +1,387 @@
+﻿#include "Inventory/ItemModifiers.h"
+
+#include "Algo/StableSort.h"
+#include "Async/ParallelFor.h"
+#include "Inventory/ItemCatalog.h"
+#include "Math/VectorRegister.h"
+#include "Stats/Stats.h"
+
+namespace ItemModifiers
+{
+	/** Below this number of dirty sets, Flush does not spread the work over the task graph. */
+	constexpr int32 MinParallelSets = 32;
+
+	/** Normalizes an authored modifier. @return False if the modifier has no effect or cannot be applied. */
+	bool Compile(const EMathOperation Operation, const float Value, FCompiledModifier& OutModifier)
+	{
+		switch (Operation)
+		{
+		case EMathOperation::E_Add:
+		case EMathOperation::E_Multiply:
+		case EMathOperation::E_Override:
+			OutModifier.Operation = Operation;
+			OutModifier.Value = Value;
+			return true;
+		case EMathOperation::E_Divide:
+			if (FMath::IsNearlyZero(Value)) return false;
+			OutModifier.Operation = EMathOperation::E_Multiply;
+			OutModifier.Value = 1.0f / Value;
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
+// ===============================[ Item Modifier Table ]============================
+
+void FItemModifierTable::Build(const FItemCatalog& Catalog)
+{
+	Reset();
+
+	for (int32 Id = 0; Id < Catalog.Num(); ++Id)
+	{
+		RowOps.Reset();
+		if (const FItemRow* Row = Catalog.FindRow(Id))
+		{
+			CompileRow(*Row, Catalog.GetRowName(Id), RowOps);
+		}
+		Ops.Add(RowOps);
+	}
+}
+
+void FItemModifierTable::SetRow(const int32 Id, const FItemRow* Row, const FName RowName)
+{
+	RowOps.Reset();
+	if (Row)
+	{
+		CompileRow(*Row, RowName, RowOps);
+	}
+	Ops.Set(Id, RowOps);
+}
+
+void FItemModifierTable::AddRow(const FItemRow& Row, const FName RowName)
+{
+	RowOps.Reset();
+	CompileRow(Row, RowName, RowOps);
+	Ops.Add(RowOps);
+}
+
+void FItemModifierTable::CompileRow(const FItemRow& Row, const FName RowName, TArray<FCompiledModifier>& OutOps)
+{
+	const int32 First = OutOps.Num();
+	for (const FItemMetaEntry& Entry : Row.MetaModifiers)
+	{
+		FCompiledModifier Modifier;
+		if (!Entry.Key.IsValid() || !ItemModifiers::Compile(Entry.Operation, Entry.Value, Modifier))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ItemModifiers: '%s' has a meta modifier without key or with an invalid operation, ignored."),
+				*RowName.ToString());
+			continue;
+		}
+		Modifier.Slot = FindOrAddSlot(Entry.Key.GetTagName());
+		OutOps.Add(Modifier);
+	}
+	for (const TPair<FName, float>& Pair : Row.Modifiers)
+	{
+		FCompiledModifier& Modifier = OutOps.AddDefaulted_GetRef();
+		Modifier.Slot = FindOrAddSlot(Pair.Key);
+		Modifier.Value = Pair.Value;
+	}
+
+	// Stable: overrides of the same slot keep their authoring order, the last one wins.
+	Algo::StableSortBy(MakeArrayView(OutOps.GetData() + First, OutOps.Num() - First), &FCompiledModifier::Slot);
+}
+
+void FItemModifierTable::Reset()
+{
+	Ops.Reset();
+	StatKeys.Reset();
+	StatSlots.Reset();
+}
+
+void FItemModifierTable::BindExternal(TArray<FName> InStatKeys, const uint32* InRanges, const FCompiledModifier* InOps, const int32 InNumItems)
+{
+	Reset();
+	StatKeys = MoveTemp(InStatKeys);
+	for (int32 Slot = 0; Slot < StatKeys.Num(); ++Slot)
+	{
+		StatSlots.Add(StatKeys[Slot], Slot);
+	}
+	Ops.BindExternal(InRanges, InOps, InNumItems);
+}
+
+int32 FItemModifierTable::FindOrAddSlot(const FName StatKey)
+{
+	if (const int32* Slot = StatSlots.Find(StatKey)) return *Slot;
+
+	checkf(StatKeys.Num() < MAX_uint16, TEXT("ItemModifiers: too many distinct stat keys."));
+	const int32 Slot = StatKeys.Add(StatKey);
+	StatSlots.Add(StatKey, Slot);
+	return Slot;
+}
+
+// ===============================[ Item Modifier Evaluator ]============================
+
+FModifierSetId FItemModifierEvaluator::AddSet()
+{
+	FModifierSetId Set;
+	if (!FreeSets.IsEmpty())
+	{
+		Set = FreeSets.Pop();
+	}
+	else
+	{
+		Set = SetItemIds.AddDefaulted();
+		SetDirty.Add(false);
+		SetAlive.Add(false);
+		Adds.AddZeroed(SlotStride);
+		Scales.AddZeroed(SlotStride);
+		Overrides.AddZeroed(SlotStride);
+		OverrideMasks.AddZeroed(SlotStride);
+	}
+
+	SetAlive[Set] = true;
+	SetDirty[Set] = true;
+	return Set;
+}
+
+void FItemModifierEvaluator::RemoveSet(const FModifierSetId Set)
+{
+	if (!IsValidSet(Set)) return;
+
+	SetItemIds[Set].Reset();
+	SetAlive[Set] = false;
+	SetDirty[Set] = false;
+	FreeSets.Add(Set);
+}
+
+void FItemModifierEvaluator::SetItems(const FModifierSetId Set, TConstArrayView<int32> Items)
+{
+	if (!IsValidSet(Set)) return;
+
+	TArray<int32>& Current = SetItemIds[Set];
+	if (Current.Num() == Items.Num() && FMemory::Memcmp(Current.GetData(), Items.GetData(), Items.NumBytes()) == 0) return;
+
+	Current.Reset();
+	Current.Append(Items.GetData(), Items.Num());
+	SetDirty[Set] = true;
+}
+
+void FItemModifierEvaluator::AddItem(const FModifierSetId Set, const int32 Item)
+{
+	if (!IsValidSet(Set)) return;
+
+	SetItemIds[Set].Add(Item);
+	SetDirty[Set] = true;
+}
+
+bool FItemModifierEvaluator::RemoveItem(const FModifierSetId Set, const int32 Item)
+{
+	if (!IsValidSet(Set)) return false;
+
+	const int32 Index = SetItemIds[Set].Find(Item);
+	if (Index == INDEX_NONE) return false;
+
+	SetItemIds[Set].RemoveAt(Index);
+	SetDirty[Set] = true;
+	return true;
+}
+
+void FItemModifierEvaluator::InvalidateAll()
+{
+	for (int32 Set = 0; Set < SetDirty.Num(); ++Set)
+	{
+		SetDirty[Set] = SetAlive[Set];
+	}
+}
+
+void FItemModifierEvaluator::InvalidateItems(TConstArrayView<int32> Items)
+{
+	if (Items.IsEmpty()) return;
+
+	for (int32 Set = 0; Set < SetItemIds.Num(); ++Set)
+	{
+		if (!SetAlive[Set] || SetDirty[Set]) continue;
+		for (const int32 Item : SetItemIds[Set])
+		{
+			if (Items.Contains(Item))
+			{
+				SetDirty[Set] = true;
+				break;
+			}
+		}
+	}
+}
+
+int32 FItemModifierEvaluator::Flush(const FItemModifierTable& Table)
+{
+	if (Table.NumSlots() != NumSlots)
+	{
+		NumSlots = Table.NumSlots();
+		SlotStride = Align(NumSlots, 4);
+		const int32 NumFloats = SetItemIds.Num() * SlotStride;
+		Adds.SetNumZeroed(NumFloats);
+		Scales.SetNumZeroed(NumFloats);
+		Overrides.SetNumZeroed(NumFloats);
+		OverrideMasks.SetNumZeroed(NumFloats);
+		InvalidateAll();
+	}
+
+	TArray<FModifierSetId> DirtySets;
+	for (FModifierSetId Set = 0; Set < SetDirty.Num(); ++Set)
+	{
+		if (SetDirty[Set])
+		{
+			DirtySets.Add(Set);
+		}
+	}
+
+	// Every set writes its own range of the aggregate arrays, no synchronization is needed.
+	ParallelFor(DirtySets.Num(), [this, &DirtySets, &Table](const int32 Index)
+	{
+		Recompute(DirtySets[Index], Table);
+	}, DirtySets.Num() < ItemModifiers::MinParallelSets ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	for (const FModifierSetId Set : DirtySets)
+	{
+		SetDirty[Set] = false;
+	}
+	return DirtySets.Num();
+}
+
+void FItemModifierEvaluator::Recompute(const FModifierSetId Set, const FItemModifierTable& Table)
+{
+	const int32 Offset = Set * SlotStride;
+	float* SetAdds = Adds.GetData() + Offset;
+	float* SetScales = Scales.GetData() + Offset;
+	float* SetOverrides = Overrides.GetData() + Offset;
+	float* SetMasks = OverrideMasks.GetData() + Offset;
+
+	FMemory::Memzero(SetAdds, SlotStride * sizeof(float));
+	FMemory::Memzero(SetOverrides, SlotStride * sizeof(float));
+	FMemory::Memzero(SetMasks, SlotStride * sizeof(float));
+	for (int32 Slot = 0; Slot < SlotStride; ++Slot)
+	{
+		SetScales[Slot] = 1.0f;
+	}
+
+	for (const int32 Item : SetItemIds[Set])
+	{
+		for (const FCompiledModifier& Modifier : Table.GetOps(Item))
+		{
+			switch (Modifier.Operation)
+			{
+			case EMathOperation::E_Add:
+				SetAdds[Modifier.Slot] += Modifier.Value;
+				break;
+			case EMathOperation::E_Multiply:
+				SetScales[Modifier.Slot] *= Modifier.Value;
+				break;
+			case EMathOperation::E_Override:
+				SetOverrides[Modifier.Slot] = Modifier.Value;
+				SetMasks[Modifier.Slot] = 1.0f;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
+
+float FItemModifierEvaluator::Evaluate(const FModifierSetId Set, const int32 Slot, const float Base) const
+{
+	if (!IsValidSet(Set) || Slot < 0 || Slot >= NumSlots) return Base;
+
+	const int32 Index = Set * SlotStride + Slot;
+	return OverrideMasks[Index] != 0.0f ? Overrides[Index] : (Base + Adds[Index]) * Scales[Index];
+}
+
+void FItemModifierEvaluator::Resolve(const FModifierSetId Set, TConstArrayView<float> Base, TArrayView<float> Out) const
+{
+	check(Base.Num() >= NumSlots && Out.Num() >= NumSlots);
+	if (!IsValidSet(Set))
+	{
+		FMemory::Memmove(Out.GetData(), Base.GetData(), NumSlots * sizeof(float));
+		return;
+	}
+
+	const int32 Offset = Set * SlotStride;
+	const float* SetAdds = Adds.GetData() + Offset;
+	const float* SetScales = Scales.GetData() + Offset;
+	const float* SetOverrides = Overrides.GetData() + Offset;
+	const float* SetMasks = OverrideMasks.GetData() + Offset;
+
+	// Out = Computed + Mask * (Override - Computed), with Computed = (Base + Add) * Scale.
+	int32 Slot = 0;
+	for (; Slot + 4 <= NumSlots; Slot += 4)
+	{
+		const VectorRegister4Float Computed = VectorMultiply(VectorAdd(VectorLoad(Base.GetData() + Slot), VectorLoadAligned(SetAdds + Slot)), VectorLoadAligned(SetScales + Slot));
+		const VectorRegister4Float Blend = VectorSubtract(VectorLoadAligned(SetOverrides + Slot), Computed);
+		VectorStore(VectorMultiplyAdd(VectorLoadAligned(SetMasks + Slot), Blend, Computed), Out.GetData() + Slot);
+	}
+	for (; Slot < NumSlots; ++Slot)
+	{
+		const float Computed = (Base[Slot] + SetAdds[Slot]) * SetScales[Slot];
+		Out[Slot] = Computed + SetMasks[Slot] * (SetOverrides[Slot] - Computed);
+	}
+}
+
+// ===============================[ Item Modifier Subsystem ]============================
+
+void UItemModifierSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	if (UItemCatalogSubsystem* Catalog = UItemCatalogSubsystem::Get())
+	{
+		CatalogRebuiltHandle = Catalog->OnCatalogRebuilt.AddUObject(this, &UItemModifierSubsystem::HandleCatalogRebuilt);
+		RowsPatchedHandle = Catalog->OnRowsPatched.AddUObject(this, &UItemModifierSubsystem::HandleRowsPatched);
+	}
+}
+
+void UItemModifierSubsystem::Deinitialize()
+{
+	if (UItemCatalogSubsystem* Catalog = UItemCatalogSubsystem::Get())
+	{
+		Catalog->OnCatalogRebuilt.Remove(CatalogRebuiltHandle);
+		Catalog->OnRowsPatched.Remove(RowsPatchedHandle);
+	}
+	CatalogRebuiltHandle.Reset();
+	RowsPatchedHandle.Reset();
+	Super::Deinitialize();
+}
+
+void UItemModifierSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	Flush();
+}
+
+TStatId UItemModifierSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UItemModifierSubsystem, STATGROUP_Tickables);
+}
+
+void UItemModifierSubsystem::Flush()
+{
+	if (const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog())
+	{
+		Evaluator.Flush(Catalog->GetModifiers());
+	}
+}
+
+int32 UItemModifierSubsystem::FindStatSlot(const FName StatKey)
+{
+	const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog();
+	return Catalog ? Catalog->GetModifiers().FindSlot(StatKey) : INDEX_NONE;
+}
+
+void UItemModifierSubsystem::HandleCatalogRebuilt()
+{
+	Evaluator.InvalidateAll();
+}
+
+void UItemModifierSubsystem::HandleRowsPatched(TConstArrayView<int32> Items)
+{
+	Evaluator.InvalidateItems(Items);
+}
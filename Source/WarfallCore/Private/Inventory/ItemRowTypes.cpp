@@ -1,5 +1,6 @@
 ﻿#include "Inventory/ItemRowTypes.h"
 
+#include "Inventory/ItemCatalog.h"
 #include "Inventory/VisualItem.h"
 #include "DetailLayoutBuilder.h"
 #include "DetailWidgetRow.h"
@@ -121,6 +122,37 @@ FItemRow::FItemRow()
 	
 }
 
+// ===============================[ Item Helpers ]============================
+
+bool HlpItem::GetItemRow(const FName RowID, FItemRow& OutItemRow)
+{
+	const FItemRow* Row = FindItemRow(RowID);
+	if (!Row) { return false; }
+	OutItemRow = *Row;
+	return true;
+}
+
+void FItemRowDetail::OnDataTableChanged(const UDataTable* InDataTable, const FName InRowName)
+{
+	UItemCatalogSubsystem::NotifyRowChanged(InDataTable, InRowName);
+}
+
+const FItemRow* HlpItem::FindItemRow(const FName RowID)
+{
+	if (const FItemCatalog* Catalog = UItemCatalogSubsystem::GetCatalog(); Catalog && Catalog->HasRows())
+	{
+		return Catalog->FindRow(RowID);
+	}
+
+	// The catalog is not available before the engine subsystems are initialized (early customizations, commandlets),
+	// and a catalog mapped from a cooked file holds no rows.
+	const UDataTable* Table = UTables::GetTable(ETablePath::ItemsTable);
+	if (!Table) { return nullptr; }
+
+	const FItemRowDetail* RowDetail = Table->FindRow<FItemRowDetail>(RowID, TEXT("Finding"));
+	return RowDetail ? &RowDetail->Details : nullptr;
+}
+
 #define LOCTEXT_NAMESPACE "CustomItemRow"
 
 // ===============================[ Property Customization Factory ]============================
@@ -0,0 +1,348 @@
+﻿#include "Inventory/ItemSnapshot.h"
+
+#include "Inventory/ContainerTree.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemInstanceStore.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace ItemSnapshot
+{
+	constexpr uint8 FlagLazy = 1 << 0;
+	constexpr uint8 FlagPerishes = 1 << 1;
+	constexpr uint8 FlagPlaced = 1 << 2;
+	constexpr uint8 FlagRotated = 1 << 3;
+
+	void WriteVarint(FArchive& Ar, uint32 Value)
+	{
+		Ar.SerializeIntPacked(Value);
+	}
+
+	uint32 ReadVarint(FArchive& Ar)
+	{
+		uint32 Value = 0;
+		Ar.SerializeIntPacked(Value);
+		return Value;
+	}
+}
+
+// ===============================[ Item Snapshot Writer ]============================
+
+FItemSnapshotWriter::FItemSnapshotWriter(FArchive& InAr, const FItemInstanceStore& InStore, const FItemContainerTree& InTree, const FItemCatalog& InCatalog, const bool bInCompress) :
+ Ar(InAr),
+ Store(InStore),
+ Tree(InTree),
+ Catalog(InCatalog),
+ bCompress(bInCompress)
+{
+}
+
+void FItemSnapshotWriter::AddRoot(const FItemHandle Handle, const FItemSnapshotPlacement* Placement)
+{
+	if (!Store.IsValid(Handle)) return;
+
+	FQueuedInstance& Root = Queued.AddDefaulted_GetRef();
+	Root.Handle = Handle;
+	Root.bHasPlacement = Placement != nullptr;
+	Root.Placement = Placement ? *Placement : FItemSnapshotPlacement();
+
+	// Pre-order walk, so that every container gets its index before its content.
+	for (int32 Index = Queued.Num() - 1; Index < Queued.Num(); ++Index)
+	{
+		Tree.ForEachContent(Queued[Index].Handle, [this, Index](const FItemHandle Content)
+		{
+			FQueuedInstance& Entry = Queued.AddDefaulted_GetRef();
+			Entry.Handle = Content;
+			Entry.Parent = Index;
+		});
+	}
+}
+
+bool FItemSnapshotWriter::WriteChunk(const double Now, const int32 MaxInstances)
+{
+	using namespace ItemSnapshot;
+
+	if (bFinished) return false;
+
+	if (!bHeaderWritten)
+	{
+		uint32 HeaderMagic = Magic;
+		uint32 HeaderVersion = Version;
+		uint32 HeaderFlags = bCompress ? FlagCompressed : 0;
+		Ar << HeaderMagic << HeaderVersion << HeaderFlags;
+		bHeaderWritten = true;
+	}
+
+	const int32 First = NextIndex;
+	const int32 End = FMath::Min(First + FMath::Max(MaxInstances, 1), Queued.Num());
+	if (End > First)
+	{
+		// Dictionary indices first, to write the names new to this chunk ahead of the columns.
+		TArray<FName, TInlineAllocator<64>> NewNames;
+		ChunkNames.Reset();
+		for (int32 Index = First; Index < End; ++Index)
+		{
+			const FItemHandle Handle = Queued[Index].Handle;
+			const int32 ItemId = Store.IsValid(Handle) ? Store.GetItemId(Handle) : INDEX_NONE;
+			if (!Catalog.IsValidId(ItemId))
+			{
+				ChunkNames.Add(0);
+				continue;
+			}
+
+			uint32* NameIndex = NameIndices.Find(ItemId);
+			if (!NameIndex)
+			{
+				NameIndex = &NameIndices.Add(ItemId, NameIndices.Num() + 1);
+				NewNames.Add(Catalog.GetRowName(ItemId));
+			}
+			ChunkNames.Add(*NameIndex);
+		}
+
+		Payload.Reset();
+		FMemoryWriter Writer(Payload);
+		WriteVarint(Writer, NewNames.Num());
+		for (const FName Name : NewNames)
+		{
+			const FTCHARToUTF8 Utf8(*Name.ToString());
+			WriteVarint(Writer, Utf8.Length());
+			Writer.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+		}
+		WriteVarint(Writer, End - First);
+
+		// Destroyed instances keep their index, as a dictionary index of 0, so that parent indices stay valid.
+		auto IsLive = [this, First](const int32 Index) { return ChunkNames[Index - First] != 0; };
+		for (int32 Index = First; Index < End; ++Index)
+		{
+			WriteVarint(Writer, ChunkNames[Index - First]);
+		}
+		for (int32 Index = First; Index < End; ++Index)
+		{
+			WriteVarint(Writer, IsLive(Index) ? FMath::Max(Store.GetStack(Queued[Index].Handle), 0) : 0);
+		}
+		for (int32 Index = First; Index < End; ++Index)
+		{
+			WriteVarint(Writer, Queued[Index].Parent + 1);
+		}
+		for (int32 Index = First; Index < End; ++Index)
+		{
+			const FQueuedInstance& Entry = Queued[Index];
+			uint8 Flags = 0;
+			if (IsLive(Index))
+			{
+				Flags |= Store.GetAgingMode(Entry.Handle) == EItemAgingMode::Lazy ? FlagLazy : 0;
+				Flags |= Store.GetPerishDeadline(Entry.Handle) > 0.0 ? FlagPerishes : 0;
+				Flags |= Entry.bHasPlacement ? FlagPlaced : 0;
+				Flags |= Entry.bHasPlacement && Entry.Placement.bRotated ? FlagRotated : 0;
+			}
+			Writer << Flags;
+		}
+		for (float (FItemInstanceStore::*Getter)(FItemHandle) const : { &FItemInstanceStore::GetDurability, &FItemInstanceStore::GetWear, &FItemInstanceStore::GetPerishMultiplier, &FItemInstanceStore::GetWearRate })
+		{
+			for (int32 Index = First; Index < End; ++Index)
+			{
+				float Value = IsLive(Index) ? (Store.*Getter)(Queued[Index].Handle) : 0.0f;
+				Writer << Value;
+			}
+		}
+		for (int32 Index = First; Index < End; ++Index)
+		{
+			if (IsLive(Index) && Store.GetPerishDeadline(Queued[Index].Handle) > 0.0)
+			{
+				double Remaining = Store.GetPerishDeadline(Queued[Index].Handle) - Now;
+				Writer << Remaining;
+			}
+		}
+		for (int32 Index = First; Index < End; ++Index)
+		{
+			double SinceEvaluated = IsLive(Index) ? FMath::Max(Now - Store.GetLastEvaluated(Queued[Index].Handle), 0.0) : 0.0;
+			Writer << SinceEvaluated;
+		}
+		for (int32 Index = First; Index < End; ++Index)
+		{
+			FQueuedInstance& Entry = Queued[Index];
+			if (IsLive(Index) && Entry.bHasPlacement)
+			{
+				Writer << Entry.Placement.Pocket << Entry.Placement.CellX << Entry.Placement.CellY;
+			}
+		}
+
+		uint32 PayloadSize = Payload.Num();
+		uint32 StoredSize = 0;
+		if (bCompress)
+		{
+			int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Payload.Num());
+			Compressed.SetNumUninitialized(CompressedSize);
+			if (FCompression::CompressMemory(NAME_Zlib, Compressed.GetData(), CompressedSize, Payload.GetData(), Payload.Num()) && CompressedSize < Payload.Num())
+			{
+				StoredSize = CompressedSize;
+			}
+		}
+		WriteVarint(Ar, PayloadSize);
+		WriteVarint(Ar, StoredSize);
+		Ar.Serialize(StoredSize ? Compressed.GetData() : Payload.GetData(), StoredSize ? StoredSize : PayloadSize);
+		NextIndex = End;
+	}
+
+	if (NextIndex < Queued.Num()) return true;
+
+	WriteVarint(Ar, 0);
+	bFinished = true;
+	return false;
+}
+
+// ===============================[ Item Snapshot Reader ]============================
+
+FItemSnapshotReader::FItemSnapshotReader(FArchive& InAr) :
+ Ar(InAr)
+{
+	Names.Add(NAME_None);
+}
+
+bool FItemSnapshotReader::ReadHeader()
+{
+	uint32 HeaderMagic = 0;
+	Ar << HeaderMagic << Version << Flags;
+	if (Ar.IsError() || HeaderMagic != FItemSnapshotWriter::Magic || Version == 0 || Version > FItemSnapshotWriter::Version)
+	{
+		UE_LOG(LogTemp, Error, TEXT("ItemSnapshot: not a snapshot, or version %u is not supported."), Version);
+		bDone = true;
+		return false;
+	}
+	return true;
+}
+
+int32 FItemSnapshotReader::ReadChunk(TArray<FItemSnapshotEntry>& OutEntries)
+{
+	using namespace ItemSnapshot;
+
+	if (bDone) return 0;
+
+	const uint32 PayloadSize = ReadVarint(Ar);
+	if (PayloadSize == 0 && !Ar.IsError())
+	{
+		bDone = true;
+		return 0;
+	}
+
+	const uint32 StoredSize = ReadVarint(Ar);
+	if (Ar.IsError() || PayloadSize > MaxChunkBytes || StoredSize > MaxChunkBytes || (StoredSize && !(Flags & FItemSnapshotWriter::FlagCompressed)))
+	{
+		UE_LOG(LogTemp, Error, TEXT("ItemSnapshot: corrupted chunk header after %d instances."), NextIndex);
+		bDone = true;
+		return INDEX_NONE;
+	}
+
+	Payload.SetNumUninitialized(PayloadSize);
+	if (StoredSize)
+	{
+		Stored.SetNumUninitialized(StoredSize);
+		Ar.Serialize(Stored.GetData(), StoredSize);
+		if (Ar.IsError() || !FCompression::UncompressMemory(NAME_Zlib, Payload.GetData(), PayloadSize, Stored.GetData(), StoredSize))
+		{
+			UE_LOG(LogTemp, Error, TEXT("ItemSnapshot: chunk after %d instances does not decompress."), NextIndex);
+			bDone = true;
+			return INDEX_NONE;
+		}
+	}
+	else
+	{
+		Ar.Serialize(Payload.GetData(), PayloadSize);
+	}
+
+	const int32 NumBefore = OutEntries.Num();
+	if (Ar.IsError() || !ReadPayload(OutEntries))
+	{
+		UE_LOG(LogTemp, Error, TEXT("ItemSnapshot: corrupted chunk after %d instances."), NextIndex);
+		OutEntries.SetNum(NumBefore);
+		bDone = true;
+		return INDEX_NONE;
+	}
+
+	const int32 NumRead = OutEntries.Num() - NumBefore;
+	NextIndex += NumRead;
+	return NumRead;
+}
+
+bool FItemSnapshotReader::ReadPayload(TArray<FItemSnapshotEntry>& OutEntries)
+{
+	using namespace ItemSnapshot;
+
+	FMemoryReader Reader(Payload);
+	const uint32 NumNames = ReadVarint(Reader);
+	if (NumNames > static_cast<uint32>(Payload.Num())) return false;
+
+	TArray<ANSICHAR, TInlineAllocator<NAME_SIZE>> Chars;
+	for (uint32 Name = 0; Name < NumNames; ++Name)
+	{
+		const uint32 Length = ReadVarint(Reader);
+		if (Reader.IsError() || Length >= NAME_SIZE) return false;
+
+		Chars.SetNumUninitialized(Length);
+		Reader.Serialize(Chars.GetData(), Length);
+		const FUTF8ToTCHAR Converted(Chars.GetData(), Length);
+		Names.Add(FName(Converted.Length(), Converted.Get()));
+	}
+
+	const uint32 Count = ReadVarint(Reader);
+	if (Reader.IsError() || Count > static_cast<uint32>(Payload.Num())) return false;
+
+	const int32 First = OutEntries.Num();
+	OutEntries.AddDefaulted(Count);
+	TArrayView<FItemSnapshotEntry> Entries = TArrayView<FItemSnapshotEntry>(OutEntries).Slice(First, Count);
+
+	for (FItemSnapshotEntry& Entry : Entries)
+	{
+		const uint32 NameIndex = ReadVarint(Reader);
+		if (NameIndex >= static_cast<uint32>(Names.Num())) return false;
+		Entry.ItemID = Names[NameIndex];
+	}
+	for (FItemSnapshotEntry& Entry : Entries)
+	{
+		Entry.Stack = static_cast<int32>(FMath::Min(ReadVarint(Reader), static_cast<uint32>(MAX_int32)));
+	}
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		// Containers are written before their content. Checked before narrowing, a corrupted value could wrap negative.
+		const uint32 StoredParent = ReadVarint(Reader);
+		if (StoredParent > static_cast<uint32>(NextIndex + Index)) return false;
+		Entries[Index].Parent = static_cast<int32>(StoredParent) - 1;
+	}
+	for (FItemSnapshotEntry& Entry : Entries)
+	{
+		uint8 EntryFlags = 0;
+		Reader << EntryFlags;
+		Entry.AgingMode = EntryFlags & FlagLazy ? EItemAgingMode::Lazy : EItemAgingMode::Scheduled;
+		Entry.bPerishes = (EntryFlags & FlagPerishes) != 0;
+		Entry.bHasPlacement = (EntryFlags & FlagPlaced) != 0;
+		Entry.Placement.bRotated = (EntryFlags & FlagRotated) != 0;
+	}
+	for (float FItemSnapshotEntry::*Field : { &FItemSnapshotEntry::Durability, &FItemSnapshotEntry::Wear, &FItemSnapshotEntry::PerishMultiplier, &FItemSnapshotEntry::WearRate })
+	{
+		for (FItemSnapshotEntry& Entry : Entries)
+		{
+			Reader << Entry.*Field;
+		}
+	}
+	for (FItemSnapshotEntry& Entry : Entries)
+	{
+		if (Entry.bPerishes)
+		{
+			Reader << Entry.PerishRemaining;
+		}
+	}
+	for (FItemSnapshotEntry& Entry : Entries)
+	{
+		Reader << Entry.SinceEvaluated;
+	}
+	for (FItemSnapshotEntry& Entry : Entries)
+	{
+		if (Entry.bHasPlacement)
+		{
+			Reader << Entry.Placement.Pocket << Entry.Placement.CellX << Entry.Placement.CellY;
+		}
+	}
+
+	return !Reader.IsError() && Reader.AtEnd();
+}
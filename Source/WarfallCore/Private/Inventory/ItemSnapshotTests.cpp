@@ -0,0 +1,520 @@
+﻿#include "Inventory/ContainerTree.h"
+#include "Inventory/ItemCatalog.h"
+#include "Inventory/ItemInstanceStore.h"
+#include "Inventory/ItemSnapshot.h"
+#include "Inventory/ItemTestTables.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ItemSnapshotTests
+{
+	/**
+	 * Reads a whole snapshot.
+	 *
+	 * @param OutEntries Receives the entries read, reset first.
+	 * @return The result of the last ReadChunk: 0 for a snapshot ending cleanly, INDEX_NONE for a rejected one.
+	 */
+	int32 ReadAll(const TArray<uint8>& Bytes, TArray<FItemSnapshotEntry>& OutEntries)
+	{
+		OutEntries.Reset();
+		FMemoryReader Ar(Bytes);
+		FItemSnapshotReader Reader(Ar);
+		if (!Reader.ReadHeader()) return INDEX_NONE;
+
+		int32 NumRead = 0;
+		do
+		{
+			NumRead = Reader.ReadChunk(OutEntries);
+		}
+		while (NumRead > 0);
+		return NumRead;
+	}
+
+	/** @return How many times the UTF-8 bytes of a text appear in a buffer. */
+	int32 CountOccurrences(const TArray<uint8>& Bytes, const TCHAR* Text)
+	{
+		const FTCHARToUTF8 Utf8(Text);
+		int32 Count = 0;
+		for (int32 Start = 0; Start + Utf8.Length() <= Bytes.Num(); ++Start)
+		{
+			Count += FMemory::Memcmp(Bytes.GetData() + Start, Utf8.Get(), Utf8.Length()) == 0;
+		}
+		return Count;
+	}
+
+	/** @return An uncompressed snapshot of one Test_Sword root, written with raw values for its name index and parent. */
+	TArray<uint8> MakeRawSnapshot(uint32 NameIndex, uint32 Parent)
+	{
+		TArray<uint8> Payload;
+		FMemoryWriter Writer(Payload);
+		ANSICHAR Name[] = "Test_Sword";
+		uint32 NumNames = 1;
+		uint32 NameLength = UE_ARRAY_COUNT(Name) - 1;
+		uint32 Count = 1;
+		uint32 Stack = 1;
+		uint8 Flags = 0;
+		float Durability = 1.0f, Wear = 0.0f, PerishMultiplier = 1.0f, WearRate = 0.0f;
+		double SinceEvaluated = 0.0;
+		Writer.SerializeIntPacked(NumNames);
+		Writer.SerializeIntPacked(NameLength);
+		Writer.Serialize(Name, NameLength);
+		Writer.SerializeIntPacked(Count);
+		Writer.SerializeIntPacked(NameIndex);
+		Writer.SerializeIntPacked(Stack);
+		Writer.SerializeIntPacked(Parent);
+		Writer << Flags << Durability << Wear << PerishMultiplier << WearRate << SinceEvaluated;
+
+		TArray<uint8> Bytes;
+		FMemoryWriter Ar(Bytes);
+		uint32 Magic = FItemSnapshotWriter::Magic;
+		uint32 Version = FItemSnapshotWriter::Version;
+		uint32 HeaderFlags = 0;
+		uint32 PayloadSize = Payload.Num();
+		uint32 StoredSize = 0;
+		uint32 End = 0;
+		Ar << Magic << Version << HeaderFlags;
+		Ar.SerializeIntPacked(PayloadSize);
+		Ar.SerializeIntPacked(StoredSize);
+		Ar.Serialize(Payload.GetData(), Payload.Num());
+		Ar.SerializeIntPacked(End);
+		return Bytes;
+	}
+}
+
+// ===============================[ Item Snapshot Tests ]============================
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemSnapshotRoundTripTest, "Warfall.Items.Snapshot.RoundTrip", ItemTests::Flags)
+
+bool FItemSnapshotRoundTripTest::RunTest(const FString& Parameters)
+{
+	constexpr double Now = 1000.0;
+	ItemTests::FTestTables Tables;
+	Tables.AddItem(TEXT("Test_Bag"), EItemType::E_None);
+	Tables.AddItem(TEXT("Test_Bread"), EItemType::E_Consumable, 20, 5.0f, TEXT("Test_Bag"));
+	Tables.AddItem(TEXT("Test_Sword"), EItemType::E_Weapon);
+	FItemCatalog Catalog;
+	Catalog.Build(Tables.Items);
+	if (!TestEqual(TEXT("The catalog holds every row"), Catalog.Num(), 3)) return false;
+
+	// Two bags, the second nested in the first, with instances of every kind inside.
+	FItemInstanceStore Store;
+	FItemContainerTree Tree;
+	TArray<FItemHandle> Roots;
+	auto AddInstance = [&](const FName RowName, const FItemHandle Parent, const int32 Stack)
+	{
+		const FItemHandle Handle = Store.Create(Catalog.FindId(RowName), Stack, 10.0f + Store.Num());
+		Store.SetWear(Handle, 0.5f * Store.Num());
+		Store.SetPerishMultiplier(Handle, 1.5f);
+		Store.SetWearRate(Handle, 0.25f);
+		Store.SetLastEvaluated(Handle, Now - Store.Num());
+		Tree.Insert(Handle, Parent, FContainedItem());
+		Store.SetContainer(Handle, Parent);
+		return Handle;
+	};
+	const FItemHandle Bag = AddInstance(TEXT("Test_Bag"), FItemHandle(), 1);
+	const FItemHandle Inner = AddInstance(TEXT("Test_Bag"), Bag, 1);
+	const FItemHandle Bread = AddInstance(TEXT("Test_Bread"), Inner, 12);
+	Store.SetPerishDeadline(Bread, Now + 42.5);
+	const FItemHandle LazyBread = AddInstance(TEXT("Test_Bread"), Bag, 3);
+	Store.SetPerishDeadline(LazyBread, Now + 300.0);
+	Store.SetAgingMode(LazyBread, EItemAgingMode::Lazy);
+	AddInstance(TEXT("Test_Sword"), Bag, 1);
+	const FItemHandle Sword = AddInstance(TEXT("Test_Sword"), FItemHandle(), 1);
+	Roots.Add(Bag);
+	Roots.Add(Sword);
+
+	TArray<uint8> Bytes;
+	TArray<FItemHandle> Order;
+	for (const bool bCompress : { false, true })
+	{
+		Bytes.Reset();
+		Order.Reset();
+		{
+			FMemoryWriter Ar(Bytes);
+			FItemSnapshotWriter Writer(Ar, Store, Tree, Catalog, bCompress);
+			for (int32 Root = 0; Root < Roots.Num(); ++Root)
+			{
+				FItemSnapshotPlacement Placement;
+				Placement.Pocket = static_cast<uint8>(Root + 1);
+				Placement.CellX = static_cast<uint8>(Root * 2);
+				Placement.CellY = 3;
+				Placement.bRotated = Root == 0;
+				Writer.AddRoot(Roots[Root], &Placement);
+			}
+			// Chunks of two instances, so that parents are referenced across chunks.
+			while (Writer.WriteChunk(Now, 2))
+			{
+			}
+			for (int32 Index = 0; Index < Writer.Num(); ++Index)
+			{
+				Order.Add(Writer.GetHandle(Index));
+			}
+		}
+		if (!TestEqual(TEXT("Every instance is written"), Order.Num(), Store.Num())) return false;
+
+		TArray<FItemSnapshotEntry> Entries;
+		FMemoryReader Ar(Bytes);
+		FItemSnapshotReader Reader(Ar);
+		if (!TestTrue(TEXT("The header reads back"), Reader.ReadHeader())) return false;
+		int32 NumRead = 0;
+		do
+		{
+			NumRead = Reader.ReadChunk(Entries);
+		}
+		while (NumRead > 0);
+		TestEqual(TEXT("The snapshot ends cleanly"), NumRead, 0);
+		if (!TestEqual(TEXT("Every instance reads back"), Entries.Num(), Order.Num())) return false;
+
+		for (int32 Index = 0; Index < Entries.Num(); ++Index)
+		{
+			const FItemSnapshotEntry& Entry = Entries[Index];
+			const FItemHandle Handle = Order[Index];
+			const FItemHandle Parent = Tree.GetParent(Handle);
+			const bool bPerishes = Store.GetPerishDeadline(Handle) > 0.0;
+			TestEqual(TEXT("Item"), Entry.ItemID, Catalog.GetRowName(Store.GetItemId(Handle)));
+			TestEqual(TEXT("Stack"), Entry.Stack, Store.GetStack(Handle));
+			TestEqual(TEXT("Durability"), Entry.Durability, Store.GetDurability(Handle));
+			TestEqual(TEXT("Wear"), Entry.Wear, Store.GetWear(Handle));
+			TestEqual(TEXT("Perish multiplier"), Entry.PerishMultiplier, Store.GetPerishMultiplier(Handle));
+			TestEqual(TEXT("Wear rate"), Entry.WearRate, Store.GetWearRate(Handle));
+			TestTrue(TEXT("Aging mode"), Entry.AgingMode == Store.GetAgingMode(Handle));
+			TestEqual(TEXT("Perishes"), Entry.bPerishes, bPerishes);
+			TestEqual(TEXT("Perish remaining"), Entry.PerishRemaining, bPerishes ? Store.GetPerishDeadline(Handle) - Now : 0.0);
+			TestEqual(TEXT("Since evaluated"), Entry.SinceEvaluated, Now - Store.GetLastEvaluated(Handle));
+			TestTrue(TEXT("Containers come first"), Entry.Parent < Index);
+			TestTrue(TEXT("Parent"), (Entry.Parent == INDEX_NONE ? FItemHandle() : Order[Entry.Parent]) == Parent);
+			TestEqual(TEXT("Roots carry their placement"), Entry.bHasPlacement, !Parent.IsValid());
+			if (Entry.bHasPlacement)
+			{
+				const int32 Root = Roots.IndexOfByKey(Handle);
+				TestEqual(TEXT("Pocket"), static_cast<int32>(Entry.Placement.Pocket), Root + 1);
+				TestEqual(TEXT("Cell X"), static_cast<int32>(Entry.Placement.CellX), Root * 2);
+				TestEqual(TEXT("Cell Y"), static_cast<int32>(Entry.Placement.CellY), 3);
+				TestEqual(TEXT("Rotated"), Entry.Placement.bRotated, Root == 0);
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemSnapshotOverdueTest, "Warfall.Items.Snapshot.OverdueRestore", ItemTests::Flags)
+
+bool FItemSnapshotOverdueTest::RunTest(const FString& Parameters)
+{
+	constexpr double SaveTime = 1000.0;
+	ItemTests::FTestTables Tables;
+	// Bread molds after 60 s, mold rots into nothing after 120 s.
+	Tables.AddItem(TEXT("Test_Bread"), EItemType::E_Consumable, 20, 1.0f, TEXT("Test_Mold"));
+	Tables.AddItem(TEXT("Test_Mold"), EItemType::E_Consumable, 20, 2.0f);
+	FItemCatalog Catalog;
+	Catalog.Build(Tables.Items);
+	const int32 Bread = Catalog.FindId(TEXT("Test_Bread"));
+	const int32 Mold = Catalog.FindId(TEXT("Test_Mold"));
+
+	// A lazy bread 30 s overdue when saved keeps its negative remaining time through the snapshot.
+	FItemInstanceStore Store;
+	FItemContainerTree Tree;
+	const FItemHandle Handle = Store.Create(Bread, 4);
+	Store.SetAgingMode(Handle, EItemAgingMode::Lazy);
+	Store.SetPerishDeadline(Handle, SaveTime - 30.0);
+	Store.SetLastEvaluated(Handle, SaveTime - 50.0);
+	Tree.Insert(Handle, FItemHandle(), FContainedItem());
+
+	TArray<uint8> Bytes;
+	{
+		FMemoryWriter Ar(Bytes);
+		FItemSnapshotWriter Writer(Ar, Store, Tree, Catalog);
+		Writer.AddRoot(Handle);
+		while (Writer.WriteChunk(SaveTime))
+		{
+		}
+	}
+	TArray<FItemSnapshotEntry> Entries;
+	FMemoryReader Ar(Bytes);
+	FItemSnapshotReader Reader(Ar);
+	if (!TestTrue(TEXT("The header reads back"), Reader.ReadHeader())) return false;
+	while (Reader.ReadChunk(Entries) > 0)
+	{
+	}
+	if (!TestEqual(TEXT("The bread reads back"), Entries.Num(), 1)) return false;
+	const FItemSnapshotEntry& Entry = Entries[0];
+	TestTrue(TEXT("The bread perishes"), Entry.bPerishes);
+	TestEqual(TEXT("The overdue time is kept"), Entry.PerishRemaining, -30.0);
+
+	// Restored at the start of a world, earlier than the overdue time: the bread already molded 30 s ago.
+	FItemAgingState State;
+	State.ItemId = Catalog.FindId(Entry.ItemID);
+	State.Durability = Entry.Durability;
+	State.Wear = Entry.Wear;
+	TestEqual(TEXT("One transformation"), HlpItem::AgeOverdue(Catalog, State, Entry.PerishRemaining, Entry.SinceEvaluated, 0.0, Entry.PerishMultiplier, Entry.WearRate), 1);
+	TestEqual(TEXT("The bread molded"), State.ItemId, Mold);
+	TestEqual(TEXT("The mold lifetime counts from the bread deadline"), State.PerishDeadline, 90.0);
+
+	// Restored later, the same deadline leads to the same remaining time.
+	State.ItemId = Bread;
+	HlpItem::AgeOverdue(Catalog, State, Entry.PerishRemaining, Entry.SinceEvaluated, 5000.0, Entry.PerishMultiplier, Entry.WearRate);
+	TestEqual(TEXT("The same remaining time whatever the restore time"), State.PerishDeadline, 5090.0);
+
+	// Overdue beyond the whole chain: nothing is left.
+	State.ItemId = Bread;
+	TestEqual(TEXT("Two transformations"), HlpItem::AgeOverdue(Catalog, State, -200.0, 0.0, 0.0, 1.0f, 0.0f), 2);
+	TestEqual(TEXT("The mold rotted away"), State.ItemId, static_cast<int32>(INDEX_NONE));
+	TestEqual(TEXT("Nothing perishes any more"), State.PerishDeadline, 0.0);
+
+	// A faster pocket shortens the lifetimes that follow.
+	State.ItemId = Bread;
+	HlpItem::AgeOverdue(Catalog, State, -30.0, 0.0, 0.0, 2.0f, 0.0f);
+	TestEqual(TEXT("The mold lifetime follows the multiplier"), State.PerishDeadline, 30.0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemSnapshotDictionaryTest, "Warfall.Items.Snapshot.Dictionary", ItemTests::Flags)
+
+bool FItemSnapshotDictionaryTest::RunTest(const FString& Parameters)
+{
+	ItemTests::FTestTables Tables;
+	Tables.AddItem(TEXT("Test_Bag"), EItemType::E_None);
+	Tables.AddItem(TEXT("Test_Arrow"), EItemType::E_Ingredient, 99);
+	Tables.AddItem(TEXT("Test_Sword"), EItemType::E_Weapon);
+	FItemCatalog Catalog;
+	Catalog.Build(Tables.Items);
+
+	for (const bool bCompress : { false, true })
+	{
+		// Arrows in every chunk, swords from the second chunk on.
+		FItemInstanceStore Store;
+		FItemContainerTree Tree;
+		const FItemHandle Bag = Store.Create(Catalog.FindId(TEXT("Test_Bag")));
+		Tree.Insert(Bag, FItemHandle(), FContainedItem());
+		TArray<FName> Expected;
+		Expected.Add(TEXT("Test_Bag"));
+		for (int32 Index = 0; Index < 20; ++Index)
+		{
+			const FName RowName = Index >= 5 && Index % 2 ? FName(TEXT("Test_Sword")) : FName(TEXT("Test_Arrow"));
+			const FItemHandle Handle = Store.Create(Catalog.FindId(RowName));
+			Tree.Insert(Handle, Bag, FContainedItem());
+			Store.SetContainer(Handle, Bag);
+			Expected.Add(RowName);
+		}
+
+		TArray<uint8> Bytes;
+		const int32 Destroyed = Expected.Num() - 1;
+		{
+			FMemoryWriter Ar(Bytes);
+			FItemSnapshotWriter Writer(Ar, Store, Tree, Catalog, bCompress);
+			Writer.AddRoot(Bag);
+			if (!TestEqual(TEXT("Every instance is queued"), Writer.Num(), Expected.Num())) return false;
+
+			// The last instance is destroyed between two chunks: it keeps its index, without a name.
+			const FItemHandle DestroyedHandle = Writer.GetHandle(Destroyed);
+			while (Writer.WriteChunk(0.0, 4))
+			{
+				if (Writer.NumWritten() > 8)
+				{
+					Store.Destroy(DestroyedHandle);
+				}
+			}
+		}
+
+		if (!bCompress)
+		{
+			// Every name is written once, by the first chunk using it.
+			for (const TCHAR* RowName : { TEXT("Test_Bag"), TEXT("Test_Arrow"), TEXT("Test_Sword") })
+			{
+				TestEqual(FString::Printf(TEXT("%s is written once"), RowName), ItemSnapshotTests::CountOccurrences(Bytes, RowName), 1);
+			}
+		}
+
+		TArray<FItemSnapshotEntry> Entries;
+		TestEqual(TEXT("The snapshot ends cleanly"), ItemSnapshotTests::ReadAll(Bytes, Entries), 0);
+		if (!TestEqual(TEXT("Every instance reads back"), Entries.Num(), Expected.Num())) return false;
+		for (int32 Index = 0; Index < Destroyed; ++Index)
+		{
+			TestEqual(TEXT("Names resolve across chunks"), Entries[Index].ItemID, Expected[Index]);
+			TestEqual(TEXT("Parent"), Entries[Index].Parent, Index == 0 ? static_cast<int32>(INDEX_NONE) : 0);
+		}
+		TestEqual(TEXT("The destroyed instance has no name"), Entries[Destroyed].ItemID, FName(NAME_None));
+		TestEqual(TEXT("The destroyed instance keeps its parent"), Entries[Destroyed].Parent, 0);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemSnapshotVarintTest, "Warfall.Items.Snapshot.VarintEdges", ItemTests::Flags)
+
+bool FItemSnapshotVarintTest::RunTest(const FString& Parameters)
+{
+	ItemTests::FTestTables Tables;
+	Tables.AddItem(TEXT("Test_Bag"), EItemType::E_None);
+	Tables.AddItem(TEXT("Test_Arrow"), EItemType::E_Ingredient, 99);
+	FItemCatalog Catalog;
+	Catalog.Build(Tables.Items);
+	const int32 Bag = Catalog.FindId(TEXT("Test_Bag"));
+	const int32 Arrow = Catalog.FindId(TEXT("Test_Arrow"));
+
+	// Stacks around every byte boundary of the packed encoding, and negative stacks written as 0.
+	const int32 Stacks[] = { 0, 1, 127, 128, 16383, 16384, 2097151, 2097152, 268435455, 268435456, MAX_int32, -5 };
+	FItemInstanceStore Store;
+	FItemContainerTree Tree;
+	TArray<FItemHandle> Roots;
+	for (const int32 Stack : Stacks)
+	{
+		Roots.Add(Store.Create(Arrow, Stack));
+		Tree.Insert(Roots.Last(), FItemHandle(), FContainedItem());
+	}
+	// Enough roots that the counts and parent indices need two bytes, then a bag holding content.
+	while (Roots.Num() < 300)
+	{
+		Roots.Add(Store.Create(Arrow, Roots.Num()));
+		Tree.Insert(Roots.Last(), FItemHandle(), FContainedItem());
+	}
+	const FItemHandle Container = Store.Create(Bag);
+	Tree.Insert(Container, FItemHandle(), FContainedItem());
+	Roots.Add(Container);
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		const FItemHandle Content = Store.Create(Arrow, Index + 1);
+		Tree.Insert(Content, Container, FContainedItem());
+		Store.SetContainer(Content, Container);
+	}
+
+	for (const bool bCompress : { false, true })
+	{
+		TArray<uint8> Bytes;
+		{
+			FMemoryWriter Ar(Bytes);
+			FItemSnapshotWriter Writer(Ar, Store, Tree, Catalog, bCompress);
+			for (const FItemHandle Root : Roots)
+			{
+				Writer.AddRoot(Root);
+			}
+			while (Writer.WriteChunk(0.0, 200))
+			{
+			}
+		}
+
+		TArray<FItemSnapshotEntry> Entries;
+		TestEqual(TEXT("The snapshot ends cleanly"), ItemSnapshotTests::ReadAll(Bytes, Entries), 0);
+		if (!TestEqual(TEXT("Every instance reads back"), Entries.Num(), Roots.Num() + 3)) return false;
+		for (int32 Index = 0; Index < UE_ARRAY_COUNT(Stacks); ++Index)
+		{
+			TestEqual(FString::Printf(TEXT("Stack of %d"), Stacks[Index]), Entries[Index].Stack, FMath::Max(Stacks[Index], 0));
+		}
+		for (int32 Index = UE_ARRAY_COUNT(Stacks); Index < Roots.Num() - 1; ++Index)
+		{
+			if (!TestEqual(TEXT("Stacks past the first chunk"), Entries[Index].Stack, Index)) return false;
+		}
+		const int32 ContainerIndex = Roots.Num() - 1;
+		for (int32 Index = ContainerIndex + 1; Index < Entries.Num(); ++Index)
+		{
+			TestEqual(TEXT("Parents beyond one byte"), Entries[Index].Parent, ContainerIndex);
+			TestEqual(TEXT("Content stack"), Entries[Index].Stack, Index - ContainerIndex);
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemSnapshotCorruptTest, "Warfall.Items.Snapshot.Corrupt", ItemTests::Flags)
+
+bool FItemSnapshotCorruptTest::RunTest(const FString& Parameters)
+{
+	// Every rejected snapshot logs why.
+	AddExpectedError(TEXT("ItemSnapshot:"), EAutomationExpectedErrorFlags::Contains, 0);
+	TArray<FItemSnapshotEntry> Entries;
+
+	// Hand-written chunks, with the raw values of the name index and parent of their one instance.
+	TestEqual(TEXT("A well-formed chunk reads"), ItemSnapshotTests::ReadAll(ItemSnapshotTests::MakeRawSnapshot(1, 0), Entries), 0);
+	TestEqual(TEXT("Its instance reads back"), Entries.Num(), 1);
+	TestEqual(TEXT("A name index beyond the dictionary is rejected"), ItemSnapshotTests::ReadAll(ItemSnapshotTests::MakeRawSnapshot(2, 0), Entries), static_cast<int32>(INDEX_NONE));
+	for (const uint32 Parent : { 1u, 2u, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu })
+	{
+		TestEqual(FString::Printf(TEXT("Parent %u is rejected"), Parent), ItemSnapshotTests::ReadAll(ItemSnapshotTests::MakeRawSnapshot(1, Parent), Entries), static_cast<int32>(INDEX_NONE));
+		TestEqual(TEXT("A rejected chunk appends nothing"), Entries.Num(), 0);
+	}
+
+	// A real snapshot of nested bags, then damaged.
+	ItemTests::FTestTables Tables;
+	Tables.AddItem(TEXT("Test_Bag"), EItemType::E_None);
+	Tables.AddItem(TEXT("Test_Bread"), EItemType::E_Consumable, 20, 5.0f);
+	FItemCatalog Catalog;
+	Catalog.Build(Tables.Items);
+	FItemInstanceStore Store;
+	FItemContainerTree Tree;
+	FItemHandle Outermost;
+	FItemHandle Parent;
+	for (int32 Depth = 0; Depth < 6; ++Depth)
+	{
+		const FItemHandle Bag = Store.Create(Catalog.FindId(TEXT("Test_Bag")));
+		Tree.Insert(Bag, Parent, FContainedItem());
+		Store.SetContainer(Bag, Parent);
+		Outermost = Depth == 0 ? Bag : Outermost;
+		const FItemHandle Bread = Store.Create(Catalog.FindId(TEXT("Test_Bread")), Depth + 1);
+		Store.SetPerishDeadline(Bread, 100.0 + Depth);
+		Tree.Insert(Bread, Bag, FContainedItem());
+		Store.SetContainer(Bread, Bag);
+		Parent = Bag;
+	}
+
+	int32 UncompressedSize = 0;
+	for (const bool bCompress : { false, true })
+	{
+		TArray<uint8> Bytes;
+		{
+			FMemoryWriter Ar(Bytes);
+			FItemSnapshotWriter Writer(Ar, Store, Tree, Catalog, bCompress);
+			Writer.AddRoot(Outermost);
+			while (Writer.WriteChunk(0.0, 3))
+			{
+			}
+		}
+		if (!TestEqual(TEXT("The intact snapshot ends cleanly"), ItemSnapshotTests::ReadAll(Bytes, Entries), 0)) return false;
+		const int32 NumEntries = Entries.Num();
+		UncompressedSize = bCompress ? UncompressedSize : Bytes.Num();
+
+		// Cut anywhere before its end marker, the snapshot is rejected instead of ending early.
+		for (int32 Length = 0; Length < Bytes.Num(); ++Length)
+		{
+			const TArray<uint8> Truncated(Bytes.GetData(), Length);
+			if (!TestEqual(FString::Printf(TEXT("Truncated to %d bytes"), Length), ItemSnapshotTests::ReadAll(Truncated, Entries), static_cast<int32>(INDEX_NONE))) return false;
+			if (!TestTrue(TEXT("A truncated snapshot never reads more"), Entries.Num() < NumEntries)) return false;
+		}
+
+		TArray<uint8> Damaged = Bytes;
+		Damaged[0] ^= 0xFF;
+		TestEqual(TEXT("A wrong magic is rejected"), ItemSnapshotTests::ReadAll(Damaged, Entries), static_cast<int32>(INDEX_NONE));
+		Damaged = Bytes;
+		Damaged[4] = static_cast<uint8>(FItemSnapshotWriter::Version + 1);
+		TestEqual(TEXT("A later version is rejected"), ItemSnapshotTests::ReadAll(Damaged, Entries), static_cast<int32>(INDEX_NONE));
+		Damaged = Bytes;
+		Damaged[8] ^= FItemSnapshotWriter::FlagCompressed;
+		// Only when a chunk was stored compressed, which a smaller snapshot tells.
+		if (bCompress && Bytes.Num() < UncompressedSize)
+		{
+			TestEqual(TEXT("Compressed chunks of an uncompressed snapshot are rejected"), ItemSnapshotTests::ReadAll(Damaged, Entries), static_cast<int32>(INDEX_NONE));
+		}
+
+		// Random bytes flipped: the reader may accept the damage, but never returns an entry it could not have written.
+		// Damaged compressed chunks are left to the checks of zlib.
+		if (bCompress) continue;
+
+		FRandomStream Random(19);
+		for (int32 Trial = 0; Trial < 500; ++Trial)
+		{
+			Damaged = Bytes;
+			for (int32 Flip = Random.RandRange(1, 3); Flip > 0; --Flip)
+			{
+				Damaged[Random.RandRange(12, Bytes.Num() - 1)] ^= static_cast<uint8>(Random.RandRange(1, 255));
+			}
+			ItemSnapshotTests::ReadAll(Damaged, Entries);
+			for (int32 Index = 0; Index < Entries.Num(); ++Index)
+			{
+				if (!TestTrue(TEXT("Parents always come first"), Entries[Index].Parent >= INDEX_NONE && Entries[Index].Parent < Index)) return false;
+				if (!TestTrue(TEXT("Stacks are never negative"), Entries[Index].Stack >= 0)) return false;
+			}
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,107 @@
+﻿#include "Inventory/ItemStatColumns.h"
+
+#include "Inventory/ItemCatalog.h"
+
+void FItemStatColumns::Build(const FItemCatalog& Catalog)
+{
+	Allocate(Catalog.Num());
+	for (int32 Id = 0; Id < NumItems; ++Id)
+	{
+		SetRow(Id, Catalog.GetRow(Id));
+	}
+}
+
+void FItemStatColumns::Reset()
+{
+	FloatColumns.Reset();
+	MaxStackSizes.Reset();
+	FloatData = nullptr;
+	StackData = nullptr;
+	NumItems = 0;
+	Stride = 0;
+}
+
+void FItemStatColumns::BindExternal(const float* InFloats, const int32* InStackSizes, const int32 InNumItems, const int32 InStride)
+{
+	Reset();
+	FloatData = InFloats;
+	StackData = InStackSizes;
+	NumItems = InNumItems;
+	Stride = InStride;
+}
+
+void FItemStatColumns::SetRow(const int32 Id, const FItemRow& Row)
+{
+	check(Id >= 0 && Id < NumItems);
+	check(!IsExternal());
+
+	auto Write = [this, Id](const EItemStat Stat, const float Value)
+	{
+		FloatColumns[static_cast<int32>(Stat) * Stride + Id] = Value;
+	};
+
+	Write(EItemStat::WeaponDamage, Row.WeaponDamage);
+	Write(EItemStat::ArmorPenetration, Row.ArmorPenetration);
+	Write(EItemStat::FleshDamage, Row.FleshDamage);
+	Write(EItemStat::ArmorValue, Row.ArmorValue);
+	Write(EItemStat::PerishRate, Row.PerishRate);
+	Write(EItemStat::MaxDurability, Row.MaxDurability);
+	Write(EItemStat::MaxWear, Row.GetMaxWear());
+	Write(EItemStat::Mass, Row.WeightConfig.GetMass());
+
+	MaxStackSizes[Id] = Row.MaxStackSize;
+}
+
+void FItemStatColumns::ClearRow(const int32 Id)
+{
+	check(Id >= 0 && Id < NumItems);
+	check(!IsExternal());
+
+	for (int32 Stat = 0; Stat < static_cast<int32>(EItemStat::Num); ++Stat)
+	{
+		FloatColumns[Stat * Stride + Id] = 0.0f;
+	}
+	MaxStackSizes[Id] = 0;
+}
+
+void FItemStatColumns::AddRow(const FItemRow& Row)
+{
+	check(!IsExternal());
+
+	if (NumItems == 0 && Stride == 0)
+	{
+		Allocate(0);
+	}
+	if (NumItems == Stride)
+	{
+		Relayout(Align(Stride * 2, ColumnAlignment));
+	}
+	const int32 Id = NumItems++;
+	SetRow(Id, Row);
+}
+
+void FItemStatColumns::Allocate(const int32 InNumItems)
+{
+	NumItems = InNumItems;
+	Stride = Align(FMath::Max(InNumItems, 1), ColumnAlignment);
+	FloatColumns.SetNumZeroed(Stride * static_cast<int32>(EItemStat::Num));
+	MaxStackSizes.SetNumZeroed(Stride);
+	FloatData = FloatColumns.GetData();
+	StackData = MaxStackSizes.GetData();
+}
+
+void FItemStatColumns::Relayout(const int32 NewStride)
+{
+	TArray<float, TAlignedHeapAllocator<64>> NewColumns;
+	NewColumns.SetNumZeroed(NewStride * static_cast<int32>(EItemStat::Num));
+	for (int32 Stat = 0; Stat < static_cast<int32>(EItemStat::Num); ++Stat)
+	{
+		FMemory::Memcpy(NewColumns.GetData() + Stat * NewStride, FloatColumns.GetData() + Stat * Stride, NumItems * sizeof(float));
+	}
+
+	FloatColumns = MoveTemp(NewColumns);
+	MaxStackSizes.SetNumZeroed(NewStride);
+	Stride = NewStride;
+	FloatData = FloatColumns.GetData();
+	StackData = MaxStackSizes.GetData();
+}
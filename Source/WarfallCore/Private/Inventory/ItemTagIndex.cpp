@@ -0,0 +1,278 @@
+﻿#include "Inventory/ItemTagIndex.h"
+
+#include "Inventory/ItemCatalog.h"
+
+void FItemTagIndex::Build(const FItemCatalog& Catalog)
+{
+	Reset();
+	NumItemBits = Catalog.Num();
+	WordsPerTag = FDenseBitSet::NumWordsFor(NumItemBits);
+
+	// Gather first: the number of distinct tags sizes the posting storage.
+	TArray<TArray<FGameplayTag>> ItemTags;
+	TArray<int32> NumNameTags;
+	TArray<int32> RowSlots;
+	ItemTags.SetNum(NumItemBits);
+	NumNameTags.SetNum(NumItemBits);
+	for (int32 Id = 0; Id < NumItemBits; ++Id)
+	{
+		NumNameTags[Id] = GatherIndexedTags(Catalog.GetRow(Id), ItemTags[Id]);
+		RowSlots.Reset();
+		for (const FGameplayTag& Tag : ItemTags[Id])
+		{
+			RowSlots.Add(FindOrAddSlot(Tag));
+		}
+		ItemSlots.Add(RowSlots);
+	}
+
+	Words.SetNumZeroed(Tags.Num() * WordsPerTag);
+	for (int32 Id = 0; Id < NumItemBits; ++Id)
+	{
+		for (int32 Index = NumNameTags[Id]; Index < ItemTags[Id].Num(); ++Index)
+		{
+			FindOrAddNamePosting(TagSlots[ItemTags[Id][Index]]);
+		}
+	}
+
+	for (int32 Id = 0; Id < NumItemBits; ++Id)
+	{
+		const int32 Word = Id >> 6;
+		const uint64 Bit = 1ull << (Id & 63);
+		for (int32 Index = 0; Index < ItemTags[Id].Num(); ++Index)
+		{
+			const int32 Slot = TagSlots[ItemTags[Id][Index]];
+			Words[Slot * WordsPerTag + Word] |= Bit;
+			if (Index < NumNameTags[Id] && NameSlots[Slot] != INDEX_NONE)
+			{
+				NameWords[NameSlots[Slot] * WordsPerTag + Word] |= Bit;
+			}
+		}
+	}
+	WordsData = Words.GetData();
+	NameWordsData = NameWords.GetData();
+}
+
+void FItemTagIndex::BindExternal(TArray<FGameplayTag> InTags, const uint64* InWords, TArray<int32> InNameSlots, const uint64* InNameWords, const int32 InNumItems)
+{
+	check(InNameSlots.Num() == InTags.Num());
+
+	Reset();
+	NumItemBits = InNumItems;
+	WordsPerTag = FDenseBitSet::NumWordsFor(InNumItems);
+	WordsData = InWords;
+	NameWordsData = InNameWords;
+	Tags = MoveTemp(InTags);
+	NameSlots = MoveTemp(InNameSlots);
+	for (int32 Slot = 0; Slot < Tags.Num(); ++Slot)
+	{
+		if (Tags[Slot].IsValid())
+		{
+			TagSlots.Add(Tags[Slot], Slot);
+		}
+		if (NameSlots[Slot] != INDEX_NONE)
+		{
+			++NumNamePostings;
+		}
+	}
+}
+
+void FItemTagIndex::SetRow(const int32 Id, const FItemRow* Row)
+{
+	check(Id >= 0 && Id < NumItemBits);
+	check(WordsData == Words.GetData());
+
+	const int32 Word = Id >> 6;
+	const uint64 Bit = 1ull << (Id & 63);
+	for (const int32 Slot : ItemSlots.Get(Id))
+	{
+		Words[Slot * WordsPerTag + Word] &= ~Bit;
+		if (NameSlots[Slot] != INDEX_NONE)
+		{
+			NameWords[NameSlots[Slot] * WordsPerTag + Word] &= ~Bit;
+		}
+	}
+
+	if (Removed.Num() < NumItemBits)
+	{
+		Removed.SetNum(NumItemBits);
+	}
+	Removed.SetTo(Id, Row == nullptr);
+
+	TArray<FGameplayTag> ItemTags;
+	TArray<int32> RowSlots;
+	const int32 NumNameTags = Row ? GatherIndexedTags(*Row, ItemTags) : 0;
+	for (int32 Index = 0; Index < ItemTags.Num(); ++Index)
+	{
+		const int32 Slot = FindOrAddSlot(ItemTags[Index]);
+		RowSlots.Add(Slot);
+		if (Words.Num() < Tags.Num() * WordsPerTag)
+		{
+			Words.AddZeroed(WordsPerTag);
+			WordsData = Words.GetData();
+		}
+
+		// The bit of the item is cleared from its previous postings: a name posting copied now only holds Tags.
+		if (Index >= NumNameTags)
+		{
+			FindOrAddNamePosting(Slot);
+		}
+		else if (NameSlots[Slot] != INDEX_NONE)
+		{
+			NameWords[NameSlots[Slot] * WordsPerTag + Word] |= Bit;
+		}
+		Words[Slot * WordsPerTag + Word] |= Bit;
+	}
+	ItemSlots.Set(Id, RowSlots);
+}
+
+void FItemTagIndex::AddRow(const FItemRow& Row)
+{
+	check(WordsData == Words.GetData());
+
+	const int32 NewWordsPerTag = FDenseBitSet::NumWordsFor(NumItemBits + 1);
+	if (NewWordsPerTag != WordsPerTag)
+	{
+		Relayout(NewWordsPerTag);
+	}
+	const int32 Id = NumItemBits++;
+	ItemSlots.Add(TConstArrayView<int32>());
+	SetRow(Id, &Row);
+}
+
+void FItemTagIndex::Relayout(const int32 NewWordsPerTag)
+{
+	TArray<uint64> NewWords;
+	NewWords.SetNumZeroed(Tags.Num() * NewWordsPerTag);
+	const int32 KeptWords = FMath::Min(WordsPerTag, NewWordsPerTag);
+	for (int32 Slot = 0; Slot < Tags.Num(); ++Slot)
+	{
+		FMemory::Memcpy(NewWords.GetData() + Slot * NewWordsPerTag, Words.GetData() + Slot * WordsPerTag, KeptWords * sizeof(uint64));
+	}
+
+	TArray<uint64> NewNameWords;
+	NewNameWords.SetNumZeroed(NumNamePostings * NewWordsPerTag);
+	for (int32 Posting = 0; Posting < NumNamePostings; ++Posting)
+	{
+		FMemory::Memcpy(NewNameWords.GetData() + Posting * NewWordsPerTag, NameWords.GetData() + Posting * WordsPerTag, KeptWords * sizeof(uint64));
+	}
+
+	Words = MoveTemp(NewWords);
+	WordsData = Words.GetData();
+	NameWords = MoveTemp(NewNameWords);
+	NameWordsData = NameWords.GetData();
+	WordsPerTag = NewWordsPerTag;
+}
+
+void FItemTagIndex::Reset()
+{
+	Words.Reset();
+	WordsData = nullptr;
+	NameSlots.Reset();
+	NameWords.Reset();
+	NameWordsData = nullptr;
+	NumNamePostings = 0;
+	Tags.Reset();
+	TagSlots.Reset();
+	ItemSlots.Reset();
+	Removed.Init(0, false);
+	NumItemBits = 0;
+	WordsPerTag = 0;
+}
+
+int32 FItemTagIndex::GatherIndexedTags(const FItemRow& Row, TArray<FGameplayTag>& OutTags)
+{
+	OutTags.Reset();
+	auto AddWithParents = [&OutTags](const FGameplayTag& Tag)
+	{
+		if (!Tag.IsValid()) return;
+		for (const FGameplayTag& Parent : Tag.GetGameplayTagParents())
+		{
+			OutTags.AddUnique(Parent);
+		}
+	};
+
+	for (const FGameplayTag& Tag : Row.Tags)
+	{
+		AddWithParents(Tag);
+	}
+	const int32 NumNameTags = OutTags.Num();
+	AddWithParents(Row.IngredientsType);
+	return NumNameTags;
+}
+
+TConstArrayView<uint64> FItemTagIndex::GetPostings(const FGameplayTag& Tag) const
+{
+	const int32* Slot = TagSlots.Find(Tag);
+	if (!Slot) return TConstArrayView<uint64>();
+	return TConstArrayView<uint64>(WordsData + *Slot * WordsPerTag, WordsPerTag);
+}
+
+bool FItemTagIndex::HasTag(const FGameplayTag& Tag, const int32 ItemId) const
+{
+	const TConstArrayView<uint64> Postings = GetPostings(Tag);
+	if (Postings.IsEmpty() || ItemId < 0 || ItemId >= NumItemBits) return false;
+	return (Postings[ItemId >> 6] >> (ItemId & 63)) & 1ull;
+}
+
+void FItemTagIndex::QueryAll(const FGameplayTagContainer& AllOf, FDenseBitSet& OutItems) const
+{
+	OutItems.Init(NumItemBits, true);
+	OutItems.AndNot(Removed);
+	for (const FGameplayTag& Tag : AllOf)
+	{
+		// An unknown tag yields an empty view, which clears the result.
+		OutItems.And(GetPostings(Tag));
+		if (OutItems.IsEmpty()) return;
+	}
+}
+
+void FItemTagIndex::QueryAny(const FGameplayTagContainer& AnyOf, FDenseBitSet& OutItems) const
+{
+	OutItems.Init(NumItemBits, false);
+	for (const FGameplayTag& Tag : AnyOf)
+	{
+		OutItems.Or(GetPostings(Tag));
+	}
+}
+
+void FItemTagIndex::QueryNameContains(const FString& Fragment, FDenseBitSet& OutItems) const
+{
+	OutItems.Init(NumItemBits, false);
+	for (int32 Slot = 0; Slot < Tags.Num(); ++Slot)
+	{
+		if (Tags[Slot].IsValid() && Tags[Slot].GetTagName().ToString().Contains(Fragment))
+		{
+			OutItems.Or(TConstArrayView<uint64>(GetNameWords(Slot), WordsPerTag));
+		}
+	}
+}
+
+int32 FItemTagIndex::FindOrAddSlot(const FGameplayTag& Tag)
+{
+	if (const int32* Slot = TagSlots.Find(Tag))
+	{
+		return *Slot;
+	}
+	const int32 Slot = Tags.Add(Tag);
+	TagSlots.Add(Tag, Slot);
+	NameSlots.Add(INDEX_NONE);
+	return Slot;
+}
+
+int32 FItemTagIndex::FindOrAddNamePosting(const int32 Slot)
+{
+	if (NameSlots[Slot] != INDEX_NONE)
+	{
+		return NameSlots[Slot];
+	}
+	const int32 Posting = NumNamePostings++;
+	NameWords.Append(Words.GetData() + Slot * WordsPerTag, WordsPerTag);
+	NameWordsData = NameWords.GetData();
+	NameSlots[Slot] = Posting;
+	return Posting;
+}
+
+const uint64* FItemTagIndex::GetNameWords(const int32 Slot) const
+{
+	return NameSlots[Slot] == INDEX_NONE ? WordsData + Slot * WordsPerTag : NameWordsData + NameSlots[Slot] * WordsPerTag;
+}
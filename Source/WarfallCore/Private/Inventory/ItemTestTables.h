@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Crafting/CraftingTypes.h"
+#include "Engine/DataTable.h"
+#include "Inventory/ItemRowTypes.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// ===============================[ Item Test Tables ]============================
+
+namespace ItemTests
+{
+	constexpr EAutomationTestFlags Flags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter;
+
+	/** Rooted transient items and recipes tables, filled row by row by the tests. */
+	struct FTestTables
+	{
+		UDataTable* Items = nullptr;
+		UDataTable* Recipes = nullptr;
+
+		FTestTables()
+		{
+			Items = NewObject<UDataTable>(GetTransientPackage());
+			Items->RowStruct = FItemRowDetail::StaticStruct();
+			Items->AddToRoot();
+			Recipes = NewObject<UDataTable>(GetTransientPackage());
+			Recipes->RowStruct = FRecipeRowDetail::StaticStruct();
+			Recipes->AddToRoot();
+		}
+
+		~FTestTables()
+		{
+			Items->RemoveFromRoot();
+			Items->MarkAsGarbage();
+			Recipes->RemoveFromRoot();
+			Recipes->MarkAsGarbage();
+		}
+
+		/**
+		 * @param PerishRate Lifetime in minutes, 0 for items that do not perish.
+		 * @param PerishTo Row the item turns into when it perishes.
+		 */
+		void AddItem(const FName RowName, const EItemType Type, const int32 MaxStackSize = 1, const float PerishRate = 0.0f, const FName PerishTo = NAME_None)
+		{
+			FItemRowDetail Row;
+			Row.Details.Type = Type;
+			Row.Details.MaxStackSize = MaxStackSize;
+			Row.Details.PerishRate = PerishRate;
+			Row.Details.PerishTo.ID = PerishTo;
+			Items->AddRow(RowName, Row);
+		}
+
+		/** @return The row of an added item, to set what AddItem leaves to its default. */
+		FItemRow& GetItem(const FName RowName)
+		{
+			return Items->FindRow<FItemRowDetail>(RowName, TEXT("ItemTests"))->Details;
+		}
+
+		/** Adds a recipe crafting one of Result from one of each ingredient. Ids follow the order of the calls. */
+		void AddRecipe(const FName RowName, TConstArrayView<FName> Ingredients, const FName Result)
+		{
+			FRecipeRowDetail Row;
+			for (const FName Ingredient : Ingredients)
+			{
+				Row.Details.Ingredients.AddDefaulted_GetRef().Ingredient.ID = Ingredient;
+			}
+			Row.Details.Results.AddDefaulted_GetRef().Result.ID = Result;
+			Recipes->AddRow(RowName, Row);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,162 @@
+﻿#include "Inventory/PerishScheduler.h"
+
+namespace PerishScheduler
+{
+	constexpr uint64 SlotMask = FPerishScheduler::NumSlots - 1;
+	/** Number of ticks covered by the whole wheel. */
+	constexpr uint64 WheelSpan = 1ull << (FPerishScheduler::SlotBits * FPerishScheduler::NumLevels);
+	/** Nodes grow by this many instance slots, the slab size of FItemInstanceStore. */
+	constexpr int32 NodeGrowth = 4096;
+	/** Far enough for any game, low enough to convert to uint64 ticks. */
+	constexpr double MaxDeadlineTicks = 1.0e15;
+}
+
+// ===============================[ Perish Scheduler ]============================
+
+FPerishScheduler::FPerishScheduler(const double InTickSeconds) :
+ TickSeconds(FMath::Max(InTickSeconds, 0.001))
+{
+	Reset(0.0);
+}
+
+void FPerishScheduler::Reset(const double Now)
+{
+	Nodes.Reset();
+	for (int32& Head : Heads)
+	{
+		Head = INDEX_NONE;
+	}
+	CurrentTick = static_cast<uint64>(FMath::Max(Now, 0.0) / TickSeconds);
+	NumScheduled = 0;
+}
+
+void FPerishScheduler::Schedule(const FItemHandle Handle, const double Deadline)
+{
+	using namespace PerishScheduler;
+
+	if (!Handle.IsValid()) return;
+
+	const int32 Index = static_cast<int32>(Handle.GetIndex());
+	if (!Nodes.IsValidIndex(Index))
+	{
+		Nodes.SetNum(Align(Index + 1, NodeGrowth));
+	}
+	if (Nodes[Index].Bucket != INDEX_NONE)
+	{
+		Unlink(Index);
+	}
+
+	// Rounded up so that no instance perishes before its deadline; the current tick has already fired.
+	FNode& Node = Nodes[Index];
+	const double Ticks = FMath::Min(FMath::CeilToDouble(FMath::Max(Deadline, 0.0) / TickSeconds), MaxDeadlineTicks);
+	Node.Handle = Handle.GetValue();
+	Node.DeadlineTick = FMath::Max(static_cast<uint64>(Ticks), CurrentTick + 1);
+	Insert(Index);
+	++NumScheduled;
+}
+
+void FPerishScheduler::Unschedule(const FItemHandle Handle)
+{
+	if (IsScheduled(Handle))
+	{
+		Unlink(static_cast<int32>(Handle.GetIndex()));
+	}
+}
+
+int32 FPerishScheduler::Advance(const double Now, TArray<FItemHandle>& OutExpired)
+{
+	using namespace PerishScheduler;
+
+	const int32 NumBefore = OutExpired.Num();
+	const uint64 TargetTick = static_cast<uint64>(FMath::Max(Now, 0.0) / TickSeconds);
+	while (CurrentTick < TargetTick)
+	{
+		if (NumScheduled == 0)
+		{
+			CurrentTick = TargetTick;
+			break;
+		}
+
+		++CurrentTick;
+		// Upper levels first: their nodes may land in the lower slots cascaded right after.
+		for (int32 Level = NumLevels - 1; Level > 0; --Level)
+		{
+			if ((CurrentTick & ((1ull << (SlotBits * Level)) - 1)) == 0)
+			{
+				Cascade(Level);
+			}
+		}
+
+		int32& Head = Heads[CurrentTick & SlotMask];
+		while (Head != INDEX_NONE)
+		{
+			const int32 Index = Head;
+			OutExpired.Add(FItemHandle::FromValue(Nodes[Index].Handle));
+			Unlink(Index);
+		}
+	}
+	return OutExpired.Num() - NumBefore;
+}
+
+void FPerishScheduler::Insert(const int32 Index)
+{
+	using namespace PerishScheduler;
+
+	FNode& Node = Nodes[Index];
+	const uint64 Tick = FMath::Max(Node.DeadlineTick, CurrentTick);
+	const uint64 Delta = Tick - CurrentTick;
+
+	int32 Level = 0;
+	while (Level < NumLevels - 1 && Delta >= 1ull << (SlotBits * (Level + 1)))
+	{
+		++Level;
+	}
+
+	// Beyond the wheel: the top slot cascading last, placed again from there.
+	const uint64 Slot = Delta < WheelSpan
+		? (Tick >> (SlotBits * Level)) & SlotMask
+		: ((CurrentTick >> (SlotBits * Level)) + SlotMask) & SlotMask;
+
+	Node.Bucket = Level * NumSlots + static_cast<int32>(Slot);
+	Node.Prev = INDEX_NONE;
+	Node.Next = Heads[Node.Bucket];
+	if (Node.Next != INDEX_NONE)
+	{
+		Nodes[Node.Next].Prev = Index;
+	}
+	Heads[Node.Bucket] = Index;
+}
+
+void FPerishScheduler::Unlink(const int32 Index)
+{
+	FNode& Node = Nodes[Index];
+	if (Node.Prev != INDEX_NONE)
+	{
+		Nodes[Node.Prev].Next = Node.Next;
+	}
+	else
+	{
+		Heads[Node.Bucket] = Node.Next;
+	}
+	if (Node.Next != INDEX_NONE)
+	{
+		Nodes[Node.Next].Prev = Node.Prev;
+	}
+	Node.Bucket = INDEX_NONE;
+	--NumScheduled;
+}
+
+void FPerishScheduler::Cascade(const int32 Level)
+{
+	using namespace PerishScheduler;
+
+	const int32 Bucket = Level * NumSlots + static_cast<int32>((CurrentTick >> (SlotBits * Level)) & SlotMask);
+	int32 Index = Heads[Bucket];
+	Heads[Bucket] = INDEX_NONE;
+	while (Index != INDEX_NONE)
+	{
+		const int32 Next = Nodes[Index].Next;
+		Insert(Index);
+		Index = Next;
+	}
+}
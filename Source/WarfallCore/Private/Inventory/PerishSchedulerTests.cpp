@@ -0,0 +1,82 @@
+﻿#include "Inventory/ItemInstanceStore.h"
+#include "Inventory/PerishScheduler.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// ===============================[ Perish Scheduler Tests ]============================
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPerishSchedulerCascadeTest, "Warfall.Items.PerishScheduler.CascadeOrder", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FPerishSchedulerCascadeTest::RunTest(const FString& Parameters)
+{
+	constexpr double TickSeconds = 0.25;
+	FPerishScheduler Scheduler(TickSeconds);
+	Scheduler.Reset(0.0);
+
+	// One deadline per level of the wheel and beyond its span, in shuffled order, plus deadlines sharing a level 1 slot.
+	const double Deadlines[] = { 70000.0, 1.0, 1100.0, 20.0, 20.5, 5000000.0, 16.25, 3.0 };
+	FItemInstanceStore Store;
+	TMap<FItemHandle, double> DeadlineOf;
+	for (const double Deadline : Deadlines)
+	{
+		const FItemHandle Handle = Store.Create(0);
+		Scheduler.Schedule(Handle, Deadline);
+		DeadlineOf.Add(Handle, Deadline);
+	}
+	TestEqual(TEXT("Every deadline is scheduled"), Scheduler.Num(), static_cast<int32>(UE_ARRAY_COUNT(Deadlines)));
+
+	// Advancing in uneven steps crosses the cascades of every level; nothing fires early or more than a tick late.
+	TArray<FItemHandle> Expired;
+	double LastDeadline = 0.0;
+	double Now = 0.0;
+	for (double Step = 0.3; Now < 6000000.0; Step = FMath::Min(Step * 1.7, 100000.0))
+	{
+		Now += Step;
+		Expired.Reset();
+		Scheduler.Advance(Now, Expired);
+		for (const FItemHandle Handle : Expired)
+		{
+			const double Deadline = DeadlineOf.FindRef(Handle);
+			TestTrue(FString::Printf(TEXT("Deadline %.2f does not fire early"), Deadline), Deadline <= Now);
+			TestTrue(FString::Printf(TEXT("Deadline %.2f fires in the step reaching it"), Deadline), Deadline > Now - Step - TickSeconds);
+			TestTrue(FString::Printf(TEXT("Deadline %.2f fires after %.2f"), Deadline, LastDeadline), Deadline >= LastDeadline);
+			LastDeadline = Deadline;
+			DeadlineOf.Remove(Handle);
+		}
+	}
+	TestEqual(TEXT("Every deadline fired once"), DeadlineOf.Num(), 0);
+	TestEqual(TEXT("The wheel is empty"), Scheduler.Num(), 0);
+
+	// One long advance returns every deadline in tick order, whatever level it waited in.
+	Scheduler.Reset(0.0);
+	Store.Reset();
+	FRandomStream Random(7);
+	TArray<double> Scheduled;
+	for (int32 Index = 0; Index < 500; ++Index)
+	{
+		const FItemHandle Handle = Store.Create(0);
+		// Whole ticks, distinct, so that the order is fully determined.
+		const double Deadline = (Index + 1) * TickSeconds + Random.RandHelper(1 << 14) * 500 * TickSeconds;
+		Scheduler.Schedule(Handle, Deadline);
+		DeadlineOf.Add(Handle, Deadline);
+		Scheduled.Add(Deadline);
+	}
+	Expired.Reset();
+	TestEqual(TEXT("Every deadline fires in one advance"), Scheduler.Advance(FMath::Max(Scheduled) + 1.0, Expired), Scheduled.Num());
+	for (int32 Index = 1; Index < Expired.Num(); ++Index)
+	{
+		if (!TestTrue(TEXT("Deadlines fire in tick order"), DeadlineOf.FindRef(Expired[Index - 1]) < DeadlineOf.FindRef(Expired[Index]))) break;
+	}
+
+	// Cancelled deadlines never fire.
+	const FItemHandle Cancelled = Store.Create(0);
+	Scheduler.Schedule(Cancelled, Now + 10.0);
+	Scheduler.Unschedule(Cancelled);
+	Expired.Reset();
+	Scheduler.Advance(Now + 20.0, Expired);
+	TestFalse(TEXT("A cancelled deadline does not fire"), Expired.Contains(Cancelled));
+	return true;
+}
+
+#endif
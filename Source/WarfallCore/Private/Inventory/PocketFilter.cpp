@@ -0,0 +1,132 @@
+﻿#include "Inventory/PocketFilter.h"
+
+#include "Inventory/ItemRowTypes.h"
+#include "Inventory/ItemTagIndex.h"
+
+// ===============================[ Pocket Filter ]============================
+
+void FPocketFilter::Compile(const FItemTagIndex& TagIndex, const FPocketSpec& Spec)
+{
+	Whitelist = Spec.Whitelist;
+	Blacklist = Spec.Blacklist;
+	bPlayerEditable = Spec.bPlayerEditableFilters;
+	Recompile(TagIndex);
+}
+
+void FPocketFilter::Recompile(const FItemTagIndex& TagIndex)
+{
+	Admission.Init(TagIndex.NumItems(), Whitelist.IsEmpty());
+	for (const FGameplayTag& Tag : Whitelist)
+	{
+		Admission.Or(TagIndex.GetPostings(Tag));
+	}
+	for (const FGameplayTag& Tag : Blacklist)
+	{
+		Admission.AndNot(TagIndex.GetPostings(Tag));
+	}
+}
+
+bool FPocketFilter::AddTag(const FItemTagIndex& TagIndex, const FGameplayTag& Tag, const bool bBlacklist)
+{
+	FGameplayTagContainer& Filter = bBlacklist ? Blacklist : Whitelist;
+	if (!Tag.IsValid() || Filter.HasTagExact(Tag)) return false;
+
+	const bool bWasOpen = Whitelist.IsEmpty();
+	Filter.AddTag(Tag);
+	UpdateWords(TagIndex, Tag, bWasOpen);
+	return true;
+}
+
+bool FPocketFilter::RemoveTag(const FItemTagIndex& TagIndex, const FGameplayTag& Tag, const bool bBlacklist)
+{
+	FGameplayTagContainer& Filter = bBlacklist ? Blacklist : Whitelist;
+	const bool bWasOpen = Whitelist.IsEmpty();
+	if (!Filter.RemoveTag(Tag)) return false;
+
+	UpdateWords(TagIndex, Tag, bWasOpen);
+	return true;
+}
+
+void FPocketFilter::RefreshItems(const FItemTagIndex& TagIndex, TConstArrayView<int32> ItemIds)
+{
+	if (Admission.Num() != TagIndex.NumItems())
+	{
+		Admission.SetNum(TagIndex.NumItems());
+	}
+
+	FPostings White;
+	FPostings Black;
+	GatherPostings(TagIndex, White, Black);
+	TArrayView<uint64> Words = Admission.GetWords();
+	for (const int32 ItemId : ItemIds)
+	{
+		if (Admission.IsValidIndex(ItemId))
+		{
+			Words[ItemId >> 6] = ComputeWord(White, Black, ItemId >> 6);
+		}
+	}
+}
+
+void FPocketFilter::Route(TConstArrayView<const FPocketFilter*> Pockets, FDenseBitSet& Items, TArray<FDenseBitSet>& OutRouted)
+{
+	OutRouted.SetNum(Pockets.Num());
+	for (int32 Index = 0; Index < Pockets.Num(); ++Index)
+	{
+		FDenseBitSet& Routed = OutRouted[Index];
+		Routed = Items;
+		Routed.And(Pockets[Index]->GetAdmission());
+		Items.AndNot(Routed);
+	}
+}
+
+void FPocketFilter::GatherPostings(const FItemTagIndex& TagIndex, FPostings& OutWhite, FPostings& OutBlack) const
+{
+	for (const FGameplayTag& Tag : Whitelist)
+	{
+		OutWhite.Add(TagIndex.GetPostings(Tag));
+	}
+	for (const FGameplayTag& Tag : Blacklist)
+	{
+		OutBlack.Add(TagIndex.GetPostings(Tag));
+	}
+}
+
+uint64 FPocketFilter::ComputeWord(const FPostings& White, const FPostings& Black, const int32 WordIndex) const
+{
+	uint64 Word = Whitelist.IsEmpty() ? ~0ull : 0ull;
+	for (const TConstArrayView<uint64>& Postings : White)
+	{
+		Word |= Postings.IsValidIndex(WordIndex) ? Postings[WordIndex] : 0ull;
+	}
+	for (const TConstArrayView<uint64>& Postings : Black)
+	{
+		Word &= Postings.IsValidIndex(WordIndex) ? ~Postings[WordIndex] : ~0ull;
+	}
+
+	// Bits past the last item stay cleared, as FDenseBitSet expects.
+	const int32 Used = Admission.Num() - WordIndex * 64;
+	return Used < 64 ? Word & ((1ull << FMath::Max(Used, 0)) - 1ull) : Word;
+}
+
+void FPocketFilter::UpdateWords(const FItemTagIndex& TagIndex, const FGameplayTag& Tag, const bool bWasOpen)
+{
+	// An empty whitelist admits everything: switching from or to it changes every word.
+	if (bWasOpen != Whitelist.IsEmpty() || Admission.Num() != TagIndex.NumItems())
+	{
+		Recompile(TagIndex);
+		return;
+	}
+
+	FPostings White;
+	FPostings Black;
+	GatherPostings(TagIndex, White, Black);
+	const TConstArrayView<uint64> Postings = TagIndex.GetPostings(Tag);
+	TArrayView<uint64> Words = Admission.GetWords();
+	for (int32 WordIndex = 0; WordIndex < FMath::Min(Postings.Num(), Words.Num()); ++WordIndex)
+	{
+		if (Postings[WordIndex])
+		{
+			Words[WordIndex] = ComputeWord(White, Black, WordIndex);
+		}
+	}
+}
@@ -0,0 +1,157 @@
+#include "Utils/AssetCache.h"
+
+#include "Engine/Engine.h"
+#include "Inventory/CookedItemCatalog.h"
+#include "Misc/Paths.h"
+#include "Utils/Paths.h"
+
+namespace
+{
+	/** Assets requested by UTables and UGlobalTools, preloaded as soon as the cache starts. */
+	const TCHAR* const PreloadPaths[] =
+	{
+		INPUT_TABLE_PATH,
+		ITEM_TABLE_PATH,
+		MODULE_TABLE_PATH,
+		STATS_TABLE_PATH,
+		CHAR_PROFILE_TABLE_PATH,
+		ATTRIBUTES_TREE_DATA_PATH,
+		SKILLS_TREE_DATA_PATH,
+		SHAPE_MATERIAL_PATH,
+		THUMBNAIL_MATERIAL_PATH,
+		RENDER_TARGET_MATERIAL_PATH,
+		OUTLINES_MATERIAL_PATH,
+		OUTLINES_MATERIAL_INST_PATH,
+	};
+
+	FAutoConsoleCommand DumpAssetCacheCommand(
+		TEXT("Warfall.AssetCache.Dump"),
+		TEXT("Logs the load time of every asset held by the asset cache."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			if (const UAssetCacheSubsystem* Cache = UAssetCacheSubsystem::Get())
+			{
+				Cache->DumpLoadTimes();
+			}
+		}));
+}
+
+void UAssetCacheSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Packaged builds read the items from the cooked catalog and only load ItemsTable when a full row is requested.
+	const bool bSkipItemsTable = !WITH_EDITOR && FPaths::FileExists(FCookedItemCatalog::GetDefaultPath());
+
+	for (const TCHAR* Path : PreloadPaths)
+	{
+		if (bSkipItemsTable && FCString::Strcmp(Path, ITEM_TABLE_PATH) == 0) continue;
+		Preload(FSoftObjectPath(Path));
+	}
+}
+
+void UAssetCacheSubsystem::Deinitialize()
+{
+	for (const TSharedPtr<FStreamableHandle>& Handle : PreloadHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->CancelHandle();
+		}
+	}
+	PreloadHandles.Empty();
+	PendingPreloads = 0;
+	Assets.Empty();
+	LoadTimes.Empty();
+	Super::Deinitialize();
+}
+
+UAssetCacheSubsystem* UAssetCacheSubsystem::Get()
+{
+	return GEngine ? GEngine->GetEngineSubsystem<UAssetCacheSubsystem>() : nullptr;
+}
+
+UObject* UAssetCacheSubsystem::LoadAsset(const FSoftObjectPath& Path, UClass* Class)
+{
+	if (Path.IsNull()) return nullptr;
+
+	if (IsInGameThread())
+	{
+		if (UAssetCacheSubsystem* Cache = Get())
+		{
+			return Cache->Resolve(Path, Class);
+		}
+	}
+	return StaticLoadObject(Class, nullptr, *Path.ToString());
+}
+
+UObject* UAssetCacheSubsystem::Resolve(const FSoftObjectPath& Path, UClass* Class)
+{
+	if (UObject* const* Found = Assets.Find(Path); Found && *Found)
+	{
+		return (*Found)->IsA(Class) ? *Found : nullptr;
+	}
+
+	// Not preloaded yet (or still in flight): loading synchronously flushes the pending request of that package.
+	const double StartTime = FPlatformTime::Seconds();
+	UObject* Asset = StaticLoadObject(Class, nullptr, *Path.ToString());
+	Store(Path, Asset, FPlatformTime::Seconds() - StartTime, false);
+	return Asset;
+}
+
+void UAssetCacheSubsystem::DumpLoadTimes() const
+{
+	TArray<TPair<FSoftObjectPath, double>> Sorted = LoadTimes.Array();
+	Sorted.Sort([](const TPair<FSoftObjectPath, double>& A, const TPair<FSoftObjectPath, double>& B)
+	{
+		return A.Value > B.Value;
+	});
+
+	UE_LOG(LogTemp, Log, TEXT("AssetCache: %d assets cached, %d preloads pending."), Assets.Num(), PendingPreloads);
+	for (const TPair<FSoftObjectPath, double>& Entry : Sorted)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %8.2f ms  %s"), Entry.Value * 1000.0, *Entry.Key.ToString());
+	}
+}
+
+void UAssetCacheSubsystem::Preload(const FSoftObjectPath& Path)
+{
+	if (Path.IsNull()) return;
+
+	PendingPreloads++;
+	const double StartTime = FPlatformTime::Seconds();
+	TSharedPtr<FStreamableHandle> Handle = StreamableManager.RequestAsyncLoad(
+		Path,
+		FStreamableDelegate::CreateUObject(this, &UAssetCacheSubsystem::OnPreloaded, Path, StartTime),
+		FStreamableManager::AsyncLoadHighPriority);
+
+	if (Handle.IsValid())
+	{
+		PreloadHandles.Add(Handle);
+	}
+}
+
+void UAssetCacheSubsystem::OnPreloaded(FSoftObjectPath Path, double StartTime)
+{
+	PendingPreloads = FMath::Max(PendingPreloads - 1, 0);
+
+	// A synchronous request may have resolved it first, keep that measurement.
+	if (Assets.FindRef(Path)) return;
+
+	UObject* Asset = Path.ResolveObject();
+	if (!Asset)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("AssetCache: failed to preload %s"), *Path.ToString());
+		return;
+	}
+	Store(Path, Asset, FPlatformTime::Seconds() - StartTime, true);
+}
+
+void UAssetCacheSubsystem::Store(const FSoftObjectPath& Path, UObject* Asset, const double Duration, const bool bAsync)
+{
+	if (!Asset) return;
+
+	Assets.Add(Path, Asset);
+	LoadTimes.Add(Path, Duration);
+	UE_LOG(LogTemp, Log, TEXT("AssetCache: %s loaded %s in %.2f ms"), *Path.ToString(), bAsync ? TEXT("async") : TEXT("sync"), Duration * 1000.0);
+}
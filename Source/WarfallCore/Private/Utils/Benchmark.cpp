@@ -0,0 +1,70 @@
+#include "Utils/Benchmark.h"
+
+#include "HAL/MemoryBase.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// ===============================[ Benchmark Result ]============================
+
+double FBenchmarkResult::GetPercentile(const double Percent) const
+{
+	if (Samples.IsEmpty()) return 0.0;
+
+	const int32 Rank = FMath::CeilToInt(Percent / 100.0 * Samples.Num()) - 1;
+	return Samples[FMath::Clamp(Rank, 0, Samples.Num() - 1)];
+}
+
+double FBenchmarkResult::GetMean() const
+{
+	if (Samples.IsEmpty()) return 0.0;
+
+	double Sum = 0.0;
+	for (const double Sample : Samples)
+	{
+		Sum += Sample;
+	}
+	return Sum / Samples.Num();
+}
+
+// ===============================[ Benchmark Report ]============================
+
+void FBenchmarkReport::Log() const
+{
+	for (const FBenchmarkResult& Result : Results)
+	{
+		UE_LOG(LogTemp, Display, TEXT("%s | %-28s | %7d rows | p50 %10.1f ns | p90 %10.1f ns | p99 %10.1f ns | %6.2f allocs/op"),
+			*Suite, *Result.Name, Result.Rows, Result.GetPercentile(50.0), Result.GetPercentile(90.0), Result.GetPercentile(99.0), Result.AllocationsPerOp);
+	}
+}
+
+FString FBenchmarkReport::WriteCsv() const
+{
+	FString Csv = TEXT("Suite,Operation,Rows,OpsPerSample,Samples,MeanNs,P50Ns,P90Ns,P99Ns,MaxNs,AllocsPerOp\n");
+	for (const FBenchmarkResult& Result : Results)
+	{
+		Csv += FString::Printf(TEXT("%s,%s,%d,%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f\n"),
+			*Suite, *Result.Name, Result.Rows, Result.OpsPerSample, Result.Samples.Num(), Result.GetMean(),
+			Result.GetPercentile(50.0), Result.GetPercentile(90.0), Result.GetPercentile(99.0), Result.GetPercentile(100.0),
+			Result.AllocationsPerOp);
+	}
+
+	const FString Path = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / FString::Printf(TEXT("%s-%s.csv"), *Suite, *FDateTime::Now().ToString());
+	if (!FFileHelper::SaveStringToFile(Csv, *Path))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Benchmark: failed to write '%s'."), *Path);
+		return FString();
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Benchmark: %d results written to '%s'."), Results.Num(), *Path);
+	return Path;
+}
+
+int64 FBenchmarkReport::GetAllocationCount()
+{
+#if !UE_BUILD_SHIPPING
+	return static_cast<int64>(FMalloc::TotalMallocCalls.load() + FMalloc::TotalReallocCalls.load());
+#else
+	return -1;
+#endif
+}
@@ -0,0 +1,128 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Inventory/ItemRowTypes.h"
+#include "CraftingComponent.generated.h"
+
+class UCraftingJobSubsystem;
+class UInventoryComponent;
+struct FCraftingJob;
+struct FCraftingPlan;
+
+// ===============================[ Crafting Component ]============================
+
+/**
+ * Crafts and repairs from the owner inventory, for players as for workstations.
+ * A craft plans every intermediate of the recipe tree with the FCraftingPlanner of URecipeCatalogSubsystem, consumes
+ * the ingredients in the same server call, then waits the CraftDuration of every batch in UCraftingJobSubsystem. A
+ * repair consumes the RepairData materials of the item and waits its repair time. Leftovers of intermediates and
+ * byproducts are created along with the target and placed in the inventory pockets routed for them. When one of them
+ * fits nowhere, the craft is undone: its results are destroyed and what it took from the inventory is refunded.
+ * A repair whose instance left the inventory or can no longer be repaired refunds its materials the same way.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class WARFALLCORE_API UCraftingComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FCraftStarted, FName, ItemID, int32, Quantity, float, Duration);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FCraftFinished, FName, ItemID, int32, Quantity, bool, bSuccess);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FRepairFinished, int32, SlotId, bool, bSuccess);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnItemsCrafted, TConstArrayView<FItemHandle> /* Instances */);
+
+	// ========== FUNCTIONS ==========
+public:
+	/** Largest quantity a single call may ask for. */
+	static constexpr int32 MaxCraftQuantity = 999;
+
+	UCraftingComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/**
+	 * Plans crafting an item from the owner inventory.
+	 *
+	 * @param ItemID Row of the item in the items table.
+	 * @param Quantity How many of it.
+	 * @param OutPlan Receives the plan, partial when it is not complete.
+	 * @return True if the inventory holds everything the plan needs.
+	 */
+	bool PlanCraft(const FName ItemID, const int32 Quantity, FCraftingPlan& OutPlan) const;
+
+	/** Crafts an item and everything below it. The owner is answered through OnCraftStarted and OnCraftFinished. */
+	UFUNCTION(Server, Reliable, BlueprintCallable, Category = "Crafting")
+	void ServerCraft(const FName ItemID, const int32 Quantity);
+	/** Repairs the stack of a slot of the owner inventory. The owner is answered through OnRepairFinished. */
+	UFUNCTION(Server, Reliable, BlueprintCallable, Category = "Crafting")
+	void ServerRepair(const int32 SlotId);
+
+	/**
+	 * Places the results of a craft in the inventory, or destroys them all and refunds what the craft took.
+	 * Called by UCraftingJobSubsystem when it commits a craft of the component.
+	 *
+	 * @return True if every result was placed.
+	 */
+	bool PlaceCrafted(TConstArrayView<FItemHandle> Crafted, const TMap<int32, int32>& TakenItems);
+	/**
+	 * Repairs an instance still held by the inventory, or refunds what the repair took.
+	 * Called by UCraftingJobSubsystem when it commits a repair of the component.
+	 *
+	 * @return True if the instance was repaired.
+	 */
+	bool CommitRepair(const FItemHandle Instance, const TMap<int32, int32>& TakenItems);
+	/**
+	 * Called by UCraftingJobSubsystem when a job of the component completes.
+	 *
+	 * @param Instances The placed results of a craft, the repaired instance of a repair.
+	 * @param bSuccess False for crafts whose results fit nowhere and for failed repairs, both refunded.
+	 */
+	void HandleJobCompleted(const FCraftingJob& Job, TConstArrayView<FItemHandle> Instances, const bool bSuccess);
+	/** Jobs of the component still pending. Server only. */
+	TConstArrayView<uint32> GetActiveJobs() const { return ActiveJobs; }
+
+	/** Broadcast on the owning client when a craft asked with ServerCraft starts, with its duration in seconds. */
+	UPROPERTY(BlueprintAssignable)
+	FCraftStarted OnCraftStarted;
+	/** Broadcast on the owning client when a craft asked with ServerCraft ends. */
+	UPROPERTY(BlueprintAssignable)
+	FCraftFinished OnCraftFinished;
+	/** Broadcast on the owning client when a repair asked with ServerRepair ends. */
+	UPROPERTY(BlueprintAssignable)
+	FRepairFinished OnRepairFinished;
+
+	/** Broadcast on the server with the instances a craft created, once placed in the inventory. */
+	FOnItemsCrafted OnItemsCrafted;
+
+private:
+	UFUNCTION(Client, Reliable)
+	void ClientCraftStarted(const FName ItemID, const int32 Quantity, const float Duration);
+	UFUNCTION(Client, Reliable)
+	void ClientCraftFinished(const FName ItemID, const int32 Quantity, const bool bSuccess);
+	UFUNCTION(Client, Reliable)
+	void ClientRepairFinished(const int32 SlotId, const bool bSuccess);
+
+	UCraftingJobSubsystem* GetJobs() const;
+	/**
+	 * Consumes the ingredients of a complete plan.
+	 *
+	 * @param OutTaken Receives the quantity taken of each item, tag ingredients resolved to their items.
+	 * @return False, having consumed nothing, if the inventory no longer holds what the plan needs.
+	 */
+	bool ConsumePlan(const FCraftingPlan& Plan, TMap<int32, int32>& OutTaken);
+	/** Gives items back to the inventory, those without room waiting in PendingRefunds. */
+	void RefundItems(const TMap<int32, int32>& Items);
+	/** Places again the pending refunds that now fit. */
+	void FlushRefunds();
+	/** Consumes the repair materials of a slot and queues its repair. @return The id of the job, 0 on failure. */
+	uint32 StartRepair(const int32 SlotId);
+
+	// ========== VARIABLES ==========
+	/** Inventory of the owner the crafts draw from. */
+	UPROPERTY()
+	TObjectPtr<UInventoryComponent> Inventory = nullptr;
+	TArray<uint32> ActiveJobs;
+	/** Refunded items the inventory had no room for, by item, placed again on the next request or completion. */
+	TMap<int32, int32> PendingRefunds;
+};
@@ -0,0 +1,302 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Inventory/ItemRowTypes.h"
+#include "Inventory/PocketFilter.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "InventoryComponent.generated.h"
+
+class UInventoryComponent;
+class FItemInstanceStore;
+class FItemSnapshotWriter;
+struct FGridOccupancy;
+struct FItemCatalog;
+struct FPerishTransform;
+struct FItemSnapshotEntry;
+
+// ===============================[ Inventory Slot ]============================
+
+/**
+ * One stack of an inventory, as replicated.
+ * Items travel as their compact catalog id rather than the row names of an FItemRowHandle, durability and wear as a
+ * share of the item maximum on 8 bits, and the perish deadline as whole seconds of the server world time the game state
+ * replicates, so that clients compare it with AGameStateBase::GetServerWorldTimeSeconds rather than their own clock.
+ * Slots are bit-packed by NetSerialize, so a moved stack costs a few bytes on top of the fast array item header.
+ */
+USTRUCT(BlueprintType)
+struct WARFALLCORE_API FInventorySlot : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	static constexpr uint16 NoItem = MAX_uint16;
+	static constexpr uint8 QuantizationSteps = MAX_uint8;
+
+	/** Catalog id of the item, NoItem when the id does not fit 16 bits. */
+	UPROPERTY()
+	uint16 ItemId = NoItem;
+	UPROPERTY()
+	uint16 Stack = 0;
+	/** Index of the pocket holding the stack. */
+	UPROPERTY()
+	uint8 Pocket = 0;
+	/** Top-left cell of the stack in its pocket. */
+	UPROPERTY()
+	uint8 CellX = 0;
+	UPROPERTY()
+	uint8 CellY = 0;
+	UPROPERTY()
+	bool bRotated = false;
+	/** Durability over MaxDurability, in QuantizationSteps. */
+	UPROPERTY()
+	uint8 Durability = 0;
+	/** Wear over the max wear of the item, in QuantizationSteps. */
+	UPROPERTY()
+	uint8 Wear = 0;
+	/** Server world time in whole seconds at which the stack perishes, 0 when it never does. See GetPerishRemaining. */
+	UPROPERTY()
+	uint32 PerishDeadline = 0;
+
+	/** Instance behind the stack. Server only. */
+	UPROPERTY(NotReplicated)
+	FItemHandle Instance;
+
+	/** @return The catalog id of the item, INDEX_NONE if unset. */
+	int32 GetItemId() const { return ItemId == NoItem ? INDEX_NONE : ItemId; }
+	FIntPoint GetCell() const { return FIntPoint(CellX, CellY); }
+	/** @return The durability share from 0 to 1. */
+	float GetDurabilityRatio() const { return static_cast<float>(Durability) / QuantizationSteps; }
+	float GetWearRatio() const { return static_cast<float>(Wear) / QuantizationSteps; }
+	/**
+	 * @param World World of the inventory, whose game state gives the server world time on clients as on the server.
+	 * @return The seconds before the stack perishes, 0 once overdue, a negative value when it never does.
+	 */
+	double GetPerishRemaining(const UWorld* World) const;
+
+	/**
+	 * Quantizes the state of the instance behind the slot.
+	 *
+	 * @param Store Store holding Instance, which must be valid.
+	 * @param Catalog Catalog the item ids belong to.
+	 * @param ServerTimeOffset Server world time minus the time of the perish clock of the store, turning deadlines into
+	 *                         the replicated time base.
+	 * @return True if any replicated field changed.
+	 */
+	bool SyncFromInstance(const FItemInstanceStore& Store, const FItemCatalog& Catalog, const double ServerTimeOffset);
+
+	/** Bit-packed serialization of the replicated fields. */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	void PreReplicatedRemove(const struct FInventorySlotArray& InArraySerializer);
+	void PostReplicatedAdd(const struct FInventorySlotArray& InArraySerializer);
+	void PostReplicatedChange(const struct FInventorySlotArray& InArraySerializer);
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventorySlot> : public TStructOpsTypeTraitsBase2<FInventorySlot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * Replicated stacks of an inventory.
+ * Only the slots marked dirty since the last update of a connection are sent to it, each connection keeping its own
+ * acknowledged state.
+ */
+USTRUCT()
+struct WARFALLCORE_API FInventorySlotArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FInventorySlot> Slots;
+
+	UPROPERTY(NotReplicated)
+	TObjectPtr<UInventoryComponent> Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FInventorySlot, FInventorySlotArray>(Slots, DeltaParams, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventorySlotArray> : public TStructOpsTypeTraitsBase2<FInventorySlotArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+// ===============================[ Inventory Component ]============================
+
+UENUM(BlueprintType)
+enum class EInventorySlotChange : uint8
+{
+	E_Added		UMETA(DisplayName = "Added"),
+	E_Changed	UMETA(DisplayName = "Changed"),
+	E_Removed	UMETA(DisplayName = "Removed"),
+};
+
+/**
+ * Replicated inventory of an actor.
+ * The server edits the stacks through the functions below; each edit marks only the touched slot dirty, and slot
+ * refreshes compare the quantized values first so that sub-step durability or wear changes send nothing.
+ * Clients are notified slot by slot through OnSlotReplicated.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class WARFALLCORE_API UInventoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FSlotReplicated, const FInventorySlot&, Slot, EInventorySlotChange, Change);
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnItemCountChanged, int32 /* ItemId */, int32 /* Count */);
+
+	// ========== FUNCTIONS ==========
+public:
+	UInventoryComponent();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/**
+	 * Adds an instance to the inventory. Server only.
+	 *
+	 * @param Instance Live instance of the world item store.
+	 * @param Pocket Index of the pocket receiving the stack.
+	 * @param Cell Top-left cell of the stack in the pocket.
+	 * @param bRotated True if the footprint is turned by a quarter.
+	 * @return The id of the new slot, INDEX_NONE on failure.
+	 */
+	int32 AddInstance(const FItemHandle Instance, const uint8 Pocket, const FIntPoint Cell, const bool bRotated);
+	/**
+	 * Adds instances in the first free cells of the pockets RoutePockets chooses for them, turned by a quarter when
+	 * they only fit that way. Server only.
+	 *
+	 * @param Instances Live instances of the world item store, not held yet.
+	 * @param OutUnplaced Receives the instances no pocket admits or has room for, which are left untouched.
+	 * @return The number of instances added.
+	 */
+	int32 PlaceInstances(TConstArrayView<FItemHandle> Instances, TArray<FItemHandle>& OutUnplaced);
+	/** Removes a slot, the instance is left alive. Server only. */
+	bool RemoveSlot(const int32 SlotId);
+	/** Moves a stack to another cell or pocket. Server only. */
+	bool MoveSlot(const int32 SlotId, const uint8 Pocket, const FIntPoint Cell, const bool bRotated);
+	/**
+	 * Quantizes again the instance behind a slot, after its stack, durability or wear changed. Server only.
+	 *
+	 * @return True if the slot changed and will be replicated.
+	 */
+	bool RefreshSlot(const int32 SlotId);
+	/**
+	 * Takes items out of the stacks of an item, emptied stacks being destroyed with their slot. Server only.
+	 *
+	 * @param OutTaken If set, receives the quantity taken of each item, added to what it holds.
+	 * @return The quantity taken, less than Quantity when not enough is held.
+	 */
+	int32 ConsumeItems(const int32 ItemId, const int32 Quantity, TMap<int32, int32>* OutTaken = nullptr);
+	/** Same as ConsumeItems, out of the stacks of every item with the tag, in slot order. Server only. */
+	int32 ConsumeTagged(const FGameplayTag& Tag, const int32 Quantity, TMap<int32, int32>* OutTaken = nullptr);
+
+	/** Queues every stack, with its slot and content, in a snapshot being written. Server only. */
+	void QueueSnapshot(FItemSnapshotWriter& Writer) const;
+	/**
+	 * Puts back the stacks of one restored chunk of a snapshot in their slots. Server only.
+	 *
+	 * @param Entries The entries of the chunk.
+	 * @param Handles The instances UItemInstanceSubsystem::RestoreInstances created for them, in the same order.
+	 * @return The number of slots added.
+	 */
+	int32 RestoreSnapshot(TConstArrayView<FItemSnapshotEntry> Entries, TConstArrayView<FItemHandle> Handles);
+
+	/** @return The slot with the given id, or nullptr. */
+	const FInventorySlot* FindSlot(const int32 SlotId) const;
+	const FInventorySlot* FindSlotByInstance(const FItemHandle Instance) const;
+	TConstArrayView<FInventorySlot> GetSlots() const { return Inventory.Slots; }
+
+	/**
+	 * Mass of the stacks held and of everything nested inside them, maintained by the container tree of the world
+	 * instances in O(depth) per change. Server only.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	float GetCarriedMass() const;
+
+	/**
+	 * Quantity held per catalog id, summed over the stacks as replicated, for queries such as
+	 * FRecipeCatalog::FindCraftable. Only the stacks in the slots count, not the content of bags.
+	 * Maintained slot by slot, on the server as on clients.
+	 */
+	const TMap<int32, int32>& GetItemCounts() const { return ItemCounts; }
+	int32 GetItemCount(const int32 ItemId) const { return ItemCounts.FindRef(ItemId); }
+
+	/** Sets the dimensions and filters of a pocket, compiled into one admission bit per item. Server only. */
+	void SetPocketSpec(const uint8 Pocket, const FPocketSpec& Spec);
+	/** @return True if the filters of the pocket admit the item, false for pockets without spec. A single bit test. */
+	bool CanAdmit(const uint8 Pocket, const int32 ItemId) const;
+	/**
+	 * Chooses the pocket of each looted item, the first one by index whose filters admit it.
+	 * Costs one bitset intersection per pocket, whatever the size of the loot.
+	 *
+	 * @param ItemIds Catalog ids of the loot.
+	 * @param OutPockets Receives the pocket of each item, INDEX_NONE when no pocket admits it.
+	 */
+	void RoutePockets(TConstArrayView<int32> ItemIds, TArray<int32>& OutPockets) const;
+
+	/** Adds or removes a tag of a pocket filter on behalf of the player, if the pocket has bPlayerEditableFilters. */
+	UFUNCTION(Server, Reliable)
+	void ServerEditPocketFilter(const uint8 Pocket, const FGameplayTag Tag, const bool bBlacklist, const bool bAdd);
+
+	/** Called by the replicated slots on clients. */
+	void HandleSlotReplicated(const FInventorySlot& Slot, const EInventorySlotChange Change);
+
+	/** Broadcast on clients for every slot added, changed or removed by replication. */
+	UPROPERTY(BlueprintAssignable)
+	FSlotReplicated OnSlotReplicated;
+
+	/** Broadcast with the new quantity held of an item, each time a slot edit or its replication changes it. */
+	FOnItemCountChanged OnItemCountChanged;
+
+private:
+	FInventorySlot* FindSlotMutable(const int32 SlotId);
+	/** @return The index of a slot in the replicated array, INDEX_NONE if absent. O(1) on the server. */
+	int32 FindSlotIndex(const int32 SlotId) const;
+	/** Refreshes or removes the slots of the instances that perished this frame. */
+	void HandleInstancesPerished(TConstArrayView<FPerishTransform> Transforms);
+	void HandleCatalogRebuilt();
+	void HandleRowsPatched(TConstArrayView<int32> Ids);
+	/** Moves the contribution of a slot to the item counts, INDEX_NONE or a 0 stack once removed. */
+	void CountSlot(const int32 SlotId, const int32 ItemId, const int32 Stack);
+	void AddItemCount(const int32 ItemId, const int32 Delta);
+	int32 ConsumeMatching(TFunctionRef<bool(int32 ItemId)> Matches, const int32 Quantity, TMap<int32, int32>* OutTaken);
+	/** Marks the cells of every stack held in a pocket. */
+	void BuildOccupancy(const uint8 Pocket, const FItemCatalog& Catalog, FGridOccupancy& OutGrid) const;
+
+	// ========== VARIABLES ==========
+	UPROPERTY(Replicated)
+	FInventorySlotArray Inventory;
+
+	/** Slot id of every instance held, to route instance events without scanning the slots. */
+	TMap<FItemHandle, int32> SlotIds;
+	/**
+	 * Index in the replicated array of every slot by id, kept up to date by AddInstance and the swap of RemoveSlot.
+	 * Server only: on clients replication reorders the array, and slots are looked up by scanning it.
+	 */
+	TMap<int32, int32> SlotIndices;
+	FDelegateHandle PerishedHandle;
+	FDelegateHandle CatalogRebuiltHandle;
+	FDelegateHandle RowsPatchedHandle;
+	/** Compiled filters of every pocket by index. Pockets without spec admit nothing. Server only. */
+	TArray<FPocketFilter> PocketFilters;
+	/** Grid size of every pocket by index, from their spec. Server only. */
+	TArray<FIntPoint> PocketDimensions;
+	/** Owner of the held instances in the container tree, INDEX_NONE before BeginPlay and on clients. */
+	int32 MassOwner = INDEX_NONE;
+	TMap<int32, int32> ItemCounts;
+	/** Item and stack each slot contributes to ItemCounts, by slot id. */
+	TMap<int32, TPair<int32, int32>> CountedSlots;
+};
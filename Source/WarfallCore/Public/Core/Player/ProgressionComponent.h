@@ -2,8 +2,11 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Crafting/CraftabilityTracker.h"
 #include "ProgressionComponent.generated.h"
 
+class UInventoryComponent;
+
 
 
 
@@ -16,8 +19,12 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FNewDiscovery, FDataTableRowHandle,
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FForgetDiscovery, FDataTableRowHandle, Discovery);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FLearnRecipe, FDataTableRowHandle, Recipe);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FForgetRecipe, FDataTableRowHandle, Recipe);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FRecipeCraftableChanged, FDataTableRowHandle, Recipe, bool, bCraftable);
 	// ========== FUNCTIONS ==========
 public:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	void AddNewDiscovery(const FDataTableRowHandle& NewDiscovery);
 	void RemoveDiscovery(const FDataTableRowHandle& DiscoveryToRemove);
 	void ClearDiscoveries();
@@ -30,6 +37,12 @@ public:
 	void ForgetRecipe(const FDataTableRowHandle& Recipe);
 	UFUNCTION(BlueprintCallable)
 	bool HasRecipe(const FDataTableRowHandle& Recipe) const;
+	/** @return True if a known recipe is craftable with the items of the owner inventory. */
+	UFUNCTION(BlueprintPure)
+	bool IsRecipeCraftable(const FDataTableRowHandle& Recipe) const;
+	/** Known recipes craftable with the items of the owner inventory, maintained as the inventory changes. */
+	UFUNCTION(BlueprintCallable)
+	TArray<FDataTableRowHandle> GetCraftableRecipes() const;
 	
 	void ClearRecipes();
 	
@@ -71,10 +84,32 @@ public:
 
 	UPROPERTY(BlueprintAssignable)
 	FForgetRecipe OnForgetRecipe;
+
+	/**
+	 * Broadcast when a known recipe becomes craftable or stops being craftable, as the owner inventory changes.
+	 * Only the recipes using the changed item are evaluated, so UI and hints can listen instead of polling.
+	 */
+	UPROPERTY(BlueprintAssignable)
+	FRecipeCraftableChanged OnRecipeCraftableChanged;
+
+private:
+	/** Binds the tracker to the current catalogs and inventory, and tracks every known recipe again. */
+	void ResetTracker();
+	void HandleItemCountChanged(const int32 ItemId, const int32 Count);
+	/** @return The id of a recipe in the recipe catalog, INDEX_NONE if unknown. */
+	int32 FindRecipeId(const FDataTableRowHandle& Recipe) const;
+	FDataTableRowHandle MakeRecipeHandle(const int32 RecipeId) const;
 	
 	// ========== VARIABLES ==========
-	
-private:
 	TArray<FDataTableRowHandle> Discovery;
 	TArray<FDataTableRowHandle> KnownRecipes;
+
+	/** Inventory of the owner whose items the craftability is tracked against. */
+	UPROPERTY()
+	TObjectPtr<UInventoryComponent> Inventory = nullptr;
+	FCraftabilityTracker Tracker;
+	/** Reused by every inventory change. */
+	TArray<FCraftabilityChange> CraftabilityChanges;
+	FDelegateHandle ItemCountHandle;
+	FDelegateHandle RecipesRebuiltHandle;
 };
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Utils/DenseBitSet.h"
+
+struct FItemCatalog;
+struct FRecipeCatalog;
+struct FRecipeIngredient;
+
+// ===============================[ Craftability Tracker ]============================
+
+/** A tracked recipe that became craftable or stopped being craftable. */
+struct FCraftabilityChange
+{
+	int32 RecipeId = INDEX_NONE;
+	bool bCraftable = false;
+};
+
+/**
+ * Keeps, for every tracked recipe, the number of its ingredients the holdings do not cover.
+ * A change of the quantity held of one item only visits the recipes using that item, by name or by one of its
+ * ingredient tags, and reports the recipes whose counter reached or left zero. Nothing is evaluated again when an
+ * item no tracked recipe uses is picked up.
+ * Each ingredient is checked on its own, as in FRecipeCatalog::GetMaxBatches. The tracker reads the catalogs it was
+ * reset with: reset it again whenever either is rebuilt.
+ */
+class WARFALLCORE_API FCraftabilityTracker
+{
+	// ========== FUNCTIONS ==========
+public:
+	/**
+	 * Drops every tracked recipe and binds the tracker to the catalogs and holdings.
+	 *
+	 * @param InRecipes Recipe catalog, must outlive the tracker or its next reset.
+	 * @param InItems Item catalog the recipes were resolved against.
+	 * @param Holdings Quantity held per item id.
+	 */
+	void Reset(const FRecipeCatalog& InRecipes, const FItemCatalog& InItems, const TMap<int32, int32>& Holdings);
+	/** Drops every tracked recipe, keeping the holdings. */
+	void Clear();
+
+	/** @return True if the recipe is craftable with the current holdings, false if unknown or already tracked. */
+	bool Track(const int32 RecipeId);
+	void Untrack(const int32 RecipeId);
+
+	/**
+	 * Applies a change of the quantity held of an item.
+	 *
+	 * @param ItemId The item.
+	 * @param Count Its new quantity.
+	 * @param OutChanges Receives the tracked recipes whose craftability changed.
+	 */
+	void SetHeld(const int32 ItemId, const int32 Count, TArray<FCraftabilityChange>& OutChanges);
+
+	bool IsTracked(const int32 RecipeId) const { return Missing.IsValidIndex(RecipeId) && Missing[RecipeId] != INDEX_NONE; }
+	bool IsCraftable(const int32 RecipeId) const { return Missing.IsValidIndex(RecipeId) && Missing[RecipeId] == 0; }
+	/** @return The number of ingredients of a tracked recipe the holdings do not cover, INDEX_NONE if not tracked. */
+	int32 GetNumMissing(const int32 RecipeId) const { return Missing.IsValidIndex(RecipeId) ? Missing[RecipeId] : INDEX_NONE; }
+	/** One bit per recipe id, set for the tracked recipes currently craftable. */
+	const FDenseBitSet& GetCraftable() const { return Craftable; }
+	const TMap<int32, int32>& GetHoldings() const { return Held; }
+
+private:
+	bool IsCovered(const FRecipeIngredient& Ingredient) const;
+	/** Moves the counter of a tracked recipe when one of its ingredients became covered or uncovered. */
+	void AdjustMissing(const int32 RecipeId, const bool bWasCovered, const bool bIsCovered, TArray<FCraftabilityChange>& OutChanges);
+	/** @return The ingredient tag slots of an item, cached per item. */
+	TConstArrayView<int32> GetTagSlots(const int32 ItemId);
+
+	// ========== VARIABLES ==========
+	const FRecipeCatalog* Recipes = nullptr;
+	const FItemCatalog* Items = nullptr;
+	TMap<int32, int32> Held;
+	/** Quantity held per ingredient tag slot. */
+	TArray<int32> TagCounts;
+	/** Uncovered ingredients per recipe id, INDEX_NONE for recipes not tracked. */
+	TArray<int32> Missing;
+	FDenseBitSet Craftable;
+	TMap<int32, TArray<int32>> ItemTagSlots;
+};
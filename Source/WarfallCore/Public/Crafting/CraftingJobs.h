@@ -0,0 +1,210 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Crafting/CraftingPlanner.h"
+#include "Inventory/ItemRowTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CraftingJobs.generated.h"
+
+class UCraftingComponent;
+struct FItemCatalog;
+struct FRecipeCatalog;
+
+// ===============================[ Crafting Job Queue ]============================
+
+enum class ECraftingJobKind : uint8
+{
+	/** Creates the results of a plan whose ingredients were consumed when the job started. */
+	Craft,
+	/** Restores the durability of an instance whose materials were consumed when the job started. */
+	Repair,
+};
+
+/** A craft or a repair completing at a given time. */
+struct FCraftingJob
+{
+	uint32 JobId = 0;
+	ECraftingJobKind Kind = ECraftingJobKind::Craft;
+	/** Notified on completion. Jobs whose owner is gone by then are dropped. */
+	TWeakObjectPtr<UCraftingComponent> Owner;
+	/** The crafted or repaired item. */
+	int32 ItemId = INDEX_NONE;
+	int32 Quantity = 0;
+	/** Steps of the plan, crafts only. */
+	TArray<FCraftingStep> Steps;
+	/** Held items the plan consumed, crafts only. */
+	TMap<int32, int32> ConsumedItems;
+	/**
+	 * Every item taken out of the owner inventory for the job, tag ingredients resolved to their items: the
+	 * ingredients of a craft, the materials of a repair.
+	 */
+	TMap<int32, int32> TakenItems;
+	/** The repaired instance, repairs only. */
+	FItemHandle Instance;
+	/** World times in seconds. */
+	double StartTime = 0.0;
+	double CompletionTime = 0.0;
+};
+
+/** What a completed job creates, resolved on worker tasks before the game thread commits it. */
+struct FCraftingJobOutput
+{
+	/** Item id and size of each stack to create: the target, rounding leftovers of intermediates and byproducts. */
+	TArray<TPair<int32, int32>, TInlineAllocator<4>> Stacks;
+};
+
+/**
+ * Pending jobs in a binary min-heap by completion time, ties broken by job id so that equal times complete in
+ * start order. Pushing and popping are O(log n); cancelling is O(1), the heap entry of a cancelled job being skipped
+ * when it reaches the top, and the heap compacted once such entries outnumber the live jobs.
+ */
+class WARFALLCORE_API FCraftingJobQueue
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** @return The id given to the job, never 0. */
+	uint32 Push(FCraftingJob&& Job);
+	/**
+	 * @param OutJob If set, receives the cancelled job.
+	 * @return False if the job already completed or was cancelled.
+	 */
+	bool Cancel(const uint32 JobId, FCraftingJob* OutJob = nullptr);
+	void Reset();
+
+	/**
+	 * Takes the jobs whose completion time passed, earliest first.
+	 *
+	 * @param Now Current world time in seconds.
+	 * @param MaxJobs Maximum number of jobs taken, the others staying queued.
+	 * @param OutJobs Receives the jobs.
+	 * @return The number of jobs appended to OutJobs.
+	 */
+	int32 PopDue(const double Now, const int32 MaxJobs, TArray<FCraftingJob>& OutJobs);
+
+	/** @return True if a pending job is due. */
+	bool HasDue(const double Now);
+	const FCraftingJob* Find(const uint32 JobId) const { return Jobs.Find(JobId); }
+	/** Number of pending jobs. */
+	int32 Num() const { return Jobs.Num(); }
+
+	/**
+	 * Resolves the stacks a craft creates, from what its steps produce beyond what the following steps use.
+	 * Only reads the catalogs: safe on worker threads while the game thread does not rebuild them.
+	 */
+	static void ResolveOutput(const FCraftingJob& Job, const FRecipeCatalog& Recipes, const FItemCatalog& Items, FCraftingJobOutput& OutOutput);
+
+private:
+	struct FEntry
+	{
+		double CompletionTime = 0.0;
+		uint32 JobId = 0;
+	};
+	struct FEarlier
+	{
+		bool operator()(const FEntry& A, const FEntry& B) const
+		{
+			return A.CompletionTime < B.CompletionTime || (A.CompletionTime == B.CompletionTime && A.JobId < B.JobId);
+		}
+	};
+	/** Pops the entries of cancelled jobs off the top of the heap. */
+	void PruneTop();
+
+	// ========== VARIABLES ==========
+	TArray<FEntry> Heap;
+	TMap<uint32, FCraftingJob> Jobs;
+	uint32 NextJobId = 1;
+};
+
+// ===============================[ Crafting Job Subsystem ]============================
+
+/** Per-frame limits of UCraftingJobSubsystem. */
+struct FCraftingJobBudget
+{
+	/** Jobs completed per frame at most, the others waiting for the next frames. */
+	int32 MaxCompletionsPerFrame = 512;
+	/** Time after which a frame stops taking new batches, in milliseconds. A started batch always completes. */
+	double MaxMillisecondsPerFrame = 1.0;
+	/** Jobs resolved together on worker tasks before being committed. */
+	int32 BatchSize = 64;
+};
+
+struct FCraftingJobStats
+{
+	/** Pending jobs at the end of the last frame. */
+	int32 QueueDepth = 0;
+	int32 CompletedLastFrame = 0;
+	/** True if the budget left due jobs in the queue last frame. */
+	bool bBudgetExceeded = false;
+	/** Seconds between the completion time and the commit of the jobs of the last frame. */
+	double MeanLatency = 0.0;
+	double MaxLatency = 0.0;
+	double LastFrameMilliseconds = 0.0;
+	int64 TotalCompleted = 0;
+	/** Jobs whose owner or instance was gone at completion, and crafts refunded because their results fit nowhere. */
+	int64 TotalDropped = 0;
+};
+
+/**
+ * Runs the timed crafts and repairs of a world, for every player and workstation at once.
+ * Each frame takes the due jobs in batches: the stacks of a batch are resolved on worker tasks, then committed on
+ * the game thread in one pass, creating the instances, placing them in the owner inventories and notifying the
+ * owners. Batches stop on the budget, late jobs completing on the next frames. Ingredients are consumed when a job
+ * starts and refunded by the owner when it cancels the job; jobs only run on the server.
+ */
+UCLASS()
+class WARFALLCORE_API UCraftingJobSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	// ========== FUNCTIONS ==========
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Queues the craft of a plan whose ingredients were consumed.
+	 *
+	 * @param Owner Component notified on completion.
+	 * @param ItemId The crafted item.
+	 * @param Quantity How many of it.
+	 * @param Plan The complete plan.
+	 * @param TakenItems What consuming the plan took out of the inventory, refunded if the results cannot be placed.
+	 * @return The id of the job, 0 on failure.
+	 */
+	uint32 StartCraft(UCraftingComponent* Owner, const int32 ItemId, const int32 Quantity, const FCraftingPlan& Plan, TMap<int32, int32> TakenItems);
+	/**
+	 * Queues the repair of an instance whose materials were consumed, for the repair time of its item.
+	 *
+	 * @param TakenItems The materials consumed, refunded if the job is cancelled.
+	 * @return The id of the job, 0 if the item cannot be repaired.
+	 */
+	uint32 StartRepair(UCraftingComponent* Owner, const FItemHandle Instance, TMap<int32, int32> TakenItems);
+	/**
+	 * Cancels a pending job. Nothing is given back by the queue: the caller refunds the TakenItems of the job.
+	 *
+	 * @param OutJob If set, receives the cancelled job.
+	 */
+	bool CancelJob(const uint32 JobId, FCraftingJob* OutJob = nullptr) { return Queue.Cancel(JobId, OutJob); }
+	const FCraftingJob* FindJob(const uint32 JobId) const { return Queue.Find(JobId); }
+
+	/** @return The seconds a plan takes, the sum of CraftDuration over every batch. */
+	static double GetPlanDuration(const FCraftingPlan& Plan, const FRecipeCatalog& Recipes);
+
+	const FCraftingJobStats& GetStats() const { return Stats; }
+	FCraftingJobBudget& GetBudget() { return Budget; }
+
+private:
+	double GetNow() const;
+	/** Creates what a job produced, places it in the owner inventory and notifies the owner. Game thread. */
+	void CommitJob(const FCraftingJob& Job, const FCraftingJobOutput& Output, const FItemCatalog& Items);
+
+	// ========== VARIABLES ==========
+	FCraftingJobQueue Queue;
+	FCraftingJobBudget Budget;
+	FCraftingJobStats Stats;
+	/** Reused by every batch. */
+	TArray<FCraftingJob> DueJobs;
+	TArray<FCraftingJobOutput> Outputs;
+	TArray<FItemHandle> Created;
+};
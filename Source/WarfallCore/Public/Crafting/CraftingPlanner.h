@@ -0,0 +1,116 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Utils/DenseBitSet.h"
+
+struct FItemCatalog;
+struct FRecipeCatalog;
+
+// ===============================[ Crafting Planner ]============================
+
+/** One recipe of a plan, crafted a number of times in a row. */
+struct FCraftingStep
+{
+	int32 RecipeId = INDEX_NONE;
+	int32 Batches = 0;
+	/** The item the step is crafted for. Other results of the recipe are byproducts. */
+	int32 ItemId = INDEX_NONE;
+};
+
+/** Every craft needed to obtain an item from the holdings, intermediates included. */
+struct FCraftingPlan
+{
+	/** Steps in execution order: the ingredients of a step are crafted by the steps before it. */
+	TArray<FCraftingStep> Steps;
+	/** Held items the plan consumes, by item id. */
+	TMap<int32, int32> ConsumedItems;
+	/** Held quantities the plan consumes through ingredient tags, by tag slot of the recipe catalog. */
+	TMap<int32, int32> ConsumedTags;
+	/** Items neither held nor craftable, by item id. */
+	TMap<int32, int32> MissingItems;
+	/** Quantities of ingredient tags not held, by tag slot. */
+	TMap<int32, int32> MissingTags;
+	/** Total number of batches crafted. */
+	int32 NumCrafts = 0;
+	/** True if planning stopped on the node budget: the plan is incomplete. */
+	bool bBudgetExceeded = false;
+
+	bool IsComplete() const { return !bBudgetExceeded && MissingItems.IsEmpty() && MissingTags.IsEmpty(); }
+	void Reset();
+};
+
+/**
+ * Plans multi-level crafts over the recipe graph compiled by FRecipeCatalog.
+ * Build orders the recipes so that producers come before the recipes consuming their results, and sets aside the
+ * recipes caught in a cycle (a recipe producing one of its own ingredients, directly or through other recipes), which
+ * the planner never uses. Every craftable item then gets a level higher than the level of all the ingredients of its
+ * producers, so a plan is expanded level by level from the target down, each item being visited once however many
+ * recipes of the plan need it.
+ *
+ * The cheapest plan is the one crafting the fewest batches: held items are used first, and the rest is crafted with
+ * the producer needing the fewest batches per unit, raw materials counting for nothing. That choice is memoized per
+ * item across queries until the next build. When the plan it gives is incomplete, the other producers of the crafted
+ * items are tried, from the target down, keeping each one leaving less missing. Ingredient tags are only taken from the holdings, never crafted, and
+ * byproducts are not used by the following steps. Game thread only.
+ */
+class WARFALLCORE_API FCraftingPlanner
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Items expanded by a plan before it gives up, against deep or wide trees. */
+	static constexpr int32 DefaultNodeBudget = 4096;
+
+	/**
+	 * Compiles the recipe graph.
+	 *
+	 * @param InRecipes Recipe catalog, must outlive the planner or its next build.
+	 * @return The number of recipes set aside because they are caught in a cycle.
+	 */
+	int32 Build(const FRecipeCatalog& InRecipes);
+	void Reset();
+
+	/**
+	 * Plans crafting an item with everything below it.
+	 * The target itself is always crafted, even when some are held.
+	 *
+	 * @param ItemId The item to craft.
+	 * @param Quantity How many of it.
+	 * @param Holdings Quantity held per item id.
+	 * @param Items The item catalog, for the tags of the held items.
+	 * @param OutPlan Receives the plan, partial when it is not complete.
+	 * @param NodeBudget Maximum number of items expanded, the alternative producers included.
+	 * @return True if the plan is complete.
+	 */
+	bool Plan(const int32 ItemId, const int32 Quantity, const TMap<int32, int32>& Holdings, const FItemCatalog& Items, FCraftingPlan& OutPlan, const int32 NodeBudget = DefaultNodeBudget) const;
+
+	bool IsCyclic(const int32 RecipeId) const { return CyclicRecipes.IsValidIndex(RecipeId) && CyclicRecipes.Test(RecipeId); }
+	int32 NumCyclic() const { return NumCyclicRecipes; }
+	/** @return 0 for raw items, otherwise one more than the highest level of the ingredients of its producers. */
+	int32 GetLevel(const int32 ItemId) const { return Levels.IsValidIndex(ItemId) ? Levels[ItemId] : 0; }
+	/** @return The producer of the item needing the fewest batches per unit, INDEX_NONE for raw items. Memoized. */
+	int32 GetBestRecipe(const int32 ItemId) const;
+
+private:
+	/**
+	 * Expands the demand level by level from the target down, each crafted item with its producer in Choices or else
+	 * its best recipe.
+	 *
+	 * @param Budget Items left to expand, decremented by every item expanded.
+	 */
+	void Expand(const int32 ItemId, const int32 Quantity, const TMap<int32, int32>& Holdings, TConstArrayView<int32> TagCounts, const TMap<int32, int32>& Choices, int32& Budget, FCraftingPlan& OutPlan) const;
+	/** Marks the recipes of every strongly connected component of the dependency graph bigger than one recipe. */
+	void FindCycles(TArray<int32>& OutOrder);
+	/** @return The quantity of an item one batch of a recipe produces. */
+	int32 GetYield(const int32 RecipeId, const int32 ItemId) const;
+	/** Computes the batches per unit of an item and of every item below it, iteratively. */
+	void ComputeUnitCost(const int32 ItemId) const;
+
+	// ========== VARIABLES ==========
+	const FRecipeCatalog* Recipes = nullptr;
+	FDenseBitSet CyclicRecipes;
+	int32 NumCyclicRecipes = 0;
+	TArray<int32> Levels;
+	/** Batches per unit of each item, negative until computed. */
+	mutable TArray<double> UnitCosts;
+	mutable TArray<int32> BestRecipes;
+};
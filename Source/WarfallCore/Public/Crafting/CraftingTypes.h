@@ -24,6 +24,10 @@ struct FItemIngredient
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FItemRowHandle Ingredient;
+
+	/** When set, any item carrying this tag, as a tag or as its IngredientsType, is accepted instead of Ingredient. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Categories = "Ingredients"))
+	FGameplayTag IngredientsType;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int32 Quantity;
@@ -68,23 +72,35 @@ struct FRecipeRow
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	TArray<FItemResult> Results;
 
+	/** Seconds one batch takes to craft, 0 for crafts completing on the next frame. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0.0f, Units = "s"))
+	float CraftDuration;
+
 	FRecipeRow() :
 	 Name(FText::GetEmpty())
 	,Description(FText::GetEmpty())	
+	,CraftDuration(0.0f)
 	{}
 
-	TArray<FItemMetaEntry> OutMeta(const int32 Index) const
-	{
-		const UDataTable* Table = UTables::GetTable(ETablePath::ItemsTable);
-		if (!Table) { return TArray<FItemMetaEntry>(); }
-		const FName ID = Results[Index].Result.ID;
-		if (!ID.IsValid()) { return TArray<FItemMetaEntry>(); }
-
-		FItemRowDetail* RowDetail = Table->FindRow<FItemRowDetail>(ID, TEXT("Finding"));
-		if (!RowDetail) { return TArray<FItemMetaEntry>(); }
+	/**
+	 * Meta entries of the item of a result, viewed in the detail columns of the item catalog: neither table is loaded,
+	 * cooked catalog included, and nothing is copied.
+	 * Code knowing the recipe id should prefer FRecipeCatalog::GetResultMeta, baked at build without any lookup. Its
+	 * index is not this one, see FRecipeCatalog::FindResultIndex.
+	 *
+	 * @param Index Index of the result in Results, as authored.
+	 */
+	WARFALLCORE_API TConstArrayView<FItemMetaEntry> OutMeta(const int32 Index) const;
+};
+USTRUCT(BlueprintType)
+struct WARFALLCORE_API FRecipeRowDetail : public FTableRowBase
+{
+	GENERATED_BODY()
 
-		return RowDetail->Details.MetaModifiers;
-	};
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FRecipeRow Details;
 
-	TArray<
-};
\ No newline at end of file
+	FRecipeRowDetail() :
+	 Details(FRecipeRow())
+	{}
+};
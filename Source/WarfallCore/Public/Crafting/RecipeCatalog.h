@@ -0,0 +1,282 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Crafting/CraftingPlanner.h"
+#include "Inventory/ItemRowTypes.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "RecipeCatalog.generated.h"
+
+class FCookedItemCatalog;
+struct FDataTableRowHandle;
+struct FItemCatalog;
+struct FRecipeRow;
+
+// ===============================[ Recipe Catalog ]============================
+
+/** A recipe the holdings can craft. */
+struct FCraftableRecipe
+{
+	int32 RecipeId = INDEX_NONE;
+	/** Number of times in a row the recipe can be crafted with the holdings. */
+	int32 MaxBatches = 0;
+};
+
+/** A flattened ingredient of a compiled recipe: either an item id or an ingredient tag slot. */
+struct FRecipeIngredient
+{
+	/** The item, INDEX_NONE for tag ingredients and unknown items. */
+	int32 ItemId = INDEX_NONE;
+	/** Slot of the ingredient tag in the catalog, INDEX_NONE for item ingredients. */
+	int32 TagSlot = INDEX_NONE;
+	int32 Quantity = 1;
+};
+
+static_assert(sizeof(FRecipeIngredient) == 12, "FRecipeIngredient is part of the cooked catalog format.");
+
+/** A result of a compiled recipe. */
+struct FRecipeResult
+{
+	int32 ItemId = INDEX_NONE;
+	int32 Quantity = 1;
+};
+
+static_assert(sizeof(FRecipeResult) == 8, "FRecipeResult is part of the cooked catalog format.");
+
+/**
+ * Compiled, read-only view over RecipesTable, resolved against the item catalog.
+ * Ingredients are flattened to item ids or ingredient tags, and every item id and ingredient tag keeps the list of
+ * the recipes using it. Finding what an inventory can craft then only visits the recipes using something it holds,
+ * whatever the size of the table.
+ * A catalog built from a cooked file reads its ingredients and results on the mapped pages and holds no row.
+ */
+struct WARFALLCORE_API FRecipeCatalog
+{
+	// ========== FUNCTIONS ==========
+public:
+	/**
+	 * Compiles the catalog from the given table. Ids follow the order of the table rows.
+	 * Ingredients whose item is not in the item catalog are reported and make their recipe uncraftable.
+	 *
+	 * @param InTable Table whose row struct must be FRecipeRowDetail. The catalog is left empty otherwise.
+	 * @param Items The item catalog the ingredients are resolved against.
+	 */
+	void Build(const UDataTable* InTable, const FItemCatalog& Items);
+	/**
+	 * Binds the catalog on the recipes section of a cooked file. Only the reverse indexes are rebuilt.
+	 *
+	 * @param Cooked Opened cooked catalog, which must outlive this catalog or its next build.
+	 * @param Items The item catalog bound on the same file.
+	 * @param InTablePath The table the recipes were cooked from, so that row handles on it still resolve.
+	 * @return False if the file holds no recipes.
+	 */
+	bool BuildFromCooked(const FCookedItemCatalog& Cooked, const FItemCatalog& Items, const FSoftObjectPath& InTablePath = FSoftObjectPath());
+	/**
+	 * Applies item row patches that kept the id range, only visiting the recipes referencing the patched ids through
+	 * the reverse indexes. The baked meta of edited results is refreshed; recipes referencing removed items are
+	 * resolved again as Build would, the ingredient becoming unknown and the result being left out. Recipe ids are kept.
+	 *
+	 * @param ItemIds The patched item ids, all below GetNumItems.
+	 * @param Items The patched item catalog.
+	 * @return True if ingredients or results changed, the planner then having to be built again.
+	 */
+	bool PatchItems(TConstArrayView<int32> ItemIds, const FItemCatalog& Items);
+	/** Releases every compiled entry. */
+	void Reset();
+
+	/** @return The id of a recipe row, or INDEX_NONE if the row is unknown. */
+	int32 FindId(const FName RowName) const
+	{
+		const int32* Id = RowIds.Find(RowName);
+		return Id ? *Id : INDEX_NONE;
+	}
+	bool IsValidId(const int32 Id) const { return Id >= 0 && Id < NumRecipes; }
+	/**
+	 * @return The id of the recipe a row handle points at, or INDEX_NONE if the row is unknown or of another table.
+	 * Handles without table are matched by row name.
+	 */
+	int32 FindId(const FDataTableRowHandle& Recipe) const;
+	/** @return A row handle on a recipe, without table while a cooked catalog has not seen its table loaded. */
+	FDataTableRowHandle MakeHandle(const int32 Id) const;
+	/** @return The row of a recipe, nullptr for catalogs built from a cooked file. */
+	const FRecipeRow* FindRow(const int32 Id) const { return Rows.IsValidIndex(Id) ? Rows[Id] : nullptr; }
+	FName GetRowName(const int32 Id) const { return RowNames.IsValidIndex(Id) ? RowNames[Id] : NAME_None; }
+	int32 Num() const { return NumRecipes; }
+	bool IsEmpty() const { return NumRecipes == 0; }
+
+	/** @return The recipes having the item as a named ingredient, by increasing id. */
+	TConstArrayView<int32> GetRecipesUsingItem(const int32 ItemId) const;
+	/** @return The recipes having the tag as an ingredient, by increasing id. Parents of the tag are not included. */
+	TConstArrayView<int32> GetRecipesUsingTag(const FGameplayTag& Tag) const;
+	TConstArrayView<int32> GetRecipesUsingTagSlot(const int32 TagSlot) const { return TagRecipes.IsValidIndex(TagSlot) ? TConstArrayView<int32>(TagRecipes[TagSlot]) : TConstArrayView<int32>(); }
+	/** @return The ingredients of a recipe, the same item or tag listed twice being merged. */
+	TConstArrayView<FRecipeIngredient> GetIngredients(const int32 RecipeId) const
+	{
+		if (!IsValidId(RecipeId)) return TConstArrayView<FRecipeIngredient>();
+		return TConstArrayView<FRecipeIngredient>(IngredientData + IngredientStartData[RecipeId], IngredientStartData[RecipeId + 1] - IngredientStartData[RecipeId]);
+	}
+	/** Distinct ingredient tags of every recipe, a tag slot being an index in this list. */
+	TConstArrayView<FGameplayTag> GetIngredientTags() const { return IngredientTags; }
+	/** @return The results of a recipe, unknown items left out and the same item listed twice being merged. */
+	TConstArrayView<FRecipeResult> GetResults(const int32 RecipeId) const
+	{
+		if (!IsValidId(RecipeId)) return TConstArrayView<FRecipeResult>();
+		return TConstArrayView<FRecipeResult>(ResultData + ResultStartData[RecipeId], ResultStartData[RecipeId + 1] - ResultStartData[RecipeId]);
+	}
+	/** @return The seconds one batch of a recipe takes, FRecipeRow::CraftDuration. */
+	float GetCraftDuration(const int32 RecipeId) const { return IsValidId(RecipeId) ? CraftDurationData[RecipeId] : 0.0f; }
+	/**
+	 * @return The index in GetResults of the result producing the item, or INDEX_NONE.
+	 * GetResults merges the entries of FRecipeRow::Results listing the same item and drops the unknown items, so an
+	 * index in the row does not address GetResults: map it through the item of the row entry.
+	 */
+	int32 FindResultIndex(const int32 RecipeId, const int32 ItemId) const
+	{
+		return GetResults(RecipeId).IndexOfByPredicate([ItemId](const FRecipeResult& Result) { return Result.ItemId == ItemId; });
+	}
+	/**
+	 * @param RecipeId The recipe.
+	 * @param Index Index of the result in GetResults, not in FRecipeRow::Results, see FindResultIndex.
+	 * @return The meta entries of the item of a result, baked at build: no table access and no copy.
+	 */
+	TConstArrayView<FItemMetaEntry> GetResultMeta(const int32 RecipeId, const int32 Index) const
+	{
+		if (!IsValidId(RecipeId) || Index < 0 || Index >= ResultStartData[RecipeId + 1] - ResultStartData[RecipeId]) return TConstArrayView<FItemMetaEntry>();
+		const TPair<int32, int32>& Span = ResultMetaSpans[ResultStartData[RecipeId] + Index];
+		return TConstArrayView<FItemMetaEntry>(ResultMeta.GetData() + Span.Key, Span.Value);
+	}
+	/** @return The recipes having the item as a result, by increasing id. */
+	TConstArrayView<int32> GetRecipesProducing(const int32 ItemId) const;
+	/** @return The number of item ids the recipes were resolved against. */
+	int32 GetNumItems() const { return FMath::Max(ProducerStarts.Num() - 1, 0); }
+
+	/** Sums the holdings matching each ingredient tag, one entry per tag slot. */
+	void CountTags(const TMap<int32, int32>& Holdings, const FItemCatalog& Items, TArray<int32>& OutTagCounts) const;
+
+	/**
+	 * Finds every recipe the holdings can craft at least once.
+	 * Costs one lookup per held item and ingredient tag, plus one check per recipe using something held.
+	 *
+	 * @param Holdings Quantity held per item id.
+	 * @param Items The item catalog the ids belong to, for the tags of the held items.
+	 * @param OutCraftable Receives the recipes by increasing id, with how many times each can be crafted.
+	 */
+	void FindCraftable(const TMap<int32, int32>& Holdings, const FItemCatalog& Items, TArray<FCraftableRecipe>& OutCraftable) const;
+	/**
+	 * Counts how many times in a row a recipe can be crafted. Each ingredient is checked on its own: an item matching
+	 * several ingredients of the recipe, by name and by tag, counts for each of them.
+	 *
+	 * @return The number of batches, 0 if the recipe is unknown or has no ingredient.
+	 */
+	int32 GetMaxBatches(const int32 RecipeId, const TMap<int32, int32>& Holdings, const FItemCatalog& Items) const;
+
+	/** Flat arrays of the catalog, as written into the cooked file. */
+	TConstArrayView<int32> GetRawIngredientStarts() const { return TConstArrayView<int32>(IngredientStartData, NumRecipes > 0 ? NumRecipes + 1 : 0); }
+	TConstArrayView<FRecipeIngredient> GetRawIngredients() const { return TConstArrayView<FRecipeIngredient>(IngredientData, NumRecipes > 0 ? IngredientStartData[NumRecipes] : 0); }
+	TConstArrayView<int32> GetRawResultStarts() const { return TConstArrayView<int32>(ResultStartData, NumRecipes > 0 ? NumRecipes + 1 : 0); }
+	TConstArrayView<FRecipeResult> GetRawResults() const { return TConstArrayView<FRecipeResult>(ResultData, NumRecipes > 0 ? ResultStartData[NumRecipes] : 0); }
+	TConstArrayView<float> GetCraftDurations() const { return TConstArrayView<float>(CraftDurationData, NumRecipes); }
+
+	/** @return True if the catalog reads a cooked file, which patches cannot edit. */
+	bool IsExternal() const { return NumRecipes > 0 && IngredientData != Ingredients.GetData(); }
+
+	/** Incremented on each build, so that cached queries can detect that ids were reassigned. */
+	uint32 GetRevision() const { return Revision; }
+	/** @return The compiled table, or the table a cooked catalog comes from when it is loaded. */
+	const UDataTable* GetTable() const;
+	const FSoftObjectPath& GetTablePath() const { return TablePath; }
+
+private:
+	/** Builds everything derived from the flat arrays: tag users, baked result meta and reverse item indexes. */
+	void BuildIndexes(const FItemCatalog& Items);
+	/** Points the results of an item to its new meta entries, in place when they are not longer than before. */
+	void RefreshResultMeta(const int32 ItemId, TConstArrayView<FItemMetaEntry> Meta);
+	int32 ComputeBatches(const int32 RecipeId, const TMap<int32, int32>& Holdings, TConstArrayView<int32> TagCounts) const;
+
+	// ========== VARIABLES ==========
+	const UDataTable* Table = nullptr;
+	/** Path of the table, kept by cooked catalogs which never load it. */
+	FSoftObjectPath TablePath;
+	TArray<FName> RowNames;
+	TArray<const FRecipeRow*> Rows;
+	TMap<FName, int32> RowIds;
+	/** Ingredients of recipe Id are Ingredients[IngredientStarts[Id], IngredientStarts[Id + 1]). */
+	TArray<int32> IngredientStarts;
+	TArray<FRecipeIngredient> Ingredients;
+	/** Recipes using item Id are ItemRecipes[ItemRecipeStarts[Id], ItemRecipeStarts[Id + 1]). */
+	TArray<int32> ItemRecipeStarts;
+	TArray<int32> ItemRecipes;
+	/** Results of recipe Id are Results[ResultStarts[Id], ResultStarts[Id + 1]). */
+	TArray<int32> ResultStarts;
+	TArray<FRecipeResult> Results;
+	TArray<float> CraftDurations;
+	/** Read pointers, either on the arrays above or on a cooked file. */
+	const int32* IngredientStartData = nullptr;
+	const FRecipeIngredient* IngredientData = nullptr;
+	const int32* ResultStartData = nullptr;
+	const FRecipeResult* ResultData = nullptr;
+	const float* CraftDurationData = nullptr;
+	int32 NumRecipes = 0;
+	/** Start and length in ResultMeta of the meta entries of each entry of Results, shared by the results of an item. */
+	TArray<TPair<int32, int32>> ResultMetaSpans;
+	TArray<FItemMetaEntry> ResultMeta;
+	/** Recipes producing item Id are ProducerRecipes[ProducerStarts[Id], ProducerStarts[Id + 1]). */
+	TArray<int32> ProducerStarts;
+	TArray<int32> ProducerRecipes;
+	/** Distinct ingredient tags, their slot being their index. */
+	TArray<FGameplayTag> IngredientTags;
+	TMap<FGameplayTag, int32> TagSlots;
+	/** Recipes using each ingredient tag, by slot. */
+	TArray<TArray<int32>> TagRecipes;
+	uint32 Revision = 0;
+};
+
+// ===============================[ Recipe Catalog Subsystem ]============================
+
+/**
+ * Owns the recipe catalog for the whole engine lifetime.
+ * The catalog is compiled from RecipesTable once the item catalog is available, and compiled again whenever either
+ * table changes, since ingredients are resolved to item ids. When the item catalog is mapped from a cooked file holding
+ * the recipes, the catalog is bound on that file instead and RecipesTable is never loaded.
+ */
+UCLASS()
+class WARFALLCORE_API URecipeCatalogSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+	DECLARE_MULTICAST_DELEGATE(FOnRecipesRebuilt);
+
+	// ========== FUNCTIONS ==========
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** @return The subsystem instance, or nullptr before the engine is initialized. */
+	static URecipeCatalogSubsystem* Get();
+	/** @return The compiled catalog, or nullptr when the subsystem is unavailable or the table failed to load. */
+	static const FRecipeCatalog* GetCatalog();
+
+	const FRecipeCatalog& GetRecipes() const { return Catalog; }
+	/** @return The planner compiled from the catalog, rebuilt with it. */
+	const FCraftingPlanner& GetPlanner() const { return Planner; }
+
+	/** Recompiles the catalog from RecipesTable, or binds it on the cooked file, and notifies the listeners. */
+	void Rebuild();
+
+	/** Broadcast after every rebuild. Previously resolved recipe ids must be considered stale. */
+	FOnRecipesRebuilt OnRecipesRebuilt;
+
+private:
+	void BindTable(UDataTable* NewTable);
+	void HandleItemRowsPatched(TConstArrayView<int32> Ids);
+
+	// ========== VARIABLES ==========
+	UPROPERTY()
+	UDataTable* RecipesTable = nullptr;
+
+	FRecipeCatalog Catalog;
+	FCraftingPlanner Planner;
+	FDelegateHandle TableChangedHandle;
+	FDelegateHandle ItemsRebuiltHandle;
+	FDelegateHandle ItemsPatchedHandle;
+};
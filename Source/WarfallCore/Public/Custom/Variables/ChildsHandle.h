@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "BaseHandle.h"
+#include "Utils/DenseBitSet.h"
 #include "ChildsHandle.generated.h"
 
 // ===============================[ Property Customization Factory ]============================
@@ -56,4 +57,10 @@ public:
 	virtual bool GetFilterConditions(const FName RowName, const FName HandleTag) const override;
 	virtual ETablePath GetDataTable() override;
 	virtual FString DefaultFilter() const override;
+
+private:
+	/** Rows matching the handle tag, resolved once per tag and catalog revision through the tag index. */
+	mutable FDenseBitSet CachedMatches;
+	mutable FName CachedTag = NAME_None;
+	mutable uint32 CachedRevision = 0;
 };
\ No newline at end of file
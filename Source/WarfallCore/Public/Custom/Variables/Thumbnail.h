@@ -101,9 +101,10 @@ public:
 
 	UMaterialInstanceDynamic* CreateMaterial()
 	{
-		if (!UGlobalTools::GetMaterial(EMaterialPath::Thumbnail) || !Thumbnail) return nullptr;
+		UMaterialInterface* ThumbnailMaterial = UGlobalTools::GetMaterial(EMaterialPath::Thumbnail);
+		if (!ThumbnailMaterial || !Thumbnail) return nullptr;
 		
-		UMaterialInstanceDynamic* NewMaterial = UMaterialInstanceDynamic::Create(UGlobalTools::GetMaterial(EMaterialPath::Thumbnail), nullptr);
+		UMaterialInstanceDynamic* NewMaterial = UMaterialInstanceDynamic::Create(ThumbnailMaterial, nullptr);
 		UTexture2D* LoadThumbnail = Thumbnail.LoadSynchronous();
 		UTexture2D* LoadLayer = Layer.LoadSynchronous();
 		NewMaterial->SetTextureParameterValue("Icon", LoadThumbnail);
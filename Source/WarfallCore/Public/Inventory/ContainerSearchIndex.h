@@ -0,0 +1,160 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Inventory/ItemCapabilities.h"
+#include "Inventory/ItemRowTypes.h"
+#include "Utils/DenseBitSet.h"
+
+class FItemInstanceStore;
+struct FItemCatalog;
+
+// ===============================[ Container Search Index ]============================
+
+/** What a search of container content selects. Every criterion set must hold. */
+struct FContainerSearchQuery
+{
+	/** Capabilities every result has, such as CanPerish for perishables or Weapon for weapons. */
+	EItemCapability Capabilities = EItemCapability::None;
+	/** Tags every result carries, parents included. */
+	FGameplayTagContainer Tags;
+	int32 MinQuality = MIN_int32;
+	int32 MaxQuality = MAX_int32;
+	/** Words, each of which must start a word of the result name, case insensitive. */
+	FString Text;
+};
+
+enum class EContainerSortKey : uint8
+{
+	/** Local slot order, close to the order in which the instances entered the container. */
+	None,
+	Name,
+	Quality,
+	/** Read from the store when the query runs: a stack change alone does not sort the view again. */
+	Stack,
+};
+
+/**
+ * Search index of the instances directly held by one container.
+ * Instances get a local slot, and every searchable key (capability bit, tag and its parents, quality, name word) keeps
+ * the bitset of the slots having it, so a query is a handful of bitset intersections over the content of the
+ * container, without reading any row. The keys of an item are derived once per item id while instances of it are
+ * held. Inserting or removing an instance sets or clears its bits only.
+ */
+class WARFALLCORE_API FContainerSearchIndex
+{
+	// ========== FUNCTIONS ==========
+public:
+	/**
+	 * Indexes an instance.
+	 *
+	 * @param Handle The instance, not indexed yet.
+	 * @param ItemId Catalog id of its item.
+	 * @param Catalog The item catalog.
+	 * @return False if the instance is already indexed or the item unknown.
+	 */
+	bool Insert(const FItemHandle Handle, const int32 ItemId, const FItemCatalog& Catalog);
+	/** @return False if the instance was not indexed. Its slot is reused by the next insertion. */
+	bool Remove(const FItemHandle Handle);
+	/** Indexes an instance again, after it turned into another item. */
+	bool Update(const FItemHandle Handle, const int32 ItemId, const FItemCatalog& Catalog);
+	void Reset();
+
+	bool Contains(const FItemHandle Handle) const { return Slots.Contains(Handle); }
+	int32 Num() const { return Slots.Num(); }
+	/** Incremented by every change, so that views can tell when to run their query again. */
+	uint32 GetRevision() const { return Revision; }
+
+	/**
+	 * Selects the instances matching a query.
+	 *
+	 * @param Query The criteria.
+	 * @param OutSlots Receives one bit per local slot.
+	 */
+	void Select(const FContainerSearchQuery& Query, FDenseBitSet& OutSlots) const;
+
+	/**
+	 * Selects and sorts the instances matching a query. Only the matching instances are sorted.
+	 *
+	 * @param Query The criteria.
+	 * @param Store Store of the instances, for live values such as the stack.
+	 * @param SortKey The order.
+	 * @param bDescending True to reverse the order.
+	 * @param OutResults Receives the instances.
+	 */
+	void Search(const FContainerSearchQuery& Query, const FItemInstanceStore& Store, const EContainerSortKey SortKey, const bool bDescending, TArray<FItemHandle>& OutResults) const;
+
+	/** Splits a name into lower case words, on every character that is neither a letter nor a digit. */
+	static void Tokenize(const FString& Text, TArray<FString>& OutTokens);
+
+private:
+	/** Keys of an item, shared by its instances. */
+	struct FItemKeys
+	{
+		TArray<FGameplayTag> Tags;
+		TArray<FString> Tokens;
+		/** Lower case display name, the sort key. */
+		FString SortName;
+		uint32 Capabilities = 0;
+		int32 Quality = 0;
+		int32 NumInstances = 0;
+	};
+
+	struct FEntry
+	{
+		FItemHandle Handle;
+		int32 ItemId = INDEX_NONE;
+	};
+
+	/** Derives the keys of an item from its row, or from the catalog postings when it has no rows. */
+	static void BuildKeys(const FItemCatalog& Catalog, const int32 ItemId, FItemKeys& OutKeys);
+	/** Sets or clears the bits of a slot under every key of an item. */
+	void ApplyKeys(const FItemKeys& Keys, const int32 Slot, const bool bValue);
+	static void SetBit(FDenseBitSet& Postings, const int32 Slot, const bool bValue);
+
+	// ========== VARIABLES ==========
+	TArray<FEntry> Entries;
+	TArray<int32> FreeSlots;
+	TMap<FItemHandle, int32> Slots;
+	TMap<int32, FItemKeys> ItemKeys;
+	FDenseBitSet Live;
+	/** One posting per bit of EItemCapability. */
+	FDenseBitSet CapabilityPostings[32];
+	TMap<FGameplayTag, FDenseBitSet> TagPostings;
+	TMap<int32, FDenseBitSet> QualityPostings;
+	TMap<FString, FDenseBitSet> TokenPostings;
+	uint32 Revision = 0;
+};
+
+/**
+ * Sorted result of a search, read page by page.
+ * The query only runs again when the container changed, so paging through a large storage costs a copy per page.
+ */
+class WARFALLCORE_API FContainerSearchView
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Changes the query or order; the next Refresh runs it. */
+	void SetQuery(const FContainerSearchQuery& InQuery, const EContainerSortKey InSortKey, const bool bInDescending);
+	/**
+	 * Runs the query if the index changed since the last run.
+	 *
+	 * @return True if the results changed.
+	 */
+	bool Refresh(const FContainerSearchIndex& Index, const FItemInstanceStore& Store);
+
+	int32 Num() const { return Results.Num(); }
+	int32 GetNumPages(const int32 PageSize) const { return PageSize > 0 ? FMath::DivideAndRoundUp(Results.Num(), PageSize) : 0; }
+	/** @return The results of one page, empty past the last one. */
+	TConstArrayView<FItemHandle> GetPage(const int32 Page, const int32 PageSize) const;
+
+private:
+	// ========== VARIABLES ==========
+	FContainerSearchQuery Query;
+	TArray<FItemHandle> Results;
+	EContainerSortKey SortKey = EContainerSortKey::None;
+	bool bDescending = false;
+	bool bDirty = true;
+	const FContainerSearchIndex* Source = nullptr;
+	uint32 SourceRevision = 0;
+};
@@ -0,0 +1,148 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/ItemRowTypes.h"
+
+// ===============================[ Container Tree ]============================
+
+/** What an instance weighs and occupies, as seen by the container holding it. */
+struct FContainedItem
+{
+	/** Mass of the whole stack, without its content. */
+	double Mass = 0.0;
+	/** Cells taken in the container holding the instance. */
+	int32 Cells = 0;
+	/** Cells offered to the instances held, 0 for items that are not containers. */
+	int32 Capacity = 0;
+};
+
+/**
+ * Nesting of item instances inside containers, with the aggregates of every subtree kept up to date.
+ * Each node caches the mass of its subtree and the cells used by its direct content. Adding, moving, removing or
+ * updating an instance applies its mass difference to its ancestors only, so the mass carried by a root or an owner is
+ * read in O(1) and maintained in O(depth), whatever the number of instances nested below.
+ * Roots can be given an owner, typically an inventory, whose total mass is maintained the same way.
+ */
+class WARFALLCORE_API FItemContainerTree
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Removes every instance and owner. */
+	void Reset();
+
+	/**
+	 * Adds an instance to the tree.
+	 *
+	 * @param Handle The instance, not in the tree yet.
+	 * @param Parent Container of the instance, already in the tree, or an invalid handle for a root.
+	 * @param Item Mass and cells of the instance.
+	 * @return False if the instance is already in the tree or the parent is not.
+	 */
+	bool Insert(const FItemHandle Handle, const FItemHandle Parent, const FContainedItem& Item);
+	/**
+	 * Removes an instance. Its content moves to its parent; the content of a root becomes roots of the owner of the
+	 * removed instance, so that the mass an inventory carries only drops by the mass of the instance itself.
+	 *
+	 * @param Handle The instance.
+	 * @param OutContent Receives the instances that were directly held, to update their container.
+	 * @return False if the instance is not in the tree.
+	 */
+	bool Remove(const FItemHandle Handle, TArray<FItemHandle>* OutContent = nullptr);
+	/**
+	 * Moves an instance and its content to another container. A root leaves its owner.
+	 *
+	 * @param Handle The instance.
+	 * @param NewParent The container, or an invalid handle to make the instance a root.
+	 * @return False if either is not in the tree or the container is inside the instance.
+	 */
+	bool Move(const FItemHandle Handle, const FItemHandle NewParent);
+	/** Applies a new mass, footprint or capacity, after a stack change or a transformation of the item. */
+	bool Update(const FItemHandle Handle, const FContainedItem& Item);
+
+	/** @return A new owner, with no roots. */
+	int32 AddOwner();
+	/**
+	 * Releases an owner. Roots it still has, such as the content of a held bag that was destroyed, are left without
+	 * owner, at the cost of one pass over the nodes when any is left.
+	 */
+	void RemoveOwner(const int32 Owner);
+	/**
+	 * Gives a root to an owner, whose mass then includes the subtree of the root.
+	 *
+	 * @param Handle A root of the tree.
+	 * @param Owner The owner, INDEX_NONE to clear it.
+	 * @return False if the instance is not a root or the owner is unknown.
+	 */
+	bool SetOwner(const FItemHandle Handle, const int32 Owner);
+	/** @return The mass of every subtree of an owner, 0 for unknown owners. */
+	double GetOwnerMass(const int32 Owner) const { return OwnerMasses.IsValidIndex(Owner) ? OwnerMasses[Owner] : 0.0; }
+
+	bool Contains(const FItemHandle Handle) const
+	{
+		const int32 Index = static_cast<int32>(Handle.GetIndex());
+		return Handle.IsValid() && Nodes.IsValidIndex(Index) && Nodes[Index].Handle == Handle.GetValue();
+	}
+	/** @return The container holding an instance, invalid for roots. */
+	FItemHandle GetParent(const FItemHandle Handle) const;
+	/** @return The outermost container of an instance, the instance itself for roots. O(depth). */
+	FItemHandle GetRoot(const FItemHandle Handle) const;
+	/** @return The number of containers above an instance, 0 for roots. */
+	int32 GetDepth(const FItemHandle Handle) const;
+
+	/** @return The mass of an instance and everything it holds, 0 if not in the tree. */
+	double GetMass(const FItemHandle Handle) const { return Contains(Handle) ? Nodes[Handle.GetIndex()].Mass : 0.0; }
+	/** @return The cells an instance takes in its container. */
+	int32 GetCells(const FItemHandle Handle) const { return Contains(Handle) ? Nodes[Handle.GetIndex()].Cells : 0; }
+	/** @return The cells taken by the instances directly held. */
+	int32 GetUsedCells(const FItemHandle Handle) const { return Contains(Handle) ? Nodes[Handle.GetIndex()].UsedCells : 0; }
+	int32 GetCapacity(const FItemHandle Handle) const { return Contains(Handle) ? Nodes[Handle.GetIndex()].Capacity : 0; }
+	int32 GetFreeCells(const FItemHandle Handle) const { return FMath::Max(GetCapacity(Handle) - GetUsedCells(Handle), 0); }
+
+	/** Calls Function(FItemHandle) for every instance directly held by a container. The tree must not change meanwhile. */
+	template <typename FunctionType>
+	void ForEachContent(const FItemHandle Handle, FunctionType&& Function) const
+	{
+		if (!Contains(Handle)) return;
+
+		for (int32 Child = Nodes[Handle.GetIndex()].FirstChild; Child != INDEX_NONE; Child = Nodes[Child].NextSibling)
+		{
+			Function(FItemHandle::FromValue(Nodes[Child].Handle));
+		}
+	}
+
+	/** Number of instances in the tree. */
+	int32 Num() const { return NumNodes; }
+
+private:
+	/** One instance slot, with the links to its parent and siblings. */
+	struct FNode
+	{
+		/** Mass of the subtree. Kept in double so that long sequences of deltas do not drift. */
+		double Mass = 0.0;
+		double SelfMass = 0.0;
+		/** Handle value of the instance, 0 when the slot is not in the tree. */
+		uint32 Handle = 0;
+		int32 Parent = INDEX_NONE;
+		int32 FirstChild = INDEX_NONE;
+		int32 PrevSibling = INDEX_NONE;
+		int32 NextSibling = INDEX_NONE;
+		/** Owner of a root, INDEX_NONE otherwise. */
+		int32 Owner = INDEX_NONE;
+		int32 Cells = 0;
+		int32 UsedCells = 0;
+		int32 Capacity = 0;
+	};
+
+	/** Adds a mass difference to a node, its ancestors and the owner of its root. */
+	void AddMass(int32 Index, const double Delta);
+	/** Puts a detached node under a parent, or leaves it a root for INDEX_NONE. */
+	void Link(const int32 Index, const int32 Parent);
+	/** Detaches a node from its parent or owner, along with its subtree. */
+	void Unlink(const int32 Index);
+
+	// ========== VARIABLES ==========
+	/** One node per instance slot, indexed by FItemHandle::GetIndex. */
+	TArray<FNode> Nodes;
+	TSparseArray<double> OwnerMasses;
+	int32 NumNodes = 0;
+};
@@ -0,0 +1,213 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+struct FCompiledMetaEntry;
+struct FCompiledModifier;
+struct FItemCatalog;
+struct FItemDetail;
+struct FRecipeCatalog;
+struct FRecipeIngredient;
+struct FRecipeResult;
+struct FRepairMaterial;
+
+// ===============================[ Cooked Item Catalog ]============================
+
+/**
+ * Header of a cooked item catalog file. Every section offset is relative to the start of the file and 64-byte aligned.
+ *
+ * Layout:
+ *   Header
+ *   Item names   : NumItems + 1 uint32 offsets into the following UTF-8 characters
+ *   Stats        : EItemStat::Num columns of StatStride floats
+ *   Stack sizes  : StatStride int32
+ *   Capabilities : NumItems uint32
+ *   Perish targets: NumItems int32 item ids, INDEX_NONE for items perishing into nothing
+ *   Tag names    : NumTags + 1 uint32 offsets into the following UTF-8 characters
+ *   Postings     : NumTags postings of WordsPerTag uint64
+ *   Name slots   : NumTags int32 name posting indices, INDEX_NONE for slots matched by name through their posting
+ *   Name postings: NumNamePostings postings of WordsPerTag uint64
+ *   Modifier keys: NumModifierKeys + 1 uint32 offsets into the following UTF-8 characters
+ *   Modifier ranges: NumItems + 1 uint32 offsets into the modifier ops
+ *   Modifier ops : NumModifierOps FCompiledModifier
+ *   Display names: NumItems + 1 uint32 offsets into the following UTF-8 characters
+ *   Details      : NumItems FItemDetail
+ *   Repair ranges: NumItems + 1 uint32 offsets into the repair materials
+ *   Repair materials: NumRepairMaterials FRepairMaterial
+ *   Meta keys    : NumMetaKeys + 1 uint32 offsets into the following UTF-8 characters
+ *   Meta ranges  : NumItems + 1 uint32 offsets into the meta entries
+ *   Meta entries : NumMetaEntries FCompiledMetaEntry
+ *   Recipes      : RecipesSize bytes, an FCookedRecipesHeader and its sections; 0 bytes when no recipe was compiled
+ */
+struct FCookedItemCatalogHeader
+{
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 NumItems = 0;
+	int32 StatStride = 0;
+	int32 NumStats = 0;
+	int32 NumTags = 0;
+	int32 WordsPerTag = 0;
+	int32 NumModifierKeys = 0;
+	int32 NumModifierOps = 0;
+	int32 NumNamePostings = 0;
+	int32 NumRepairMaterials = 0;
+	int32 NumMetaKeys = 0;
+	int32 NumMetaEntries = 0;
+	int32 Padding = 0;
+	uint64 ItemNamesOffset = 0;
+	uint64 StatsOffset = 0;
+	uint64 StackSizesOffset = 0;
+	uint64 CapabilitiesOffset = 0;
+	uint64 PerishTargetsOffset = 0;
+	uint64 TagNamesOffset = 0;
+	uint64 PostingsOffset = 0;
+	uint64 NameSlotsOffset = 0;
+	uint64 NamePostingsOffset = 0;
+	uint64 ModifierKeysOffset = 0;
+	uint64 ModifierRangesOffset = 0;
+	uint64 ModifierOpsOffset = 0;
+	uint64 DisplayNamesOffset = 0;
+	uint64 DetailsOffset = 0;
+	uint64 RepairRangesOffset = 0;
+	uint64 RepairMaterialsOffset = 0;
+	uint64 MetaKeysOffset = 0;
+	uint64 MetaRangesOffset = 0;
+	uint64 MetaEntriesOffset = 0;
+	uint64 RecipesOffset = 0;
+	uint64 RecipesSize = 0;
+	uint64 FileSize = 0;
+};
+
+static_assert(sizeof(FCookedItemCatalogHeader) == 232, "The cooked catalog header is part of the file format, bump the version when changing it.");
+
+/**
+ * Header of the recipes section, the compiled FRecipeCatalog. Offsets are relative to the start of the file, 64-byte
+ * aligned, and every section lies within the recipes section.
+ *
+ * Layout:
+ *   Header
+ *   Recipe names      : NumRecipes + 1 uint32 offsets into the following UTF-8 characters
+ *   Ingredient starts : NumRecipes + 1 int32 offsets into the ingredients
+ *   Ingredients       : NumIngredients FRecipeIngredient
+ *   Result starts     : NumRecipes + 1 int32 offsets into the results
+ *   Results           : NumResults FRecipeResult
+ *   Craft durations   : NumRecipes float
+ *   Ingredient tags   : NumIngredientTags + 1 uint32 offsets into the following UTF-8 characters
+ */
+struct FCookedRecipesHeader
+{
+	int32 NumRecipes = 0;
+	int32 NumIngredients = 0;
+	int32 NumResults = 0;
+	int32 NumIngredientTags = 0;
+	uint64 RecipeNamesOffset = 0;
+	uint64 IngredientStartsOffset = 0;
+	uint64 IngredientsOffset = 0;
+	uint64 ResultStartsOffset = 0;
+	uint64 ResultsOffset = 0;
+	uint64 CraftDurationsOffset = 0;
+	uint64 IngredientTagNamesOffset = 0;
+};
+
+static_assert(sizeof(FCookedRecipesHeader) == 72, "The cooked recipes header is part of the file format, bump the version when changing it.");
+
+/**
+ * Read-only, memory-mapped image of the compiled item catalog.
+ * The file is written at cook time from the catalog built out of ItemsTable and the recipes compiled against it;
+ * servers map it at startup and bind the catalog columns directly on the mapped pages, so neither ItemsTable nor
+ * RecipesTable is loaded and the columns are not deserialized.
+ */
+class WARFALLCORE_API FCookedItemCatalog
+{
+	// ========== FUNCTIONS ==========
+public:
+	static constexpr uint32 FileMagic = 0x43494657; // "WFIC"
+	static constexpr uint32 FileVersion = 5;
+
+	FCookedItemCatalog();
+	~FCookedItemCatalog();
+
+	/** @return The location the cook writes the catalog to, staged next to the content as a non-UFS file. */
+	static FString GetDefaultPath();
+
+	/**
+	 * Serializes a compiled catalog.
+	 *
+	 * @param Catalog Catalog built from ItemsTable. Catalogs bound on a cooked file cannot be written back.
+	 * @param Recipes Recipes compiled against the catalog, or nullptr to leave the recipes section empty.
+	 * @param Path Destination file, overwritten.
+	 * @return True if the file was written.
+	 */
+	static bool Write(const FItemCatalog& Catalog, const FRecipeCatalog* Recipes, const FString& Path);
+
+	/**
+	 * Maps a cooked catalog file and validates its header and sections.
+	 *
+	 * @param Path File written by Write.
+	 * @return True if the file is mapped and every section lies within it.
+	 */
+	bool Open(const FString& Path);
+	void Close();
+	bool IsOpen() const { return Data != nullptr; }
+
+	const FCookedItemCatalogHeader& GetHeader() const { return *reinterpret_cast<const FCookedItemCatalogHeader*>(Data); }
+
+	FName GetItemName(const int32 Id) const { return ReadName(GetHeader().ItemNamesOffset, GetHeader().NumItems, Id); }
+	FName GetTagName(const int32 Slot) const { return ReadName(GetHeader().TagNamesOffset, GetHeader().NumTags, Slot); }
+	FName GetModifierKey(const int32 Slot) const { return ReadName(GetHeader().ModifierKeysOffset, GetHeader().NumModifierKeys, Slot); }
+	FName GetMetaKey(const int32 Slot) const { return ReadName(GetHeader().MetaKeysOffset, GetHeader().NumMetaKeys, Slot); }
+	FString GetDisplayName(const int32 Id) const { return ReadString(GetHeader().DisplayNamesOffset, GetHeader().NumItems, Id); }
+
+	const float* GetStats() const { return Section<float>(GetHeader().StatsOffset); }
+	const int32* GetStackSizes() const { return Section<int32>(GetHeader().StackSizesOffset); }
+	const uint32* GetCapabilities() const { return Section<uint32>(GetHeader().CapabilitiesOffset); }
+	const int32* GetPerishTargets() const { return Section<int32>(GetHeader().PerishTargetsOffset); }
+	const uint64* GetPostings() const { return Section<uint64>(GetHeader().PostingsOffset); }
+	const int32* GetNameSlots() const { return Section<int32>(GetHeader().NameSlotsOffset); }
+	const uint64* GetNamePostings() const { return Section<uint64>(GetHeader().NamePostingsOffset); }
+	const uint32* GetModifierRanges() const { return Section<uint32>(GetHeader().ModifierRangesOffset); }
+	const FCompiledModifier* GetModifierOps() const { return Section<FCompiledModifier>(GetHeader().ModifierOpsOffset); }
+	const FItemDetail* GetDetails() const { return Section<FItemDetail>(GetHeader().DetailsOffset); }
+	const uint32* GetRepairRanges() const { return Section<uint32>(GetHeader().RepairRangesOffset); }
+	const FRepairMaterial* GetRepairMaterials() const { return Section<FRepairMaterial>(GetHeader().RepairMaterialsOffset); }
+	const uint32* GetMetaRanges() const { return Section<uint32>(GetHeader().MetaRangesOffset); }
+	const FCompiledMetaEntry* GetMetaEntries() const { return Section<FCompiledMetaEntry>(GetHeader().MetaEntriesOffset); }
+
+	/** @return True if the recipes were cooked with the items. */
+	bool HasRecipes() const { return GetHeader().RecipesSize > 0; }
+	const FCookedRecipesHeader& GetRecipesHeader() const { return *Section<FCookedRecipesHeader>(GetHeader().RecipesOffset); }
+	FName GetRecipeName(const int32 Id) const { return ReadName(GetRecipesHeader().RecipeNamesOffset, GetRecipesHeader().NumRecipes, Id); }
+	FName GetIngredientTagName(const int32 Slot) const { return ReadName(GetRecipesHeader().IngredientTagNamesOffset, GetRecipesHeader().NumIngredientTags, Slot); }
+	const int32* GetIngredientStarts() const { return Section<int32>(GetRecipesHeader().IngredientStartsOffset); }
+	const FRecipeIngredient* GetIngredients() const { return Section<FRecipeIngredient>(GetRecipesHeader().IngredientsOffset); }
+	const int32* GetResultStarts() const { return Section<int32>(GetRecipesHeader().ResultStartsOffset); }
+	const FRecipeResult* GetResults() const { return Section<FRecipeResult>(GetRecipesHeader().ResultsOffset); }
+	const float* GetCraftDurations() const { return Section<float>(GetRecipesHeader().CraftDurationsOffset); }
+
+private:
+	template <typename T>
+	const T* Section(const uint64 Offset) const { return reinterpret_cast<const T*>(Data + Offset); }
+
+	FName ReadName(uint64 TableOffset, int32 Count, int32 Index) const;
+	FString ReadString(uint64 TableOffset, int32 Count, int32 Index) const;
+	bool ValidateNames(uint64 TableOffset, int32 Count, uint64 End) const;
+	bool ValidateModifiers() const;
+	bool ValidatePerishTargets() const;
+	bool ValidateNameSlots() const;
+	bool ValidateDetails() const;
+	bool ValidateMeta() const;
+	bool ValidateRecipes() const;
+	/** @return True if Count + 1 offsets into a section of Total entries start at 0, never decrease and end at Total. */
+	template <typename T>
+	static bool ValidateStarts(const T* Starts, const int32 Count, const int32 Total);
+	bool Validate() const;
+
+	// ========== VARIABLES ==========
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+};
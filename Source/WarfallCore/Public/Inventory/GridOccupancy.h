@@ -0,0 +1,108 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+// ===============================[ Grid Occupancy ]============================
+
+/**
+ * Occupancy of a grid container (FBagSpec, FPocketSpec), one 64-bit mask per grid row.
+ * Bit X of row Y is set when cell (X, Y) is taken. A footprint test is one shifted mask ANDed against each of its rows,
+ * and free-spot searches scan whole rows at once instead of looping over cells. Grids are at most 64 cells wide.
+ */
+struct WARFALLCORE_API FGridOccupancy
+{
+	// ========== FUNCTIONS ==========
+public:
+	static constexpr int32 MaxWidth = 64;
+
+	FGridOccupancy() = default;
+	explicit FGridOccupancy(const FIntPoint InDimensions) { Init(InDimensions); }
+
+	/** Resizes the grid and frees every cell. Widths above MaxWidth are clamped. */
+	void Init(const FIntPoint InDimensions);
+	/** Frees every cell. */
+	void Clear() { FMemory::Memzero(Rows.GetData(), Rows.Num() * sizeof(uint64)); }
+
+	FIntPoint GetDimensions() const { return FIntPoint(Width, Rows.Num()); }
+	int32 GetWidth() const { return Width; }
+	int32 GetHeight() const { return Rows.Num(); }
+	TConstArrayView<uint64> GetRows() const { return Rows; }
+
+	bool IsValidCell(const FIntPoint Cell) const { return Cell.X >= 0 && Cell.X < Width && Cell.Y >= 0 && Cell.Y < Rows.Num(); }
+	bool IsOccupied(const FIntPoint Cell) const { return IsValidCell(Cell) && (Rows[Cell.Y] >> Cell.X) & 1ull; }
+
+	/** @return The footprint turned by a quarter. */
+	static FIntPoint Rotate(const FIntPoint Footprint) { return FIntPoint(Footprint.Y, Footprint.X); }
+
+	/**
+	 * Tests whether a footprint fits at a position.
+	 *
+	 * @param Footprint Size of the item in cells, see HlpItem::GetFootprint. Empty footprints never fit.
+	 * @param Position Top-left cell of the item.
+	 * @return True if the footprint lies inside the grid and every covered cell is free.
+	 */
+	bool CanPlace(const FIntPoint Footprint, const FIntPoint Position) const
+	{
+		if (!IsInside(Footprint, Position)) return false;
+
+		const uint64 Mask = RowMask(Footprint.X) << Position.X;
+		for (int32 Y = Position.Y; Y < Position.Y + Footprint.Y; ++Y)
+		{
+			if (Rows[Y] & Mask) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Marks the cells of a footprint as taken. The footprint must fit, see CanPlace.
+	 *
+	 * @return False if the footprint does not fit, the grid is then left untouched.
+	 */
+	bool Place(const FIntPoint Footprint, const FIntPoint Position);
+	/** Frees the cells of a footprint placed at a position. Cells outside the grid are ignored. */
+	void Remove(const FIntPoint Footprint, const FIntPoint Position);
+
+	/**
+	 * Finds the first position, row by row then column by column, where a footprint fits.
+	 *
+	 * @param Footprint Size of the item in cells.
+	 * @param OutPosition Receives the top-left cell of the free spot.
+	 * @return False if the footprint fits nowhere.
+	 */
+	bool FindFirstFree(const FIntPoint Footprint, FIntPoint& OutPosition) const;
+	/**
+	 * Same as FindFirstFree, also trying the footprint turned by a quarter when it does not fit as is.
+	 *
+	 * @param Footprint Size of the item in cells.
+	 * @param OutPosition Receives the top-left cell of the free spot.
+	 * @param bOutRotated Receives true if the spot was found for the rotated footprint.
+	 * @return False if the footprint fits nowhere in either orientation.
+	 */
+	bool FindFirstFreeRotated(const FIntPoint Footprint, FIntPoint& OutPosition, bool& bOutRotated) const;
+
+	/** Number of positions where a footprint fits, used to score layouts. */
+	int32 CountFreeSpots(const FIntPoint Footprint) const;
+	int32 CountFreeCells() const;
+
+	bool operator==(const FGridOccupancy& Other) const { return Width == Other.Width && Rows == Other.Rows; }
+
+private:
+	/** @return A mask of the Count lowest bits. */
+	static uint64 RowMask(const int32 Count) { return Count >= 64 ? ~0ull : (1ull << Count) - 1ull; }
+
+	bool IsInside(const FIntPoint Footprint, const FIntPoint Position) const
+	{
+		return Footprint.X > 0 && Footprint.Y > 0 && Position.X >= 0 && Position.Y >= 0
+			&& Position.X + Footprint.X <= Width && Position.Y + Footprint.Y <= Rows.Num();
+	}
+
+	/**
+	 * Bit X is set when Footprint.X free cells start at column X in the band of rows [Y, Y + Footprint.Y).
+	 * Computed with one OR per band row and a logarithmic number of shifts for the run length.
+	 */
+	uint64 FreeStarts(const FIntPoint Footprint, const int32 Y) const;
+
+	// ========== VARIABLES ==========
+	TArray<uint64, TInlineAllocator<16>> Rows;
+	int32 Width = 0;
+};
@@ -0,0 +1,106 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/GridOccupancy.h"
+
+struct FItemCatalog;
+
+// ===============================[ Grid Pack Solver ]============================
+
+/** One stack of a grid container, as seen by the pack solver. */
+struct FPackEntry
+{
+	/** Caller-side identifier of the stack (instance handle, slot index). INDEX_NONE for stacks created by the solver. */
+	int32 Handle = INDEX_NONE;
+	int32 ItemId = INDEX_NONE;
+	int32 Quantity = 0;
+	/** Size of the item in cells, before rotation. Filled by the solver from FPackItemInfo. */
+	FIntPoint Footprint = FIntPoint(1, 1);
+	/** Top-left cell of the stack. */
+	FIntPoint Position = FIntPoint::ZeroValue;
+	/** True when the footprint is turned by a quarter. */
+	bool bRotated = false;
+};
+
+/** Item properties used by the solver, resolved on the game thread so that solving never reads the catalog. */
+struct FPackItemInfo
+{
+	FIntPoint Footprint = FIntPoint(1, 1);
+	int32 MaxStackSize = 1;
+	/** Rank of the item type, lower types are packed first. */
+	int32 TypeOrder = 0;
+	/** First gameplay tag of the item, groups items of the same type. */
+	FString TagKey;
+};
+
+/** Contents of one grid container to sort. */
+struct WARFALLCORE_API FPackRequest
+{
+	FIntPoint Dimensions = FIntPoint::ZeroValue;
+	TArray<FPackEntry> Contents;
+	/** Properties of every item id of Contents, see ResolveItems. */
+	TMap<int32, FPackItemInfo> Items;
+	/** Time allowed to search for better layouts, in microseconds. The first layout is always completed. */
+	int32 BudgetMicroseconds = 500;
+	/** Version of the container contents when the request was made, checked again when the layout is applied. */
+	uint32 ContentVersion = 0;
+	/** Merges the stacks of the same item up to their MaxStackSize before packing. */
+	bool bMergeStacks = true;
+
+	/**
+	 * Fills Items for every item of Contents. Game thread only.
+	 *
+	 * @param Catalog The item catalog the ids of Contents belong to.
+	 */
+	void ResolveItems(const FItemCatalog& Catalog);
+};
+
+/** Best layout found for a request. */
+struct WARFALLCORE_API FPackResult
+{
+	/** Every placed stack at its new position. Merged stacks keep the handle of one of their sources. */
+	TArray<FPackEntry> Layout;
+	/** Handles of the stacks emptied by merging. */
+	TArray<int32> RemovedHandles;
+	/** Stacks that fit nowhere. A result with unplaced stacks is never applied. */
+	TArray<FPackEntry> Unplaced;
+	/** Version of the contents the layout was computed from. */
+	uint32 ContentVersion = 0;
+	int32 Attempts = 0;
+	double ElapsedMicroseconds = 0.0;
+
+	bool IsComplete() const { return Unplaced.IsEmpty(); }
+};
+
+/**
+ * Sorts and packs grid containers.
+ * Stacks are first merged by item, then packed first-fit (rotation allowed) in several orders: the canonical
+ * type/tag order first, then by decreasing area, height and width, then shuffled orders until the budget runs out.
+ * The best layout places every stack with the fewest used rows; ties keep the earliest, most ordered, attempt.
+ */
+class WARFALLCORE_API FGridPackSolver
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Solves a request on the calling thread. Reads nothing but the request. */
+	static FPackResult Solve(const FPackRequest& Request);
+
+	/**
+	 * Solves a request on a worker thread.
+	 *
+	 * @param Request The request, with its items resolved.
+	 * @param OnSolved Called on the game thread with the best layout found.
+	 */
+	static void SolveAsync(FPackRequest Request, TUniqueFunction<void(FPackResult&&)> OnSolved);
+
+	/**
+	 * Applies a layout as one transaction: the layout is fully validated against the grid before anything changes.
+	 *
+	 * @param Result A complete layout returned by Solve.
+	 * @param CurrentVersion Version of the container contents now. Layouts computed from other contents are rejected.
+	 * @param Grid Occupancy of the container, replaced by the occupancy of the layout.
+	 * @param Commit Moves, merges and removes the stacks of the container as described by the result.
+	 * @return False if the layout was rejected, in which case neither the grid nor Commit were touched.
+	 */
+	static bool Apply(const FPackResult& Result, const uint32 CurrentVersion, FGridOccupancy& Grid, TFunctionRef<void(const FPackResult&)> Commit);
+};
@@ -0,0 +1,78 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+struct FItemCatalog;
+
+/** How the aging of an item instance is driven. */
+enum class EItemAgingMode : uint8
+{
+	/** The perish deadline waits in the timing wheel and fires on time. */
+	Scheduled,
+	/** Nothing runs until the instance is read; everything elapsed since its last evaluation is then computed at once. */
+	Lazy,
+};
+
+/** Aging fields of one instance at a given time. */
+struct FItemAgingState
+{
+	/** INDEX_NONE once the instance perished into nothing. */
+	int32 ItemId = INDEX_NONE;
+	/** Time at which the current item perishes, 0 when it never does or when perishing is not evaluated. */
+	double PerishDeadline = 0.0;
+	float Durability = 0.0f;
+	float Wear = 0.0f;
+};
+
+namespace HlpItem
+{
+	/**
+	 * @param Catalog The item catalog.
+	 * @param ItemId The item.
+	 * @return The lifetime of the item in seconds at a perish multiplier of 1, 0 if it does not perish.
+	 */
+	WARFALLCORE_API double GetPerishLifetime(const FItemCatalog& Catalog, const int32 ItemId);
+
+	/**
+	 * Ages an instance from one time to another in closed form, whatever the time elapsed.
+	 * Every passed deadline turns the item into its PerishTo item at full durability, the next deadline following the
+	 * previous one; a chain coming back to an item it already went through skips its whole loops at once.
+	 * Weathering then removes WearRate durability per second since the last transformation, the MaxWear share of the
+	 * lost durability becoming permanent wear, which caps the durability.
+	 *
+	 * @param Catalog The item catalog.
+	 * @param State The state at From, receives the state at Now.
+	 * @param From Time of the last evaluation.
+	 * @param Now Time to evaluate.
+	 * @param PerishMultiplier Multiplier of the pocket holding the instance, constant over the period.
+	 * @param WearRate Durability lost per second, constant over the period. Only items with durability weather.
+	 * @return The number of transformations applied.
+	 */
+	WARFALLCORE_API int32 AgeInstance(const FItemCatalog& Catalog, FItemAgingState& State, const double From, const double Now, const float PerishMultiplier, const float WearRate);
+
+	/**
+	 * Ages an instance restored from a save whose deadline passed while it was saved, as AgeInstance would have.
+	 * The overdue time carries over to the next items of the chain, even when the restore time is too early for the
+	 * saved deadline to be a positive time, a deadline of 0 meaning that the item never perishes.
+	 *
+	 * @param Catalog The item catalog.
+	 * @param State The state when saved, its PerishDeadline ignored; receives the state at Now.
+	 * @param PerishRemaining Seconds left before the deadline when saved, 0 or negative.
+	 * @param SinceEvaluated Seconds between the last evaluation of the instance and the save.
+	 * @param Now Restore time, the clock of the deadline State receives.
+	 * @param PerishMultiplier Multiplier of the pocket holding the instance.
+	 * @param WearRate Durability lost per second.
+	 * @return The number of transformations applied.
+	 */
+	WARFALLCORE_API int32 AgeOverdue(const FItemCatalog& Catalog, FItemAgingState& State, const double PerishRemaining, const double SinceEvaluated, const double Now, const float PerishMultiplier, const float WearRate);
+
+	/**
+	 * @param Catalog The item catalog.
+	 * @param ItemId The item.
+	 * @param PerishDeadline Deadline of the instance.
+	 * @param Now Current time.
+	 * @param PerishMultiplier Multiplier of the pocket holding the instance.
+	 * @return The share of the lifetime left, from 1 (fresh) to 0 (about to perish). 1 for items that do not perish.
+	 */
+	WARFALLCORE_API float GetFreshness(const FItemCatalog& Catalog, const int32 ItemId, const double PerishDeadline, const double Now, const float PerishMultiplier);
+}
@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "Inventory/ItemCatalog.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "ItemAssetPrefetcher.generated.h"
+
+/**
+ * Describes which soft references of an item a caller is about to use.
+ * Values can be combined to prefetch several usages in a single request.
+ */
+enum class EItemAssetUsage : uint8
+{
+	None		= 0,
+	/** Thumbnail texture and its optional layer, for inventory and container UI. */
+	Icon		= 1 << 0,
+	/** Static mesh spawned when the item is dropped in the world. */
+	WorldDrop	= 1 << 1,
+	/** Static and skeletal meshes displayed when the item is equipped. */
+	Equipped	= 1 << 2,
+
+	All			= Icon | WorldDrop | Equipped,
+};
+ENUM_CLASS_FLAGS(EItemAssetUsage)
+
+/**
+ * Streams the soft references of whole item sets in one prioritized request,
+ * so opening a large container or spawning loot never resolves assets one by one on the game thread.
+ */
+UCLASS()
+class WARFALLCORE_API UItemAssetPrefetcher : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+	// ========== FUNCTIONS ==========
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** @return The subsystem instance, or nullptr before the engine is initialized. */
+	static UItemAssetPrefetcher* Get();
+
+	/**
+	 * Issues a single streamable request for the assets of every given item.
+	 * The caller keeps the assets resident for as long as it holds the returned handle. With a catalog built from a
+	 * cooked file, the soft references are read from ItemsTable, loaded by the first call.
+	 *
+	 * @param Items Dense ids of the items to prefetch. Duplicates and invalid ids are ignored.
+	 * @param Usage Which references of the items are needed.
+	 * @param OnComplete Called once everything is loaded, or immediately when nothing has to be streamed.
+	 * @param Priority Priority of the streamable request.
+	 * @return The request handle, or nullptr when every asset was already resident.
+	 */
+	TSharedPtr<FStreamableHandle> Prefetch(TConstArrayView<FItemId> Items, const EItemAssetUsage Usage,
+		FStreamableDelegate OnComplete = FStreamableDelegate(), const TAsyncLoadPriority Priority = FStreamableManager::AsyncLoadHighPriority);
+
+	/**
+	 * Cancels a pending request. The completion callback is not called and the handle is released.
+	 *
+	 * @param Handle The handle returned by Prefetch, reset on return.
+	 */
+	static void Cancel(TSharedPtr<FStreamableHandle>& Handle);
+
+	/**
+	 * Appends the non-resident soft references of a row matching the usage.
+	 *
+	 * @param Row The item row to inspect.
+	 * @param Usage Which references of the item are needed.
+	 * @param OutPaths Receives the paths still to be loaded.
+	 */
+	static void CollectPaths(const FItemRow& Row, const EItemAssetUsage Usage, TSet<FSoftObjectPath>& OutPaths);
+
+	// ========== VARIABLES ==========
+private:
+	FStreamableManager StreamableManager;
+};
@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/ItemRowTypes.h"
+#include "Utils/DenseBitSet.h"
+
+/**
+ * Capability mask compiled once per item from its row.
+ *
+ * Layout:
+ *   bits  0-7  : Item.State tags, same values as EItemFlags
+ *   bits  8-15 : item type, same values as EItemType shifted by 8
+ *   bits 16-23 : predicates derived from the type, the tags and the row thresholds
+ */
+enum class EItemCapability : uint32
+{
+	None				= 0,
+
+	// ========== Item.State tags ==========
+	Lootable			= static_cast<uint32>(EItemFlags::E_CanLooted),
+	Perishable			= static_cast<uint32>(EItemFlags::E_CanPerished),
+	Dismantleable		= static_cast<uint32>(EItemFlags::E_CanDismantled),
+	Repairable			= static_cast<uint32>(EItemFlags::E_CanRepair),
+	Container			= static_cast<uint32>(EItemFlags::E_HasContainer),
+
+	// ========== Type ==========
+	Weapon				= static_cast<uint32>(EItemType::E_Weapon) << 8,
+	Armor				= static_cast<uint32>(EItemType::E_Armor) << 8,
+	Consumable			= static_cast<uint32>(EItemType::E_Consumable) << 8,
+	Tool				= static_cast<uint32>(EItemType::E_Tool) << 8,
+	Ammunition			= static_cast<uint32>(EItemType::E_Ammunition) << 8,
+	Ingredient			= static_cast<uint32>(EItemType::E_Ingredient) << 8,
+	Recipe				= static_cast<uint32>(EItemType::E_Recipe) << 8,
+
+	// ========== Derived ==========
+	/** FItemRow::CanPerish: consumable, perishable tag and PerishRate > 0. */
+	CanPerish			= 1u << 16,
+	/** FItemRow::CanBeRepair: has durability, repairable tag and RepairTimeMultiplier > 0. */
+	CanBeRepaired		= 1u << 17,
+	/** FItemRow::HasDurability: weapon, armor or tool. */
+	HasDurability		= 1u << 18,
+	/** FItemRow::IsUsingAmmunition: bow or crossbow. */
+	UsesAmmunition		= 1u << 19,
+	/** FItemRow::GetEquipeableVisible. */
+	Equipable			= 1u << 20,
+	/** MaxStackSize > 1. */
+	Stackable			= 1u << 21,
+};
+ENUM_CLASS_FLAGS(EItemCapability)
+
+namespace HlpItem
+{
+	/**
+	 * Converts the Item.State tags of a container into the matching EItemFlags.
+	 *
+	 * @param Flags Tags of the row, usually FItemRow::Flags.
+	 * @return The combined flags.
+	 */
+	WARFALLCORE_API EItemFlags GetStateFlags(const FGameplayTagContainer& Flags);
+
+	/**
+	 * Compiles the capability mask of a row.
+	 *
+	 * @param Row The item row.
+	 * @return The packed capabilities of the row.
+	 */
+	WARFALLCORE_API EItemCapability CompileCapabilities(const FItemRow& Row);
+
+	/**
+	 * Marks in OutMatches every entry of the column that holds all the required capabilities.
+	 * The column is tested four masks at a time with vector instructions.
+	 *
+	 * @param Column One capability mask per item, as returned by FItemCatalog::GetCapabilityColumn.
+	 * @param Required Capabilities every selected item must have.
+	 * @param OutMatches Resized to the column and set for every matching index.
+	 */
+	WARFALLCORE_API void FilterByCapabilities(TConstArrayView<uint32> Column, const EItemCapability Required, FDenseBitSet& OutMatches);
+
+	/**
+	 * Keeps the ids of a list (an inventory content for instance) holding all the required capabilities.
+	 *
+	 * @param Column One capability mask per item.
+	 * @param Items The ids to filter.
+	 * @param Required Capabilities every selected item must have.
+	 * @param OutItems Receives the matching ids, in input order.
+	 */
+	WARFALLCORE_API void FilterByCapabilities(TConstArrayView<uint32> Column, TConstArrayView<int32> Items, const EItemCapability Required, TArray<int32>& OutItems);
+}
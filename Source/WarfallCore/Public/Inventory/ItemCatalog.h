@@ -0,0 +1,248 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/CookedItemCatalog.h"
+#include "Inventory/ItemCapabilities.h"
+#include "Inventory/ItemDetailColumns.h"
+#include "Inventory/ItemModifiers.h"
+#include "Inventory/ItemRowTypes.h"
+#include "Inventory/ItemStatColumns.h"
+#include "Inventory/ItemTagIndex.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "ItemCatalog.generated.h"
+
+/** Dense index of an item inside the compiled catalog. INDEX_NONE when the row does not exist. */
+using FItemId = int32;
+
+// ===============================[ Item Catalog ]============================
+
+/**
+ * Compiled, read-only view over ItemsTable.
+ * Every row name is mapped once to a dense id; lookups then return references to the rows owned by the table,
+ * so gameplay code never loads the table nor copies an FItemRow to read it.
+ * A catalog built from a cooked file holds the names, stats, capabilities, perish targets, tag postings, modifiers and
+ * details, but no row: FindRow then returns nullptr and HasRows is false.
+ */
+struct WARFALLCORE_API FItemCatalog
+{
+	// ========== FUNCTIONS ==========
+public:
+	/**
+	 * Compiles the catalog from the given table. Ids follow the order of the table rows.
+	 *
+	 * @param InTable Table whose row struct must be FItemRowDetail. The catalog is left empty otherwise.
+	 */
+	void Build(const UDataTable* InTable);
+	/**
+	 * Binds the catalog on a mapped cooked file. The stats, capabilities and postings are read in place.
+	 *
+	 * @param Cooked Opened cooked catalog, which must outlive this catalog or its next build.
+	 * @return False if the cooked catalog is not open.
+	 */
+	bool BuildFromCooked(const FCookedItemCatalog& Cooked);
+	/** Releases every compiled entry. */
+	void Reset();
+
+	/**
+	 * Applies row edits of the bound table to every derived structure, in time proportional to the number of edits.
+	 * Edited rows keep their id, added rows get new ids and removed rows leave an empty id behind (FindRow returns
+	 * nullptr, no stat, capability, tag or modifier). Ids are therefore never reassigned by a patch.
+	 *
+	 * @param ChangedRows Names of the rows added, edited or removed since the last build or patch.
+	 * @param OutPatchedIds Receives the ids whose data changed.
+	 * @return False if the catalog must be rebuilt instead: no rows bound, or too many removed ids.
+	 */
+	bool PatchRows(TConstArrayView<FName> ChangedRows, TArray<FItemId>& OutPatchedIds);
+
+	/**
+	 * Resolves the dense id of a row.
+	 *
+	 * @param RowName The row name inside ItemsTable.
+	 * @return The id of the row, or INDEX_NONE if the row is unknown.
+	 */
+	FItemId FindId(const FName RowName) const
+	{
+		const FItemId* Id = RowIds.Find(RowName);
+		return Id ? *Id : INDEX_NONE;
+	}
+
+	bool IsValidId(const FItemId Id) const { return Id >= 0 && Id < NumItems; }
+
+	const FItemRow* FindRow(const FItemId Id) const { return Rows.IsValidIndex(Id) ? Rows[Id] : nullptr; }
+	const FItemRow* FindRow(const FName RowName) const { return FindRow(FindId(RowName)); }
+	/**
+	 * Like FindRow, but catalogs built from a cooked file read the row from ItemsTable, loading it if needed.
+	 * Gameplay code reads the compiled columns instead; this is for the editor and the fields nothing compiles.
+	 */
+	const FItemRow* FindRowOrTable(const FItemId Id) const;
+
+	/** Returns the row of a valid id. Asserts when the id is out of range or the catalog holds no rows. */
+	const FItemRow& GetRow(const FItemId Id) const
+	{
+		check(Rows.IsValidIndex(Id));
+		return *Rows[Id];
+	}
+
+	FName GetRowName(const FItemId Id) const { return RowNames.IsValidIndex(Id) ? RowNames[Id] : NAME_None; }
+	/** @return The display name of an item as a string, empty for unnamed items and unknown ids. */
+	FString GetDisplayName(const FItemId Id) const;
+	TConstArrayView<FName> GetRowNames() const { return RowNames; }
+	/** @return The number of ids, removed rows included. */
+	int32 Num() const { return NumItems; }
+	/** @return The number of ids whose row was removed by a patch. */
+	int32 NumRemoved() const { return RemovedCount; }
+	bool IsEmpty() const { return NumItems == 0; }
+	/** @return True if the rows are available, false for catalogs built from a cooked file. */
+	bool HasRows() const { return !Rows.IsEmpty(); }
+
+	/** Hot numeric fields of every item, stored column by column. */
+	const FItemStatColumns& GetStats() const { return Stats; }
+
+	EItemCapability GetCapabilities(const FItemId Id) const
+	{
+		checkSlow(IsValidId(Id));
+		return static_cast<EItemCapability>(CapabilityData[Id]);
+	}
+	/** @return True if the item holds every required capability. A single AND and compare per call. */
+	bool HasCapabilities(const FItemId Id, const EItemCapability Required) const
+	{
+		const uint32 RequiredMask = static_cast<uint32>(Required);
+		return IsValidId(Id) && (CapabilityData[Id] & RequiredMask) == RequiredMask;
+	}
+	/** One capability mask per item id, see HlpItem::FilterByCapabilities. */
+	TConstArrayView<uint32> GetCapabilityColumn() const { return TConstArrayView<uint32>(CapabilityData, NumItems); }
+
+	/** @return The id of the FItemRow::PerishTo item, INDEX_NONE when the item perishes into nothing. */
+	FItemId GetPerishTarget(const FItemId Id) const
+	{
+		checkSlow(IsValidId(Id));
+		return PerishTargetData[Id];
+	}
+	TConstArrayView<FItemId> GetPerishTargetColumn() const { return TConstArrayView<FItemId>(PerishTargetData, NumItems); }
+
+	/** Gameplay tag to item postings, parents included. */
+	const FItemTagIndex& GetTagIndex() const { return TagIndex; }
+	/** Meta modifiers of every item, compiled to flat op lists. */
+	const FItemModifierTable& GetModifiers() const { return Modifiers; }
+	/** Cold fields of every item: footprint, capacity, quality, repair time and materials, meta entries. */
+	const FItemDetailColumns& GetDetails() const { return Details; }
+
+	/** Incremented on each build, so caches keyed on the catalog can detect that ids were reassigned. */
+	uint32 GetGeneration() const { return Generation; }
+	/** Incremented on each build and patch, so caches of derived data (queries, filters) can detect any change. */
+	uint32 GetRevision() const { return Revision; }
+	const UDataTable* GetTable() const { return Table; }
+
+private:
+	/** Refreshes every derived entry of an id. Row is nullptr for removed rows. */
+	void SetRow(const FItemId Id, const FItemRow* Row);
+	FItemId AddRow(const FName RowName, const FItemRow& Row);
+	void RemoveRow(const FItemId Id);
+	/** Resolves the PerishTo row of every id. Rows may perish into rows added after them, so this runs once all ids exist. */
+	void ResolvePerishTargets();
+	/** @return The id the row of Id perishes into. Rows perishing into themselves are reported and perish into nothing. */
+	FItemId ResolvePerishTarget(const FItemId Id, const FItemRow* Row) const;
+	/** Lists Id in NameReferrers under the PerishTo row and the repair materials of its row. */
+	void AddReferences(const FItemId Id, const FItemRow& Row);
+	/**
+	 * Resolves again the perish target and repair materials of the rows referring to added or removed rows.
+	 *
+	 * @param PatchedNames Names of the rows added or removed by the patch.
+	 * @param OutPatchedIds Receives the ids resolved again, if not already listed.
+	 */
+	void ResolveReferrers(TConstArrayView<FName> PatchedNames, TArray<FItemId>& OutPatchedIds);
+
+	// ========== VARIABLES ==========
+	const UDataTable* Table = nullptr;
+	TArray<FName> RowNames;
+	TArray<const FItemRow*> Rows;
+	TMap<FName, FItemId> RowIds;
+	FItemStatColumns Stats;
+	TArray<uint32> Capabilities;
+	/** Read pointer, either on Capabilities or on a cooked file. */
+	const uint32* CapabilityData = nullptr;
+	TArray<FItemId> PerishTargets;
+	/** Read pointer, either on PerishTargets or on a cooked file. */
+	const FItemId* PerishTargetData = nullptr;
+	FItemTagIndex TagIndex;
+	FItemModifierTable Modifiers;
+	FItemDetailColumns Details;
+	/**
+	 * Ids whose row refers to a row name through PerishTo or a repair material, so that patches adding or removing a
+	 * row only resolve those rows again. Only appended to between builds: an edited row may stay listed under a name it
+	 * no longer refers to, which costs one extra resolve.
+	 */
+	TMap<FName, TArray<FItemId>> NameReferrers;
+	/** The cooked file the catalog is bound on, nullptr for catalogs built from ItemsTable. */
+	const FCookedItemCatalog* CookedFile = nullptr;
+	int32 NumItems = 0;
+	int32 RemovedCount = 0;
+	uint32 Generation = 0;
+	uint32 Revision = 0;
+};
+
+// ===============================[ Item Catalog Subsystem ]============================
+
+/**
+ * Owns the item catalog for the whole engine lifetime.
+ * The catalog is compiled once from ItemsTable on initialization. Table edits (editor, PIE playtests) are reported
+ * row by row through FItemRowDetail::OnDataTableChanged and patched in place when the table broadcasts its change;
+ * the catalog is only rebuilt when the edits cannot be patched.
+ * Packaged builds first try to map the catalog written by the cook (see FCookedItemCatalog), in which case ItemsTable
+ * is never loaded and the catalog holds no rows.
+ */
+UCLASS()
+class WARFALLCORE_API UItemCatalogSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+	DECLARE_MULTICAST_DELEGATE(FOnCatalogRebuilt);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnRowsPatched, TConstArrayView<FItemId>);
+
+	// ========== FUNCTIONS ==========
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** @return The subsystem instance, or nullptr before the engine is initialized. */
+	static UItemCatalogSubsystem* Get();
+	/** @return The compiled catalog, or nullptr when the subsystem is unavailable or the table failed to load. */
+	static const FItemCatalog* GetCatalog();
+
+	const FItemCatalog& GetItems() const { return Catalog; }
+
+	/** Recompiles the catalog from ItemsTable and notifies the listeners. */
+	void Rebuild();
+	/** @return True if the catalog is bound on a cooked file rather than compiled from ItemsTable. */
+	bool IsCooked() const { return CookedCatalog.IsOpen(); }
+	/** The cooked file the catalog is bound on, closed unless IsCooked. */
+	const FCookedItemCatalog& GetCookedCatalog() const { return CookedCatalog; }
+
+	/**
+	 * Records a row edit, patched on the next change broadcast of the table.
+	 *
+	 * @param Table The edited table. Ignored unless it is the bound ItemsTable.
+	 * @param RowName The edited row.
+	 */
+	static void NotifyRowChanged(const UDataTable* Table, const FName RowName);
+
+	/** Broadcast after every rebuild. Previously resolved ids and row references must be considered stale. */
+	FOnCatalogRebuilt OnCatalogRebuilt;
+	/** Broadcast after rows were patched in place, with the affected ids. Other ids and rows stay valid. */
+	FOnRowsPatched OnRowsPatched;
+
+private:
+	bool LoadCooked();
+	void BindTable(UDataTable* NewTable);
+	void HandleTableChanged();
+
+	// ========== VARIABLES ==========
+	UPROPERTY()
+	UDataTable* ItemsTable = nullptr;
+
+	FCookedItemCatalog CookedCatalog;
+	FItemCatalog Catalog;
+	FDelegateHandle TableChangedHandle;
+	/** Rows reported by NotifyRowChanged since the last change broadcast. */
+	TSet<FName> PendingRows;
+};
@@ -0,0 +1,139 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/ItemRangedArray.h"
+#include "Inventory/ItemRowTypes.h"
+
+struct FItemCatalog;
+
+// ===============================[ Item Detail Columns ]============================
+
+/** Fixed-size cold fields of one item. Part of the cooked catalog format. */
+struct FItemDetail
+{
+	/** Cells covered in a grid, see HlpItem::GetFootprint. */
+	int16 FootprintX = 0;
+	int16 FootprintY = 0;
+	/** Cells of the bag or pocket of a container item, 0 for the other items. */
+	int32 Capacity = 0;
+	int32 Quality = 0;
+	/** Seconds a repair takes, see FItemRow::GetRepairTime. */
+	float RepairTime = 0.0f;
+	/** Slot in the tag index of the first of the row Tags, INDEX_NONE for items without tags. */
+	int32 FirstTagSlot = INDEX_NONE;
+
+	FIntPoint GetFootprint() const { return FIntPoint(FootprintX, FootprintY); }
+};
+
+static_assert(sizeof(FItemDetail) == 20, "FItemDetail is part of the cooked catalog format.");
+
+/** A repair material, resolved to its item id. */
+struct FRepairMaterial
+{
+	/** The material, INDEX_NONE when it is not in the catalog. */
+	int32 ItemId = INDEX_NONE;
+	int32 Quantity = 1;
+};
+
+/** An FItemMetaEntry whose key is interned into a slot, as stored by the cooked catalog. */
+struct FCompiledMetaEntry
+{
+	uint16 Slot = 0;
+	EMathOperation Operation = EMathOperation::E_Add;
+	uint8 Padding = 0;
+	float Value = 0.0f;
+};
+
+static_assert(sizeof(FCompiledMetaEntry) == 8, "FCompiledMetaEntry is part of the cooked catalog format.");
+
+/**
+ * Cold item fields read outside the simulation loop: grid footprint, container capacity, quality, repair time and
+ * materials, meta entries. They are compiled with the catalog so that no call site reads an FItemRow for them, and
+ * cooked with it so that packaged servers never load ItemsTable.
+ */
+class WARFALLCORE_API FItemDetailColumns
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Compiles the columns of every row of the catalog, whose tag index must be built. */
+	void Build(const FItemCatalog& Catalog);
+	void Reset();
+
+	/**
+	 * Uses details and repair materials owned elsewhere, laid out like GetRawDetails and CopyRawRepairMaterials
+	 * (memory-mapped catalogs). The storage must outlive the columns, which become read-only.
+	 * Meta entries are expanded back to FItemMetaEntry, their keys being gameplay tags.
+	 *
+	 * @param InDetails InNumItems details.
+	 * @param InRepairRanges InNumItems + 1 offsets into InRepairMaterials.
+	 * @param InRepairMaterials Every repair material, item after item.
+	 * @param MetaKeys Tag name of each meta entry slot.
+	 * @param MetaRanges InNumItems + 1 offsets into MetaEntries.
+	 * @param CompiledMeta Every meta entry, item after item.
+	 * @param InNumItems Number of items covered by the columns.
+	 */
+	void BindExternal(const FItemDetail* InDetails, const uint32* InRepairRanges, const FRepairMaterial* InRepairMaterials,
+		TConstArrayView<FName> MetaKeys, const uint32* MetaRanges, const FCompiledMetaEntry* CompiledMeta, const int32 InNumItems);
+
+	/**
+	 * Recompiles the columns of one item. The entries of the other items never move.
+	 *
+	 * @param Id The item id.
+	 * @param Row The new row, or nullptr when the row was removed from the table.
+	 * @param Catalog The catalog, for the repair material ids and the tag slots.
+	 */
+	void SetRow(const int32 Id, const FItemRow* Row, const FItemCatalog& Catalog);
+	/** Compiles a row appended at the end of the catalog. */
+	void AddRow(const FItemRow& Row, const FItemCatalog& Catalog);
+
+	const FItemDetail& Get(const int32 Id) const
+	{
+		checkSlow(Id >= 0 && Id < NumItems);
+		return DetailData[Id];
+	}
+	/** @return The repair materials of an item, the same material listed twice being merged. Empty for unknown ids. */
+	TConstArrayView<FRepairMaterial> GetRepairMaterials(const int32 Id) const
+	{
+		return RepairMaterials.Get(Id);
+	}
+	/** @return The meta entries of an item, as authored in FItemRow::MetaModifiers. Empty for unknown ids. */
+	TConstArrayView<FItemMetaEntry> GetMetaEntries(const int32 Id) const
+	{
+		return MetaEntries.Get(Id);
+	}
+
+	int32 Num() const { return NumItems; }
+
+	TConstArrayView<FItemDetail> GetRawDetails() const { return TConstArrayView<FItemDetail>(DetailData, NumItems); }
+	/**
+	 * Copies the repair materials for the cooked catalog.
+	 *
+	 * @param OutRanges Receives one offset per item plus one, the materials of item Id being [OutRanges[Id], OutRanges[Id + 1]).
+	 * @param OutMaterials Receives every repair material, item after item.
+	 */
+	void CopyRawRepairMaterials(TArray<uint32>& OutRanges, TArray<FRepairMaterial>& OutMaterials) const { RepairMaterials.CopyCompact(OutRanges, OutMaterials); }
+	/**
+	 * Interns the keys of every meta entry, for the cooked catalog.
+	 *
+	 * @param OutKeys Receives the tag name of each slot.
+	 * @param OutRanges Receives one offset per item plus one, the entries of item Id being [OutRanges[Id], OutRanges[Id + 1]).
+	 * @param OutEntries Receives every meta entry, item after item.
+	 */
+	void CompileMeta(TArray<FName>& OutKeys, TArray<uint32>& OutRanges, TArray<FCompiledMetaEntry>& OutEntries) const;
+
+private:
+	static FItemDetail CompileDetail(const FItemRow& Row, const FItemCatalog& Catalog);
+	/** Appends the repair materials of a row to OutMaterials, merged by item. */
+	static void CompileRepairMaterials(const FItemRow& Row, const FItemCatalog& Catalog, TArray<FRepairMaterial>& OutMaterials);
+
+	// ========== VARIABLES ==========
+	TArray<FItemDetail> Details;
+	/** Read pointer, either on Details or on external storage. */
+	const FItemDetail* DetailData = nullptr;
+	TItemRangedArray<FRepairMaterial> RepairMaterials;
+	/** Always owned, the cooked keys being expanded back to gameplay tags. */
+	TItemRangedArray<FItemMetaEntry> MetaEntries;
+	/** Repair materials of the row being compiled, kept to reuse its allocation. */
+	TArray<FRepairMaterial> RowMaterials;
+	int32 NumItems = 0;
+};
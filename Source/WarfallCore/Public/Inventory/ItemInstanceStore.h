@@ -0,0 +1,358 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/ContainerSearchIndex.h"
+#include "Inventory/ContainerTree.h"
+#include "Inventory/ItemAging.h"
+#include "Inventory/ItemRowTypes.h"
+#include "Inventory/PerishScheduler.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemInstanceStore.generated.h"
+
+struct FItemCatalog;
+struct FItemSnapshotEntry;
+
+// ===============================[ Item Instance Store ]============================
+
+/**
+ * Pool of every live item instance of a world, stored column by column.
+ * Instances live in fixed-size slabs that are never moved nor freed while the store exists, so column pointers stay
+ * stable and the memory footprint only grows in whole slabs. Destroyed slots go to an intrusive free list and are
+ * recycled first, which makes Create and Destroy O(1) without touching the heap.
+ * Accessors take a handle that must be valid, see IsValid.
+ */
+class WARFALLCORE_API FItemInstanceStore
+{
+	// ========== FUNCTIONS ==========
+public:
+	static constexpr int32 SlabShift = 12;
+	static constexpr int32 SlabSize = 1 << SlabShift;
+	static constexpr int32 MaxInstances = 1 << FItemHandle::IndexBits;
+
+	FItemInstanceStore() = default;
+	FItemInstanceStore(const FItemInstanceStore&) = delete;
+	FItemInstanceStore& operator=(const FItemInstanceStore&) = delete;
+
+	/**
+	 * Allocates an instance.
+	 *
+	 * @param ItemId Catalog id of the item.
+	 * @param Stack Number of items in the stack.
+	 * @param Durability Starting durability, usually the MaxDurability stat of the item.
+	 * @return The handle of the instance, invalid if the store is full.
+	 */
+	FItemHandle Create(const int32 ItemId, const int32 Stack = 1, const float Durability = 0.0f);
+	/**
+	 * Releases an instance; its handle and every copy of it become invalid.
+	 *
+	 * @return False if the handle was already invalid.
+	 */
+	bool Destroy(const FItemHandle Handle);
+	/** Destroys every instance. Slabs are kept for the next instances. */
+	void Reset();
+	/** Allocates the slabs needed to hold a number of instances without growing later. */
+	void Reserve(const int32 NumInstances);
+
+	bool IsValid(const FItemHandle Handle) const
+	{
+		if (!Handle.IsValid()) return false;
+
+		const uint32 Index = Handle.GetIndex();
+		return Index < static_cast<uint32>(NumSlots) && GetSlab(Index).Generations[Index & SlotMask] == Handle.GetGeneration();
+	}
+
+	/** Number of live instances. */
+	int32 Num() const { return NumLive; }
+	/** Number of slots allocated, live or free. */
+	int32 GetCapacity() const { return NumSlots; }
+	SIZE_T GetAllocatedSize() const { return Slabs.GetAllocatedSize() + Slabs.Num() * sizeof(FSlab); }
+
+	int32 GetItemId(const FItemHandle Handle) const { return Column(Handle, &FSlab::ItemIds); }
+	void SetItemId(const FItemHandle Handle, const int32 ItemId) { Column(Handle, &FSlab::ItemIds) = ItemId; }
+	int32 GetStack(const FItemHandle Handle) const { return Column(Handle, &FSlab::Stacks); }
+	void SetStack(const FItemHandle Handle, const int32 Stack) { Column(Handle, &FSlab::Stacks) = Stack; }
+	float GetDurability(const FItemHandle Handle) const { return Column(Handle, &FSlab::Durabilities); }
+	void SetDurability(const FItemHandle Handle, const float Durability) { Column(Handle, &FSlab::Durabilities) = Durability; }
+	float GetWear(const FItemHandle Handle) const { return Column(Handle, &FSlab::Wears); }
+	void SetWear(const FItemHandle Handle, const float Wear) { Column(Handle, &FSlab::Wears) = Wear; }
+	/** World time in seconds at which the instance perishes, 0 when it never does. */
+	double GetPerishDeadline(const FItemHandle Handle) const { return Column(Handle, &FSlab::PerishDeadlines); }
+	void SetPerishDeadline(const FItemHandle Handle, const double Deadline) { Column(Handle, &FSlab::PerishDeadlines) = Deadline; }
+	/** PerishRateMultiplier of the pocket holding the instance, 1 by default. */
+	float GetPerishMultiplier(const FItemHandle Handle) const { return Column(Handle, &FSlab::PerishMultipliers); }
+	void SetPerishMultiplier(const FItemHandle Handle, const float Multiplier) { Column(Handle, &FSlab::PerishMultipliers) = Multiplier; }
+	/** Durability lost per second by weathering, 0 by default. */
+	float GetWearRate(const FItemHandle Handle) const { return Column(Handle, &FSlab::WearRates); }
+	void SetWearRate(const FItemHandle Handle, const float WearRate) { Column(Handle, &FSlab::WearRates) = WearRate; }
+	/** Time at which the durability, wear and, for lazy instances, the item and deadline were last brought up to date. */
+	double GetLastEvaluated(const FItemHandle Handle) const { return Column(Handle, &FSlab::LastEvaluated); }
+	void SetLastEvaluated(const FItemHandle Handle, const double Time) { Column(Handle, &FSlab::LastEvaluated) = Time; }
+	EItemAgingMode GetAgingMode(const FItemHandle Handle) const { return Column(Handle, &FSlab::AgingModes); }
+	void SetAgingMode(const FItemHandle Handle, const EItemAgingMode Mode) { Column(Handle, &FSlab::AgingModes) = Mode; }
+	FItemHandle GetContainer(const FItemHandle Handle) const { return FItemHandle::FromValue(Column(Handle, &FSlab::Containers)); }
+	void SetContainer(const FItemHandle Handle, const FItemHandle Container) { Column(Handle, &FSlab::Containers) = Container.GetValue(); }
+
+	/**
+	 * Copies every column of an instance.
+	 *
+	 * @param Handle The instance.
+	 * @param Catalog Catalog the item ids belong to, resolves the row name of the item.
+	 * @param OutInstance Receives the state of the instance.
+	 * @return False if the handle is invalid.
+	 */
+	bool Read(const FItemHandle Handle, const FItemCatalog& Catalog, FItemInstance& OutInstance) const;
+
+	/** Calls Function(FItemHandle) for every live instance, in slot order. Instances must not be created or destroyed meanwhile. */
+	template <typename FunctionType>
+	void ForEach(FunctionType&& Function) const
+	{
+		for (int32 Index = 0; Index < NumSlots; ++Index)
+		{
+			const FSlab& Slab = GetSlab(Index);
+			const int32 Slot = Index & SlotMask;
+			if (Slab.ItemIds[Slot] != INDEX_NONE)
+			{
+				Function(FItemHandle(Index, Slab.Generations[Slot]));
+			}
+		}
+	}
+
+private:
+	static constexpr int32 SlotMask = SlabSize - 1;
+
+	/** One column per field, SlabSize values each. Free slots have an item id of INDEX_NONE. */
+	struct FSlab
+	{
+		double PerishDeadlines[SlabSize];
+		double LastEvaluated[SlabSize];
+		int32 ItemIds[SlabSize];
+		int32 Stacks[SlabSize];
+		float Durabilities[SlabSize];
+		float Wears[SlabSize];
+		float PerishMultipliers[SlabSize];
+		float WearRates[SlabSize];
+		uint32 Containers[SlabSize];
+		/** Next free slot of the free list, only meaningful for free slots. */
+		int32 NextFree[SlabSize];
+		uint16 Generations[SlabSize];
+		EItemAgingMode AgingModes[SlabSize];
+	};
+
+	FSlab& GetSlab(const uint32 Index) { return *Slabs[Index >> SlabShift]; }
+	const FSlab& GetSlab(const uint32 Index) const { return *Slabs[Index >> SlabShift]; }
+
+	template <typename ValueType>
+	ValueType& Column(const FItemHandle Handle, ValueType (FSlab::*Field)[SlabSize])
+	{
+		checkSlow(IsValid(Handle));
+		return (GetSlab(Handle.GetIndex()).*Field)[Handle.GetIndex() & SlotMask];
+	}
+	template <typename ValueType>
+	const ValueType& Column(const FItemHandle Handle, ValueType (FSlab::*Field)[SlabSize]) const
+	{
+		checkSlow(IsValid(Handle));
+		return (GetSlab(Handle.GetIndex()).*Field)[Handle.GetIndex() & SlotMask];
+	}
+
+	/** Appends a slab and pushes its slots on the free list. @return False if the store is full. */
+	bool AddSlab();
+
+	// ========== VARIABLES ==========
+	TArray<TUniquePtr<FSlab>> Slabs;
+	/** First slot of the free list, INDEX_NONE when every slot is live. */
+	int32 FirstFree = INDEX_NONE;
+	int32 NumSlots = 0;
+	int32 NumLive = 0;
+};
+
+// ===============================[ Item Instance Subsystem ]============================
+
+/** One instance that perished during a frame. */
+struct FPerishTransform
+{
+	FItemHandle Handle;
+	int32 FromItem = INDEX_NONE;
+	/** The PerishTo item the instance became, INDEX_NONE when it perished into nothing and is destroyed after the broadcast. */
+	int32 ToItem = INDEX_NONE;
+};
+
+/**
+ * Owns the item instances of a world.
+ * Gameplay code keeps FItemHandle values instead of instance objects; the blueprint functions below copy instances in
+ * and out through FItemInstance.
+ * Perishable instances get a deadline from their PerishRate and the multiplier of their pocket, kept in a timing wheel:
+ * each frame only the instances whose deadline passed are touched, and they are turned into their PerishTo item in one
+ * batch.
+ * Instances nobody observes (storage chests, offline players, unloaded cells) can be suspended instead: they leave the
+ * wheel and cost nothing until read, when Refresh computes their freshness, PerishTo chain, durability and wear in
+ * closed form, see HlpItem::AgeInstance.
+ * Nesting in containers is mirrored in a container tree caching the mass of every subtree, so that encumbrance checks
+ * read one value instead of walking the content of nested bags.
+ */
+UCLASS()
+class WARFALLCORE_API UItemInstanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnInstancesPerished, TConstArrayView<FPerishTransform>);
+
+	// ========== FUNCTIONS ==========
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	FItemInstanceStore& GetStore() { return Store; }
+	const FItemInstanceStore& GetStore() const { return Store; }
+	const FPerishScheduler& GetPerishScheduler() const { return PerishScheduler; }
+	FItemContainerTree& GetContainerTree() { return ContainerTree; }
+	const FItemContainerTree& GetContainerTree() const { return ContainerTree; }
+
+	/**
+	 * Creates an instance of an item at full durability.
+	 *
+	 * @param ItemID Row of the item in the items table.
+	 * @param Stack Number of items in the stack, clamped to the max stack size of the item.
+	 * @return The handle of the instance, invalid if the item is unknown.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	FItemHandle CreateInstance(const FName ItemID, const int32 Stack = 1);
+
+	/** Destroys an instance; its content moves to the container holding it. */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	bool DestroyInstance(const FItemHandle Handle);
+
+	UFUNCTION(BlueprintPure, Category = "Items")
+	bool IsValidInstance(const FItemHandle Handle) const { return Store.IsValid(Handle); }
+
+	/** Refreshes the instance before copying it. @return False if the handle is invalid. */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	bool GetInstance(const FItemHandle Handle, FItemInstance& OutInstance);
+
+	/**
+	 * Brings the durability and wear of an instance up to date and, for lazy instances, its item and perish deadline.
+	 * To call before reading the aging columns of the store directly.
+	 *
+	 * @return False if the handle is invalid or the instance perished into nothing and was destroyed.
+	 */
+	bool Refresh(const FItemHandle Handle);
+
+	/**
+	 * Switches instances to lazy aging, to call when their container stops being observed or streams out.
+	 * Cost is paid once here; the instances then cost nothing until read or resumed.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	void SuspendInstances(const TArray<FItemHandle>& Handles);
+	/** Catches instances up in closed form and puts their deadline back in the timing wheel. */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	void ResumeInstances(const TArray<FItemHandle>& Handles);
+
+	/** @return The share of the lifetime left, from 1 (fresh) to 0. 1 for items that do not perish or invalid handles. */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	float GetFreshness(const FItemHandle Handle);
+
+	/** Sets the durability lost per second by weathering, for instance when an item is exposed to the weather. */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	void SetWearRate(const FItemHandle Handle, const float WearRate);
+
+	/**
+	 * Changes the perish speed of an instance, to call when it moves to a pocket with another FPocketSpec::PerishRateMultiplier.
+	 * The remaining time is scaled by the ratio of the multipliers and the deadline rescheduled in O(1).
+	 *
+	 * @param Handle The instance.
+	 * @param Multiplier The new multiplier. Zero freezes the instance for all practical purposes.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	void SetPerishMultiplier(const FItemHandle Handle, const float Multiplier);
+
+	/**
+	 * Puts an instance and its content in a container, in O(depth) of both places.
+	 *
+	 * @param Handle The instance.
+	 * @param Container An instance of an item with a container, or an invalid handle to take the instance out.
+	 * @return False if the container has not enough free cells or is inside the instance.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	bool MoveToContainer(const FItemHandle Handle, const FItemHandle Container);
+
+	/**
+	 * Changes the size of a stack, for instance when items are consumed. The masses of the containers above follow.
+	 *
+	 * @param Handle The instance.
+	 * @param Stack The new size, clamped to the max stack size. The instance is destroyed at 0.
+	 * @return False if the handle is invalid or the instance was destroyed.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	bool SetStack(const FItemHandle Handle, const int32 Stack);
+
+	/**
+	 * Restores the durability of an instance up to the cap its permanent wear leaves.
+	 *
+	 * @return False if the handle is invalid, the instance perished into nothing or its item cannot be repaired.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	bool Repair(const FItemHandle Handle);
+
+	/**
+	 * Creates the instances of one chunk of a snapshot, see FItemSnapshotReader.
+	 * Times saved relative to the save are placed on the current clock; items missing from the catalog are skipped
+	 * with a warning and their content restored as roots.
+	 *
+	 * @param Entries The entries of the chunk.
+	 * @param InOutHandles Instances of the previous chunks by snapshot index, receives those of the chunk, invalid for
+	 *                     skipped entries.
+	 * @return The number of instances created.
+	 */
+	int32 RestoreInstances(TConstArrayView<FItemSnapshotEntry> Entries, TArray<FItemHandle>& InOutHandles);
+
+	/** @return The mass of an instance and everything nested inside it. */
+	UFUNCTION(BlueprintPure, Category = "Items")
+	float GetCarriedMass(const FItemHandle Handle) const { return static_cast<float>(ContainerTree.GetMass(Handle)); }
+
+	/**
+	 * Indexes the content of a container for search, to call when a large storage opens.
+	 * The index then follows every instance entering, leaving or perishing in the container until it is disabled or
+	 * the container destroyed. Only the instances directly in the container are indexed, not the content of bags.
+	 *
+	 * @param Container An instance of an item with a container.
+	 * @return The index, nullptr if the handle is invalid. Stays valid until the index is disabled.
+	 */
+	const FContainerSearchIndex* EnableSearchIndex(const FItemHandle Container);
+	void DisableSearchIndex(const FItemHandle Container) { SearchIndexes.Remove(Container); }
+	/** @return The index of a container, nullptr if it was not enabled. */
+	const FContainerSearchIndex* FindSearchIndex(const FItemHandle Container) const;
+
+	/** Broadcast once per frame with every scheduled instance that perished, and on refresh for lazy instances. */
+	FOnInstancesPerished OnInstancesPerished;
+
+private:
+	/** Current time of the perish clock, the world time in seconds. */
+	double GetNow() const;
+	/**
+	 * Gives an instance the full lifetime of its item from a time, or clears its deadline if the item does not perish.
+	 *
+	 * @param Handle The instance.
+	 * @param From Start of the lifetime. Chained transformations start at the deadline of the previous item.
+	 */
+	void StartPerishing(const FItemHandle Handle, const double From);
+	/** Turns the expired instances into their PerishTo item and notifies the listeners. */
+	void ApplyPerished();
+	/** Mass of the stack and cells of an instance, from the catalog. */
+	FContainedItem DescribeInstance(const FItemHandle Handle) const;
+	/** Takes an instance out of the container tree and the store, its content moving up. */
+	void ReleaseInstance(const FItemHandle Handle);
+	/** Moves an instance between the search indexes of two containers, if they have one. */
+	void MoveSearchEntry(const FItemHandle Handle, const FItemHandle From, const FItemHandle To);
+	/** Indexes an instance again in its container, after it turned into another item. */
+	void UpdateSearchEntry(const FItemHandle Handle);
+
+	// ========== VARIABLES ==========
+	FItemInstanceStore Store;
+	FPerishScheduler PerishScheduler;
+	FItemContainerTree ContainerTree;
+	/** Boxed so that views keep pointing to their index while others are enabled. */
+	TMap<FItemHandle, TUniquePtr<FContainerSearchIndex>> SearchIndexes;
+	/** Reused every frame, so that perishing does not allocate in steady state. */
+	TArray<FItemHandle> ExpiredHandles;
+	TArray<FPerishTransform> PerishTransforms;
+};
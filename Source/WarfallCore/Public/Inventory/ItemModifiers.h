@@ -0,0 +1,221 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/ItemRangedArray.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Utils/GlobalTools.h"
+#include "ItemModifiers.generated.h"
+
+struct FItemCatalog;
+struct FItemRow;
+
+// ===============================[ Item Modifier Table ]============================
+
+/** One modifier of an item, compiled to an operation on a dense stat slot. */
+struct FCompiledModifier
+{
+	uint16 Slot = 0;
+	/** E_Add, E_Multiply or E_Override. Divisions are compiled to multiplications by the reciprocal. */
+	EMathOperation Operation = EMathOperation::E_Add;
+	uint8 Padding = 0;
+	float Value = 0.0f;
+};
+
+static_assert(sizeof(FCompiledModifier) == 8, "FCompiledModifier is part of the cooked catalog format.");
+
+/**
+ * Modifiers of every item, compiled into one flat op list.
+ * Stat keys (the Item.Meta tag of each FItemMetaEntry, and the names of FItemRow::Modifiers which are additions) are
+ * interned into dense slots. The ops of an item are contiguous and sorted by slot, authoring order kept within a slot.
+ */
+class WARFALLCORE_API FItemModifierTable
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Compiles the modifiers of every row of the catalog, which must hold its rows. */
+	void Build(const FItemCatalog& Catalog);
+	void Reset();
+
+	/**
+	 * Uses ops owned elsewhere, laid out like CopyRawOps (memory-mapped catalogs).
+	 * The storage must outlive the table, which becomes read-only.
+	 *
+	 * @param InStatKeys One key per slot.
+	 * @param InRanges InNumItems + 1 offsets into InOps, the ops of item Id being [InRanges[Id], InRanges[Id + 1]).
+	 * @param InOps Every op, item after item.
+	 * @param InNumItems Number of items covered by the table.
+	 */
+	void BindExternal(TArray<FName> InStatKeys, const uint32* InRanges, const FCompiledModifier* InOps, const int32 InNumItems);
+
+	/**
+	 * Recompiles the ops of one item. The ops of the other items never move.
+	 *
+	 * @param Id The item id.
+	 * @param Row The new row, or nullptr when the row was removed from the table.
+	 * @param RowName Name of the row, for diagnostics.
+	 */
+	void SetRow(const int32 Id, const FItemRow* Row, const FName RowName);
+	/** Compiles a row appended at the end of the catalog. */
+	void AddRow(const FItemRow& Row, const FName RowName);
+
+	/** @return The ops of an item, empty for unknown ids. */
+	TConstArrayView<FCompiledModifier> GetOps(const int32 Id) const
+	{
+		return Ops.Get(Id);
+	}
+
+	/**
+	 * Resolves the slot of a stat.
+	 *
+	 * @param StatKey Item.Meta tag name, or key of FItemRow::Modifiers.
+	 * @return The slot, or INDEX_NONE if no item modifies this stat.
+	 */
+	int32 FindSlot(const FName StatKey) const
+	{
+		const int32* Slot = StatSlots.Find(StatKey);
+		return Slot ? *Slot : INDEX_NONE;
+	}
+	FName GetStatKey(const int32 Slot) const { return StatKeys.IsValidIndex(Slot) ? StatKeys[Slot] : NAME_None; }
+	TConstArrayView<FName> GetStatKeys() const { return StatKeys; }
+	int32 NumSlots() const { return StatKeys.Num(); }
+	int32 NumOps() const { return Ops.NumValues(); }
+
+	/**
+	 * Copies the ops for the cooked catalog.
+	 *
+	 * @param OutRanges Receives one offset per item plus one, the ops of item Id being [OutRanges[Id], OutRanges[Id + 1]).
+	 * @param OutOps Receives every op, item after item.
+	 */
+	void CopyRawOps(TArray<uint32>& OutRanges, TArray<FCompiledModifier>& OutOps) const { Ops.CopyCompact(OutRanges, OutOps); }
+
+private:
+	int32 FindOrAddSlot(const FName StatKey);
+	/** Appends the sorted ops of a row to OutOps. */
+	void CompileRow(const FItemRow& Row, const FName RowName, TArray<FCompiledModifier>& OutOps);
+
+	// ========== VARIABLES ==========
+	TItemRangedArray<FCompiledModifier> Ops;
+	/** Ops of the row being compiled, kept to reuse its allocation. */
+	TArray<FCompiledModifier> RowOps;
+	TArray<FName> StatKeys;
+	TMap<FName, int32> StatSlots;
+};
+
+// ===============================[ Item Modifier Evaluator ]============================
+
+/** Handle of an item set (the equipped and consumed items of one character) inside an FItemModifierEvaluator. */
+using FModifierSetId = int32;
+
+/**
+ * Aggregates the modifiers of many item sets.
+ * Each set caches, per stat slot, the sum of its additions, the product of its multiplications and its last override.
+ * Changing the items of a set only marks it dirty; Flush then recomputes every dirty set in one parallel pass, and
+ * Resolve applies the cached aggregates to the base stats four slots at a time.
+ */
+class WARFALLCORE_API FItemModifierEvaluator
+{
+	// ========== FUNCTIONS ==========
+public:
+	FModifierSetId AddSet();
+	void RemoveSet(const FModifierSetId Set);
+	bool IsValidSet(const FModifierSetId Set) const { return SetAlive.IsValidIndex(Set) && SetAlive[Set]; }
+
+	/** Replaces the items of a set. The set is only marked dirty when its content changes. */
+	void SetItems(const FModifierSetId Set, TConstArrayView<int32> Items);
+	void AddItem(const FModifierSetId Set, const int32 Item);
+	/** Removes one occurrence of an item. @return False if the set did not hold the item. */
+	bool RemoveItem(const FModifierSetId Set, const int32 Item);
+	TConstArrayView<int32> GetItems(const FModifierSetId Set) const { return SetItemIds[Set]; }
+
+	bool IsDirty(const FModifierSetId Set) const { return SetDirty[Set]; }
+	/** Marks every set dirty, to call when the modifier table is rebuilt. */
+	void InvalidateAll();
+	/** Marks dirty the sets holding any of the given items, to call when their rows are patched. */
+	void InvalidateItems(TConstArrayView<int32> Items);
+
+	/**
+	 * Recomputes the aggregates of every dirty set.
+	 *
+	 * @param Table The compiled modifiers the item ids refer to.
+	 * @return The number of sets recomputed.
+	 */
+	int32 Flush(const FItemModifierTable& Table);
+
+	/**
+	 * Applies the aggregates of a set to one stat. The set must have been flushed.
+	 *
+	 * @param Set The item set.
+	 * @param Slot Slot of the stat in the modifier table.
+	 * @param Base Value of the stat without any item.
+	 * @return (Base + additions) * multiplications, or the last override.
+	 */
+	float Evaluate(const FModifierSetId Set, const int32 Slot, const float Base) const;
+	/**
+	 * Applies the aggregates of a set to every stat at once. The set must have been flushed.
+	 *
+	 * @param Set The item set.
+	 * @param Base One base value per slot of the modifier table.
+	 * @param Out Receives one value per slot. May alias Base.
+	 */
+	void Resolve(const FModifierSetId Set, TConstArrayView<float> Base, TArrayView<float> Out) const;
+
+private:
+	void Recompute(const FModifierSetId Set, const FItemModifierTable& Table);
+
+	// ========== VARIABLES ==========
+	TArray<TArray<int32>> SetItemIds;
+	TArray<bool> SetDirty;
+	TArray<bool> SetAlive;
+	TArray<FModifierSetId> FreeSets;
+
+	/** Aggregates, SlotStride floats per set. Overrides are blended in through a 0/1 mask. */
+	TArray<float, TAlignedHeapAllocator<16>> Adds;
+	TArray<float, TAlignedHeapAllocator<16>> Scales;
+	TArray<float, TAlignedHeapAllocator<16>> Overrides;
+	TArray<float, TAlignedHeapAllocator<16>> OverrideMasks;
+	int32 NumSlots = 0;
+	int32 SlotStride = 0;
+};
+
+// ===============================[ Item Modifier Subsystem ]============================
+
+/**
+ * Owns the modifier aggregates of every character of a world.
+ * Characters register one item set each and update it when their equipment or active consumables change; the dirty
+ * sets are recomputed together once per frame, and all of them when the item catalog is rebuilt.
+ */
+UCLASS()
+class WARFALLCORE_API UItemModifierSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	// ========== FUNCTIONS ==========
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	FItemModifierEvaluator& GetEvaluator() { return Evaluator; }
+	const FItemModifierEvaluator& GetEvaluator() const { return Evaluator; }
+
+	/** Recomputes the dirty sets now, for callers that need the new values within the frame of the change. */
+	void Flush();
+
+	/**
+	 * Resolves the slot of a stat in the compiled modifiers of the item catalog.
+	 *
+	 * @param StatKey Item.Meta tag name, or key of FItemRow::Modifiers.
+	 * @return The slot, or INDEX_NONE if no item modifies this stat.
+	 */
+	static int32 FindStatSlot(const FName StatKey);
+
+private:
+	void HandleCatalogRebuilt();
+	void HandleRowsPatched(TConstArrayView<int32> Items);
+
+	// ========== VARIABLES ==========
+	FItemModifierEvaluator Evaluator;
+	FDelegateHandle CatalogRebuiltHandle;
+	FDelegateHandle RowsPatchedHandle;
+};
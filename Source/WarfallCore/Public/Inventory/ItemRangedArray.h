@@ -0,0 +1,166 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+// ===============================[ Item Ranged Array ]============================
+
+/**
+ * Variable-length entries of every item id (modifier ops, repair materials, meta entries), stored in one array.
+ * Each id keeps its own [begin, end) range, so replacing the entries of one id never moves those of the others: entries
+ * that fit in the old range are written in place, the others are appended at the end and the old range becomes slack,
+ * reclaimed once it outweighs the live entries. Arrays bound on external storage read the compact layout of the cooked
+ * catalog, NumItems + 1 offsets, and CopyCompact writes that layout back.
+ */
+template <typename T>
+class TItemRangedArray
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Below this number of slack entries, Set never compacts the array. */
+	static constexpr int32 MinCompactSlack = 64;
+
+	void Reset()
+	{
+		Begins.Reset();
+		Ends.Reset();
+		Values.Reset();
+		BeginData = nullptr;
+		EndData = nullptr;
+		ValueData = nullptr;
+		NumItems = 0;
+		NumSlack = 0;
+	}
+
+	/**
+	 * Reads entries owned elsewhere (memory-mapped catalogs). The storage must outlive the array, which becomes read-only.
+	 *
+	 * @param InRanges InNumItems + 1 offsets into InValues, the entries of item Id being [InRanges[Id], InRanges[Id + 1]).
+	 * @param InValues Every entry, item after item.
+	 * @param InNumItems Number of items covered by the array.
+	 */
+	void BindExternal(const uint32* InRanges, const T* InValues, const int32 InNumItems)
+	{
+		Reset();
+		BeginData = InRanges;
+		EndData = InRanges + 1;
+		ValueData = InValues;
+		NumItems = InNumItems;
+	}
+
+	/** Appends the entries of the next id. */
+	void Add(TConstArrayView<T> ItemValues)
+	{
+		check(!IsExternal());
+		Begins.Add(Values.Num());
+		Values.Append(ItemValues.GetData(), ItemValues.Num());
+		Ends.Add(Values.Num());
+		NumItems++;
+		RefreshData();
+	}
+
+	/** Replaces the entries of an id, in place when they fit in its current range, at the end of the array otherwise. */
+	void Set(const int32 Id, TConstArrayView<T> ItemValues)
+	{
+		check(!IsExternal());
+		check(Id >= 0 && Id < NumItems);
+
+		const int32 OldCount = Ends[Id] - Begins[Id];
+		if (ItemValues.Num() <= OldCount)
+		{
+			for (int32 Index = 0; Index < ItemValues.Num(); ++Index)
+			{
+				Values[Begins[Id] + Index] = ItemValues[Index];
+			}
+			NumSlack += OldCount - ItemValues.Num();
+		}
+		else
+		{
+			Begins[Id] = Values.Num();
+			Values.Append(ItemValues.GetData(), ItemValues.Num());
+			NumSlack += OldCount;
+		}
+		Ends[Id] = Begins[Id] + ItemValues.Num();
+
+		if (NumSlack >= MinCompactSlack && NumSlack > Values.Num() / 2)
+		{
+			Compact();
+		}
+		RefreshData();
+	}
+
+	/** @return The entries of an item, empty for unknown ids. */
+	TConstArrayView<T> Get(const int32 Id) const
+	{
+		if (Id < 0 || Id >= NumItems) return TConstArrayView<T>();
+		return TConstArrayView<T>(ValueData + BeginData[Id], EndData[Id] - BeginData[Id]);
+	}
+
+	int32 Num() const { return NumItems; }
+	/** @return The number of entries of every item, slack excluded. */
+	int32 NumValues() const
+	{
+		if (IsExternal()) return NumItems > 0 ? static_cast<int32>(EndData[NumItems - 1]) : 0;
+		return Values.Num() - NumSlack;
+	}
+	/** @return True if the array reads external storage. */
+	bool IsExternal() const { return BeginData != Begins.GetData(); }
+
+	/**
+	 * Writes the compact layout of the cooked catalog.
+	 *
+	 * @param OutRanges Receives NumItems + 1 offsets into OutValues, nothing when the array is empty.
+	 * @param OutValues Receives every entry, item after item, without slack.
+	 */
+	void CopyCompact(TArray<uint32>& OutRanges, TArray<T>& OutValues) const
+	{
+		OutRanges.Reset(NumItems > 0 ? NumItems + 1 : 0);
+		OutValues.Reset(NumValues());
+		for (int32 Id = 0; Id < NumItems; ++Id)
+		{
+			OutRanges.Add(OutValues.Num());
+			const TConstArrayView<T> ItemValues = Get(Id);
+			OutValues.Append(ItemValues.GetData(), ItemValues.Num());
+		}
+		if (NumItems > 0)
+		{
+			OutRanges.Add(OutValues.Num());
+		}
+	}
+
+private:
+	/** Moves every range back to back, dropping the slack. */
+	void Compact()
+	{
+		TArray<T> Compacted;
+		Compacted.Reserve(Values.Num() - NumSlack);
+		for (int32 Id = 0; Id < NumItems; ++Id)
+		{
+			const uint32 Begin = Compacted.Num();
+			Compacted.Append(Values.GetData() + Begins[Id], Ends[Id] - Begins[Id]);
+			Begins[Id] = Begin;
+			Ends[Id] = Compacted.Num();
+		}
+		Values = MoveTemp(Compacted);
+		NumSlack = 0;
+	}
+
+	void RefreshData()
+	{
+		BeginData = Begins.GetData();
+		EndData = Ends.GetData();
+		ValueData = Values.GetData();
+	}
+
+	// ========== VARIABLES ==========
+	/** Entries of item Id are Values[Begins[Id], Ends[Id]). */
+	TArray<uint32> Begins;
+	TArray<uint32> Ends;
+	TArray<T> Values;
+	/** Read pointers, either on the arrays above or on external storage. */
+	const uint32* BeginData = nullptr;
+	const uint32* EndData = nullptr;
+	const T* ValueData = nullptr;
+	int32 NumItems = 0;
+	/** Entries no range covers anymore. */
+	int32 NumSlack = 0;
+};
@@ -264,7 +264,7 @@ struct FPocketSpec
 
 /**
  * Struct representing an entry of item metadata used to define modifications to game statistics.
- * Each entry consists of a key identifying the statistic and a value determining the modification amount.
+ * Each entry consists of a key identifying the statistic, the operation applied to it and the modification amount.
  */
 USTRUCT(BlueprintType)
 struct FItemMetaEntry
@@ -283,6 +283,12 @@ struct FItemMetaEntry
 	 */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float Value = 0;
+	/**
+	 * Operation applying Value to the statistic. Every addition of a stat is summed first, then the multiplications and
+	 * divisions are applied; an override replaces the result.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EMathOperation Operation = EMathOperation::E_Add;
 };
 
 // ===============================[ Property Customization Factory ]============================
@@ -677,13 +683,72 @@ struct FItemRow
 	}
 };
 
+/**
+ * 32-bit generational handle of an item instance, see FItemInstanceStore.
+ * The low IndexBits address the slot of the instance, the high bits hold the generation of the slot when the handle was
+ * issued. Destroying an instance bumps the generation, so stale handles are detected instead of reaching a recycled slot.
+ */
+USTRUCT(BlueprintType)
+struct FItemHandle
+{
+	GENERATED_BODY()
+
+	static constexpr uint32 IndexBits = 20;
+	static constexpr uint32 IndexMask = (1u << IndexBits) - 1u;
+	/** Generations cycle in [1, MaxGeneration], so a valid handle is never 0. */
+	static constexpr uint32 MaxGeneration = (1u << (32 - IndexBits)) - 1u;
+
+	FItemHandle() = default;
+	FItemHandle(const uint32 Index, const uint32 Generation) :
+	 Value(Generation << IndexBits | (Index & IndexMask))
+	{}
+
+	bool IsValid() const { return Value != 0; }
+	uint32 GetIndex() const { return Value & IndexMask; }
+	uint32 GetGeneration() const { return Value >> IndexBits; }
+	uint32 GetValue() const { return Value; }
+	static FItemHandle FromValue(const uint32 InValue)
+	{
+		FItemHandle Handle;
+		Handle.Value = InValue;
+		return Handle;
+	}
+
+	bool operator==(const FItemHandle& Other) const { return Value == Other.Value; }
+	bool operator!=(const FItemHandle& Other) const { return Value != Other.Value; }
+	friend uint32 GetTypeHash(const FItemHandle& Handle) { return Handle.Value; }
+
+private:
+	UPROPERTY()
+	uint32 Value = 0;
+};
+
+/**
+ * Copy of the state of one item instance, which lives column by column in an FItemInstanceStore.
+ * Used where a whole instance travels at once: blueprints, save games and spawn requests.
+ */
 USTRUCT(BlueprintType)
 struct FItemInstance
 {
 	GENERATED_BODY()
 
-	FGuid GuidID;
-	
+	UPROPERTY(BlueprintReadOnly)
+	FItemHandle Handle;
+	/** Row of the item in the items table. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FName ItemID = NAME_None;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Stack = 1;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Durability = 0.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Wear = 0.0f;
+	/** World time in seconds at which the item perishes, 0 when it never does. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	double PerishDeadline = 0.0;
+	/** Instance holding this one, invalid for items lying in a pocket of their owner. */
+	UPROPERTY(BlueprintReadOnly)
+	FItemHandle Container;
 };
 
 // ===============================[ Property Customization Factory ]============================
@@ -805,21 +870,29 @@ struct WARFALLCORE_API FItemRowDetail : public FTableRowBase
 	FItemRowDetail() :
 	 Details(FItemRow())
 	{}
-	
+
+	/** Reports the edited row to the item catalog, which patches its derived data instead of rebuilding it. */
+	virtual void OnDataTableChanged(const UDataTable* InDataTable, const FName InRowName) override;
 };
 
 namespace HlpItem
 {
-	inline bool GetItemRow(const FName RowID, FItemRow& OutItemRow)
-	{
-		const UDataTable* Table = UTables::GetTable(ETablePath::ItemsTable);
-		if (!Table) { return false; }
-
-		const FItemRowDetail* RowDetail = Table->FindRow<FItemRowDetail>(RowID, TEXT("Finding"));
-		if (!RowDetail) { return false; }
-		OutItemRow = RowDetail->Details;
-		return true;
-	}
+	/**
+	 * Copies an item row into OutItemRow.
+	 * Prefer FindItemRow in gameplay code, which returns a view on the row without copying it.
+	 *
+	 * @param RowID The row name inside ItemsTable.
+	 * @param OutItemRow Receives a copy of the row when found.
+	 * @return True if the row exists; false otherwise.
+	 */
+	WARFALLCORE_API bool GetItemRow(const FName RowID, FItemRow& OutItemRow);
+	/**
+	 * Finds an item row through the compiled item catalog, without loading the table or copying the row.
+	 *
+	 * @param RowID The row name inside ItemsTable.
+	 * @return A pointer to the row owned by ItemsTable, or nullptr if the row does not exist.
+	 */
+	WARFALLCORE_API const FItemRow* FindItemRow(const FName RowID);
 	inline bool IsPerishable(const FItemRow& Row) { return Row.CanPerish();	}
 	inline int32 GetPerishTime(const FItemRow& Row) { return Row.GetPerishTime(); }
 	inline float GetDurabilityMax(const FItemRow& Row) { return Row.MaxDurability; }
@@ -0,0 +1,166 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/ItemAging.h"
+#include "Inventory/ItemRowTypes.h"
+
+class FItemContainerTree;
+class FItemInstanceStore;
+struct FItemCatalog;
+
+// ===============================[ Item Snapshot ]============================
+
+/** Where a root instance sits in an inventory. */
+struct FItemSnapshotPlacement
+{
+	uint8 Pocket = 0;
+	uint8 CellX = 0;
+	uint8 CellY = 0;
+	bool bRotated = false;
+};
+
+/** One instance read back from a snapshot. */
+struct FItemSnapshotEntry
+{
+	/** Row of the item, NAME_None for instances destroyed while the snapshot was being written. */
+	FName ItemID;
+	int32 Stack = 0;
+	float Durability = 0.0f;
+	float Wear = 0.0f;
+	float PerishMultiplier = 1.0f;
+	float WearRate = 0.0f;
+	/** Seconds left before the item perished when saved, negative for lazy instances already overdue. */
+	double PerishRemaining = 0.0;
+	/** Seconds between the last evaluation of the instance and the save. */
+	double SinceEvaluated = 0.0;
+	/** Snapshot index of the container holding the instance, INDEX_NONE for roots. Containers always come first. */
+	int32 Parent = INDEX_NONE;
+	EItemAgingMode AgingMode = EItemAgingMode::Scheduled;
+	bool bPerishes = false;
+	bool bHasPlacement = false;
+	FItemSnapshotPlacement Placement;
+};
+
+/**
+ * Writes item instances, and everything nested inside them, as a versioned binary snapshot.
+ * The snapshot is written chunk by chunk so that a large storage is saved over several frames:
+ *
+ *   Header : Magic, Version, Flags (uint32 each)
+ *   Chunks : varint payload size (0 ends the snapshot), varint stored size (0 when stored uncompressed), stored bytes
+ *
+ * Each payload starts with the row names first used by the chunk, appended to the dictionary of the snapshot, then the
+ * instance count and one column per field: item (varint dictionary index, 0 for destroyed instances), stack (varint),
+ * parent (varint snapshot index + 1), flags (uint8), durability, wear, perish multiplier, wear rate (float), perish
+ * remaining (double, perishing instances only), since evaluated (double), placement (3 uint8, placed instances only).
+ * Items are stored by row name so that reordering or extending ItemsTable does not break saves, times relative to the
+ * save so that they survive the world clock restarting, and similar values next to each other so that they compress.
+ */
+class WARFALLCORE_API FItemSnapshotWriter
+{
+	// ========== FUNCTIONS ==========
+public:
+	static constexpr uint32 Magic = 0x53494657; // "WFIS"
+	static constexpr uint32 Version = 1;
+	static constexpr uint32 FlagCompressed = 1;
+	static constexpr int32 DefaultChunkSize = 4096;
+
+	/**
+	 * @param InAr Destination archive, must outlive the writer.
+	 * @param InStore Store holding the instances.
+	 * @param InTree Container tree of the store, to collect the content of the roots.
+	 * @param InCatalog Catalog the item ids belong to.
+	 * @param bInCompress True to compress each chunk, when it gets smaller.
+	 */
+	FItemSnapshotWriter(FArchive& InAr, const FItemInstanceStore& InStore, const FItemContainerTree& InTree, const FItemCatalog& InCatalog, const bool bInCompress = true);
+
+	/**
+	 * Queues an instance and everything nested inside it, containers before their content.
+	 *
+	 * @param Handle The instance.
+	 * @param Placement Slot of the instance in an inventory, if any.
+	 */
+	void AddRoot(const FItemHandle Handle, const FItemSnapshotPlacement* Placement = nullptr);
+
+	/**
+	 * Writes the next chunk of queued instances, as they are at this time. Call once per frame until it returns false.
+	 *
+	 * @param Now Current time of the perish clock.
+	 * @param MaxInstances Number of instances in the chunk.
+	 * @return True while instances remain. The end of the snapshot is written along with the last chunk.
+	 */
+	bool WriteChunk(const double Now, const int32 MaxInstances = DefaultChunkSize);
+
+	/** Number of instances queued. */
+	int32 Num() const { return Queued.Num(); }
+	int32 NumWritten() const { return NextIndex; }
+	/** @return The instance written at a snapshot index. */
+	FItemHandle GetHandle(const int32 Index) const { return Queued[Index].Handle; }
+
+private:
+	struct FQueuedInstance
+	{
+		FItemHandle Handle;
+		int32 Parent = INDEX_NONE;
+		bool bHasPlacement = false;
+		FItemSnapshotPlacement Placement;
+	};
+
+	// ========== VARIABLES ==========
+	FArchive& Ar;
+	const FItemInstanceStore& Store;
+	const FItemContainerTree& Tree;
+	const FItemCatalog& Catalog;
+	TArray<FQueuedInstance> Queued;
+	/** Dictionary index of every item written so far, from 1. */
+	TMap<int32, uint32> NameIndices;
+	/** Reused by every chunk. */
+	TArray<uint8> Payload;
+	TArray<uint8> Compressed;
+	TArray<uint32> ChunkNames;
+	int32 NextIndex = 0;
+	bool bCompress = true;
+	bool bHeaderWritten = false;
+	bool bFinished = false;
+};
+
+/** Reads a snapshot written by FItemSnapshotWriter, chunk by chunk. */
+class WARFALLCORE_API FItemSnapshotReader
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Largest chunk accepted, against corrupted sizes. */
+	static constexpr uint32 MaxChunkBytes = 64 * 1024 * 1024;
+
+	/** @param InAr Source archive, must outlive the reader. */
+	explicit FItemSnapshotReader(FArchive& InAr);
+
+	/** @return False if the archive does not start with a snapshot of a supported version. */
+	bool ReadHeader();
+	/**
+	 * Reads the next chunk.
+	 *
+	 * @param OutEntries Receives the instances of the chunk, appended in snapshot order.
+	 * @return The number of entries appended, 0 once the snapshot ended, INDEX_NONE if the chunk is corrupted.
+	 */
+	int32 ReadChunk(TArray<FItemSnapshotEntry>& OutEntries);
+
+	uint32 GetVersion() const { return Version; }
+	bool IsDone() const { return bDone; }
+	/** Number of instances read so far. */
+	int32 NumRead() const { return NextIndex; }
+
+private:
+	/** Parses a decompressed payload. @return False if it is inconsistent. */
+	bool ReadPayload(TArray<FItemSnapshotEntry>& OutEntries);
+
+	// ========== VARIABLES ==========
+	FArchive& Ar;
+	/** Dictionary of the snapshot, NAME_None first. */
+	TArray<FName> Names;
+	TArray<uint8> Payload;
+	TArray<uint8> Stored;
+	uint32 Version = 0;
+	uint32 Flags = 0;
+	int32 NextIndex = 0;
+	bool bDone = false;
+};
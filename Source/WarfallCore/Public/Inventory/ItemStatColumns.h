@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+struct FItemRow;
+struct FItemCatalog;
+
+/**
+ * Numeric item fields read by the simulation every tick.
+ * Each value owns one contiguous column inside FItemStatColumns.
+ */
+enum class EItemStat : uint8
+{
+	WeaponDamage,
+	ArmorPenetration,
+	FleshDamage,
+	ArmorValue,
+	PerishRate,
+	MaxDurability,
+	/** Absolute wear threshold, MaxDurability * MaxWear (see FItemRow::GetMaxWear). */
+	MaxWear,
+	/** Mass resolved once from WeightConfig, so dynamic masses never walk the meshes at runtime. */
+	Mass,
+
+	Num
+};
+
+// ===============================[ Item Stat Columns ]============================
+
+/**
+ * Structure-of-arrays copy of the hot numeric fields of every catalog item, indexed by dense item id.
+ * Loops over thousands of items stream through one column instead of touching full FItemRow structures,
+ * which mix editor data, localized texts and containers the simulation never reads.
+ */
+struct WARFALLCORE_API FItemStatColumns
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Rebuilds every column from the rows of the catalog. */
+	void Build(const FItemCatalog& Catalog);
+	void Reset();
+
+	/**
+	 * Writes the hot fields of a row into its column slots.
+	 *
+	 * @param Id Dense id of the item, must be lower than Num().
+	 * @param Row The source row.
+	 */
+	void SetRow(const int32 Id, const FItemRow& Row);
+	/** Zeroes every stat of an id, for rows removed from the table. */
+	void ClearRow(const int32 Id);
+	/** Appends a row at id Num(), growing the columns geometrically. */
+	void AddRow(const FItemRow& Row);
+
+	/**
+	 * Points the columns at storage owned elsewhere, laid out like GetRawFloats and GetRawStackSizes.
+	 * Used by memory-mapped catalogs; the storage must outlive the columns, which become read-only.
+	 *
+	 * @param InFloats EItemStat::Num columns of InStride floats.
+	 * @param InStackSizes InStride max stack sizes.
+	 * @param InNumItems Number of items in each column.
+	 * @param InStride Number of floats between two columns.
+	 */
+	void BindExternal(const float* InFloats, const int32* InStackSizes, const int32 InNumItems, const int32 InStride);
+	bool IsExternal() const { return NumItems > 0 && FloatData != FloatColumns.GetData(); }
+
+	/** @return The whole column of a stat, one value per item id. */
+	TConstArrayView<float> GetColumn(const EItemStat Stat) const
+	{
+		return TConstArrayView<float>(FloatData + static_cast<int32>(Stat) * Stride, NumItems);
+	}
+	float Get(const EItemStat Stat, const int32 Id) const
+	{
+		checkSlow(Id >= 0 && Id < NumItems);
+		return FloatData[static_cast<int32>(Stat) * Stride + Id];
+	}
+
+	TConstArrayView<int32> GetMaxStackSizes() const { return TConstArrayView<int32>(StackData, NumItems); }
+	int32 GetMaxStackSize(const int32 Id) const
+	{
+		checkSlow(Id >= 0 && Id < NumItems);
+		return StackData[Id];
+	}
+
+	int32 Num() const { return NumItems; }
+	int32 GetStride() const { return Stride; }
+
+	/** @return Every float column back to back, Stride values each, padding included. */
+	TConstArrayView<float> GetRawFloats() const { return TConstArrayView<float>(FloatData, NumItems > 0 ? Stride * static_cast<int32>(EItemStat::Num) : 0); }
+	/** @return The max stack size column, Stride values, padding included. */
+	TConstArrayView<int32> GetRawStackSizes() const { return TConstArrayView<int32>(StackData, NumItems > 0 ? Stride : 0); }
+
+private:
+	void Allocate(const int32 InNumItems);
+	/** Moves every column to a larger stride, keeping the values of the current items. */
+	void Relayout(const int32 NewStride);
+
+	// ========== VARIABLES ==========
+	/** Number of floats per column. Rounded up so every column starts on its own cache line. */
+	static constexpr int32 ColumnAlignment = 16;
+
+	/** Column-major float storage: Stride values per EItemStat. */
+	TArray<float, TAlignedHeapAllocator<64>> FloatColumns;
+	TArray<int32, TAlignedHeapAllocator<64>> MaxStackSizes;
+	/** Read pointers, either on the arrays above or on external storage. */
+	const float* FloatData = nullptr;
+	const int32* StackData = nullptr;
+	int32 NumItems = 0;
+	int32 Stride = 0;
+};
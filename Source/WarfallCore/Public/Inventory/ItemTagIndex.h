@@ -0,0 +1,129 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Inventory/ItemRangedArray.h"
+#include "Utils/DenseBitSet.h"
+
+struct FItemRow;
+struct FItemCatalog;
+
+/**
+ * Inverted index from gameplay tag to the set of items carrying it.
+ * Each item contributes its Tags and its IngredientsType, together with all their parent tags,
+ * so "every item under Ingredients.Components" is a single posting read. State tags (Flags) are
+ * already packed in the capability mask of the catalog and are not indexed here.
+ * Name queries only see the Tags: the tags an item reaches through its IngredientsType alone get a second posting,
+ * the name posting, holding the items carrying them in their Tags.
+ */
+struct WARFALLCORE_API FItemTagIndex
+{
+	// ========== FUNCTIONS ==========
+public:
+	/** Rebuilds every posting from the rows of the catalog. */
+	void Build(const FItemCatalog& Catalog);
+	void Reset();
+
+	/**
+	 * Uses postings owned elsewhere, laid out like GetRawWords (memory-mapped catalogs).
+	 * The storage must outlive the index, which becomes read-only.
+	 *
+	 * @param InTags One tag per posting slot. Invalid tags keep their slot but cannot be queried.
+	 * @param InWords InTags.Num() postings of NumWordsFor(InNumItems) words each.
+	 * @param InNameSlots Name posting of each slot, laid out like GetNameSlots.
+	 * @param InNameWords Name postings, laid out like GetRawNameWords.
+	 * @param InNumItems Number of items covered by every posting.
+	 */
+	void BindExternal(TArray<FGameplayTag> InTags, const uint64* InWords, TArray<int32> InNameSlots, const uint64* InNameWords, const int32 InNumItems);
+
+	/**
+	 * Re-indexes one item after its row changed. Costs one word write per tag the item was or is now indexed under.
+	 *
+	 * @param Id The item id.
+	 * @param Row The new row, or nullptr when the row was removed from the table.
+	 */
+	void SetRow(const int32 Id, const FItemRow* Row);
+	/** Indexes a row appended at id NumItems(). */
+	void AddRow(const FItemRow& Row);
+
+	/**
+	 * Collects the tags an item is indexed under: its own tags and every parent.
+	 *
+	 * @param Row The item row.
+	 * @param OutTags Receives the tags, without duplicates, those coming from Row.Tags first.
+	 * @return The number of leading tags coming from Row.Tags, the ones name queries match.
+	 */
+	static int32 GatherIndexedTags(const FItemRow& Row, TArray<FGameplayTag>& OutTags);
+
+	/** @return The posting words of a tag, one bit per item id, or an empty view when no item carries it. */
+	TConstArrayView<uint64> GetPostings(const FGameplayTag& Tag) const;
+
+	bool HasTag(const FGameplayTag& Tag, const int32 ItemId) const;
+	/** @return The posting slot of a tag, its index in GetTags, or INDEX_NONE when no item carries it. */
+	int32 FindSlot(const FGameplayTag& Tag) const
+	{
+		const int32* Slot = TagSlots.Find(Tag);
+		return Slot ? *Slot : INDEX_NONE;
+	}
+
+	/**
+	 * Selects the items carrying every tag of the container (parents included).
+	 *
+	 * @param AllOf Required tags. An empty container selects every item.
+	 * @param OutItems Receives one bit per item id.
+	 */
+	void QueryAll(const FGameplayTagContainer& AllOf, FDenseBitSet& OutItems) const;
+	/**
+	 * Selects the items carrying at least one tag of the container (parents included).
+	 *
+	 * @param AnyOf Accepted tags. An empty container selects nothing.
+	 * @param OutItems Receives one bit per item id.
+	 */
+	void QueryAny(const FGameplayTagContainer& AnyOf, FDenseBitSet& OutItems) const;
+	/**
+	 * Selects the items carrying a tag whose name contains the fragment, as the editor row pickers filter.
+	 * Only the Tags of the items are matched, not their IngredientsType.
+	 *
+	 * @param Fragment Substring searched in the full tag names.
+	 * @param OutItems Receives one bit per item id.
+	 */
+	void QueryNameContains(const FString& Fragment, FDenseBitSet& OutItems) const;
+
+	int32 NumItems() const { return NumItemBits; }
+	int32 NumTags() const { return Tags.Num(); }
+	int32 GetWordsPerTag() const { return WordsPerTag; }
+	TConstArrayView<FGameplayTag> GetTags() const { return Tags; }
+	/** @return Every posting back to back, GetWordsPerTag words each, in the order of GetTags. */
+	TConstArrayView<uint64> GetRawWords() const { return TConstArrayView<uint64>(WordsData, Tags.Num() * WordsPerTag); }
+	/** @return The name posting of every slot, INDEX_NONE where it is the posting of the slot itself. */
+	TConstArrayView<int32> GetNameSlots() const { return NameSlots; }
+	/** @return Every name posting back to back, GetWordsPerTag words each. */
+	TConstArrayView<uint64> GetRawNameWords() const { return TConstArrayView<uint64>(NameWordsData, NumNamePostings * WordsPerTag); }
+
+private:
+	int32 FindOrAddSlot(const FGameplayTag& Tag);
+	/** Gives a slot its name posting, a copy of its posting: until now, only Tags reached it. */
+	int32 FindOrAddNamePosting(const int32 Slot);
+	const uint64* GetNameWords(const int32 Slot) const;
+	/** Moves every posting to a new number of words per tag. */
+	void Relayout(const int32 NewWordsPerTag);
+
+	// ========== VARIABLES ==========
+	/** Posting words of every tag, WordsPerTag consecutive words per slot. */
+	TArray<uint64> Words;
+	/** Read pointer, either on Words or on external storage. */
+	const uint64* WordsData = nullptr;
+	/** Name posting of each slot reached through an IngredientsType, INDEX_NONE for the others. */
+	TArray<int32> NameSlots;
+	TArray<uint64> NameWords;
+	const uint64* NameWordsData = nullptr;
+	int32 NumNamePostings = 0;
+	TArray<FGameplayTag> Tags;
+	TMap<FGameplayTag, int32> TagSlots;
+	/** Slots of the postings each item is set in, so that SetRow only clears those. Empty for bound indices. */
+	TItemRangedArray<int32> ItemSlots;
+	/** Ids of the rows removed since the last build, excluded from QueryAll. */
+	FDenseBitSet Removed;
+	int32 NumItemBits = 0;
+	int32 WordsPerTag = 0;
+};
@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/ItemRowTypes.h"
+
+// ===============================[ Perish Scheduler ]============================
+
+/**
+ * Hierarchical timing wheel of the perish deadlines of item instances.
+ * Time is cut in ticks of TickSeconds. Level L has NumSlots slots, each covering NumSlots^L ticks; a deadline goes to
+ * the lowest level whose span covers its distance to the current tick. Advancing fires the level 0 slot of each new
+ * tick and, whenever a level wraps, cascades the next slot of the level above one level down. Scheduling, rescheduling
+ * and cancelling are O(1) list operations, and advancing costs one slot per elapsed tick plus the expired instances,
+ * whatever the number of instances waiting.
+ * Deadlines beyond the span of the wheel wait in the top level and are placed again each time they cascade.
+ */
+class WARFALLCORE_API FPerishScheduler
+{
+	// ========== FUNCTIONS ==========
+public:
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	static constexpr int32 NumLevels = 4;
+
+	/**
+	 * @param InTickSeconds Resolution of the wheel. Instances perish at most one tick after their deadline.
+	 */
+	explicit FPerishScheduler(const double InTickSeconds = 0.25);
+
+	/** Cancels every deadline and restarts the wheel at a time. */
+	void Reset(const double Now);
+
+	/**
+	 * Schedules or reschedules the deadline of an instance.
+	 *
+	 * @param Handle The instance. A handle reusing the slot of a previously scheduled one replaces it.
+	 * @param Deadline Time in seconds, in the clock passed to Advance. Past deadlines expire on the next tick.
+	 */
+	void Schedule(const FItemHandle Handle, const double Deadline);
+	/** Cancels the deadline of an instance, if any. */
+	void Unschedule(const FItemHandle Handle);
+	bool IsScheduled(const FItemHandle Handle) const
+	{
+		const int32 Index = static_cast<int32>(Handle.GetIndex());
+		return Nodes.IsValidIndex(Index) && Nodes[Index].Bucket != INDEX_NONE && Nodes[Index].Handle == Handle.GetValue();
+	}
+
+	/**
+	 * Moves the wheel forward.
+	 *
+	 * @param Now Current time in seconds.
+	 * @param OutExpired Receives every instance whose deadline passed, in deadline tick order. Their deadlines are cancelled.
+	 * @return The number of instances appended to OutExpired.
+	 */
+	int32 Advance(const double Now, TArray<FItemHandle>& OutExpired);
+
+	/** Number of scheduled deadlines. */
+	int32 Num() const { return NumScheduled; }
+	double GetTickSeconds() const { return TickSeconds; }
+
+private:
+	/** Links of one instance slot inside its bucket list. */
+	struct FNode
+	{
+		uint64 DeadlineTick = 0;
+		uint32 Handle = 0;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		/** Level * NumSlots + slot of the bucket holding the node, INDEX_NONE when not scheduled. */
+		int32 Bucket = INDEX_NONE;
+	};
+
+	/** Puts a node in the bucket matching its deadline tick. */
+	void Insert(const int32 Index);
+	void Unlink(const int32 Index);
+	/** Empties a bucket of a level above 0 and places its nodes again, relative to the current tick. */
+	void Cascade(const int32 Level);
+
+	// ========== VARIABLES ==========
+	/** One node per instance slot, indexed by FItemHandle::GetIndex. */
+	TArray<FNode> Nodes;
+	/** First node of every bucket, INDEX_NONE for empty buckets. */
+	int32 Heads[NumLevels * NumSlots];
+	double TickSeconds;
+	uint64 CurrentTick = 0;
+	int32 NumScheduled = 0;
+};
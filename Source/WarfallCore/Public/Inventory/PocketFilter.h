@@ -0,0 +1,78 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Utils/DenseBitSet.h"
+
+struct FItemTagIndex;
+struct FPocketSpec;
+
+// ===============================[ Pocket Filter ]============================
+
+/**
+ * Whitelist and Blacklist of a pocket compiled into one admission bit per item id.
+ * An item is admitted when it carries a whitelisted tag, or any tag if the whitelist is empty, and no blacklisted one;
+ * parents count, so whitelisting Ingredients admits every ingredient. Admission is then a single bit test.
+ * Filter edits only recompute the words of the items carrying the edited tag, from the tag postings of the catalog.
+ */
+class WARFALLCORE_API FPocketFilter
+{
+	// ========== FUNCTIONS ==========
+public:
+	/**
+	 * Compiles the filters of a pocket.
+	 *
+	 * @param TagIndex Tag postings of the item catalog.
+	 * @param Spec The pocket, whose Whitelist, Blacklist and bPlayerEditableFilters are copied.
+	 */
+	void Compile(const FItemTagIndex& TagIndex, const FPocketSpec& Spec);
+	/** Compiles the current filters again, after the catalog was rebuilt. */
+	void Recompile(const FItemTagIndex& TagIndex);
+
+	/**
+	 * Adds a tag to a filter.
+	 *
+	 * @param TagIndex Tag postings of the item catalog.
+	 * @param Tag The tag.
+	 * @param bBlacklist True for the blacklist, false for the whitelist.
+	 * @return False if the filter already held the tag.
+	 */
+	bool AddTag(const FItemTagIndex& TagIndex, const FGameplayTag& Tag, const bool bBlacklist);
+	/** @return False if the filter did not hold the tag. */
+	bool RemoveTag(const FItemTagIndex& TagIndex, const FGameplayTag& Tag, const bool bBlacklist);
+
+	/** Evaluates again items whose rows were patched or added. */
+	void RefreshItems(const FItemTagIndex& TagIndex, TConstArrayView<int32> ItemIds);
+
+	bool Admits(const int32 ItemId) const { return Admission.IsValidIndex(ItemId) && Admission.Test(ItemId); }
+	const FDenseBitSet& GetAdmission() const { return Admission; }
+	const FGameplayTagContainer& GetWhitelist() const { return Whitelist; }
+	const FGameplayTagContainer& GetBlacklist() const { return Blacklist; }
+	bool IsPlayerEditable() const { return bPlayerEditable; }
+
+	/**
+	 * Splits items over pockets, each item going to the first pocket admitting it.
+	 * Costs one intersection per pocket whatever the number of items.
+	 *
+	 * @param Pockets Filters in priority order.
+	 * @param Items Items to route, one bit per item id. Receives the items no pocket admits.
+	 * @param OutRouted Receives the items routed to each pocket.
+	 */
+	static void Route(TConstArrayView<const FPocketFilter*> Pockets, FDenseBitSet& Items, TArray<FDenseBitSet>& OutRouted);
+
+private:
+	using FPostings = TArray<TConstArrayView<uint64>, TInlineAllocator<8>>;
+
+	/** Reads the postings of every tag of both filters once, for ComputeWord. */
+	void GatherPostings(const FItemTagIndex& TagIndex, FPostings& OutWhite, FPostings& OutBlack) const;
+	/** @return The admission bits of one word. */
+	uint64 ComputeWord(const FPostings& White, const FPostings& Black, const int32 WordIndex) const;
+	/** Computes again the words where a posting has bits, or everything when the whitelist became empty or not. */
+	void UpdateWords(const FItemTagIndex& TagIndex, const FGameplayTag& Tag, const bool bWasOpen);
+
+	// ========== VARIABLES ==========
+	FGameplayTagContainer Whitelist;
+	FGameplayTagContainer Blacklist;
+	FDenseBitSet Admission;
+	bool bPlayerEditable = false;
+};
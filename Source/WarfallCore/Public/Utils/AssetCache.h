@@ -0,0 +1,72 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "AssetCache.generated.h"
+
+/**
+ * Keeps the shared assets of the module (tables, data assets, materials) resolved and rooted.
+ * Every known path is preloaded asynchronously when the engine initializes; later requests are served from the cache
+ * instead of going through StaticLoadObject, and the load time of each asset is recorded.
+ */
+UCLASS()
+class WARFALLCORE_API UAssetCacheSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+	// ========== FUNCTIONS ==========
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** @return The subsystem instance, or nullptr before the engine is initialized. */
+	static UAssetCacheSubsystem* Get();
+
+	/**
+	 * Returns a loaded asset, going through the cache when it is available.
+	 * Falls back on a plain StaticLoadObject before the engine is initialized or outside the game thread.
+	 *
+	 * @param Path The asset path, in object path or export text form.
+	 * @param Class Expected class of the asset.
+	 * @return The loaded asset, or nullptr if it could not be loaded.
+	 */
+	static UObject* LoadAsset(const FSoftObjectPath& Path, UClass* Class);
+
+	template<typename T>
+	static T* Load(const FSoftObjectPath& Path)
+	{
+		return Cast<T>(LoadAsset(Path, T::StaticClass()));
+	}
+
+	/**
+	 * Returns a cached asset, loading it synchronously on the first request.
+	 *
+	 * @param Path The asset path.
+	 * @param Class Expected class of the asset.
+	 * @return The asset, or nullptr if it could not be loaded.
+	 */
+	UObject* Resolve(const FSoftObjectPath& Path, UClass* Class);
+
+	/** @return True once every preload request has completed. */
+	bool IsPreloadComplete() const { return PendingPreloads == 0; }
+
+	/** Logs the load time of every cached asset, slowest first. */
+	void DumpLoadTimes() const;
+
+private:
+	void Preload(const FSoftObjectPath& Path);
+	void OnPreloaded(FSoftObjectPath Path, double StartTime);
+	void Store(const FSoftObjectPath& Path, UObject* Asset, const double Duration, const bool bAsync);
+
+	// ========== VARIABLES ==========
+	UPROPERTY()
+	TMap<FSoftObjectPath, UObject*> Assets;
+
+	/** Load time of each asset, in seconds. */
+	TMap<FSoftObjectPath, double> LoadTimes;
+
+	FStreamableManager StreamableManager;
+	TArray<TSharedPtr<FStreamableHandle>> PreloadHandles;
+	int32 PendingPreloads = 0;
+};
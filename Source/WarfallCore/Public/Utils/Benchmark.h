@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// ===============================[ Benchmark ]============================
+
+/** Timings of one benchmarked operation against one data set size. */
+struct WARFALLCORE_API FBenchmarkResult
+{
+	FString Name;
+	/** Size of the data set the operation ran against. */
+	int32 Rows = 0;
+	/** Operations performed by one timed sample, used to report per-operation costs. */
+	int32 OpsPerSample = 1;
+	/** Nanoseconds per operation, one entry per sample, sorted ascending. */
+	TArray<double> Samples;
+	/** Heap allocations per operation over every sample. Negative when the allocator does not count them. */
+	double AllocationsPerOp = -1.0;
+
+	/** @return The sample at the given percentile (0-100), nearest rank. */
+	double GetPercentile(const double Percent) const;
+	double GetMean() const;
+};
+
+/**
+ * Runs timed bodies and collects their results into a CSV report, so that every change to a hot path ships with
+ * before/after numbers. Meant for console commands and perf automation tests: everything runs synchronously on the
+ * calling thread.
+ */
+class WARFALLCORE_API FBenchmarkReport
+{
+	// ========== FUNCTIONS ==========
+public:
+	explicit FBenchmarkReport(const FString& InSuite) : Suite(InSuite) {}
+
+	/**
+	 * Times a body after one untimed warm-up call.
+	 *
+	 * @param Name Name of the operation in the report.
+	 * @param Rows Size of the data set the body runs against.
+	 * @param NumSamples Number of timed calls.
+	 * @param OpsPerSample Operations performed by one call to the body.
+	 * @param Body Callable timed once per sample.
+	 * @return The result, sorted and added to the report.
+	 */
+	template <typename FBody>
+	const FBenchmarkResult& Run(const FString& Name, const int32 Rows, const int32 NumSamples, const int32 OpsPerSample, FBody&& Body)
+	{
+		FBenchmarkResult& Result = Results.AddDefaulted_GetRef();
+		Result.Name = Name;
+		Result.Rows = Rows;
+		Result.OpsPerSample = FMath::Max(OpsPerSample, 1);
+		Result.Samples.Reserve(NumSamples);
+
+		Body();
+
+		const int64 StartAllocations = GetAllocationCount();
+		for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Body();
+			Result.Samples.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0 / Result.OpsPerSample);
+		}
+		if (StartAllocations >= 0 && NumSamples > 0)
+		{
+			Result.AllocationsPerOp = static_cast<double>(GetAllocationCount() - StartAllocations) / (static_cast<double>(NumSamples) * Result.OpsPerSample);
+		}
+
+		Result.Samples.Sort();
+		return Result;
+	}
+
+	/** Logs one line per result. */
+	void Log() const;
+	/**
+	 * Writes every result to Saved/Benchmarks/<Suite>-<timestamp>.csv.
+	 *
+	 * @return The path of the written file, or an empty string on failure.
+	 */
+	FString WriteCsv() const;
+
+	TConstArrayView<FBenchmarkResult> GetResults() const { return Results; }
+
+	/** @return The number of heap allocations made so far by the process, or -1 when the build does not count them. */
+	static int64 GetAllocationCount();
+
+	// ========== VARIABLES ==========
+private:
+	FString Suite;
+	TArray<FBenchmarkResult> Results;
+};
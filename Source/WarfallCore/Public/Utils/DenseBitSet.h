@@ -0,0 +1,145 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed-size bitset over dense indices (item ids, recipe ids...), stored as 64-bit words.
+ * Binary operations take raw word views, so owned sets can be combined with postings stored elsewhere
+ * (compiled indices, memory-mapped catalogs) without copying them first.
+ */
+class FDenseBitSet
+{
+	// ========== FUNCTIONS ==========
+public:
+	FDenseBitSet() = default;
+	explicit FDenseBitSet(const int32 InNumBits, const bool bValue = false)
+	{
+		Init(InNumBits, bValue);
+	}
+
+	static int32 NumWordsFor(const int32 InNumBits) { return (InNumBits + 63) / 64; }
+
+	/** Resizes the set and assigns every bit. */
+	void Init(const int32 InNumBits, const bool bValue)
+	{
+		NumBits = FMath::Max(InNumBits, 0);
+		Words.Init(bValue ? ~0ull : 0ull, NumWordsFor(NumBits));
+		ClearPadding();
+	}
+
+	/** Grows or shrinks the set, new bits are cleared. */
+	void SetNum(const int32 InNumBits)
+	{
+		NumBits = FMath::Max(InNumBits, 0);
+		Words.SetNumZeroed(NumWordsFor(NumBits));
+		ClearPadding();
+	}
+
+	int32 Num() const { return NumBits; }
+
+	bool Test(const int32 Index) const
+	{
+		checkSlow(Index >= 0 && Index < NumBits);
+		return (Words[Index >> 6] >> (Index & 63)) & 1ull;
+	}
+	bool IsValidIndex(const int32 Index) const { return Index >= 0 && Index < NumBits; }
+
+	void Set(const int32 Index) { Words[Index >> 6] |= 1ull << (Index & 63); }
+	void Clear(const int32 Index) { Words[Index >> 6] &= ~(1ull << (Index & 63)); }
+	void SetTo(const int32 Index, const bool bValue) { bValue ? Set(Index) : Clear(Index); }
+
+	void SetAll() { for (uint64& Word : Words) { Word = ~0ull; } ClearPadding(); }
+	void ClearAll() { for (uint64& Word : Words) { Word = 0ull; } }
+
+	/** Keeps only the bits also set in Other. Missing words of Other are treated as cleared. */
+	void And(TConstArrayView<uint64> Other)
+	{
+		const int32 Common = FMath::Min(Words.Num(), Other.Num());
+		for (int32 Index = 0; Index < Common; ++Index) { Words[Index] &= Other[Index]; }
+		for (int32 Index = Common; Index < Words.Num(); ++Index) { Words[Index] = 0ull; }
+	}
+	void Or(TConstArrayView<uint64> Other)
+	{
+		const int32 Common = FMath::Min(Words.Num(), Other.Num());
+		for (int32 Index = 0; Index < Common; ++Index) { Words[Index] |= Other[Index]; }
+		ClearPadding();
+	}
+	/** Clears every bit set in Other. */
+	void AndNot(TConstArrayView<uint64> Other)
+	{
+		const int32 Common = FMath::Min(Words.Num(), Other.Num());
+		for (int32 Index = 0; Index < Common; ++Index) { Words[Index] &= ~Other[Index]; }
+	}
+
+	void And(const FDenseBitSet& Other) { And(Other.GetWords()); }
+	void Or(const FDenseBitSet& Other) { Or(Other.GetWords()); }
+	void AndNot(const FDenseBitSet& Other) { AndNot(Other.GetWords()); }
+
+	int32 CountSetBits() const
+	{
+		int32 Count = 0;
+		for (const uint64 Word : Words) { Count += FMath::CountBits(Word); }
+		return Count;
+	}
+
+	bool IsEmpty() const
+	{
+		for (const uint64 Word : Words) { if (Word) return false; }
+		return true;
+	}
+
+	/** Calls Func(int32 Index) for every set bit, in increasing order. */
+	template<typename FuncType>
+	void ForEachSetBit(FuncType&& Func) const
+	{
+		ForEachSetBit(Words, Func);
+	}
+
+	template<typename FuncType>
+	static void ForEachSetBit(TConstArrayView<uint64> InWords, FuncType&& Func)
+	{
+		for (int32 WordIndex = 0; WordIndex < InWords.Num(); ++WordIndex)
+		{
+			uint64 Word = InWords[WordIndex];
+			while (Word)
+			{
+				const int32 Bit = static_cast<int32>(FMath::CountTrailingZeros64(Word));
+				Func(WordIndex * 64 + Bit);
+				Word &= Word - 1;
+			}
+		}
+	}
+
+	/** @return The index of the first set bit at or after From, or INDEX_NONE. */
+	int32 FindFirstSetBit(const int32 From = 0) const
+	{
+		if (From >= NumBits) return INDEX_NONE;
+		int32 WordIndex = FMath::Max(From, 0) >> 6;
+		uint64 Word = Words[WordIndex] & (~0ull << (FMath::Max(From, 0) & 63));
+		while (true)
+		{
+			if (Word) return WordIndex * 64 + static_cast<int32>(FMath::CountTrailingZeros64(Word));
+			if (++WordIndex >= Words.Num()) return INDEX_NONE;
+			Word = Words[WordIndex];
+		}
+	}
+
+	TArrayView<uint64> GetWords() { return Words; }
+	TConstArrayView<uint64> GetWords() const { return Words; }
+
+	bool operator == (const FDenseBitSet& Other) const { return NumBits == Other.NumBits && Words == Other.Words; }
+
+private:
+	/** Keeps the bits past NumBits cleared so counts and iterations never report them. */
+	void ClearPadding()
+	{
+		if (const int32 Used = NumBits & 63; Used && Words.Num() > 0)
+		{
+			Words.Last() &= (1ull << Used) - 1ull;
+		}
+	}
+
+	// ========== VARIABLES ==========
+	TArray<uint64> Words;
+	int32 NumBits = 0;
+};
@@ -5,6 +5,7 @@
 #include <windows.h>
 #include "Windows/HideWindowsPlatformTypes.h"
 
+#include "Utils/AssetCache.h"
 #include "Utils/Paths.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet2/KismetEditorUtilities.h"
@@ -32,14 +33,14 @@ class WARFALLCORE_API UGlobalTools : public UObject
 
 public:
     /**
-     * Returns a loaded material interface by its logical name.
+     * Returns a loaded material interface by its logical name, served by the asset cache once loaded.
      *
      * @param MaterialName One of: "Shape", "Thumbnail", "Outline".
      * @return A pointer to the material if found, otherwise nullptr.
      */
     static UMaterialInterface* GetMaterial(const EMaterialPath& MaterialName)
     {
-    	static const TMap<EMaterialPath, FString> TableMap =
+    	static const TMap<EMaterialPath, FSoftObjectPath> TableMap =
     		{
     		{EMaterialPath::Shape, SHAPE_MATERIAL_PATH},
     		{EMaterialPath::Thumbnail, THUMBNAIL_MATERIAL_PATH},
@@ -47,32 +48,32 @@ public:
     		{EMaterialPath::RenderTarget, RENDER_TARGET_MATERIAL_PATH}
     		};
     	
-    	const FString* PathPtr = TableMap.Find(MaterialName);
+    	const FSoftObjectPath* PathPtr = TableMap.Find(MaterialName);
     	if (!PathPtr)
     	{
     		return nullptr;
     	}
-    	return Cast<UMaterialInterface>(StaticLoadObject(UMaterialInterface::StaticClass(), nullptr, **PathPtr));
+    	return UAssetCacheSubsystem::Load<UMaterialInterface>(*PathPtr);
     }
 
 	/**
-	 * Returns a loaded material instance by its logical name.
+	 * Returns a loaded material instance by its logical name, served by the asset cache once loaded.
 	 *
 	 * @param MaterialName The material instance path name, such as "Outline".
 	 * @return A pointer to the material instance if found, otherwise nullptr.
 	 */
 	static UMaterialInstance* GetMaterialInstance(const EMaterialInstPath& MaterialName)
     {
-    	static const TMap<EMaterialInstPath, FString> TableMap =
+    	static const TMap<EMaterialInstPath, FSoftObjectPath> TableMap =
 			{
     		{EMaterialInstPath::Outline, OUTLINES_MATERIAL_INST_PATH},
 			};
-    	const FString* PathPtr = TableMap.Find(MaterialName);
+    	const FSoftObjectPath* PathPtr = TableMap.Find(MaterialName);
     	if (!PathPtr)
     	{
     		return nullptr;
     	}
-    	return Cast<UMaterialInstance>(StaticLoadObject(UMaterialInstance::StaticClass(), nullptr, **PathPtr));
+    	return UAssetCacheSubsystem::Load<UMaterialInstance>(*PathPtr);
     }
 	
     /**
@@ -11,6 +11,7 @@
 #define MODULE_TABLE_PATH TEXT("/Script/Engine.DataTable'/WarfallCore/Data/Tables/ModulesTable.ModulesTable'")
 #define STATS_TABLE_PATH TEXT("/Script/Engine.DataTable'/WarfallCore/Data/Tables/StatsTable.StatsTable'")
 #define CHAR_PROFILE_TABLE_PATH TEXT("/Script/Engine.DataTable'/WarfallCore/Data/Tables/CharProfilesTable.CharProfilesTable'")
+#define RECIPE_TABLE_PATH TEXT("/Script/Engine.DataTable'/WarfallCore/Data/Tables/RecipesTable.RecipesTable'")
 
 // ASSETS PATHS
 #define ATTRIBUTES_TREE_DATA_PATH TEXT("/Script/WarfallCore.AttributesTree'/GameCore/Data/Assets/AttributesTree.AttributesTree'")
@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "Paths.h"
+#include "Utils/AssetCache.h"
 #include "Tables.generated.h"
 
 /**
@@ -17,6 +18,7 @@
  * - ModulesTable: Refers to the table managing module-related data.
  * - StatsTable: Represents the table with statistical information.
  * - CharProfilesTable: Refers to the table containing character profile data.
+ * - RecipesTable: Refers to the table containing the crafting recipes.
  */
 enum class ETablePath
 {
@@ -26,6 +28,7 @@ enum class ETablePath
 	ModulesTable,
 	StatsTable,
 	CharProfilesTable,
+	RecipesTable,
 };
 
 enum class EAssetsDataPath
@@ -45,48 +48,59 @@ class WARFALLCORE_API UTables : public UObject
 
 	public:
 	/**
-	 * Loads and returns a DataTable based on the provided name.
+	 * Returns a DataTable based on the provided name, served by the asset cache once loaded.
 	 *
 	 * @return A pointer to the loaded UDataTable or nullptr if not found.
 	 */
 	static UDataTable* GetTable(const ETablePath& Table)
 	{
-		static const TMap<ETablePath, FString> TableMap =
+		const FSoftObjectPath* PathPtr = FindTablePath(Table);
+		if (!PathPtr)
+		{
+			return nullptr;
+		}
+		return UAssetCacheSubsystem::Load<UDataTable>(*PathPtr);
+	}
+
+	/**
+	 * Returns the asset path of a DataTable, without loading it.
+	 *
+	 * @return A pointer to the path or nullptr if not found.
+	 */
+	static const FSoftObjectPath* FindTablePath(const ETablePath& Table)
+	{
+		static const TMap<ETablePath, FSoftObjectPath> TableMap =
 			{
 			{ETablePath::InputsTable, INPUT_TABLE_PATH},
 			{ETablePath::ItemsTable, ITEM_TABLE_PATH},
 			{ETablePath::ModulesTable, MODULE_TABLE_PATH},
 			{ETablePath::StatsTable, STATS_TABLE_PATH},
 			{ETablePath::CharProfilesTable, CHAR_PROFILE_TABLE_PATH},
+			{ETablePath::RecipesTable, RECIPE_TABLE_PATH},
 			};
 		
-		const FString* PathPtr = TableMap.Find(Table);
-		if (!PathPtr)
-		{
-			return nullptr;
-		}
-		return Cast<UDataTable>(StaticLoadObject(UDataTable::StaticClass(), nullptr, **PathPtr));
+		return TableMap.Find(Table);
 	}
 
 	/**
-	 * Loads and returns a DataAsset based on the provided name.
+	 * Returns a DataAsset based on the provided name, served by the asset cache once loaded.
 	 *
 	 * @param DataName One of: "AttributesTree", "SkillsTree".
 	 * @return A pointer to the loaded UDataAsset or nullptr if not found.
 	 */
 	static UDataAsset* GetDataAsset(const EAssetsDataPath& DataName)
 	{
-		static const TMap<EAssetsDataPath, FString> DataMap =
+		static const TMap<EAssetsDataPath, FSoftObjectPath> DataMap =
 			{
 			{EAssetsDataPath::AttributesTree, ATTRIBUTES_TREE_DATA_PATH},
 			{EAssetsDataPath::SkillsTree, SKILLS_TREE_DATA_PATH}
 			};
-		const FString* PathPtr = DataMap.Find(DataName);
+		const FSoftObjectPath* PathPtr = DataMap.Find(DataName);
 		if (!PathPtr)
 		{
 			return nullptr;
 		}
-		return Cast<UDataAsset>(StaticLoadObject(UDataAsset::StaticClass(), nullptr, **PathPtr));
+		return UAssetCacheSubsystem::Load<UDataAsset>(*PathPtr);
 	}
 	
 	/**
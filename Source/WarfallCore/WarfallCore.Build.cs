@@ -26,6 +26,7 @@ public class WarfallCore : ModuleRules
 			new string[]
 			{
 				"Core",
+				"NetCore",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -47,7 +48,6 @@ public class WarfallCore : ModuleRules
 				"UMG",
 				"EnhancedInput", 
 				"EditorStyle",
-				"NetCore",
 				"GameplayTags",
 				"OnlineSubsystem",
 				"OnlineSubsystemUtils"